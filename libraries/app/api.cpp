@@ -41,9 +41,15 @@
 #include <fc/smart_ref_impl.hpp>
 #include <fc/thread/future.hpp>
 #include <graphene/db/bdb_index.hpp>
+#include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/account_history/account_history_table.hpp>
 
 namespace graphene { namespace app {
 
+    using graphene::account_history::account_history_plugin;
+    using graphene::account_history::account_history_head;
+    using graphene::account_history::history_scan_action;
+
     login_api::login_api(application& a)
     :_app(a)
     {
@@ -134,7 +140,8 @@ namespace graphene { namespace app {
 
     network_broadcast_api::network_broadcast_api(application& a):_app(a)
     {
-       _applied_block_connection = _app.chain_database()->applied_block.connect([this](const signed_block& b){ on_applied_block(b); });
+       _applied_block_connection = _app.chain_database()->applied_block.connect(
+          _app.chain_database()->timed_handler("network_broadcast_api", [this](const signed_block& b){ on_applied_block(b); }));
     }
 
     void network_broadcast_api::on_applied_block( const signed_block& b )
@@ -231,6 +238,31 @@ namespace graphene { namespace app {
        return _app.p2p_node()->set_advanced_node_parameters(params);
     }
 
+    fc::variant_object network_node_api::get_apply_statistics() const
+    {
+       return _app.chain_database()->get_apply_statistics().to_variant();
+    }
+
+    void network_node_api::reset_apply_statistics()
+    {
+       _app.chain_database()->reset_apply_statistics();
+    }
+
+    fc::variant_object network_node_api::get_api_pool_statistics() const
+    {
+       return _app.get_api_pool_statistics();
+    }
+
+    fc::variant_object network_node_api::get_contract_cache_statistics() const
+    {
+       return _app.chain_database()->get_contract_cache().to_variant();
+    }
+
+    fc::variant_object network_node_api::get_contract_scheduler_statistics() const
+    {
+       return _app.chain_database()->get_contract_scheduler().to_variant();
+    }
+
     fc::api<network_broadcast_api> login_api::network_broadcast()const
     {
        FC_ASSERT(_network_broadcast_api);
@@ -321,42 +353,25 @@ namespace graphene { namespace app {
        FC_ASSERT( _app.chain_database() );
        const auto& db = *_app.chain_database();
        FC_ASSERT( limit <= 100 );
+       auto plugin = _app.get_plugin<account_history_plugin>( "account_history" );
+       FC_ASSERT( plugin );
        vector<operation_history_object> result;
        account_id_type account;
        try {
           account = database_api.get_account_id_from_string(account_id_or_name);
-          const auto& recent = account(db).statistics(db).most_recent_op;
-          unique_ptr<object> ptr = db.get_object_copy(recent);
-          const account_transaction_history_object& node = (const account_transaction_history_object&)*ptr;
-          if(start == operation_history_id_type() || start.instance.value > node.operation_id.instance.value)
-             start = node.operation_id;
        } catch(...) { return result; }
+       const auto& stats = account(db).statistics(db);
 
-       // const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
-       // const auto& by_op_idx = hist_idx.indices().get<by_op>();
-       const auto& hist_idx = dynamic_cast<const bdb_index<account_transaction_history_object>&>(db.get_index(account_transaction_history_object::space_id, account_transaction_history_object::type_id));
-       const auto& by_op_idx = hist_idx.get_bdb_secondary_index(1);
-
-       atho_by_op key;
-       key.account = account;
-       key.operation_id = start;
-       auto itr = by_op_idx.lower_bound(&key, sizeof(key));
-
-       while(itr != by_op_idx.end() && itr->account == account && itr->operation_id.instance.value > stop.instance.value && result.size() < limit)
-       {
-           if (itr->operation_id.instance.value <= start.instance.value)
-           {
-               auto oho = db.find_db(itr->operation_id);
-               result.push_back(*oho);
-           }          
-           --itr;
-       }
-       if(stop.instance.value == 0 && result.size() < limit && itr->account == account) {
-           auto oho = db.find_db(itr->operation_id);
-           result.push_back(*oho);
-       }
-
-       return result;
+       // operation ids grow with the sequence, newest first from start down to stop, a stop of 0 includes operation 0;
+       // history of reversible blocks is served by the plugin as well, before it is written
+       auto filter = [&]( const account_history_head& head ) {
+          if( start != operation_history_id_type() && head.operation_id > start.instance.value )
+             return history_scan_action::skip;
+          if( stop != operation_history_id_type() && head.operation_id <= stop.instance.value )
+             return history_scan_action::stop;
+          return history_scan_action::take;
+       };
+       return plugin->scan_history( account, flat_set<int32_t>(), stats.total_ops, stats.removed_ops + 1, limit, filter );
     }
 
     vector<operation_history_object> history_api::get_account_history_operations( const std::string account_id_or_name,
@@ -368,49 +383,27 @@ namespace graphene { namespace app {
        FC_ASSERT( _app.chain_database() );
        const auto& db = *_app.chain_database();
        FC_ASSERT( limit <= 100 );
+       auto plugin = _app.get_plugin<account_history_plugin>( "account_history" );
+       FC_ASSERT( plugin );
        vector<operation_history_object> result;
        account_id_type account;
        try {
           account = database_api.get_account_id_from_string(account_id_or_name);
        } catch(...) { return result; }
        const auto& stats = account(db).statistics(db);
-       if( stats.most_recent_op == account_transaction_history_id_type() ) return result;
-       const account_transaction_history_object* node = &stats.most_recent_op(db);
-       if( start == operation_history_id_type() )
-          start = node->operation_id;
-
-       std::unique_ptr<account_transaction_history_object> atho_ptr;
-       while(node && node->operation_id.instance.value > stop.instance.value && result.size() < limit)
-       {
-          if( node->operation_id.instance.value <= start.instance.value ) {
-             auto oho = db.find_db(node->operation_id);
-             
-             if(oho->op.which() == operation_id)
-               result.push_back( *oho );
-          }
+       if( stats.total_ops == 0 ) return result;
 
-          if( node->next == account_transaction_history_id_type() )
-             node = nullptr;
-          else 
-          { 
-              atho_ptr = db.find_db(node->next);
-              node = atho_ptr.get(); // &node->next(db);
-          }
-       }
-       if( stop.instance.value == 0 && result.size() < limit ) 
-       {
-          const account_transaction_history_object head = *(db.find_db(account_transaction_history_id_type()));
-          if (head.account == account)
-          {
-              auto oh = db.find_db(head.operation_id);
-              if(oh && oh->op.which() == operation_id )
-                result.push_back(*oh);
-          }
-       }
-       return result;
+       // operation ids grow with the sequence, so the walk ends at the first one not after stop
+       auto filter = [&]( const account_history_head& head ) {
+          if( stop.instance.value != 0 && head.operation_id <= stop.instance.value )
+             return history_scan_action::stop;
+          if( start != operation_history_id_type() && head.operation_id > start.instance.value )
+             return history_scan_action::skip;
+          return head.op_type == operation_id ? history_scan_action::take : history_scan_action::skip;
+       };
+       return plugin->scan_history( account, { operation_id }, stats.total_ops, stats.removed_ops + 1, limit, filter );
     }
 
-
     vector<operation_history_object> history_api::get_relative_account_history( const std::string account_id_or_name,
                                                                                 uint32_t start,
                                                                                 unsigned limit,
@@ -419,6 +412,8 @@ namespace graphene { namespace app {
        FC_ASSERT( _app.chain_database() );
        const auto& db = *_app.chain_database();
        FC_ASSERT(limit <= 100);
+       auto plugin = _app.get_plugin<account_history_plugin>( "account_history" );
+       FC_ASSERT( plugin );
        vector<operation_history_object> result;
        account_id_type account;
        try {
@@ -430,28 +425,10 @@ namespace graphene { namespace app {
        else
           stop = min( stats.total_ops, stop );
 
+       // from sequence stop down to start
        if( stop >= start && stop > stats.removed_ops && limit > 0 )
-       {
-          //const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
-          //const auto& by_seq_idx = hist_idx.indices().get<by_seq>();
-          const auto& hist_idx = dynamic_cast<const bdb_index<account_transaction_history_object>&>(db.get_index(account_transaction_history_object::space_id, account_transaction_history_object::type_id));
-          const auto& by_seq_idx = hist_idx.get_bdb_secondary_index(0);
-
-          // auto itr = by_seq_idx.upper_bound(boost::make_tuple(account, stop));
-          // auto itr_stop = by_seq_idx.lower_bound(boost::make_tuple(account, start));
-
-          atho_by_seq key;
-          key.account = account;
-          key.sequence = start;
-          auto itr = by_seq_idx.upper_bound(&key, sizeof(key));
-
-          while( itr != by_seq_idx.end() && itr->account == account && itr->sequence >= stop && result.size() < limit)
-          {
-             auto oho = db.find_db(itr->operation_id);
-             result.push_back( *oho );
-             --itr;
-          } 
-       }
+          result = plugin->scan_history( account, flat_set<int32_t>(), stop, std::max( start, stats.removed_ops + 1 ), limit,
+             []( const account_history_head& ) { return history_scan_action::take; } );
        return result;
     }
 
@@ -465,6 +442,8 @@ namespace graphene { namespace app {
        FC_ASSERT(_app.chain_database());
        const auto& db = *_app.chain_database();
        FC_ASSERT(limit <= 100);
+       auto plugin = _app.get_plugin<account_history_plugin>( "account_history" );
+       FC_ASSERT( plugin );
        vector<operation_history_object> result;
        account_id_type account;
        try {
@@ -475,30 +454,11 @@ namespace graphene { namespace app {
        uint32_t stop = stats.total_ops; 
        total_count = stop;
 
+       // the operation types are filtered on the record heads, skipped operations are not read
        if (stop >= start && stop > stats.removed_ops && limit > 0)
-       {
-          //const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
-          //const auto& by_seq_idx = hist_idx.indices().get<by_seq>();
-          const auto& hist_idx = dynamic_cast<const bdb_index<account_transaction_history_object>&>(db.get_index(account_transaction_history_object::space_id, account_transaction_history_object::type_id));
-          const auto& by_seq_idx = hist_idx.get_bdb_secondary_index(0);
-
-          // auto itr = by_seq_idx.upper_bound(boost::make_tuple(account, start));
-          // auto itr_stop = by_seq_idx.lower_bound(boost::make_tuple(account, stop));
-
-          atho_by_seq key;
-          key.account = account;
-          key.sequence = stop;
-          auto itr = by_seq_idx.upper_bound(&key, sizeof(key));
-
-          while (itr != by_seq_idx.end() && itr->account == account && itr->sequence >= start && result.size() < limit)
-          {
-             auto oho = db.find_db(itr->operation_id);
-             if (operation_types.empty() || find(operation_types.begin(), operation_types.end(), oho->op.which()) != operation_types.end())
-               result.push_back(*oho);
-
-             --itr;
-          }
-       }
+          result = plugin->scan_history( account, flat_set<int32_t>( operation_types.begin(), operation_types.end() ),
+                                         stop, std::max( start, stats.removed_ops + 1 ), limit,
+                                         []( const account_history_head& ) { return history_scan_action::take; } );
        return result;
     }
 
@@ -547,6 +507,14 @@ namespace graphene { namespace app {
        return result;
     } FC_CAPTURE_AND_RETHROW( (a)(b)(bucket_seconds)(start)(end) ) }
 
+    market_candles history_api::get_market_candles( asset_id_type a, asset_id_type b, uint32_t resolution,
+                                                    fc::time_point_sec start, fc::time_point_sec end )const
+    { try {
+       auto hist = _app.get_plugin<market_history_plugin>( "market_history" );
+       FC_ASSERT( hist );
+       return hist->get_candles( a, b, resolution, start, end, 1000 );
+    } FC_CAPTURE_AND_RETHROW( (a)(b)(resolution)(start)(end) ) }
+
     crypto_api::crypto_api(){};
 
     commitment_type crypto_api::blind( const blind_factor_type& blind, uint64_t value )
@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api_worker_pool.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/log/logger.hpp>
+
+namespace graphene { namespace app {
+
+api_worker_pool::api_worker_pool( const api_worker_pool_options& options )
+   : _options( options ), _chain_thread( &fc::thread::current() )
+{
+   FC_ASSERT( _options.chain_thread_slots > 0, "at least one chain thread slot is required" );
+   for( uint16_t i = 0; i < _options.worker_threads; ++i )
+      _workers.push_back( std::make_shared<fc::thread>( "api-worker-" + std::to_string( i ) ) );
+}
+
+api_worker_pool::~api_worker_pool()
+{
+   {
+      // queued requests are dropped, tasks already posted find no queue and only give back their slot
+      std::lock_guard<std::mutex> lock( _mutex );
+      _queues.clear();
+      _waiting_for_chain.clear();
+      _pending = 0;
+   }
+   for( auto& worker : _workers )
+      worker->quit();
+
+   // tasks posted to the chain thread use this pool, wait until every one of them has run
+   auto drain = [this]() {
+      while( true )
+      {
+         {
+            std::lock_guard<std::mutex> lock( _mutex );
+            if( _chain_in_flight == 0 )
+               return;
+         }
+         fc::usleep( fc::milliseconds( 1 ) );
+      }
+   };
+   if( _chain_thread == &fc::thread::current() )
+      drain();
+   else
+      _chain_thread->async( drain, "api worker pool drain" ).wait();
+}
+
+uint64_t api_worker_pool::open_queue()
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   uint64_t queue_id = _next_queue_id++;
+   _queues[queue_id];
+   return queue_id;
+}
+
+void api_worker_pool::close_queue( uint64_t queue_id )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   auto itr = _queues.find( queue_id );
+   if( itr == _queues.end() )
+      return;
+   for( const auto& r : itr->second.pending )
+   {
+      --_pending;
+      --_methods[r.method].pending;
+   }
+   _queues.erase( itr );
+}
+
+std::string api_worker_pool::parse_call( const fc::variant& request, bool& database_api_call, fc::variant& id )
+{
+   database_api_call = false;
+   try
+   {
+      if( !request.is_object() )
+         return std::string();
+      const auto& obj = request.get_object();
+      if( obj.contains( "id" ) )
+         id = obj["id"];
+      if( !obj.contains( "method" ) )
+         return std::string();
+      std::string method = obj["method"].as_string();
+      if( method != "call" )
+      {
+         // calls without an API id go to the first registered API, which is the database API
+         database_api_call = true;
+         return method;
+      }
+      if( !obj.contains( "params" ) || !obj["params"].is_array() || obj["params"].get_array().size() < 2 )
+         return std::string();
+      const auto& params = obj["params"].get_array();
+      database_api_call = ( params[0].is_string() && params[0].as_string() == "database" )
+                       || ( params[0].is_numeric() && params[0].as_uint64() == 0 );
+      return params[1].as_string();
+   }
+   catch( const fc::exception& )
+   {
+      return std::string();
+   }
+}
+
+std::string api_worker_pool::parse_request( const std::string& request, bool& database_api_call, fc::variant& id )
+{
+   database_api_call = false;
+   fc::variant parsed;
+   try
+   {
+      parsed = fc::json::from_string( request );
+   }
+   catch( const fc::exception& )
+   {
+      return std::string();
+   }
+   if( parsed.is_array() )
+      return "batch";
+   return parse_call( parsed, database_api_call, id );
+}
+
+bool api_worker_pool::is_concurrent( const fc::variant& request )const
+{
+   if( _workers.empty() )
+      return false;
+   bool database_api_call = false;
+   fc::variant id;
+   if( !request.is_array() )
+      return _options.concurrent_methods.count( parse_call( request, database_api_call, id ) ) > 0 && database_api_call;
+
+   // a batch may leave the chain thread only if every call in it may
+   const auto& calls = request.get_array();
+   if( calls.empty() )
+      return false;
+   for( const auto& call : calls )
+      if( !_options.concurrent_methods.count( parse_call( call, database_api_call, id ) ) || !database_api_call )
+         return false;
+   return true;
+}
+
+std::string api_worker_pool::error_reply( const fc::variant& id, const std::string& message )
+{
+   fc::mutable_variant_object error;
+   error["code"]    = -32000;
+   error["message"] = message;
+   fc::mutable_variant_object reply;
+   reply["id"]      = id;
+   reply["jsonrpc"] = "2.0";
+   reply["error"]   = error;
+   return fc::json::to_string( reply );
+}
+
+void api_worker_pool::submit( uint64_t queue_id, const std::string& request_body, run_type run, reject_type reject )
+{
+   request r;
+   fc::variant parsed;
+   try
+   {
+      parsed = fc::json::from_string( request_body );
+   }
+   catch( const fc::exception& )
+   {
+      // left to the RPC layer, which replies with the parse error
+   }
+   bool database_api_call = false;
+   r.method     = parsed.is_array() ? std::string( "batch" ) : parse_call( parsed, database_api_call, r.id );
+   r.concurrent = is_concurrent( parsed );
+   r.received   = fc::time_point::now();
+   r.run        = std::move( run );
+   r.reject     = std::move( reject );
+
+   std::string rejection;
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto itr = _queues.find( queue_id );
+      auto& stats = _methods[r.method];
+      if( itr == _queues.end() )
+         rejection = "connection closed";
+      else if( _pending >= _options.max_pending )
+         rejection = "server busy, too many pending requests";
+      else if( stats.pending >= _options.max_pending_per_method )
+         rejection = "server busy, too many pending requests for " + r.method;
+      else if( itr->second.pending.size() >= _options.max_pending_per_connection )
+         rejection = "too many pending requests on this connection";
+
+      if( rejection.empty() )
+      {
+         auto& queue = itr->second;
+         ++_pending;
+         ++stats.pending;
+         queue.pending.push_back( std::move( r ) );
+         if( !queue.busy )
+            schedule( queue_id, queue );
+         return;
+      }
+      ++stats.rejected;
+   }
+   r.reject( error_reply( r.id, rejection ) );
+}
+
+void api_worker_pool::schedule( uint64_t queue_id, request_queue& queue )
+{
+   if( queue.pending.empty() )
+      return;
+   queue.busy = true;
+   if( queue.pending.front().concurrent )
+      post( queue_id, true );
+   else if( _chain_in_flight < _options.chain_thread_slots )
+   {
+      ++_chain_in_flight;
+      post( queue_id, false );
+   }
+   else
+      _waiting_for_chain.push_back( queue_id );
+}
+
+void api_worker_pool::post( uint64_t queue_id, bool concurrent )
+{
+   fc::thread* thread = _chain_thread;
+   if( concurrent )
+   {
+      thread = _workers[_next_worker].get();
+      _next_worker = ( _next_worker + 1 ) % _workers.size();
+   }
+   thread->async( [this, queue_id, concurrent](){ execute( queue_id, concurrent ); }, "api request" );
+}
+
+void api_worker_pool::execute( uint64_t queue_id, bool concurrent )
+{
+   request r;
+   bool found = false;
+   bool timed_out = false;
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto itr = _queues.find( queue_id );
+      if( itr != _queues.end() && !itr->second.pending.empty() )
+      {
+         r = std::move( itr->second.pending.front() );
+         itr->second.pending.pop_front();
+         found = true;
+         auto& stats = _methods[r.method];
+         auto waited = fc::time_point::now() - r.received;
+         stats.queue_wait.record( waited.count() );
+         if( waited > fc::milliseconds( _options.timeout_ms ) )
+         {
+            timed_out = true;
+            ++stats.timed_out;
+         }
+      }
+   }
+
+   bool failed = false;
+   fc::time_point start = fc::time_point::now();
+   if( found )
+   {
+      try
+      {
+         if( timed_out )
+            r.reject( error_reply( r.id, "request timed out in queue" ) );
+         else
+            r.run();
+      }
+      catch( const fc::exception& e )
+      {
+         failed = true;
+         elog( "API request ${m} failed: ${e}", ("m", r.method)("e", e.to_detail_string()) );
+      }
+      catch( const std::exception& e )
+      {
+         failed = true;
+         elog( "API request ${m} failed: ${e}", ("m", r.method)("e", e.what()) );
+      }
+   }
+
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( found )
+   {
+      auto& stats = _methods[r.method];
+      --stats.pending;
+      --_pending;
+      if( failed )
+         ++stats.failed;
+      if( !timed_out )
+         stats.execution.record( ( fc::time_point::now() - start ).count() );
+   }
+   if( !concurrent )
+   {
+      // hand the chain thread slot to the next connection waiting for one
+      --_chain_in_flight;
+      while( !_waiting_for_chain.empty() && _chain_in_flight < _options.chain_thread_slots )
+      {
+         uint64_t next = _waiting_for_chain.front();
+         _waiting_for_chain.pop_front();
+         if( _queues.find( next ) == _queues.end() )
+            continue;
+         ++_chain_in_flight;
+         post( next, false );
+      }
+   }
+   auto itr = _queues.find( queue_id );
+   if( itr != _queues.end() )
+   {
+      itr->second.busy = false;
+      schedule( queue_id, itr->second );
+   }
+}
+
+fc::variant_object api_worker_pool::get_statistics()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   fc::mutable_variant_object methods;
+   for( const auto& m : _methods )
+   {
+      fc::mutable_variant_object entry;
+      entry["pending"]    = m.second.pending;
+      entry["rejected"]   = m.second.rejected;
+      entry["timed_out"]  = m.second.timed_out;
+      entry["failed"]     = m.second.failed;
+      entry["queue_wait"] = m.second.queue_wait.to_variant();
+      entry["execution"]  = m.second.execution.to_variant();
+      methods[ m.first.empty() ? "(unparsed)" : m.first ] = entry;
+   }
+   fc::mutable_variant_object result;
+   result["worker_threads"]    = _workers.size();
+   result["connections"]       = _queues.size();
+   result["pending"]           = _pending;
+   result["chain_in_flight"]   = _chain_in_flight;
+   result["waiting_for_chain"] = _waiting_for_chain.size();
+   result["methods"]           = methods;
+   return result;
+}
+
+} } // graphene::app
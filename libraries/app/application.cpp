@@ -244,9 +244,56 @@ std::vector<fc::ip::endpoint> application_impl::resolve_string_to_ip_endpoints(c
 }
 
 
+/**
+ * Adds JSON-RPC batch requests to websocket_api_connection, and exposes the message handler so that
+ * requests can be run by the API worker pool
+ */
+class rpc_api_connection : public fc::rpc::websocket_api_connection
+{
+   public:
+      using fc::rpc::websocket_api_connection::websocket_api_connection;
+
+      static const uint32_t max_batch_size = 100;
+
+      /// handles a single request, or an array of requests whose replies are returned in one array
+      std::string handle_message( const std::string& message, bool send_message )
+      {
+         auto first = message.find_first_not_of( " \t\r\n" );
+         if( first == std::string::npos || message[first] != '[' )
+            return on_message( message, send_message );
+
+         std::string reply;
+         try
+         {
+            const auto requests = fc::json::from_string( message ).get_array();
+            FC_ASSERT( !requests.empty(), "empty batch" );
+            FC_ASSERT( requests.size() <= max_batch_size, "batch too large, at most ${n} requests",
+                       ("n", uint64_t( max_batch_size )) );
+            for( const auto& request : requests )
+            {
+               // notifications produce no reply
+               std::string r = on_message( fc::json::to_string( request ), false );
+               if( r.empty() )
+                  continue;
+               reply += reply.empty() ? "[" : ",";
+               reply += r;
+            }
+            if( !reply.empty() )
+               reply += "]";
+         }
+         catch( const fc::exception& e )
+         {
+            reply = api_worker_pool::error_reply( fc::variant(), e.to_string() );
+         }
+         if( send_message && !reply.empty() )
+            _connection.send_message( reply );
+         return reply;
+      }
+};
+
 void application_impl::new_connection( const fc::http::websocket_connection_ptr& c )
 {
-   auto wsc = std::make_shared<fc::rpc::websocket_api_connection>(*c, GRAPHENE_NET_MAX_NESTED_OBJECTS);
+   auto wsc = std::make_shared<rpc_api_connection>(*c, GRAPHENE_NET_MAX_NESTED_OBJECTS);
    auto login = std::make_shared<graphene::app::login_api>( std::ref(*_self) );
    login->enable_api("database_api");
 
@@ -274,6 +321,90 @@ void application_impl::new_connection( const fc::http::websocket_connection_ptr&
    }
 
    login->login(username, password);
+
+   // replace the handlers installed by websocket_api_connection
+   if( !_api_pool )
+   {
+      rpc_api_connection* api = wsc.get(); // owned by the connection through its session data
+      c->on_message_handler( [api]( const std::string& msg ) { api->handle_message( msg, true ); } );
+      c->on_http_handler( [api]( const std::string& msg ) { return api->handle_message( msg, false ); } );
+      return;
+   }
+
+   // requests are queued in the API worker pool instead of run inline
+   api_worker_pool* pool = _api_pool.get();
+   uint64_t queue_id = pool->open_queue();
+   std::weak_ptr<fc::http::websocket_connection> weak_con = c;
+   std::weak_ptr<rpc_api_connection> weak_api = wsc;
+
+   c->on_message_handler( [pool, queue_id, weak_con, weak_api]( const std::string& msg ) {
+      // the websocket is not thread-safe, replies are sent by the thread delivering its messages
+      fc::thread* con_thread = &fc::thread::current();
+      auto send_reply = [weak_con, con_thread]( const std::string& reply ) {
+         if( reply.empty() )
+            return;
+         con_thread->async( [weak_con, reply]() {
+            if( auto con = weak_con.lock() )
+               con->send_message( reply );
+         }, "api reply" );
+      };
+      pool->submit( queue_id, msg,
+         [weak_con, weak_api, msg, send_reply]() {
+            auto api = weak_api.lock();
+            if( api && !weak_con.expired() )
+               send_reply( api->handle_message( msg, false ) );
+         },
+         send_reply );
+   } );
+   c->on_http_handler( [pool, queue_id, weak_con, weak_api]( const std::string& msg ) -> std::string {
+      fc::promise<std::string>::ptr reply( new fc::promise<std::string>( "api http reply" ) );
+      pool->submit( queue_id, msg,
+         [weak_con, weak_api, msg, reply]() {
+            auto con = weak_con.lock();
+            auto api = weak_api.lock();
+            reply->set_value( con && api ? api->handle_message( msg, false ) : std::string() );
+         },
+         [reply]( const std::string& error ) {
+            reply->set_value( error );
+         } );
+      return fc::future<std::string>( reply ).wait();
+   } );
+   c->closed.connect( [pool, queue_id]() { pool->close_queue( queue_id ); } );
+}
+
+void application_impl::reset_api_worker_pool()
+{
+   _api_pool.reset();
+   if( !_options->count("api-worker-threads") || _options->at("api-worker-threads").as<uint16_t>() == 0 )
+      return;
+
+   api_worker_pool_options opts;
+   opts.worker_threads             = _options->at("api-worker-threads").as<uint16_t>();
+   opts.chain_thread_slots         = _options->at("api-chain-thread-slots").as<uint32_t>();
+   opts.max_pending                = _options->at("api-max-pending-requests").as<uint32_t>();
+   opts.max_pending_per_method     = _options->at("api-max-pending-per-method").as<uint32_t>();
+   opts.max_pending_per_connection = _options->at("api-max-pending-per-connection").as<uint32_t>();
+   opts.timeout_ms                 = _options->at("api-request-timeout-ms").as<uint32_t>();
+
+   // concurrent methods read the published snapshot, without it they have to stay on the chain thread
+   if( _chain_db->snapshots_enabled() )
+   {
+      std::vector<std::string> methods;
+      boost::split( methods, _options->at("api-concurrent-methods").as<string>(), boost::is_any_of(" \t,") );
+      for( const auto& m : methods )
+      {
+         // ids of external indexes are read from Berkeley DB, whose handles are not thread-safe
+         if( m == "get_objects" || m == "multi_call" )
+            wlog( "${m} can read Berkeley DB and is not run on the API worker threads", ("m", m) );
+         else if( !m.empty() )
+            opts.concurrent_methods.insert( m );
+      }
+   }
+   else
+      wlog( "enable-read-snapshots is off, all API calls will run on the chain thread" );
+
+   _api_pool.reset( new api_worker_pool( opts ) );
+   ilog( "Started ${n} API worker threads", ("n", opts.worker_threads) );
 }
 
 void application_impl::reset_websocket_server()
@@ -390,6 +521,26 @@ void application_impl::startup()
       _chain_db->enable_standby_votes_tracking( _options->at("enable-standby-votes-tracking").as<bool>() );
    }
 
+   if( _options->count("apply-statistics-log-interval") )
+   {
+      _chain_db->set_apply_statistics_log_interval( _options->at("apply-statistics-log-interval").as<uint32_t>() );
+   }
+
+   if( _options->count("contract-cache-size") )
+   {
+      _chain_db->get_contract_cache().set_capacity( _options->at("contract-cache-size").as<uint32_t>() );
+   }
+
+   if( _options->count("contract-execution-threads") )
+   {
+      _chain_db->set_contract_execution_threads( _options->at("contract-execution-threads").as<uint16_t>() );
+   }
+
+   if( _options->count("enable-read-snapshots") && _options->at("enable-read-snapshots").as<bool>() )
+   {
+      _chain_db->enable_snapshots();
+   }
+
    if( _options->count("replay-blockchain") )
       _chain_db->wipe( _data_dir / "blockchain", false );
 
@@ -416,6 +567,9 @@ void application_impl::startup()
    if( _active_plugins.find( "market_history" ) != _active_plugins.end() )
       _app_options.has_market_history_plugin = true;
 
+   if( _active_plugins.find( "contract_history" ) != _active_plugins.end() )
+      _app_options.has_contract_history_plugin = true;
+
    if( _options->count("api-access") ) {
 
       if(fc::exists(_options->at("api-access").as<boost::filesystem::path>()))
@@ -447,6 +601,7 @@ void application_impl::startup()
    }
 
    reset_p2p_node(_data_dir);
+   reset_api_worker_pool();
    reset_websocket_server();
    reset_websocket_tls_server();
 } FC_LOG_AND_RETHROW() }
@@ -946,6 +1101,34 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("enable-standby-votes-tracking", bpo::value<bool>()->implicit_value(true),
           "Whether to enable tracking of votes of standby witnesses and committee members. "
           "Set it to true to provide accurate data to API clients, set to false for slightly better performance.")
+         ("apply-statistics-log-interval", bpo::value<uint32_t>()->default_value(1200),
+          "Log a summary of block apply timings (slowest operations, plugins and maintenance phases) "
+          "every N blocks, 0 to disable")
+         ("contract-cache-size", bpo::value<uint32_t>()->default_value(64),
+          "Number of compiled smart contracts kept in memory, 0 to compile on every call")
+         ("contract-execution-threads", bpo::value<uint16_t>()->default_value(0),
+          "Threads executing the calls to distinct smart contracts of a block in parallel before applying it, "
+          "0 to execute every call serially. Needs a contract engine supporting parallel calls.")
+         ("enable-read-snapshots", bpo::value<bool>()->implicit_value(true),
+          "Publish a copy-on-write snapshot of the object database after each block so that API reads "
+          "do not wait for block application. Uses extra memory for objects changed between blocks.")
+         ("api-worker-threads", bpo::value<uint16_t>()->default_value(0),
+          "Number of threads serving read-only API calls, 0 to run every API call inline on the chain thread")
+         ("api-chain-thread-slots", bpo::value<uint32_t>()->default_value(4),
+          "Maximum number of API calls queued on the chain thread at once when api-worker-threads is set")
+         ("api-max-pending-requests", bpo::value<uint32_t>()->default_value(2000),
+          "Maximum number of API requests queued or running, further requests are rejected")
+         ("api-max-pending-per-method", bpo::value<uint32_t>()->default_value(500),
+          "Maximum number of queued or running API requests for a single method")
+         ("api-max-pending-per-connection", bpo::value<uint32_t>()->default_value(100),
+          "Maximum number of queued API requests on a single connection")
+         ("api-request-timeout-ms", bpo::value<uint32_t>()->default_value(10000),
+          "API requests waiting longer than this in the queue are answered with an error instead of being run")
+         ("api-concurrent-methods", bpo::value<string>()->default_value(
+             "get_assets get_chain_properties get_global_properties get_dynamic_global_properties "
+             "get_config get_chain_id"),
+          "Database API methods run on the API worker threads, requires enable-read-snapshots. "
+          "get_objects and multi_call always run on the chain thread")
          // TODO uncomment this when GUI is ready
          //("enable-subscribe-to-all", bpo::value<bool>()->implicit_value(false),
          // "Whether allow API clients to subscribe to universal object creation and removal events")
@@ -1126,5 +1309,12 @@ const application_options& application::get_options()
    return my->_app_options;
 }
 
+fc::variant_object application::get_api_pool_statistics()const
+{
+   if( !my->_api_pool )
+      return fc::variant_object();
+   return my->_api_pool->get_statistics();
+}
+
 // namespace detail
 } }
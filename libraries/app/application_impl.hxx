@@ -3,6 +3,7 @@
 #include <fc/network/http/websocket.hpp>
 #include <graphene/app/application.hpp>
 #include <graphene/app/api_access.hpp>
+#include <graphene/app/api_worker_pool.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/net/message.hpp>
@@ -24,6 +25,8 @@ class application_impl : public net::node_delegate
 
       void new_connection( const fc::http::websocket_connection_ptr& c );
 
+      void reset_api_worker_pool();
+
       void reset_websocket_server();
 
       void reset_websocket_tls_server();
@@ -187,6 +190,8 @@ class application_impl : public net::node_delegate
 
       std::shared_ptr<graphene::chain::database>            _chain_db;
       std::shared_ptr<graphene::net::node>                  _p2p_network;
+      /// declared before the servers, connections closed on their destruction still report to the pool
+      std::unique_ptr<api_worker_pool>                 _api_pool;
       std::shared_ptr<fc::http::websocket_server>      _websocket_server;
       std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
 
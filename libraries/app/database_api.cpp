@@ -41,6 +41,7 @@
 
 #include <cfenv>
 #include <iostream>
+#include <mutex>
 
 #define GET_REQUIRED_FEES_MAX_RECURSION 4
 
@@ -55,10 +56,19 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       ~database_api_impl();
 
       vector<optional<contract_object>> lookup_contracts(const vector<contract_addr_type> & contract_addrs) const;
+      string call_contract_readonly(const contract_addr_type& contract_addr, const string& call_data) const;
+      vector<contract_event_record> get_contract_events(const contract_addr_type& contract_addr, const string& name,
+                                                        uint32_t start_block, uint32_t stop_block, uint32_t limit) const;
+      void subscribe_to_contract_events(std::function<void(const variant&)> callback,
+                                        const contract_addr_type& contract_addr, const flat_set<string>& names);
+      void unsubscribe_from_contract_events(const contract_addr_type& contract_addr);
 
       // Objects
       fc::variants get_objects(const vector<object_id_type>& ids)const;
 
+      // Batching
+      vector<api_call_result> multi_call( const vector<api_call>& calls );
+
       // Subscriptions
       void set_subscribe_callback( std::function<void(const variant&)> cb, bool notify_remove_create );
       void set_pending_transaction_callback( std::function<void(const variant&)> cb );
@@ -144,6 +154,10 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       vector<optional<worker_object>> get_workers_by_account(const std::string account_id_or_name)const;
       uint64_t get_worker_count()const;
 
+      // PIO contributions
+      vector<pio_contribution_object> get_pio_contribution_ranking( uint32_t epoch, uint32_t limit )const;
+      optional<pio_epoch_object> get_pio_epoch( uint32_t epoch )const;
+
       // Votes
       vector<variant> lookup_vote_ids( const vector<vote_id_type>& votes )const;
 
@@ -179,7 +193,8 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
          if( !_subscribe_callback )
             return;
 
-         if( !is_subscribed_to_item(i) )
+         std::lock_guard<std::mutex> lock( _subscribe_filter_mutex );
+         if( !_subscribe_filter.contains( i ) )
             _subscribe_filter.insert( vec.data(), vec.size() );
       }
 
@@ -189,6 +204,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
          if( !_subscribe_callback )
             return false;
 
+         std::lock_guard<std::mutex> lock( _subscribe_filter_mutex );
          return _subscribe_filter.contains( i );
       }
 
@@ -229,6 +245,38 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
          return account;
       }
 
+      /// latest published read snapshot, null when snapshots are disabled and reads go to the live database
+      object_snapshot_ptr read_snapshot()const { return _db.snapshots_enabled() ? _db.get_snapshot() : object_snapshot_ptr(); }
+
+      /// like get_account_from_string(), but resolves the name in the snapshot when there is one
+      const account_object* get_account_from_string( const object_snapshot_ptr& snapshot, const std::string& name_or_id )const
+      {
+         if( !snapshot )
+            return get_account_from_string( name_or_id );
+         FC_ASSERT( name_or_id.size() > 0);
+         const account_object* account = nullptr;
+         if (std::isdigit(name_or_id[0]))
+            account = snapshot->find(fc::variant(name_or_id, 1).as<account_id_type>(1));
+         else
+            account = snapshot->find_by_key<account_object>(name_or_id);
+         FC_ASSERT( account, "no such account" );
+         return account;
+      }
+
+      template<uint8_t SpaceID, uint8_t TypeID, typename T>
+      const T* read_object( const object_snapshot_ptr& snapshot, object_id<SpaceID,TypeID,T> id )const
+      {
+         return snapshot ? snapshot->find( id ) : _db.find( id );
+      }
+
+      template<uint8_t SpaceID, uint8_t TypeID, typename T>
+      const T& read_object_or_throw( const object_snapshot_ptr& snapshot, object_id<SpaceID,TypeID,T> id )const
+      {
+         const T* obj = read_object( snapshot, id );
+         FC_ASSERT( obj, "Unable to find Object ${id}", ("id", id) );
+         return *obj;
+      }
+
       template<typename T>
       const std::pair<asset_id_type,asset_id_type> get_order_market( const T& order )
       {
@@ -258,9 +306,12 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       void on_objects_changed(const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts);
       void on_objects_removed(const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts);
       void on_applied_block();
+      void broadcast_contract_events();
 
       bool _notify_remove_create = false;
       mutable fc::bloom_filter _subscribe_filter;
+      /// subscriptions from calls running on API worker threads race with notifications on the chain thread
+      mutable std::mutex _subscribe_filter_mutex;
       std::set<account_id_type> _subscribed_accounts;
       std::function<void(const fc::variant&)> _subscribe_callback;
       std::function<void(const fc::variant&)> _pending_trx_callback;
@@ -272,6 +323,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       boost::signals2::scoped_connection                                                                                           _applied_block_connection;
       boost::signals2::scoped_connection                                                                                           _pending_trx_connection;
       map< pair<asset_id_type,asset_id_type>, std::function<void(const variant&)> >      _market_subscriptions;
+      map< contract_addr_type, pair< flat_set<string>, std::function<void(const variant&)> > > _contract_event_subscriptions;
       graphene::chain::database&                                                                                                            _db;
       const application_options* _app_options = nullptr;
 
@@ -301,7 +353,7 @@ database_api_impl::database_api_impl( graphene::chain::database& db, const appli
    _removed_connection = _db.removed_objects.connect([this](const vector<object_id_type>& ids, const vector<const object*>& objs, const flat_set<account_id_type>& impacted_accounts) {
                                 on_objects_removed(ids, objs, impacted_accounts);
                                 });
-   _applied_block_connection = _db.applied_block.connect([this](const signed_block&){ on_applied_block(); });
+   _applied_block_connection = _db.applied_block.connect(_db.timed_handler("database_api", [this](const signed_block&){ on_applied_block(); }));
 
    _pending_trx_connection = _db.on_pending_transaction.connect([this](const signed_transaction& trx ){
                          if( _pending_trx_callback ) _pending_trx_callback( fc::variant(trx, GRAPHENE_MAX_NESTED_OBJECTS) );
@@ -339,15 +391,145 @@ fc::variants database_api_impl::get_objects(const vector<object_id_type>& ids)co
    fc::variants result;
    result.reserve(ids.size());
 
+   const auto snapshot = read_snapshot();
    std::transform(ids.begin(), ids.end(), std::back_inserter(result),
-                  [this](object_id_type id) -> fc::variant {
-      
+                  [this, &snapshot](object_id_type id) -> fc::variant {
+      // external indexes are not part of snapshots, get_objects runs on the chain thread so they are read from the live database
+      if( snapshot && !_db.is_from_external_db(id) )
+      {
+         const object* obj = snapshot->find_object(id);
+         return obj ? obj->to_variant() : fc::variant();
+      }
       return _db.find_object_as_variant(id);
    });
 
    return result;
 }
 
+//////////////////////////////////////////////////////////////////////
+//                                                                  //
+// Batching                                                         //
+//                                                                  //
+//////////////////////////////////////////////////////////////////////
+
+namespace {
+
+   typedef std::function<fc::variant( database_api&, const fc::variants& )> multi_call_handler;
+
+   template<typename T>
+   T multi_call_param( const fc::variants& params, size_t i )
+   {
+      FC_ASSERT( params.size() > i, "missing parameter ${i}", ("i", uint64_t(i)) );
+      return params[i].as<T>( GRAPHENE_MAX_NESTED_OBJECTS );
+   }
+
+   template<typename T>
+   fc::variant multi_call_return( const T& result )
+   {
+      return fc::variant( result, GRAPHENE_MAX_NESTED_OBJECTS );
+   }
+
+   /// the read accessors wallets and explorers combine to render a page
+   const std::map<string, multi_call_handler>& multi_call_handlers()
+   {
+      static const std::map<string, multi_call_handler> handlers = {
+         { "get_objects", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_objects( multi_call_param<vector<object_id_type>>( p, 0 ) ) ); } },
+         { "get_chain_properties", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_chain_properties() ); } },
+         { "get_global_properties", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_global_properties() ); } },
+         { "get_dynamic_global_properties", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_dynamic_global_properties() ); } },
+         { "get_block_header", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_block_header( multi_call_param<uint32_t>( p, 0 ) ) ); } },
+         { "get_block", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_block( multi_call_param<uint32_t>( p, 0 ) ) ); } },
+         { "get_accounts", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_accounts( multi_call_param<vector<string>>( p, 0 ) ) ); } },
+         { "get_full_accounts", []( database_api_impl& api, const fc::variants& p ) {
+              // subscriptions cannot be registered through multi_call, the flag is ignored
+              return multi_call_return( api.get_full_accounts( multi_call_param<vector<string>>( p, 0 ), false ) ); } },
+         { "get_account_by_name", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_account_by_name( multi_call_param<string>( p, 0 ) ) ); } },
+         { "lookup_account_names", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.lookup_account_names( multi_call_param<vector<string>>( p, 0 ) ) ); } },
+         { "get_account_count", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_account_count() ); } },
+         { "get_pio_contribution_ranking", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_pio_contribution_ranking( multi_call_param<uint32_t>( p, 0 ),
+                                                                          multi_call_param<uint32_t>( p, 1 ) ) ); } },
+         { "get_account_balances", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_account_balances( multi_call_param<string>( p, 0 ),
+                                                                  multi_call_param<flat_set<asset_id_type>>( p, 1 ) ) ); } },
+         { "get_named_account_balances", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_named_account_balances( multi_call_param<string>( p, 0 ),
+                                                                        multi_call_param<flat_set<asset_id_type>>( p, 1 ) ) ); } },
+         { "get_assets", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_assets( multi_call_param<vector<asset_id_type>>( p, 0 ) ) ); } },
+         { "lookup_asset_symbols", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.lookup_asset_symbols( multi_call_param<vector<string>>( p, 0 ) ) ); } },
+         { "lookup_contracts", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.lookup_contracts( multi_call_param<vector<contract_addr_type>>( p, 0 ) ) ); } },
+         { "call_contract_readonly", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.call_contract_readonly( multi_call_param<contract_addr_type>( p, 0 ),
+                                                                    multi_call_param<string>( p, 1 ) ) ); } },
+         { "get_contract_events", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_contract_events( multi_call_param<contract_addr_type>( p, 0 ),
+                                                                 multi_call_param<string>( p, 1 ),
+                                                                 multi_call_param<uint32_t>( p, 2 ),
+                                                                 multi_call_param<uint32_t>( p, 3 ),
+                                                                 multi_call_param<uint32_t>( p, 4 ) ) ); } },
+         { "get_limit_orders", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_limit_orders( multi_call_param<asset_id_type>( p, 0 ),
+                                                              multi_call_param<asset_id_type>( p, 1 ),
+                                                              multi_call_param<uint32_t>( p, 2 ) ) ); } },
+         { "get_ticker", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_ticker( multi_call_param<string>( p, 0 ),
+                                                        multi_call_param<string>( p, 1 ) ) ); } },
+         { "get_order_book", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_order_book( multi_call_param<string>( p, 0 ),
+                                                            multi_call_param<string>( p, 1 ),
+                                                            p.size() > 2 ? multi_call_param<unsigned>( p, 2 ) : 50 ) ); } },
+         { "get_required_fees", []( database_api_impl& api, const fc::variants& p ) {
+              return multi_call_return( api.get_required_fees( multi_call_param<vector<operation>>( p, 0 ),
+                                                               multi_call_param<asset_id_type>( p, 1 ) ) ); } }
+      };
+      return handlers;
+   }
+
+}
+
+vector<api_call_result> database_api::multi_call( const vector<api_call>& calls )
+{
+   return my->multi_call( calls );
+}
+
+vector<api_call_result> database_api_impl::multi_call( const vector<api_call>& calls )
+{
+   FC_ASSERT( calls.size() <= 100, "at most 100 calls per multi_call" );
+   const auto& handlers = multi_call_handlers();
+
+   vector<api_call_result> results;
+   results.reserve( calls.size() );
+   for( const auto& call : calls )
+   {
+      api_call_result r;
+      try
+      {
+         auto itr = handlers.find( call.method );
+         FC_ASSERT( itr != handlers.end(), "${m} is not available through multi_call", ("m", call.method) );
+         r.result = itr->second( *this, call.params );
+      }
+      catch( const fc::exception& e )
+      {
+         r.error = e.to_string();
+      }
+      results.push_back( std::move( r ) );
+   }
+   return results;
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Subscriptions                                                    //
@@ -404,11 +586,15 @@ void database_api_impl::cancel_all_subscriptions( bool reset_callback, bool rese
       _subscribe_callback = std::function<void(const fc::variant&)>();
 
    if ( reset_market_subscriptions )
+   {
       _market_subscriptions.clear();
+      _contract_event_subscriptions.clear();
+   }
 
    _notify_remove_create = false;
    _subscribed_accounts.clear();
    static fc::bloom_parameters param(10000, 1.0/100, 1024*8*8*2);
+   std::lock_guard<std::mutex> lock( _subscribe_filter_mutex );
    _subscribe_filter = fc::bloom_filter(param);
 }
 
@@ -490,7 +676,7 @@ chain_property_object database_api::get_chain_properties()const
 
 chain_property_object database_api_impl::get_chain_properties()const
 {
-   return _db.get(chain_property_id_type());
+   return read_object_or_throw( read_snapshot(), chain_property_id_type() );
 }
 
 global_property_object database_api::get_global_properties()const
@@ -500,7 +686,7 @@ global_property_object database_api::get_global_properties()const
 
 global_property_object database_api_impl::get_global_properties()const
 {
-   return _db.get(global_property_id_type());
+   return read_object_or_throw( read_snapshot(), global_property_id_type() );
 }
 
 fc::variant_object database_api::get_config()const
@@ -520,7 +706,7 @@ chain_id_type database_api::get_chain_id()const
 
 chain_id_type database_api_impl::get_chain_id()const
 {
-   return _db.get_chain_id();
+   return read_object_or_throw( read_snapshot(), chain_property_id_type() ).chain_id;
 }
 
 dynamic_global_property_object database_api::get_dynamic_global_properties()const
@@ -530,7 +716,7 @@ dynamic_global_property_object database_api::get_dynamic_global_properties()cons
 
 dynamic_global_property_object database_api_impl::get_dynamic_global_properties()const
 {
-   return _db.get(dynamic_global_property_id_type());
+   return read_object_or_throw( read_snapshot(), dynamic_global_property_id_type() );
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -649,17 +835,13 @@ vector<optional<account_object>> database_api::get_accounts(const vector<std::st
 vector<optional<account_object>> database_api_impl::get_accounts(const vector<std::string>& account_names_or_ids)const
 {
    vector<optional<account_object>> result; result.reserve(account_names_or_ids.size());
+   const auto snapshot = read_snapshot();
    std::transform(account_names_or_ids.begin(), account_names_or_ids.end(), std::back_inserter(result),
-                  [this](std::string id_or_name) -> optional<account_object> {
+                  [this, &snapshot](std::string id_or_name) -> optional<account_object> {
 
-      const account_object* account = get_account_from_string(id_or_name);
-      account_id_type id = account->id;
-      if(auto o = _db.find(id))
-      {
-         subscribe_to_item( id );
-         return *o;
-      }
-      return {};
+      const account_object* account = get_account_from_string(snapshot, id_or_name);
+      subscribe_to_item( account->id );
+      return *account;
    });
    return result;
 }
@@ -917,6 +1099,87 @@ vector<optional<contract_object>> database_api_impl::lookup_contracts(const vect
     return result;
 }
 
+string database_api::call_contract_readonly(const contract_addr_type& contract_addr, const string& call_data) const
+{
+    return my->call_contract_readonly(contract_addr, call_data);
+}
+
+string database_api_impl::call_contract_readonly(const contract_addr_type& contract_addr, const string& call_data) const
+{
+    return _db.call_contract_readonly(contract_addr, call_data);
+}
+
+vector<contract_event_record> database_api::get_contract_events(const contract_addr_type& contract_addr, const string& name,
+                                                                 uint32_t start_block, uint32_t stop_block, uint32_t limit) const
+{
+   return my->get_contract_events(contract_addr, name, start_block, stop_block, limit);
+}
+
+vector<contract_event_record> database_api_impl::get_contract_events(const contract_addr_type& contract_addr, const string& name,
+                                                                      uint32_t start_block, uint32_t stop_block, uint32_t limit) const
+{ try {
+   FC_ASSERT( _app_options && _app_options->has_contract_history_plugin, "Contract history plugin is not enabled." );
+   FC_ASSERT( limit <= 100 );
+
+   vector<contract_event_record> result;
+   if( start_block > stop_block )
+      return result;
+
+   auto to_record = []( const graphene::contract_history::contract_event_object& e ) {
+      contract_event_record r;
+      r.contract_addr = e.contract_addr;
+      r.name          = e.name;
+      r.data          = e.data;
+      r.caller        = e.caller;
+      r.block_num     = e.block_num;
+      r.trx_in_block  = e.trx_in_block;
+      r.op_in_trx     = e.op_in_trx;
+      r.event_in_op   = e.event_in_op;
+      return r;
+   };
+
+   const auto& events = _db.get_index_type<graphene::contract_history::contract_event_index>().indices();
+   if( name.empty() )
+   {
+      const auto& idx = events.get<graphene::contract_history::by_contract>();
+      auto itr = idx.lower_bound( boost::make_tuple( contract_addr, start_block ) );
+      auto end = idx.upper_bound( boost::make_tuple( contract_addr, stop_block ) );
+      for( ; itr != end && result.size() < limit; ++itr )
+         result.push_back( to_record( *itr ) );
+   }
+   else
+   {
+      const auto& idx = events.get<graphene::contract_history::by_event>();
+      auto itr = idx.lower_bound( boost::make_tuple( contract_addr, name, start_block ) );
+      auto end = idx.upper_bound( boost::make_tuple( contract_addr, name, stop_block ) );
+      for( ; itr != end && result.size() < limit; ++itr )
+         result.push_back( to_record( *itr ) );
+   }
+   return result;
+} FC_CAPTURE_AND_RETHROW( (contract_addr)(name)(start_block)(stop_block)(limit) ) }
+
+void database_api::subscribe_to_contract_events(std::function<void(const variant&)> callback,
+                                                const contract_addr_type& contract_addr, const flat_set<string>& names)
+{
+   my->subscribe_to_contract_events( callback, contract_addr, names );
+}
+
+void database_api_impl::subscribe_to_contract_events(std::function<void(const variant&)> callback,
+                                                     const contract_addr_type& contract_addr, const flat_set<string>& names)
+{
+   _contract_event_subscriptions[ contract_addr ] = std::make_pair( names, callback );
+}
+
+void database_api::unsubscribe_from_contract_events(const contract_addr_type& contract_addr)
+{
+   my->unsubscribe_from_contract_events( contract_addr );
+}
+
+void database_api_impl::unsubscribe_from_contract_events(const contract_addr_type& contract_addr)
+{
+   _contract_event_subscriptions.erase( contract_addr );
+}
+
 vector<optional<account_object>> database_api::lookup_account_names(const vector<string>& account_names)const
 {
    return my->lookup_account_names( account_names );
@@ -1090,9 +1353,10 @@ vector<optional<asset_object>> database_api::get_assets(const vector<asset_id_ty
 vector<optional<asset_object>> database_api_impl::get_assets(const vector<asset_id_type>& asset_ids)const
 {
    vector<optional<asset_object>> result; result.reserve(asset_ids.size());
+   const auto snapshot = read_snapshot();
    std::transform(asset_ids.begin(), asset_ids.end(), std::back_inserter(result),
-                  [this](asset_id_type id) -> optional<asset_object> {
-      if(auto o = _db.find(id))
+                  [this, &snapshot](asset_id_type id) -> optional<asset_object> {
+      if(auto o = read_object(snapshot, id))
       {
          subscribe_to_item( id );
          return *o;
@@ -1895,6 +2159,41 @@ uint64_t database_api_impl::get_worker_count()const
     return _db.get_index_type<worker_index>().indices().size();
 }
 
+//////////////////////////////////////////////////////////////////////
+//                                                                  //
+// PIO contributions                                                //
+//                                                                  //
+//////////////////////////////////////////////////////////////////////
+
+vector<pio_contribution_object> database_api::get_pio_contribution_ranking( uint32_t epoch, uint32_t limit )const
+{
+   return my->get_pio_contribution_ranking( epoch, limit );
+}
+
+vector<pio_contribution_object> database_api_impl::get_pio_contribution_ranking( uint32_t epoch, uint32_t limit )const
+{
+   FC_ASSERT( limit <= 100 );
+   const auto& idx = _db.get_index_type<pio_contribution_index>().indices().get<by_epoch_contribution>();
+   vector<pio_contribution_object> result;
+   for( auto itr = idx.lower_bound( epoch ); itr != idx.end() && itr->epoch == epoch && result.size() < limit; ++itr )
+      result.push_back( *itr );
+   return result;
+}
+
+optional<pio_epoch_object> database_api::get_pio_epoch( uint32_t epoch )const
+{
+   return my->get_pio_epoch( epoch );
+}
+
+optional<pio_epoch_object> database_api_impl::get_pio_epoch( uint32_t epoch )const
+{
+   const auto& idx = _db.get_index_type<pio_epoch_index>().indices().get<by_epoch>();
+   auto itr = idx.find( epoch );
+   if( itr == idx.end() )
+      return {};
+   return *itr;
+}
+
 
 
 //////////////////////////////////////////////////////////////////////
@@ -2443,6 +2742,9 @@ void database_api_impl::on_applied_block()
       });
    }
 
+   if( _contract_event_subscriptions.size() )
+      broadcast_contract_events();
+
    if(_market_subscriptions.size() == 0)
       return;
 
@@ -2486,4 +2788,54 @@ void database_api_impl::on_applied_block()
    });
 }
 
+/** note: like on_applied_block(), this method cannot yield.
+ */
+void database_api_impl::broadcast_contract_events()
+{
+   const uint32_t block_num = _db.head_block_num();
+   map< contract_addr_type, vector<contract_event_record> > subscribed_events;
+   for( const optional< operation_history_object >& o_op : _db.get_applied_operations() )
+   {
+      if( !o_op.valid() || o_op->op.which() != operation::tag< smart_contract_call_operation >::value
+          || o_op->result.which() != operation_result::tag< contract_call_result >::value )
+         continue;
+
+      const auto& op = o_op->op.get<smart_contract_call_operation>();
+      auto sub = _contract_event_subscriptions.find( op.contract_addr );
+      if( sub == _contract_event_subscriptions.end() )
+         continue;
+
+      const auto& names = sub->second.first;
+      const auto& events = o_op->result.get<contract_call_result>().events;
+      for( uint16_t i = 0; i < events.size(); ++i )
+      {
+         if( !names.empty() && names.find( events[i].name ) == names.end() )
+            continue;
+         contract_event_record r;
+         r.contract_addr = op.contract_addr;
+         r.name          = events[i].name;
+         r.data          = events[i].data;
+         r.caller        = op.caller;
+         r.block_num     = block_num;
+         r.trx_in_block  = o_op->trx_in_block;
+         r.op_in_trx     = o_op->op_in_trx;
+         r.event_in_op   = i;
+         subscribed_events[ op.contract_addr ].push_back( std::move( r ) );
+      }
+   }
+   if( subscribed_events.empty() )
+      return;
+
+   /// we need to ensure the database_api is not deleted for the life of the async operation
+   auto capture_this = shared_from_this();
+   fc::async([this,capture_this,subscribed_events](){
+      for( const auto& item : subscribed_events )
+      {
+         auto itr = _contract_event_subscriptions.find( item.first );
+         if( itr != _contract_event_subscriptions.end() )
+            itr->second.second( fc::variant( item.second, GRAPHENE_NET_MAX_NESTED_OBJECTS ) );
+      }
+   });
+}
+
 } } // graphene::app
@@ -189,6 +189,18 @@ namespace graphene { namespace app {
          vector<bucket_object> get_market_history( asset_id_type a, asset_id_type b, uint32_t bucket_seconds,
                                                    fc::time_point_sec start, fc::time_point_sec end )const;
          flat_set<uint32_t> get_market_history_buckets()const;
+
+         /**
+          * @brief Get OHLCV candles of a market as compact arrays
+          * @param a One asset of the market
+          * @param b The other asset of the market
+          * @param resolution Seconds per candle, a multiple of one of the tracked bucket sizes, e.g. 604800 for one week
+          * @param start Candles opening before this time are not returned, the candle containing it is
+          * @param end Candles opening after this time are not returned
+          * @return Up to 1000 candles in time order, merged from the largest tracked bucket size dividing resolution
+          */
+         market_candles get_market_candles( asset_id_type a, asset_id_type b, uint32_t resolution,
+                                            fc::time_point_sec start, fc::time_point_sec end )const;
       private:
            application& _app;
            graphene::app::database_api database_api;
@@ -308,6 +320,33 @@ namespace graphene { namespace app {
           */
          std::vector<net::potential_peer_record> get_potential_peers() const;
 
+         /**
+          * @brief Get counters and latency histograms of the block apply pipeline, broken down
+          *        by operation type, signal handler (plugin) and chain maintenance phase
+          */
+         fc::variant_object get_apply_statistics() const;
+
+         /**
+          * @brief Reset all apply pipeline counters and histograms to zero
+          */
+         void reset_apply_statistics();
+
+         /**
+          * @brief Get queue lengths, rejections, timeouts and latencies of the API worker pool per method
+          */
+         fc::variant_object get_api_pool_statistics() const;
+
+         /**
+          * @brief Get hit, miss and compile time counters of the compiled smart contract cache
+          */
+         fc::variant_object get_contract_cache_statistics() const;
+
+         /**
+          * @brief Get how many contract calls were executed ahead of their block, and how many of those
+          * results were taken over or had to be executed again
+          */
+         fc::variant_object get_contract_scheduler_statistics() const;
+
       private:
          application& _app;
    };
@@ -476,6 +515,7 @@ FC_API(graphene::app::history_api,
        (get_fill_order_history)
        (get_market_history)
        (get_market_history_buckets)
+       (get_market_candles)
      )
 FC_API(graphene::app::block_api,
        (get_blocks)
@@ -493,6 +533,11 @@ FC_API(graphene::app::network_node_api,
        (get_potential_peers)
        (get_advanced_node_parameters)
        (set_advanced_node_parameters)
+       (get_apply_statistics)
+       (reset_apply_statistics)
+       (get_api_pool_statistics)
+       (get_contract_cache_statistics)
+       (get_contract_scheduler_statistics)
      )
 FC_API(graphene::app::crypto_api,
        (blind)
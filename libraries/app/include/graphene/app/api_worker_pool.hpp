@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/apply_statistics.hpp>
+
+#include <fc/thread/thread.hpp>
+#include <fc/variant_object.hpp>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   struct api_worker_pool_options
+   {
+      uint16_t               worker_threads             = 2;
+      uint32_t               chain_thread_slots         = 4;     ///< API calls queued on the chain thread at any time
+      uint32_t               max_pending                = 2000;  ///< requests queued or running, over all connections
+      uint32_t               max_pending_per_method     = 500;
+      uint32_t               max_pending_per_connection = 100;
+      uint32_t               timeout_ms                 = 10000; ///< requests waiting longer than this are not run
+      std::set<std::string>  concurrent_methods;                 ///< database_api methods safe to run on worker threads
+   };
+
+   /**
+    * @class api_worker_pool
+    * @brief Schedules RPC requests so that API load cannot starve block handling
+    *
+    * Requests of one connection run one at a time in arrival order, requests of different connections
+    * run independently.  Calls listed in api_worker_pool_options::concurrent_methods only read the
+    * published object snapshot and run on the worker threads.  All other calls touch live chain state
+    * and are posted to the chain thread, but never more than chain_thread_slots at once, so blocks
+    * and transactions from the p2p network always find the chain thread queue short.
+    *
+    * Admission control rejects requests beyond the global, per-method and per-connection limits with
+    * a JSON-RPC error, and requests which waited longer than the timeout are answered with an error
+    * instead of being run.
+    *
+    * run_type and reject_type callbacks are invoked on whichever thread runs the request, they must
+    * hand replies over to the thread owning the connection.
+    */
+   class api_worker_pool
+   {
+      public:
+         typedef std::function<void()>                    run_type;    ///< runs the request and delivers its reply
+         typedef std::function<void(const std::string&)>  reject_type; ///< delivers a JSON-RPC error reply
+
+         /// must be constructed on the thread that owns the chain database
+         explicit api_worker_pool( const api_worker_pool_options& options );
+         /// drops queued requests and returns once no task of the pool is left on any thread
+         ~api_worker_pool();
+
+         /// @return id of a new per-connection request queue
+         uint64_t open_queue();
+         /// drops requests still waiting in the queue, the running one completes normally
+         void     close_queue( uint64_t queue_id );
+
+         void submit( uint64_t queue_id, const std::string& request, run_type run, reject_type reject );
+
+         fc::variant_object get_statistics()const;
+
+         /**
+          * @param database_api_call set to true if the request calls the database API
+          * @param id set to the JSON-RPC request id
+          * @return the called method name, "batch" for a batch request, or an empty string if the
+          *         request cannot be parsed
+          */
+         static std::string parse_request( const std::string& request, bool& database_api_call, fc::variant& id );
+         static std::string error_reply( const fc::variant& id, const std::string& message );
+
+      private:
+         struct request
+         {
+            std::string     method;
+            bool            concurrent = false;
+            fc::time_point  received;
+            run_type        run;
+            reject_type     reject;
+            fc::variant     id;           ///< JSON-RPC request id, echoed in error replies
+         };
+
+         struct request_queue
+         {
+            std::deque<request>  pending;
+            bool                 busy = false;
+         };
+
+         struct method_statistics
+         {
+            uint32_t                   pending   = 0;
+            uint64_t                   rejected  = 0;
+            uint64_t                   timed_out = 0;
+            uint64_t                   failed    = 0;
+            chain::latency_histogram   queue_wait;
+            chain::latency_histogram   execution;
+         };
+
+         static std::string parse_call( const fc::variant& request, bool& database_api_call, fc::variant& id );
+         bool is_concurrent( const fc::variant& request )const;
+
+         /// called with _mutex held
+         void schedule( uint64_t queue_id, request_queue& queue );
+         void post( uint64_t queue_id, bool concurrent );
+         void execute( uint64_t queue_id, bool concurrent );
+
+         api_worker_pool_options                       _options;
+         fc::thread*                                   _chain_thread;
+         std::vector< std::shared_ptr<fc::thread> >    _workers;
+         size_t                                        _next_worker = 0;
+
+         mutable std::mutex                            _mutex;
+         uint64_t                                      _next_queue_id = 0;
+         std::map<uint64_t, request_queue>             _queues;
+         std::deque<uint64_t>                          _waiting_for_chain;
+         uint32_t                                      _chain_in_flight = 0;
+         uint32_t                                      _pending = 0;
+         std::map<std::string, method_statistics>      _methods;
+   };
+
+} } // graphene::app
@@ -41,6 +41,7 @@ namespace graphene { namespace app {
          // TODO change default to false when GUI is ready
          bool enable_subscribe_to_all = true;
          bool has_market_history_plugin = false;
+         bool has_contract_history_plugin = false;
    };
 
    class application
@@ -99,6 +100,9 @@ namespace graphene { namespace app {
 
          const application_options& get_options();
 
+         /// @return queue and latency statistics of the API worker pool, empty when it is disabled
+         fc::variant_object get_api_pool_statistics()const;
+
       private:
          void enable_plugin( const string& name );
          void add_available_plugin( std::shared_ptr<abstract_plugin> p );
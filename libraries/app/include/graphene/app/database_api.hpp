@@ -38,10 +38,12 @@
 #include <graphene/chain/confidential_object.hpp>
 #include <graphene/chain/market_object.hpp>
 #include <graphene/chain/operation_history_object.hpp>
+#include <graphene/chain/pio_contribution_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 #include <graphene/chain/worker_object.hpp>
 #include <graphene/chain/witness_object.hpp>
 
+#include <graphene/contract_history/contract_history_plugin.hpp>
 #include <graphene/market_history/market_history_plugin.hpp>
 
 #include <fc/api.hpp>
@@ -102,6 +104,18 @@ struct market_volume
    string                     quote_volume;
 };
 
+struct api_call
+{
+   string                     method;
+   fc::variants               params;
+};
+
+struct api_call_result
+{
+   fc::variant                result;
+   optional<string>           error;   ///< set instead of result when the call failed
+};
+
 struct market_trade
 {
    int64_t                    sequence = 0;
@@ -113,6 +127,18 @@ struct market_trade
    account_id_type            side2_account_id = GRAPHENE_NULL_ACCOUNT;
 };
 
+struct contract_event_record
+{
+   contract_addr_type         contract_addr;
+   string                     name;
+   vector<char>               data;
+   account_id_type            caller;
+   uint32_t                   block_num    = 0;
+   uint16_t                   trx_in_block = 0;
+   uint16_t                   op_in_trx    = 0;
+   uint16_t                   event_in_op  = 0;
+};
+
 /**
  * @brief The database_api class implements the RPC API for the chain database.
  *
@@ -139,6 +165,21 @@ class database_api
        */
       fc::variants get_objects(const vector<object_id_type>& ids)const;
 
+      //////////////
+      // Batching //
+      //////////////
+
+      /**
+       * @brief Execute several database API calls in one request
+       * @param calls Method names and parameters, at most 100 calls
+       * @return One result per call, in the order of calls. A failed call sets the error of its result
+       *         and does not affect the others.
+       *
+       * All calls are executed back to back without yielding, so they observe the same chain state.
+       * Only read accessors are available, subscription callbacks cannot be registered this way.
+       */
+      vector<api_call_result> multi_call( const vector<api_call>& calls );
+
       ///////////////////
       // Subscriptions //
       ///////////////////
@@ -327,14 +368,60 @@ class database_api
       vector<account_id_type> get_account_references( const std::string account_id_or_name )const;
 
       /**
-       * @brief Get a list of accounts by name
-       * @param account_names Names of the accounts to retrieve
-       * @return The accounts holding the provided names
+       * @brief Get a list of smart contracts by address
+       * @param contract_addrs Addresses of the contracts to retrieve
+       * @return The contracts at the provided addresses, null for unknown addresses
        *
-       * This function has semantics identical to @ref get_objects
+       * Contracts no longer carry their bytecode and ABI, they refer to a contract_code_object through
+       * their code member, which @ref get_objects returns.  contract_addr is the SHA256 of the bytecode,
+       * the ABI JSON and construct_data concatenated.
        */
       vector<optional<contract_object>> lookup_contracts(const vector<contract_addr_type> &contract_addrs)const;
 
+      /**
+       * @brief Run a smart contract method against the current state, without a transaction
+       * @param contract_addr Address of an activated contract
+       * @param call_data Method call, in the same format as smart_contract_call_operation::call_data
+       * @return The result returned by the method, for Wren contracts the String its toString returns
+       *
+       * Nothing is persisted: contract storage is read-only during the call and methods which write
+       * state fail.  The call is bounded by the per-call gas limit.  Contracts deployed before the
+       * ABI hardfork have no method results and are refused.
+       */
+      string call_contract_readonly(const contract_addr_type& contract_addr, const string& call_data)const;
+
+      /**
+       * @brief Get events emitted by a smart contract, oldest first
+       * @param contract_addr Address of the contract
+       * @param name Event name, or an empty string for events of any name
+       * @param start_block Lowest block number to return events from
+       * @param stop_block Highest block number to return events from
+       * @param limit Maximum number of events to return, at most 100
+       *
+       * Requires the contract_history plugin, which only keeps events of recent blocks.
+       */
+      vector<contract_event_record> get_contract_events(const contract_addr_type& contract_addr, const string& name,
+                                                        uint32_t start_block, uint32_t stop_block,
+                                                        uint32_t limit = 100)const;
+
+      /**
+       * @brief Request notification when a smart contract emits events
+       * @param callback Callback method which is called with the events of each applied block
+       * @param contract_addr Address of the contract
+       * @param names Event names to be notified of, or an empty set for all events of the contract
+       *
+       * Callback will be passed a variant containing a vector<contract_event_record>, in the order the
+       * events were emitted.  A new subscription to the same contract replaces the previous one.
+       */
+      void subscribe_to_contract_events(std::function<void(const variant&)> callback,
+                                        const contract_addr_type& contract_addr, const flat_set<string>& names);
+
+      /**
+       * @brief Unsubscribe from the events of a smart contract
+       * @param contract_addr Address of the contract
+       */
+      void unsubscribe_from_contract_events(const contract_addr_type& contract_addr);
+
       
       vector<optional<account_object>> lookup_account_names(const vector<string>& account_names)const;
 
@@ -621,6 +708,27 @@ class database_api
       uint64_t get_worker_count()const;
 
 
+      ///////////////////////
+      // PIO contributions //
+      ///////////////////////
+
+      /**
+       * @brief Get the accounts with the largest contributions in a PIO epoch
+       * @param epoch The epoch, dynamic_global_property_object::current_pio_epoch is the one in progress
+       * @param limit Maximum number of entries to return, at most 100
+       * @return Contributions of the epoch, largest first
+       *
+       * Per-account contributions are only kept for the last GRAPHENE_PIO_CONTRIBUTION_EPOCHS epochs.
+       */
+      vector<pio_contribution_object> get_pio_contribution_ranking( uint32_t epoch, uint32_t limit )const;
+
+      /**
+       * @brief Get the totals of a finished PIO epoch
+       * @param epoch The epoch
+       * @return The totals, or null if the epoch has not finished yet
+       */
+      optional<pio_epoch_object> get_pio_epoch( uint32_t epoch )const;
+
 
       ///////////
       // Votes //
@@ -733,12 +841,19 @@ FC_REFLECT( graphene::app::order_book, (base)(quote)(bids)(asks) );
 FC_REFLECT( graphene::app::market_ticker,
             (time)(base)(quote)(latest)(lowest_ask)(highest_bid)(percent_change)(base_volume)(quote_volume) );
 FC_REFLECT( graphene::app::market_volume, (time)(base)(quote)(base_volume)(quote_volume) );
+FC_REFLECT( graphene::app::api_call, (method)(params) );
+FC_REFLECT( graphene::app::api_call_result, (result)(error) );
 FC_REFLECT( graphene::app::market_trade, (sequence)(date)(price)(amount)(value)(side1_account_id)(side2_account_id) );
+FC_REFLECT( graphene::app::contract_event_record,
+            (contract_addr)(name)(data)(caller)(block_num)(trx_in_block)(op_in_trx)(event_in_op) );
 
 FC_API(graphene::app::database_api,
    // Objects
    (get_objects)
 
+   // Batching
+   (multi_call)
+
    // Subscriptions
    (set_subscribe_callback)
    (set_pending_transaction_callback)
@@ -775,6 +890,10 @@ FC_API(graphene::app::database_api,
    
    // contract
    (lookup_contracts)
+   (call_contract_readonly)
+   (get_contract_events)
+   (subscribe_to_contract_events)
+   (unsubscribe_from_contract_events)
 
    // Balances
    (get_account_balances)
@@ -822,6 +941,10 @@ FC_API(graphene::app::database_api,
    (get_workers_by_account)
    (get_worker_count)
 
+   // PIO contributions
+   (get_pio_contribution_ranking)
+   (get_pio_epoch)
+
    // Votes
    (lookup_vote_ids)
 
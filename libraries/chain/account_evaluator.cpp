@@ -30,6 +30,9 @@
 #include <graphene/chain/buyback_object.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/committee_member_object.hpp>
+#include <graphene/chain/contract_code_object.hpp>
+#include <graphene/chain/contract_gas_meter.hpp>
+#include <graphene/chain/contract_storage.hpp>
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/hardfork.hpp>
 #include <graphene/chain/internal_exceptions.hpp>
@@ -39,6 +42,7 @@
 #include <graphene/chain/worker_object.hpp>
 
 #include <algorithm>
+#include <limits>
 
 #include "../wren/src/include/wren.hpp"
 #include "../wren/src/contract/smart_contract_output.hpp"
@@ -301,22 +305,34 @@ object_id_type smart_contract_deploy_evaluator::do_apply(const smart_contract_de
         FC_ASSERT(o.contract_addr == rehash, "bad hash for smart contract");
 
         database &d = db();
+        const contract_code_id_type code = d.store_contract_code(o.bytecode, o.abi_json);
         const auto & new_smart_contract_object = d.create<contract_object>(
             [&](contract_object &obj)
             {
                 obj.owner               = o.owner;
                 obj.contract_addr       = o.contract_addr;
-                obj.bytecode            = o.bytecode;
+                obj.code                = code;
                 obj.construct_data      = o.construct_data;
-                obj.abi_json            = o.abi_json;
                 obj.contract_name       = o.contract_name;
                 obj.activated           = true;
-                obj.contract_state      = construct_smart_contract(o.bytecode, o.contract_addr, o.construct_data, o.abi_json);
 
                 ilog("deployed smart contract, addr: ${a}, name: ${n}", ("a", obj.contract_addr)("n", obj.contract_name));
             }
         );
 
+        // the constructor runs in the engine that will run the contract's calls.  An entry cached
+        // for this address by a deployment that failed or was undone may have another vm_version
+        auto engine = d.get_contract_engine();
+        d.get_contract_cache().invalidate(o.contract_addr);
+        auto compiled = d.get_contract_cache().get(o.contract_addr, [&]() {
+            return engine->compile(o.contract_addr, code(d));
+        });
+        // wren_vm code is always bounded, its gas ticks would let a constructor loop forever otherwise
+        const bool metered = d.head_block_time() >= HARDFORK_CONTRACT_GAS_TIME || code(d).vm_version > 0;
+        contract_gas_meter meter(metered ? GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT : std::numeric_limits<uint64_t>::max());
+        contract_storage storage(d, o.contract_addr);
+        engine->construct(*compiled, o.construct_data, storage, meter);
+
         return new_smart_contract_object.id;
     } FC_CAPTURE_AND_RETHROW((o))
 }
@@ -412,7 +428,11 @@ void_result smart_contract_kill_evaluator::do_apply(const smart_contract_kill_op
         ilog("try killing smart contract, addr: ${a}, name: ${n}",
             ("a", contract_obj->contract_addr)("n", contract_obj->contract_name));
 
+        const contract_code_id_type code = contract_obj->code;
+        contract_storage(db(), op.contract_addr).remove_all();
         db().remove(*contract_obj);
+        db().release_contract_code(code);
+        db().get_contract_cache().invalidate(op.contract_addr);
 
         return void_result();
     } FC_CAPTURE_AND_RETHROW((op))
@@ -422,13 +442,20 @@ void_result smart_contract_call_evaluator::do_evaluate(const smart_contract_call
 {
     try
     {
-        //TODO:
+        if (db().head_block_time() < HARDFORK_CONTRACT_GAS_TIME)
+            return void_result();
+
+        const auto& dgp = db().get_dynamic_global_properties();
+        const uint64_t block_gas_limit = db().get_global_properties().parameters.contract_block_gas_limit();
+        GRAPHENE_ASSERT(dgp.contract_gas_used < block_gas_limit,
+                        smart_contract_call_block_gas_exhausted,
+                        "block smart contract gas budget of ${l} is used up", ("l", block_gas_limit));
 
         return void_result();
     } FC_CAPTURE_AND_RETHROW((op))
 }
 
-void_result smart_contract_call_evaluator::do_apply(const smart_contract_call_operation &op)
+operation_result smart_contract_call_evaluator::do_apply(const smart_contract_call_operation &op)
 {
     try
     {
@@ -445,15 +472,87 @@ void_result smart_contract_call_evaluator::do_apply(const smart_contract_call_op
 
         FC_ASSERT(contract_obj->activated, "smart contract must be activated before calling it");
 
-        d.modify(*contract_obj,
-            [&](contract_object & b)
+        const contract_code_object& code = contract_obj->get_code(d);
+
+        // the call may use what is left of the block budget, up to the per-call limit,
+        // before the hardfork calls are not metered and pay no gas.  wren_vm code is bounded
+        // by the per-call limit even then, its gas ticks would let it loop forever otherwise
+        const bool metered = d.head_block_time() >= HARDFORK_CONTRACT_GAS_TIME;
+        const auto& dgp = d.get_dynamic_global_properties();
+        const uint64_t block_gas_limit = d.get_global_properties().parameters.contract_block_gas_limit();
+        // the limit may have been lowered below what the block used already
+        const uint64_t block_gas_left = block_gas_limit > dgp.contract_gas_used ? block_gas_limit - dgp.contract_gas_used : 0;
+        const bool limited_by_block = metered && block_gas_left < GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT;
+        contract_gas_meter meter(limited_by_block ? block_gas_left
+                                 : metered || code.vm_version > 0 ? GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT
+                                 : std::numeric_limits<uint64_t>::max());
+
+        // resolved against the table parsed at deployment, bad calls are rejected before running the VM
+        // only for code stored from the ABI hardfork, the binding running older code takes call data as sent
+        if (code.vm_version > 0)
+            code.abi->dispatch(op.call_data);
+
+        contract_call_result result;
+        try
+        {
+            meter.charge(GRAPHENE_CONTRACT_GAS_PER_CALL);
+            meter.charge_bytes(op.call_data.size());
+
+            auto engine = d.get_contract_engine();
+            auto speculative = d.find_speculative_contract_call();
+            if (speculative != nullptr && (speculative->contract_addr != op.contract_addr || speculative->call_data != op.call_data))
+                speculative = nullptr;
+
+            if (speculative != nullptr && speculative->is_valid(d))
             {
-                b.contract_state = call_smart_contract(contract_obj->bytecode, contract_obj->contract_addr,
-                                                        op.call_data, contract_obj->abi_json, contract_obj->contract_state);
+                // executed ahead of the block against the same storage values, take over its outcome
+                meter.charge(speculative->gas_used);
+                speculative->commit(d);
+                result.events = speculative->events;
+                d.get_contract_scheduler().record_outcome(true);
             }
-        );
+            else
+            {
+                if (speculative != nullptr)
+                    d.get_contract_scheduler().record_outcome(false);
+                auto compiled = d.get_contract_cache().get(contract_obj->contract_addr, [&]() {
+                    return engine->compile(contract_obj->contract_addr, code);
+                });
+                contract_storage storage(d, contract_obj->contract_addr, &meter);
+                engine->call(*compiled, op.call_data, storage, meter);
+                result.events = storage.events();
+            }
+        }
+        catch (const smart_contract_call_out_of_gas&)
+        {
+            if (!limited_by_block)
+                throw;
+            FC_THROW_EXCEPTION(smart_contract_call_block_gas_exhausted,
+                               "smart contract call used up the remaining block gas budget of ${l}", ("l", block_gas_left));
+        }
+
+        if (!metered)
+            return void_result();
+
+        d.modify(dgp, [&](dynamic_global_property_object& p) {
+            p.contract_gas_used += meter.used();
+        });
+
+        result.gas_used = meter.used();
+        if (!trx_state->skip_fee)
+        {
+            // gas is paid in CORE on top of the operation fee and routed like it
+            result.gas_fee = int64_t(meter.used() * GRAPHENE_DEFAULT_CONTRACT_PRICE_PER_KGAS / 1000);
+            if (result.gas_fee > 0)
+            {
+                d.adjust_balance(op.caller, -asset(result.gas_fee));
+                d.modify(*fee_paying_account_statistics, [&](account_statistics_object& s) {
+                    s.pay_fee(result.gas_fee, d.get_global_properties().parameters.cashback_vesting_threshold);
+                });
+            }
+        }
 
-        return void_result();
+        return result;
     } FC_CAPTURE_AND_RETHROW((op))
 }
 
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/apply_statistics.hpp>
+#include <graphene/chain/protocol/operations.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace graphene { namespace chain {
+
+namespace detail {
+
+   struct operation_name_visitor
+   {
+      typedef std::string result_type;
+
+      template<typename T>
+      std::string operator()( const T& )const
+      {
+         std::string name = fc::get_typename<T>::name();
+         auto pos = name.rfind( "::" );
+         return pos == std::string::npos ? name : name.substr( pos + 2 );
+      }
+   };
+
+   std::string operation_name( int which )
+   {
+      operation op;
+      op.set_which( which );
+      return op.visit( operation_name_visitor() );
+   }
+
+}
+
+void latency_histogram::record( int64_t elapsed_us )
+{
+   uint64_t us = elapsed_us > 0 ? uint64_t( elapsed_us ) : 0;
+   size_t bucket = 0;
+   for( uint64_t v = us; v != 0 && bucket + 1 < bucket_count; v >>= 1 )
+      ++bucket;
+   ++buckets[bucket];
+   ++count;
+   total_us += us;
+   if( us > max_us )
+      max_us = us;
+}
+
+uint64_t latency_histogram::percentile( double pct )const
+{
+   if( count == 0 )
+      return 0;
+   uint64_t target = uint64_t( ( pct / 100.0 ) * count );
+   if( target == 0 )
+      target = 1;
+   uint64_t seen = 0;
+   for( size_t i = 0; i < bucket_count; ++i )
+   {
+      seen += buckets[i];
+      if( seen >= target )
+         return std::min( uint64_t(1) << i, max_us );
+   }
+   return max_us;
+}
+
+fc::mutable_variant_object latency_histogram::to_variant()const
+{
+   fc::mutable_variant_object result;
+   result["count"]    = count;
+   result["total_us"] = total_us;
+   result["mean_us"]  = mean_us();
+   result["p50_us"]   = percentile( 50 );
+   result["p99_us"]   = percentile( 99 );
+   result["max_us"]   = max_us;
+   return result;
+}
+
+void fork_switch_statistics::record( uint32_t popped, uint32_t pushed, bool success, int64_t elapsed_us )
+{
+   ++count;
+   if( !success )
+      ++failed;
+   blocks_popped += popped;
+   blocks_pushed += pushed;
+   if( popped > max_depth )
+      max_depth = popped;
+   latency.record( elapsed_us );
+}
+
+fc::mutable_variant_object fork_switch_statistics::to_variant()const
+{
+   fc::mutable_variant_object result;
+   result["count"]         = count;
+   result["failed"]        = failed;
+   result["blocks_popped"] = blocks_popped;
+   result["blocks_pushed"] = blocks_pushed;
+   result["max_depth"]     = max_depth;
+   result["latency"]       = latency.to_variant();
+   return result;
+}
+
+latency_histogram& apply_statistics::operation( int which )
+{
+   size_t index = which < 0 ? 0 : size_t( which );
+   if( index >= _operations.size() )
+      _operations.resize( index + 1 );
+   return _operations[index];
+}
+
+void apply_statistics::reset()
+{
+   _blocks.reset();
+   _transactions.reset();
+   for( auto& h : _operations )
+      h.reset();
+   for( auto& h : _signal_handlers )
+      h.second.reset();
+   for( auto& h : _maintenance_phases )
+      h.second.reset();
+   _fork_switches.reset();
+}
+
+fc::variant_object apply_statistics::to_variant()const
+{
+   fc::mutable_variant_object operations;
+   for( size_t i = 0; i < _operations.size(); ++i )
+      if( _operations[i].count > 0 )
+         operations[ detail::operation_name( int(i) ) ] = _operations[i].to_variant();
+
+   fc::mutable_variant_object handlers;
+   for( const auto& h : _signal_handlers )
+      handlers[ h.first ] = h.second.to_variant();
+
+   fc::mutable_variant_object phases;
+   for( const auto& h : _maintenance_phases )
+      phases[ h.first ] = h.second.to_variant();
+
+   fc::mutable_variant_object result;
+   result["blocks"]             = _blocks.to_variant();
+   result["transactions"]       = _transactions.to_variant();
+   result["operations"]         = operations;
+   result["signal_handlers"]    = handlers;
+   result["maintenance_phases"] = phases;
+   result["fork_switches"]      = _fork_switches.to_variant();
+   return result;
+}
+
+std::string apply_statistics::summary( size_t top_n )const
+{
+   std::vector< std::pair<uint64_t, std::string> > entries;
+   for( size_t i = 0; i < _operations.size(); ++i )
+      if( _operations[i].count > 0 )
+         entries.emplace_back( _operations[i].total_us, "op:" + detail::operation_name( int(i) ) );
+   for( const auto& h : _signal_handlers )
+      if( h.second.count > 0 )
+         entries.emplace_back( h.second.total_us, "signal:" + h.first );
+   for( const auto& h : _maintenance_phases )
+      if( h.second.count > 0 )
+         entries.emplace_back( h.second.total_us, "maint:" + h.first );
+
+   size_t n = std::min( top_n, entries.size() );
+   std::partial_sort( entries.begin(), entries.begin() + n, entries.end(),
+                      []( const std::pair<uint64_t, std::string>& a, const std::pair<uint64_t, std::string>& b )
+                      { return a.first > b.first; } );
+
+   std::stringstream ss;
+   ss << "blocks=" << _blocks.count << " mean=" << _blocks.mean_us() << "us p99<=" << _blocks.percentile( 99 )
+      << "us max=" << _blocks.max_us << "us; fork switches=" << _fork_switches.count
+      << " (failed=" << _fork_switches.failed << ", max depth=" << _fork_switches.max_depth << "); slowest:";
+   for( size_t i = 0; i < n; ++i )
+      ss << " " << entries[i].second << "=" << entries[i].first << "us";
+   return ss.str();
+}
+
+} } // graphene::chain
@@ -24,6 +24,7 @@
 #include <graphene/chain/committee_member_evaluator.hpp>
 #include <graphene/chain/committee_member_object.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/hardfork.hpp>
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
 #include <graphene/chain/protocol/vote.hpp>
@@ -76,6 +77,9 @@ void_result committee_member_update_evaluator::do_apply( const committee_member_
 void_result committee_member_update_global_parameters_evaluator::do_evaluate(const committee_member_update_global_parameters_operation& o)
 { try {
    FC_ASSERT(trx_state->_is_proposed_trx);
+   if( db().head_block_time() < HARDFORK_CONTRACT_GAS_TIME )
+      FC_ASSERT( !o.new_parameters.extensions.value.contract_block_gas_limit.valid(),
+                 "Can not set contract_block_gas_limit before the smart contract gas hardfork" );
 
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (o) ) }
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/contract_cache.hpp>
+
+namespace graphene { namespace chain {
+
+compiled_contract_ptr contract_cache::get( const contract_addr_type& contract_addr, const compile_function& compile )
+{
+   auto itr = _entries.find( contract_addr );
+   if( itr != _entries.end() )
+   {
+      ++_hits;
+      _saved_us += itr->second->compile_us;
+      _lru.splice( _lru.begin(), _lru, itr->second );
+      return itr->second->compiled;
+   }
+
+   ++_misses;
+   const fc::time_point start = fc::time_point::now();
+   compiled_contract_ptr compiled = compile();
+   const int64_t compile_us = ( fc::time_point::now() - start ).count();
+   _compile_latency.record( compile_us );
+   FC_ASSERT( compiled, "failed to compile smart contract ${a}", ("a", contract_addr) );
+   if( _capacity == 0 )
+      return compiled;
+
+   evict_to( _capacity - 1 );
+   _lru.push_front( entry{ contract_addr, compiled, compile_us } );
+   _entries[contract_addr] = _lru.begin();
+   return compiled;
+}
+
+void contract_cache::invalidate( const contract_addr_type& contract_addr )
+{
+   auto itr = _entries.find( contract_addr );
+   if( itr == _entries.end() )
+      return;
+   ++_invalidations;
+   _lru.erase( itr->second );
+   _entries.erase( itr );
+}
+
+void contract_cache::clear()
+{
+   _lru.clear();
+   _entries.clear();
+}
+
+void contract_cache::set_capacity( size_t capacity )
+{
+   _capacity = capacity;
+   evict_to( capacity );
+}
+
+void contract_cache::evict_to( size_t capacity )
+{
+   while( _entries.size() > capacity )
+   {
+      _entries.erase( _lru.back().contract_addr );
+      _lru.pop_back();
+      ++_evictions;
+   }
+}
+
+fc::variant_object contract_cache::to_variant()const
+{
+   fc::mutable_variant_object result;
+   result["capacity"]         = uint64_t( _capacity );
+   result["size"]             = uint64_t( _entries.size() );
+   result["hits"]             = _hits;
+   result["misses"]           = _misses;
+   result["evictions"]        = _evictions;
+   result["invalidations"]    = _invalidations;
+   result["compile"]          = _compile_latency.to_variant();
+   result["compile_saved_us"] = _saved_us;
+   return result;
+}
+
+} } // graphene::chain
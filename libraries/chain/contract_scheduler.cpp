@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/contract_scheduler.hpp>
+
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/contract_code_object.hpp>
+#include <graphene/chain/contract_engine.hpp>
+#include <graphene/chain/database.hpp>
+
+#include <condition_variable>
+#include <mutex>
+
+namespace graphene { namespace chain {
+
+bool speculative_contract_call::is_valid( database& db )const
+{
+   if( !succeeded )
+      return false;
+   contract_storage storage( db, contract_addr );
+   for( const auto& r : reads )
+      if( storage.get( r.first ) != r.second )
+         return false;
+   return true;
+}
+
+void speculative_contract_call::commit( database& db )const
+{
+   contract_storage storage( db, contract_addr );
+   for( const auto& w : writes )
+   {
+      if( w.second.valid() )
+         storage.set( w.first, *w.second );
+      else
+         storage.remove( w.first );
+   }
+}
+
+namespace detail {
+
+   struct contract_call_group
+   {
+      compiled_contract_ptr                        compiled;
+      const contract_abi*                          abi = nullptr;   ///< null while calls are not dispatched
+      std::vector<speculative_contract_call*>      calls;
+   };
+
+   /// Runs the calls to one contract in order, on a worker thread
+   void run_contract_call_group( database& db, contract_engine& engine, contract_call_group& group )
+   {
+      contract_write_set overlay;
+      for( speculative_contract_call* call : group.calls )
+      {
+         try
+         {
+            const uint64_t per_call = GRAPHENE_CONTRACT_GAS_PER_CALL + call->call_data.size() * GRAPHENE_CONTRACT_GAS_PER_BYTE;
+            contract_gas_meter meter( GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT );
+            meter.charge( per_call );
+            if( group.abi != nullptr )
+               group.abi->dispatch( call->call_data );
+            contract_storage storage( db, call->contract_addr, &meter, *call, overlay );
+            engine.call( *group.compiled, call->call_data, storage, meter );
+            call->gas_used = meter.used() - per_call;
+            call->succeeded = true;
+            for( const auto& w : call->writes )
+               overlay[w.first] = w.second;
+         }
+         catch( const fc::exception& )
+         {
+            call->succeeded = false;
+         }
+         catch( ... )
+         {
+            call->succeeded = false;
+         }
+      }
+   }
+
+}
+
+void contract_call_scheduler::set_thread_count( size_t count )
+{
+   _calls.clear();
+   _threads.clear();
+   for( size_t i = 0; i < count; ++i )
+      _threads.push_back( std::make_shared<fc::thread>( "contract-" + std::to_string( i ) ) );
+}
+
+void contract_call_scheduler::speculate( database& db, const signed_block& block )
+{
+   _calls.clear();
+   contract_engine* engine = db.get_contract_engine();
+   if( _threads.empty() || engine == nullptr || !engine->supports_parallel_calls() )
+      return;
+
+   std::map<contract_addr_type, detail::contract_call_group> groups;
+   for( uint16_t t = 0; t < block.transactions.size(); ++t )
+   {
+      const auto& ops = block.transactions[t].operations;
+      for( uint16_t o = 0; o < ops.size(); ++o )
+      {
+         if( ops[o].which() != operation::tag<smart_contract_call_operation>::value )
+            continue;
+         const auto& op = ops[o].get<smart_contract_call_operation>();
+         auto& call = _calls[ std::make_pair( t, o ) ];
+         call.contract_addr = op.contract_addr;
+         call.call_data = op.call_data;
+         groups[op.contract_addr].calls.push_back( &call );
+      }
+   }
+   if( groups.size() < 2 )
+   {
+      _calls.clear();
+      return;
+   }
+
+   // compile here, the contract cache belongs to this thread
+   const auto& contracts = db.get_index_type<contract_index>().indices().get<by_contract_addr>();
+   for( auto itr = groups.begin(); itr != groups.end(); )
+   {
+      auto c = contracts.find( itr->first );
+      if( c != contracts.end() && c->activated )
+      {
+         try
+         {
+            const contract_object& contract = *c;
+            const contract_code_object& code = contract.get_code( db );
+            if( code.vm_version > 0 )
+               itr->second.abi = &*code.abi;
+            itr->second.compiled = db.get_contract_cache().get( contract.contract_addr, [&]() {
+               return engine->compile( contract.contract_addr, code );
+            });
+         }
+         catch( const fc::exception& )
+         {
+         }
+      }
+      // calls of groups left out stay unsucceeded and are executed serially
+      if( itr->second.compiled && itr->second.compiled->parallel_safe() )
+         ++itr;
+      else
+         itr = groups.erase( itr );
+   }
+
+   std::vector< std::vector<detail::contract_call_group*> > buckets( _threads.size() );
+   size_t next = 0;
+   for( auto& g : groups )
+   {
+      buckets[next].push_back( &g.second );
+      next = ( next + 1 ) % buckets.size();
+      _speculated += g.second.calls.size();
+   }
+
+   // Block the chain thread itself instead of waiting on fc futures: an fc wait would yield to
+   // other tasks of this thread, which may modify the database the workers are reading.
+   std::mutex mutex;
+   std::condition_variable done;
+   size_t running = 0;
+   for( size_t i = 0; i < buckets.size(); ++i )
+   {
+      if( buckets[i].empty() )
+         continue;
+      auto* bucket = &buckets[i];
+      ++running;
+      _threads[i]->async( [&db, engine, bucket, &mutex, &done, &running]() {
+         for( auto* group : *bucket )
+            detail::run_contract_call_group( db, *engine, *group );
+         std::lock_guard<std::mutex> lock( mutex );
+         if( --running == 0 )
+            done.notify_one();
+      }, "speculative contract calls" );
+   }
+   std::unique_lock<std::mutex> lock( mutex );
+   done.wait( lock, [&running]() { return running == 0; } );
+}
+
+const speculative_contract_call* contract_call_scheduler::find( uint16_t trx_in_block, uint16_t op_in_trx )const
+{
+   auto itr = _calls.find( std::make_pair( trx_in_block, op_in_trx ) );
+   return itr == _calls.end() ? nullptr : &itr->second;
+}
+
+fc::mutable_variant_object contract_call_scheduler::to_variant()const
+{
+   fc::mutable_variant_object result;
+   result["threads"]    = _threads.size();
+   result["speculated"] = _speculated;
+   result["committed"]  = _committed;
+   result["reexecuted"] = _reexecuted;
+   return result;
+}
+
+} } // graphene::chain
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/contract_gas_meter.hpp>
+#include <graphene/chain/contract_scheduler.hpp>
+#include <graphene/chain/contract_storage.hpp>
+#include <graphene/chain/contract_storage_object.hpp>
+#include <graphene/chain/database.hpp>
+
+namespace graphene { namespace chain {
+
+const string contract_storage::legacy_state_key;
+
+optional< vector<char> > contract_storage::get( const string& key )const
+{
+   auto value = load( key );
+   charge_read( key, value.valid() ? value->size() : 0 );
+   return value;
+}
+
+bool contract_storage::contains( const string& key )const
+{
+   charge_read( key, 0 );
+   return load( key ).valid();
+}
+
+void contract_storage::set( const string& key, vector<char> value )
+{
+   charge_write( key, value.size() );
+   if( _speculation != nullptr )
+   {
+      _speculation->writes[key] = optional< vector<char> >( std::move( value ) );
+      return;
+   }
+
+   const auto& idx = _db.get_index_type<contract_storage_index>().indices().get<by_contract_key>();
+   auto itr = idx.find( boost::make_tuple( _contract_addr, key ) );
+   if( itr == idx.end() )
+   {
+      _db.create<contract_storage_object>( [&]( contract_storage_object& obj ) {
+         obj.contract_addr = _contract_addr;
+         obj.key           = key;
+         obj.value         = std::move( value );
+      });
+   }
+   else if( itr->value != value )
+   {
+      _db.modify( *itr, [&]( contract_storage_object& obj ) {
+         obj.value = std::move( value );
+      });
+   }
+}
+
+bool contract_storage::remove( const string& key )
+{
+   charge_write( key, 0 );
+   if( _speculation != nullptr )
+   {
+      bool existed = load( key ).valid();
+      _speculation->writes[key] = optional< vector<char> >();
+      return existed;
+   }
+
+   const auto& idx = _db.get_index_type<contract_storage_index>().indices().get<by_contract_key>();
+   auto itr = idx.find( boost::make_tuple( _contract_addr, key ) );
+   if( itr == idx.end() )
+      return false;
+   _db.remove( *itr );
+   return true;
+}
+
+size_t contract_storage::remove_all()
+{
+   FC_ASSERT( !_read_only && _speculation == nullptr );
+   const auto& idx = _db.get_index_type<contract_storage_index>().indices().get<by_contract_key>();
+   size_t removed = 0;
+   auto itr = idx.lower_bound( boost::make_tuple( _contract_addr ) );
+   while( itr != idx.end() && itr->contract_addr == _contract_addr )
+   {
+      const auto& obj = *itr;
+      ++itr;
+      _db.remove( obj );
+      ++removed;
+   }
+   return removed;
+}
+
+void contract_storage::emit( const string& name, vector<char> data )
+{
+   FC_ASSERT( !_read_only, "contract ${a} attempted to emit event ${n} during a read-only call",
+              ("a", _contract_addr)("n", name) );
+   FC_ASSERT( !name.empty(), "contract events need a name" );
+   if( _meter != nullptr )
+      _meter->charge( GRAPHENE_CONTRACT_GAS_PER_EVENT
+                      + ( name.size() + data.size() ) * GRAPHENE_CONTRACT_GAS_PER_STORED_BYTE );
+
+   contract_event e;
+   e.name = name;
+   e.data = std::move( data );
+   ( _speculation != nullptr ? _speculation->events : _events ).push_back( std::move( e ) );
+}
+
+const vector<contract_event>& contract_storage::events()const
+{
+   return _speculation != nullptr ? _speculation->events : _events;
+}
+
+optional< vector<char> > contract_storage::load( const string& key )const
+{
+   if( _speculation == nullptr )
+      return find_stored( key );
+
+   auto w = _speculation->writes.find( key );
+   if( w != _speculation->writes.end() )
+      return w->second;
+   auto r = _speculation->reads.find( key );
+   if( r != _speculation->reads.end() )
+      return r->second;
+
+   auto o = _overlay->find( key );
+   optional< vector<char> > value = ( o != _overlay->end() ) ? o->second : find_stored( key );
+   _speculation->reads[key] = value;
+   return value;
+}
+
+optional< vector<char> > contract_storage::find_stored( const string& key )const
+{
+   const auto& idx = _db.get_index_type<contract_storage_index>().indices().get<by_contract_key>();
+   auto itr = idx.find( boost::make_tuple( _contract_addr, key ) );
+   if( itr == idx.end() )
+      return optional< vector<char> >();
+   return itr->value;
+}
+
+void contract_storage::charge_read( const string& key, size_t value_size )const
+{
+   if( _meter != nullptr )
+      _meter->charge( GRAPHENE_CONTRACT_GAS_PER_STORAGE_READ
+                      + ( key.size() + value_size ) * GRAPHENE_CONTRACT_GAS_PER_BYTE );
+}
+
+void contract_storage::charge_write( const string& key, size_t value_size )
+{
+   FC_ASSERT( !_read_only, "contract ${a} attempted to write key ${k} during a read-only call",
+              ("a", _contract_addr)("k", key) );
+   if( _meter != nullptr )
+      _meter->charge( GRAPHENE_CONTRACT_GAS_PER_STORAGE_WRITE
+                      + ( key.size() + value_size ) * GRAPHENE_CONTRACT_GAS_PER_STORED_BYTE );
+}
+
+} } // graphene::chain
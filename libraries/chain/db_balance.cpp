@@ -27,6 +27,8 @@
 
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/contract_code_object.hpp>
+#include <graphene/chain/hardfork.hpp>
 #include <graphene/chain/vesting_balance_object.hpp>
 #include <graphene/chain/witness_object.hpp>
 
@@ -55,6 +57,58 @@ bool database::update_contract_activate_status(const contract_addr_type & contra
     } FC_CAPTURE_AND_RETHROW((contract_addr)(activated))
 }
 
+contract_code_id_type database::store_contract_code(const string & bytecode, const string & abi_json)
+{
+    try
+    {
+        optional<contract_abi> abi;
+        try
+        {
+            abi = contract_abi::parse(abi_json);
+        }
+        catch (const fc::exception&)
+        {
+            // before the hardfork the ABI is not interpreted, any string is accepted
+            if (head_block_time() >= HARDFORK_CONTRACT_ABI_TIME)
+                throw;
+        }
+
+        const fc::sha256 code_hash = contract_code_object::hash(bytecode, abi_json);
+        const uint8_t vm_version = head_block_time() >= HARDFORK_CONTRACT_ABI_TIME ? 1 : 0;
+        const auto & index = get_index_type<contract_code_index>().indices().get<by_code_hash>();
+        auto itr = index.find(boost::make_tuple(code_hash, vm_version));
+        if (itr != index.end())
+            return itr->id;
+
+        return create<contract_code_object>(
+            [&](contract_code_object & c)
+            {
+                c.code_hash  = code_hash;
+                c.bytecode   = bytecode;
+                c.abi_json   = abi_json;
+                c.abi        = std::move(abi);
+                c.vm_version = vm_version;
+            }
+        ).id;
+    } FC_CAPTURE_AND_RETHROW((bytecode.size())(abi_json.size()))
+}
+
+bool database::release_contract_code(contract_code_id_type code)
+{
+    try
+    {
+        const auto & users = get_index_type<contract_index>().indices().get<by_contract_code>();
+        if (users.find(code) != users.end())
+            return false;
+
+        const contract_code_object * code_obj = find(code);
+        if (code_obj == nullptr)
+            return false;
+        remove(*code_obj);
+        return true;
+    } FC_CAPTURE_AND_RETHROW((code))
+}
+
 
 asset database::get_balance(account_id_type owner, asset_id_type asset_id) const
 {
@@ -142,60 +142,7 @@ bool database::_push_block(const signed_block& new_block)
          //Only switch forks if new_head is actually higher than head
          if( new_head->data.block_num() > head_block_num() )
          {
-            wlog( "Switching to fork: ${id}", ("id",new_head->data.id()) );
-            auto branches = _fork_db.fetch_branch_from(new_head->data.id(), head_block_id());
-
-            // pop blocks until we hit the forked block
-            while( head_block_id() != branches.second.back()->data.previous )
-            {
-               ilog( "popping block #${n} ${id}", ("n",head_block_num())("id",head_block_id()) );
-               pop_block();
-            }
-
-            // push all blocks on the new fork
-            for( auto ritr = branches.first.rbegin(); ritr != branches.first.rend(); ++ritr )
-            {
-                ilog( "pushing block from fork #${n} ${id}", ("n",(*ritr)->data.block_num())("id",(*ritr)->id) );
-                optional<fc::exception> except;
-                try {
-                   undo_database::session session = _undo_db.start_undo_session();
-                   apply_block( (*ritr)->data, skip );
-                   _block_id_to_block.store( (*ritr)->id, (*ritr)->data );
-                   session.commit();
-                }
-                catch ( const fc::exception& e ) { except = e; }
-                if( except )
-                {
-                   wlog( "exception thrown while switching forks ${e}", ("e",except->to_detail_string() ) );
-                   // remove the rest of branches.first from the fork_db, those blocks are invalid
-                   while( ritr != branches.first.rend() )
-                   {
-                      ilog( "removing block from fork_db #${n} ${id}", ("n",(*ritr)->data.block_num())("id",(*ritr)->id) );
-                      _fork_db.remove( (*ritr)->id );
-                      ++ritr;
-                   }
-                   _fork_db.set_head( branches.second.front() );
-
-                   // pop all blocks from the bad fork
-                   while( head_block_id() != branches.second.back()->data.previous )
-                   {
-                      ilog( "popping block #${n} ${id}", ("n",head_block_num())("id",head_block_id()) );
-                      pop_block();
-                   }
-
-                   ilog( "Switching back to fork: ${id}", ("id",branches.second.front()->data.id()) );
-                   // restore all blocks from the good fork
-                   for( auto ritr2 = branches.second.rbegin(); ritr2 != branches.second.rend(); ++ritr2 )
-                   {
-                      ilog( "pushing block #${n} ${id}", ("n",(*ritr2)->data.block_num())("id",(*ritr2)->id) );
-                      auto session = _undo_db.start_undo_session();
-                      apply_block( (*ritr2)->data, skip );
-                      _block_id_to_block.store( (*ritr2)->id, (*ritr2)->data );
-                      session.commit();
-                   }
-                   throw *except;
-                }
-            }
+            switch_forks( new_head, skip );
             return true;
          }
          else return false;
@@ -216,6 +163,138 @@ bool database::_push_block(const signed_block& new_block)
    return false;
 } FC_CAPTURE_AND_RETHROW( (new_block) ) }
 
+/**
+ * Switches the chain to the branch ending at new_head.
+ *
+ * The blocks of the new branch are first checked for everything that does not depend on chain
+ * state, so that an obviously bad branch is rejected before any block of the current branch is
+ * popped.  The new branch is then applied with one undo session per block, and the sessions are
+ * only committed once every block has been applied.  If a block fails, the partially applied
+ * branch is unwound in memory and the original branch is restored.
+ */
+void database::switch_forks( const item_ptr& new_head, uint32_t skip )
+{
+   const fc::time_point start = fc::time_point::now();
+   wlog( "Switching to fork: ${id}", ("id",new_head->data.id()) );
+   auto branches = _fork_db.fetch_branch_from(new_head->data.id(), head_block_id());
+   const block_id_type fork_point = branches.first.back()->data.previous;
+   const item_ptr old_head = _fork_db.fetch_block( head_block_id() );
+
+   auto remove_from_fork_db = [&]( fork_database::branch_type::reverse_iterator ritr )
+   {
+      // remove the rest of branches.first from the fork_db, those blocks are invalid
+      for( ; ritr != branches.first.rend(); ++ritr )
+      {
+         ilog( "removing block from fork_db #${n} ${id}", ("n",(*ritr)->data.block_num())("id",(*ritr)->id) );
+         _fork_db.remove( (*ritr)->id );
+      }
+      if( old_head )
+         _fork_db.set_head( old_head );
+   };
+
+   for( auto ritr = branches.first.rbegin(); ritr != branches.first.rend(); ++ritr )
+   {
+      optional<fc::exception> except;
+      try {
+         precheck_fork_block( (*ritr)->data, ritr == branches.first.rbegin() ? nullptr : &(*(ritr-1))->data, skip );
+      }
+      catch ( const fc::exception& e ) { except = e; }
+      if( except )
+      {
+         wlog( "rejected fork before switching ${e}", ("e",except->to_detail_string() ) );
+         remove_from_fork_db( ritr );
+         _apply_stats.fork_switches().record( 0, 0, false, ( fc::time_point::now() - start ).count() );
+         throw *except;
+      }
+   }
+
+   // pop blocks until we hit the forked block
+   uint32_t popped = 0;
+   while( head_block_id() != fork_point )
+   {
+      ilog( "popping block #${n} ${id}", ("n",head_block_num())("id",head_block_id()) );
+      pop_block();
+      ++popped;
+   }
+
+   // apply all blocks on the new fork, each in its own undo session which is only committed
+   // after the whole branch has been applied
+   vector<undo_database::session> sessions;
+   sessions.reserve( branches.first.size() );
+   optional<fc::exception> except;
+   auto ritr = branches.first.rbegin();
+   for( ; ritr != branches.first.rend(); ++ritr )
+   {
+      ilog( "pushing block from fork #${n} ${id}", ("n",(*ritr)->data.block_num())("id",(*ritr)->id) );
+      try {
+         sessions.emplace_back( _undo_db.start_undo_session() );
+         apply_block( (*ritr)->data, skip );
+      }
+      catch ( const fc::exception& e ) { except = e; break; }
+   }
+
+   if( !except )
+   {
+      for( auto& session : sessions )
+         session.commit();
+      for( auto ritr2 = branches.first.rbegin(); ritr2 != branches.first.rend(); ++ritr2 )
+         _block_id_to_block.store( (*ritr2)->id, (*ritr2)->data );
+
+      fc::microseconds elapsed = fc::time_point::now() - start;
+      _apply_stats.fork_switches().record( popped, branches.first.size(), true, elapsed.count() );
+      ilog( "Switched to fork ${id}, popped ${p} blocks and pushed ${n} blocks in ${t}us",
+            ("id",new_head->data.id())("p",popped)("n",branches.first.size())("t",elapsed.count()) );
+      return;
+   }
+
+   wlog( "exception thrown while switching forks ${e}", ("e",except->to_detail_string() ) );
+
+   // the transactions of the blocks that applied go back to the pending pool, as if they were popped
+   vector<signed_transaction> unwound;
+   for( auto ritr2 = branches.first.rbegin(); ritr2 != ritr; ++ritr2 )
+      unwound.insert( unwound.end(), (*ritr2)->data.transactions.begin(), (*ritr2)->data.transactions.end() );
+   _popped_tx.insert( _popped_tx.begin(), unwound.begin(), unwound.end() );
+
+   remove_from_fork_db( ritr );
+
+   // unwind the blocks of the bad fork that were applied, newest first
+   while( !sessions.empty() )
+   {
+      sessions.back().undo();
+      sessions.pop_back();
+   }
+
+   ilog( "Switching back to fork: ${id}", ("id",head_block_id()) );
+   // restore all blocks from the good fork
+   for( auto ritr2 = branches.second.rbegin(); ritr2 != branches.second.rend(); ++ritr2 )
+   {
+      ilog( "pushing block #${n} ${id}", ("n",(*ritr2)->data.block_num())("id",(*ritr2)->id) );
+      auto session = _undo_db.start_undo_session();
+      apply_block( (*ritr2)->data, skip );
+      _block_id_to_block.store( (*ritr2)->id, (*ritr2)->data );
+      session.commit();
+   }
+
+   _apply_stats.fork_switches().record( popped, 0, false, ( fc::time_point::now() - start ).count() );
+   throw *except;
+}
+
+/**
+ * Checks that do not depend on chain state, run on every block of a fork before switching to it.
+ */
+void database::precheck_fork_block( const signed_block& b, const signed_block* previous, uint32_t skip )const
+{
+   FC_ASSERT( (skip & skip_merkle_check) || b.transaction_merkle_root == b.calculate_merkle_root(), "",
+              ("b.transaction_merkle_root",b.transaction_merkle_root)("calc",b.calculate_merkle_root())("id",b.id()) );
+   if( previous != nullptr )
+   {
+      FC_ASSERT( b.previous == previous->id(), "", ("b.previous",b.previous)("previous",previous->id()) );
+      FC_ASSERT( b.timestamp > previous->timestamp, "", ("b.timestamp",b.timestamp)("previous",previous->timestamp) );
+   }
+   for( const auto& trx : b.transactions )
+      trx.validate();
+}
+
 /**
  * Attempts to push the transaction into the pending queue
  *
@@ -457,6 +536,10 @@ void database::pop_block()
 
    _popped_tx.insert( _popped_tx.begin(), head_block->transactions.begin(), head_block->transactions.end() );
 
+   // readers must not keep seeing the popped block until the next one is applied
+   if( snapshots_enabled() )
+      publish_snapshot( head_block_num() );
+
 } FC_CAPTURE_AND_RETHROW() }
 
 void database::clear_pending()
@@ -516,6 +599,7 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
 
 void database::_apply_block( const signed_block& next_block )
 { try {
+   scoped_latency_timer block_timer( _apply_stats.blocks() );
    uint32_t next_block_num = next_block.block_num();
    uint32_t skip = get_node_properties().skip_flags;
    _applied_ops.clear();
@@ -532,18 +616,34 @@ void database::_apply_block( const signed_block& next_block )
 
    _issue_453_affected_assets.clear();
 
-   for( const auto& trx : next_block.transactions )
+   if( _contract_scheduler.thread_count() > 0 )
    {
-      /* We do not need to push the undo state for each transaction
-       * because they either all apply and are valid or the
-       * entire block fails to apply.  We only need an "undo" state
-       * for transactions when validating broadcast transactions or
-       * when building a block.
-       */
-      apply_transaction( trx, skip );
-      ++_current_trx_in_block;
+      scoped_latency_timer speculation_timer( _apply_stats.signal_handler( "contract_speculation" ) );
+      _contract_scheduler.speculate( *this, next_block );
    }
 
+   try
+   {
+      for( const auto& trx : next_block.transactions )
+      {
+         /* We do not need to push the undo state for each transaction
+          * because they either all apply and are valid or the
+          * entire block fails to apply.  We only need an "undo" state
+          * for transactions when validating broadcast transactions or
+          * when building a block.
+          */
+         apply_transaction( trx, skip );
+         ++_current_trx_in_block;
+      }
+   }
+   catch( ... )
+   {
+      // speculative results must not leak into the next block applied at the same positions
+      _contract_scheduler.clear();
+      throw;
+   }
+   _contract_scheduler.clear();
+
    const uint32_t missed = update_witness_missed_blocks( next_block );
    update_global_dynamic_data( next_block, missed );
    update_signing_witness(signing_witness, next_block);
@@ -572,10 +672,25 @@ void database::_apply_block( const signed_block& next_block )
       apply_debug_updates();
 
    // notify observers that the block has been applied
-   notify_applied_block( next_block ); //emit
+   {
+      scoped_latency_timer notify_timer( _apply_stats.signal_handler( "applied_block" ) );
+      notify_applied_block( next_block ); //emit
+   }
    _applied_ops.clear();
 
-   notify_changed_objects();
+   {
+      scoped_latency_timer notify_timer( _apply_stats.signal_handler( "changed_objects" ) );
+      notify_changed_objects();
+   }
+
+   if( snapshots_enabled() )
+   {
+      scoped_latency_timer snapshot_timer( _apply_stats.signal_handler( "publish_snapshot" ) );
+      publish_snapshot( next_block_num );
+   }
+
+   if( _apply_stats_log_interval > 0 && next_block_num % _apply_stats_log_interval == 0 )
+      ilog( "Apply statistics at block #${n}: ${s}", ("n", next_block_num)("s", _apply_stats.summary()) );
 } FC_CAPTURE_AND_RETHROW( (next_block.block_num()) )  }
 
 
@@ -592,6 +707,7 @@ processed_transaction database::apply_transaction(const signed_transaction& trx,
 
 processed_transaction database::_apply_transaction(const signed_transaction& trx)
 { try {
+   scoped_latency_timer trx_timer( _apply_stats.transactions() );
    uint32_t skip = get_node_properties().skip_flags;
 
    if( true || !(skip&skip_validate) )   /* issue #505 explains why this skip_flag is disabled */
@@ -673,6 +789,7 @@ operation_result database::apply_operation(transaction_evaluation_state& eval_st
    unique_ptr<op_evaluator>& eval = _operation_evaluators[ u_which ];
    FC_ASSERT( eval, "No registered evaluator for operation ${op}", ("op",op) );
    auto op_id = push_applied_operation( op );
+   scoped_latency_timer op_timer( _apply_stats.operation( i_which ) );
    auto result = eval->evaluate( eval_state, op, true );
    set_applied_operation_result( op_id, result );
    return result;
@@ -24,8 +24,11 @@
 
 #include <graphene/chain/database.hpp>
 
+#include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/chain_property_object.hpp>
+#include <graphene/chain/contract_code_object.hpp>
+#include <graphene/chain/contract_engine.hpp>
 #include <graphene/chain/global_property_object.hpp>
 
 #include <fc/smart_ref_impl.hpp>
@@ -115,4 +118,24 @@ const witness_schedule_object& database::get_witness_schedule_object()const
    return *_p_witness_schedule_obj;
 }
 
+string database::call_contract_readonly( const contract_addr_type& contract_addr, const string& call_data )
+{
+   const auto& contracts = get_index_type<contract_index>().indices().get<by_contract_addr>();
+   auto itr = contracts.find( contract_addr );
+   FC_ASSERT( itr != contracts.end(), "smart contract not found: ${a}", ("a", contract_addr) );
+   FC_ASSERT( itr->activated, "smart contract must be activated before calling it" );
+
+   const contract_object& contract = *itr;
+   const contract_code_object& code = contract.get_code( *this );
+   if( code.vm_version > 0 )
+      code.abi->dispatch( call_data );
+   auto compiled = _contract_cache.get( contract_addr, [&]() {
+      return _contract_engine->compile( contract.contract_addr, code );
+   });
+
+   contract_gas_meter meter( GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT );
+   contract_storage storage( *this, contract_addr, &meter, true );
+   return _contract_engine->query( *compiled, call_data, storage, meter );
+}
+
 } }
@@ -35,9 +35,12 @@
 #include <graphene/chain/chain_property_object.hpp>
 #include <graphene/chain/committee_member_object.hpp>
 #include <graphene/chain/confidential_object.hpp>
+#include <graphene/chain/contract_storage_object.hpp>
+#include <graphene/chain/contract_code_object.hpp>
 #include <graphene/chain/fba_object.hpp>
 #include <graphene/chain/global_property_object.hpp>
 #include <graphene/chain/market_object.hpp>
+#include <graphene/chain/pio_contribution_object.hpp>
 #include <graphene/chain/operation_history_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
 #include <graphene/chain/special_authority_object.hpp>
@@ -197,6 +200,9 @@ void database::initialize_indexes()
    auto acnt_index = add_index< primary_index<account_index> >();
    acnt_index->add_secondary_index<account_member_index>();
    acnt_index->add_secondary_index<account_referrer_index>();
+   // API readers resolve account names in the published snapshot
+   add_snapshot_key( account_object::space_id, account_object::type_id,
+                     []( const object& o ) { return static_cast<const account_object&>( o ).name; } );
 
    add_index< primary_index<committee_member_index> >();
    add_index< primary_index<witness_index> >();
@@ -230,6 +236,10 @@ void database::initialize_indexes()
    add_index< primary_index< special_authority_index                      > >();
    add_index< primary_index< buyback_index                                > >();
    add_index< primary_index<collateral_bid_index                          > >();
+   add_index< primary_index<contract_storage_index                        > >();
+   add_index< primary_index<contract_code_index                           > >();
+   add_index< primary_index<pio_contribution_index                        > >();
+   add_index< primary_index<pio_epoch_index                               > >();
 
    add_index< primary_index< simple_index< fba_accumulator_object       > > >();
 }
@@ -40,6 +40,7 @@
 #include <graphene/chain/fba_object.hpp>
 #include <graphene/chain/global_property_object.hpp>
 #include <graphene/chain/market_object.hpp>
+#include <graphene/chain/pio_contribution_object.hpp>
 #include <graphene/chain/special_authority_object.hpp>
 #include <graphene/chain/vesting_balance_object.hpp>
 #include <graphene/chain/vote_count.hpp>
@@ -1075,12 +1076,64 @@ void process_hf_935( database& db )
    }
 }
 
+/**
+ * Closes the current PIO epoch: its totals are recorded in a pio_epoch_object and the next
+ * epoch starts collecting.  Only the entries of the closing epoch and of the epoch falling out
+ * of the retention window are visited.
+ */
+void database::roll_up_pio_contributions()
+{
+   const dynamic_global_property_object& dgpo = get_dynamic_global_properties();
+   const uint32_t epoch = dgpo.current_pio_epoch;
+
+   const auto& by_contribution = get_index_type<pio_contribution_index>().indices().get<by_epoch_contribution>();
+   uint64_t total_contribution = 0;
+   uint32_t contributors = 0;
+   uint32_t reports = 0;
+   for( auto itr = by_contribution.lower_bound( epoch ); itr != by_contribution.end() && itr->epoch == epoch; ++itr )
+   {
+      total_contribution += itr->contribution;
+      reports += itr->reports;
+      ++contributors;
+   }
+
+   create<pio_epoch_object>( [&]( pio_epoch_object& e ) {
+      e.epoch = epoch;
+      e.end_time = head_block_time();
+      e.total_contribution = total_contribution;
+      e.contributors = contributors;
+      e.reports = reports;
+   });
+
+   if( epoch >= GRAPHENE_PIO_CONTRIBUTION_EPOCHS )
+   {
+      const uint32_t expired = epoch - GRAPHENE_PIO_CONTRIBUTION_EPOCHS;
+      for( auto itr = by_contribution.lower_bound( expired ); itr != by_contribution.end() && itr->epoch == expired; )
+      {
+         const auto& c = *itr;
+         ++itr;
+         remove( c );
+      }
+   }
+
+   modify( dgpo, []( dynamic_global_property_object& d ) {
+      ++d.current_pio_epoch;
+   });
+}
+
 void database::perform_chain_maintenance(const signed_block& next_block, const global_property_object& global_props)
 {
+   scoped_latency_timer maint_timer( _apply_stats.maintenance_phase( "total" ) );
    const auto& gpo = get_global_properties();
 
-   distribute_fba_balances(*this);
-   create_buyback_orders(*this);
+   {
+      scoped_latency_timer timer( _apply_stats.maintenance_phase( "distribute_fba_balances" ) );
+      distribute_fba_balances(*this);
+   }
+   {
+      scoped_latency_timer timer( _apply_stats.maintenance_phase( "create_buyback_orders" ) );
+      create_buyback_orders(*this);
+   }
 
    struct vote_tally_helper {
       database& d;
@@ -1147,7 +1200,10 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
       }
    } tally_helper(*this, gpo);
 
-   perform_account_maintenance( tally_helper );
+   {
+      scoped_latency_timer timer( _apply_stats.maintenance_phase( "account_maintenance" ) );
+      perform_account_maintenance( tally_helper );
+   }
 
    struct clear_canary {
       clear_canary(vector<uint64_t>& target): target(target){}
@@ -1159,10 +1215,26 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
                 b(_committee_count_histogram_buffer),
                 c(_vote_tally_buffer);
 
-   update_top_n_authorities(*this);
-   update_active_witnesses();
-   update_active_committee_members();
-   update_worker_votes();
+   {
+      scoped_latency_timer timer( _apply_stats.maintenance_phase( "update_top_n_authorities" ) );
+      update_top_n_authorities(*this);
+   }
+   {
+      scoped_latency_timer timer( _apply_stats.maintenance_phase( "update_active_witnesses" ) );
+      update_active_witnesses();
+   }
+   {
+      scoped_latency_timer timer( _apply_stats.maintenance_phase( "update_active_committee_members" ) );
+      update_active_committee_members();
+   }
+   {
+      scoped_latency_timer timer( _apply_stats.maintenance_phase( "update_worker_votes" ) );
+      update_worker_votes();
+   }
+   {
+      scoped_latency_timer timer( _apply_stats.maintenance_phase( "roll_up_pio_contributions" ) );
+      roll_up_pio_contributions();
+   }
 
    const dynamic_global_property_object& dgpo = get_dynamic_global_properties();
 
@@ -1234,11 +1306,17 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
    if( to_update_and_match_call_orders )
       update_and_match_call_orders(*this);
 
-   process_bitassets();
+   {
+      scoped_latency_timer timer( _apply_stats.maintenance_phase( "process_bitassets" ) );
+      process_bitassets();
+   }
 
    // process_budget needs to run at the bottom because
    //   it needs to know the next_maintenance_time
-   process_budget();
+   {
+      scoped_latency_timer timer( _apply_stats.maintenance_phase( "process_budget" ) );
+      process_budget();
+   }
 }
 
 } }
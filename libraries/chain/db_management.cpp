@@ -28,6 +28,7 @@
 #include <graphene/chain/witness_schedule_object.hpp>
 #include <graphene/chain/special_authority_object.hpp>
 #include <graphene/chain/operation_history_object.hpp>
+#include <graphene/chain/wren_contract_engine.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
 #include <fc/io/fstream.hpp>
@@ -42,6 +43,7 @@ database::database()
 {
    initialize_indexes();
    initialize_evaluators();
+   set_contract_engine( nullptr );
 }
 
 database::~database()
@@ -49,6 +51,12 @@ database::~database()
    clear_pending();
 }
 
+void database::set_contract_engine( const std::shared_ptr<contract_engine>& engine )
+{
+   _contract_engine = engine ? engine : std::make_shared<wren_contract_engine>();
+   _contract_cache.clear();
+}
+
 void database::reindex( fc::path data_dir )
 { try {
    auto last_block = _block_id_to_block.last();
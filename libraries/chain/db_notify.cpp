@@ -38,6 +38,7 @@
 #include <graphene/chain/operation_history_object.hpp>
 #include <graphene/chain/vesting_balance_object.hpp>
 #include <graphene/chain/transaction_object.hpp>
+#include <graphene/chain/pio_contribution_object.hpp>
 #include <graphene/chain/impacted.hpp>
 
 using namespace fc;
@@ -443,6 +444,18 @@ void get_relevant_accounts( const object* obj, flat_set<account_id_type>& accoun
               accounts.insert( aobj->bidder );
               break;
            }
+             case impl_contract_storage_object_type:
+              break;
+             case impl_contract_code_object_type:
+              break;
+             case impl_pio_contribution_object_type:{
+              const auto& aobj = dynamic_cast<const pio_contribution_object*>(obj);
+              FC_ASSERT( aobj != nullptr );
+              accounts.insert( aobj->account );
+              break;
+           }
+             case impl_pio_epoch_object_type:
+              break;
       }
    }
 } // end get_relevant_accounts( const object* obj, flat_set<account_id_type>& accounts )
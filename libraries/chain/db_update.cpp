@@ -66,6 +66,7 @@ void database::update_global_dynamic_data( const signed_block& b, const uint32_t
            (dgp.recent_slots_filled << 1)
            + 1) << missed_blocks;
       dgp.current_aslot += missed_blocks+1;
+      dgp.contract_gas_used = 0;
    });
 
    if( !(get_node_properties().skip_flags & skip_undo_history_check) )
@@ -90,6 +90,15 @@ fc::variant_object get_config()
    result[ "GRAPHENE_DEFAULT_WITNESS_PAY_PER_BLOCK" ] = GRAPHENE_DEFAULT_WITNESS_PAY_PER_BLOCK;
    result[ "GRAPHENE_DEFAULT_WITNESS_PAY_VESTING_SECONDS" ] = GRAPHENE_DEFAULT_WITNESS_PAY_VESTING_SECONDS;
    result[ "GRAPHENE_DEFAULT_WORKER_BUDGET_PER_DAY" ] = GRAPHENE_DEFAULT_WORKER_BUDGET_PER_DAY;
+   result[ "GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT" ] = GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT;
+   result[ "GRAPHENE_DEFAULT_CONTRACT_BLOCK_GAS_LIMIT" ] = GRAPHENE_DEFAULT_CONTRACT_BLOCK_GAS_LIMIT;
+   result[ "GRAPHENE_DEFAULT_CONTRACT_CALL_MEMORY_LIMIT" ] = GRAPHENE_DEFAULT_CONTRACT_CALL_MEMORY_LIMIT;
+   result[ "GRAPHENE_DEFAULT_CONTRACT_PRICE_PER_KGAS" ] = GRAPHENE_DEFAULT_CONTRACT_PRICE_PER_KGAS;
+   result[ "GRAPHENE_CONTRACT_GAS_PER_EVENT" ] = GRAPHENE_CONTRACT_GAS_PER_EVENT;
+   result[ "GRAPHENE_CONTRACT_MAX_VM_ALLOCATION" ] = GRAPHENE_CONTRACT_MAX_VM_ALLOCATION;
+   result[ "GRAPHENE_CONTRACT_GAS_PER_TOKEN" ] = GRAPHENE_CONTRACT_GAS_PER_TOKEN;
+   result[ "GRAPHENE_CONTRACT_GAS_PER_HEAP_BYTE" ] = GRAPHENE_CONTRACT_GAS_PER_HEAP_BYTE;
+   result[ "GRAPHENE_PIO_CONTRIBUTION_EPOCHS" ] = GRAPHENE_PIO_CONTRIBUTION_EPOCHS;
    result[ "GRAPHENE_COMMITTEE_ACCOUNT" ] = fc::variant(GRAPHENE_COMMITTEE_ACCOUNT, GRAPHENE_MAX_NESTED_OBJECTS);
    result[ "GRAPHENE_WITNESS_ACCOUNT" ] = fc::variant(GRAPHENE_WITNESS_ACCOUNT, GRAPHENE_MAX_NESTED_OBJECTS);
    result[ "GRAPHENE_RELAXED_COMMITTEE_ACCOUNT" ] = fc::variant(GRAPHENE_RELAXED_COMMITTEE_ACCOUNT, GRAPHENE_MAX_NESTED_OBJECTS);
@@ -78,6 +78,7 @@ public:
    void_result do_evaluate(const smart_contract_deploy_operation& o);
    object_id_type do_apply(const smart_contract_deploy_operation& o);
 private:
+    friend class wren_contract_engine;
     string construct_smart_contract(const string &bytecode,
                                     const contract_addr_type &contract_addr,
                                     const string &construct_data,
@@ -117,8 +118,9 @@ public:
    typedef smart_contract_call_operation operation_type;
 
    void_result do_evaluate(const smart_contract_call_operation& o);
-   void_result do_apply(const smart_contract_call_operation& o);
+   operation_result do_apply(const smart_contract_call_operation& o);
 private:
+    friend class wren_contract_engine;
     string call_smart_contract(const string &bytecode,
                                  const contract_addr_type &contract_addr,
                                  const string &call_data,
@@ -430,27 +430,32 @@ namespace graphene { namespace chain {
 
          account_id_type          owner;         
          contract_addr_type       contract_addr;
-         string                   bytecode;
-         string                   abi_json;
+         /// bytecode and ABI, shared by every contract deployed with the same ones
+         contract_code_id_type    code;
+         /// arguments the contract was constructed with, contract_addr is the hash of the code and these
          string                   construct_data;
          string                   contract_name;
          uint8_t                  state;
          bool                     activated;
-         string                   contract_state;
 
          typedef account_options  options_type;
          options_type options;
 
          contract_id_type get_id()const { return id; }
+
+         template<class DB>
+         const contract_code_object& get_code(const DB& db)const { return db.get(code); }
    };
 
    struct by_contract_addr {};
+   struct by_contract_code {};
 
    typedef multi_index_container<
       contract_object,
       indexed_by<
       ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
-      ordered_unique< tag<by_contract_addr>, member< contract_object, contract_addr_type, &contract_object::contract_addr >>
+      ordered_unique< tag<by_contract_addr>, member< contract_object, contract_addr_type, &contract_object::contract_addr >>,
+      ordered_non_unique< tag<by_contract_code>, member< contract_object, contract_code_id_type, &contract_object::code >>
       >
    > contract_multi_index_type;
 
@@ -490,10 +495,8 @@ FC_REFLECT_DERIVED( graphene::chain::contract_object,
                    (graphene::db::object),
                    (owner)
                    (contract_addr)
-                   (bytecode)
-                   (abi_json)
+                   (code)
                    (construct_data)
                    (contract_name)
                    (activated)
-                   (contract_state)
                   )
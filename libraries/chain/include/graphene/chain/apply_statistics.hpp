@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <fc/time.hpp>
+#include <fc/variant_object.hpp>
+
+#include <array>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Fixed-size latency histogram with power-of-two microsecond buckets
+    *
+    * Bucket 0 counts samples below 1us, bucket i (i > 0) counts samples in [2^(i-1), 2^i) us,
+    * and the last bucket collects everything above its lower bound.  Recording a sample is a
+    * handful of integer operations, so histograms can stay enabled on the block apply path.
+    */
+   struct latency_histogram
+   {
+      static const size_t bucket_count = 25; ///< the last bucket starts at 2^23 us, about 8.4 seconds
+
+      uint64_t                                count    = 0;
+      uint64_t                                total_us = 0;
+      uint64_t                                max_us   = 0;
+      std::array<uint64_t, bucket_count>      buckets  = {};
+
+      void record( int64_t elapsed_us );
+      void reset() { *this = latency_histogram(); }
+
+      /// @return upper bound in microseconds of the bucket containing the given percentile (0-100)
+      uint64_t percentile( double pct )const;
+      uint64_t mean_us()const { return count ? total_us / count : 0; }
+
+      fc::mutable_variant_object to_variant()const;
+   };
+
+   /**
+    * @brief Counters describing fork switches performed by database::_push_block()
+    */
+   struct fork_switch_statistics
+   {
+      uint64_t           count         = 0; ///< fork switches attempted
+      uint64_t           failed        = 0; ///< attempts that ended on the original branch
+      uint64_t           blocks_popped = 0;
+      uint64_t           blocks_pushed = 0;
+      uint32_t           max_depth     = 0; ///< largest number of blocks popped by a single switch
+      latency_histogram  latency;
+
+      void record( uint32_t popped, uint32_t pushed, bool success, int64_t elapsed_us );
+      void reset() { *this = fork_switch_statistics(); }
+
+      fc::mutable_variant_object to_variant()const;
+   };
+
+   /**
+    * @brief Records elapsed time into a histogram when it goes out of scope
+    */
+   class scoped_latency_timer
+   {
+      public:
+         explicit scoped_latency_timer( latency_histogram& histogram )
+            : _histogram( histogram ), _start( fc::time_point::now() ) {}
+         ~scoped_latency_timer()
+         {
+            _histogram.record( ( fc::time_point::now() - _start ).count() );
+         }
+      private:
+         latency_histogram& _histogram;
+         fc::time_point     _start;
+   };
+
+   /**
+    * @class apply_statistics
+    * @brief Always-on counters and latency histograms for the block apply pipeline
+    *
+    * Tracks time spent applying blocks, transactions and operations (per evaluator type),
+    * in each named observer of the database signals, and in each phase of chain maintenance.
+    *
+    * Histograms are never erased once created (reset() only zeroes them), so references
+    * handed out by the accessors stay valid for the lifetime of this object.
+    */
+   class apply_statistics
+   {
+      public:
+         latency_histogram& blocks()       { return _blocks; }
+         latency_histogram& transactions() { return _transactions; }
+         latency_histogram& operation( int which );
+         latency_histogram& signal_handler( const std::string& name ) { return _signal_handlers[name]; }
+         latency_histogram& maintenance_phase( const std::string& name ) { return _maintenance_phases[name]; }
+         fork_switch_statistics& fork_switches() { return _fork_switches; }
+         const fork_switch_statistics& fork_switches()const { return _fork_switches; }
+
+         void reset();
+
+         /// Full dump, suitable for returning through the API
+         fc::variant_object to_variant()const;
+
+         /// One-line summary of the slowest entries, used for periodic logging
+         std::string summary( size_t top_n = 5 )const;
+
+      private:
+         latency_histogram                          _blocks;
+         latency_histogram                          _transactions;
+         std::vector<latency_histogram>             _operations;
+         std::map<std::string, latency_histogram>   _signal_handlers;
+         std::map<std::string, latency_histogram>   _maintenance_phases;
+         fork_switch_statistics                     _fork_switches;
+   };
+
+   /**
+    * @brief Signal handler wrapper that records the run time of the wrapped callable
+    *
+    * Created through database::timed_handler(), so that every observer connected to
+    * applied_block and friends shows up under its own name in the apply statistics.
+    */
+   template<typename Handler>
+   struct timed_signal_handler
+   {
+      latency_histogram* histogram;
+      Handler            handler;
+
+      template<typename... Args>
+      void operator()( Args&&... args )
+      {
+         scoped_latency_timer timer( *histogram );
+         handler( std::forward<Args>(args)... );
+      }
+   };
+
+} } // graphene::chain
@@ -121,7 +121,35 @@
 #define GRAPHENE_RECENTLY_MISSED_COUNT_INCREMENT             4
 #define GRAPHENE_RECENTLY_MISSED_COUNT_DECREMENT             3
 
-#define GRAPHENE_CURRENT_DB_VERSION                          "BTS2.17"
+/**
+ *  Smart contract execution budget, enforced from HARDFORK_CONTRACT_GAS_TIME.  Gas is counted
+ *  deterministically: engines charge VM instructions, contract storage charges reads and writes.
+ *  wren_vm charges the source tokens of every block a contract enters and the bytes it allocates;
+ *  contracts deployed before HARDFORK_CONTRACT_ABI_TIME run in the legacy binding, which only
+ *  charges the bytes it parses up front and the state it stores afterwards.
+ *
+ *  The block budget is chain_parameters::contract_block_gas_limit(), the committee may change it.
+ */
+///@{
+#define GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT             (10*1000*1000)
+#define GRAPHENE_DEFAULT_CONTRACT_BLOCK_GAS_LIMIT            (100*1000*1000) ///< until the committee sets another
+#define GRAPHENE_DEFAULT_CONTRACT_CALL_MEMORY_LIMIT          (16*1024*1024) ///< VM heap cap in bytes
+#define GRAPHENE_CONTRACT_MAX_VM_ALLOCATION                  (64*1024) ///< largest single allocation of a wren_vm call
+#define GRAPHENE_CONTRACT_GAS_PER_TOKEN                      20  ///< per source token of each block wren_vm enters
+#define GRAPHENE_CONTRACT_GAS_PER_HEAP_BYTE                  1   ///< per byte wren_vm allocates
+#define GRAPHENE_DEFAULT_CONTRACT_PRICE_PER_KGAS             (GRAPHENE_BLOCKCHAIN_PRECISION/100) ///< CORE per 1000 gas
+#define GRAPHENE_CONTRACT_GAS_PER_CALL                       1000
+#define GRAPHENE_CONTRACT_GAS_PER_BYTE                       1
+#define GRAPHENE_CONTRACT_GAS_PER_STORAGE_READ               200
+#define GRAPHENE_CONTRACT_GAS_PER_STORAGE_WRITE              2000
+#define GRAPHENE_CONTRACT_GAS_PER_STORED_BYTE                10
+#define GRAPHENE_CONTRACT_GAS_PER_EVENT                      500
+///@}
+
+/// Number of finished PIO epochs whose per-account contributions are kept, older epochs only keep their totals
+#define GRAPHENE_PIO_CONTRIBUTION_EPOCHS                     30
+
+#define GRAPHENE_CURRENT_DB_VERSION                          "BTS2.24"
 
 #define GRAPHENE_IRREVERSIBLE_THRESHOLD                      (70 * GRAPHENE_1_PERCENT)
 
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/apply_statistics.hpp>
+#include <graphene/chain/contract_engine.hpp>
+
+#include <functional>
+#include <list>
+#include <map>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @class contract_cache
+    * @brief Bounded LRU cache of compiled smart contracts, keyed by contract address
+    *
+    * A contract address is the hash of the bytecode, ABI and construct data, so a cached entry
+    * can never go stale; entries only leave the cache when evicted or when the contract is killed.
+    * Undoing a kill simply leads to a cache miss on the next call.
+    *
+    * Every entry remembers how long it took to compile, a hit saves that much, which is what
+    * compile_saved_us adds up.
+    */
+   class contract_cache
+   {
+      public:
+         typedef std::function<compiled_contract_ptr()> compile_function;
+
+         explicit contract_cache( size_t capacity = 64 ) : _capacity( capacity ) {}
+
+         /// @return the cached contract, compiling and inserting it on a miss
+         compiled_contract_ptr get( const contract_addr_type& contract_addr, const compile_function& compile );
+
+         void invalidate( const contract_addr_type& contract_addr );
+         void clear();
+
+         /// 0 disables caching, every get() compiles
+         void   set_capacity( size_t capacity );
+         size_t capacity()const { return _capacity; }
+         size_t size()const { return _entries.size(); }
+
+         uint64_t hits()const { return _hits; }
+         uint64_t misses()const { return _misses; }
+         const latency_histogram& compile_latency()const { return _compile_latency; }
+
+         fc::variant_object to_variant()const;
+
+      private:
+         struct entry
+         {
+            contract_addr_type     contract_addr;
+            compiled_contract_ptr  compiled;
+            int64_t                compile_us;
+         };
+         typedef std::list<entry> lru_list;
+
+         void evict_to( size_t capacity );
+
+         size_t                                            _capacity;
+         lru_list                                          _lru; ///< most recently used first
+         std::map<contract_addr_type, lru_list::iterator>  _entries;
+
+         uint64_t                                          _hits          = 0;
+         uint64_t                                          _misses        = 0;
+         uint64_t                                          _evictions     = 0;
+         uint64_t                                          _invalidations = 0;
+         uint64_t                                          _saved_us      = 0;
+         latency_histogram                                 _compile_latency;
+   };
+
+} } // graphene::chain
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/contract_abi.hpp>
+#include <graphene/chain/protocol/types.hpp>
+#include <graphene/db/object.hpp>
+#include <graphene/db/generic_index.hpp>
+
+#include <boost/multi_index/composite_key.hpp>
+
+namespace graphene { namespace chain {
+
+/**
+ * @brief Bytecode and ABI of deployed smart contracts
+ *
+ * Code is immutable once deployed, so it is kept apart from contract_object: contracts only hold
+ * a contract_code_id_type, and modifying a contract never copies its code into the undo history.
+ * Entries are addressed by the hash of their content, contracts deployed with the same bytecode
+ * and ABI share one entry, which is removed together with the last contract using it.
+ *
+ * The ABI is parsed into a dispatch table when the entry is created, calls are checked against
+ * it without touching the JSON again.  Before HARDFORK_CONTRACT_ABI_TIME the ABI is free-form:
+ * abi is left unset if it does not parse, and calls are not checked.
+ *
+ * vm_version tells which VM runs the code, it is fixed when the entry is created:
+ *  - 0: code stored before HARDFORK_CONTRACT_ABI_TIME, run by the Wren binding with the call data as sent
+ *  - 1: code stored from the hardfork, run by wren_vm with call data checked against abi
+ * The same bytecode and ABI stored under both versions gives two entries.
+ *
+ * Use database::store_contract_code() and database::release_contract_code() to manage entries.
+ */
+class contract_code_object : public graphene::db::abstract_object< contract_code_object >
+{
+   public:
+      static const uint8_t space_id = implementation_ids;
+      static const uint8_t type_id  = impl_contract_code_object_type;
+
+      fc::sha256   code_hash;
+      string       bytecode;
+      string       abi_json;
+      optional<contract_abi> abi;
+      uint8_t      vm_version = 0;
+
+      static fc::sha256 hash( const string& bytecode, const string& abi_json )
+      {
+         fc::sha256::encoder enc;
+         fc::raw::pack( enc, bytecode );
+         fc::raw::pack( enc, abi_json );
+         return enc.result();
+      }
+};
+
+struct by_code_hash;
+
+typedef multi_index_container<
+   contract_code_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_code_hash>,
+         composite_key< contract_code_object,
+            member< contract_code_object, fc::sha256, &contract_code_object::code_hash >,
+            member< contract_code_object, uint8_t, &contract_code_object::vm_version >
+         >
+      >
+   >
+> contract_code_multi_index_type;
+
+typedef generic_index< contract_code_object, contract_code_multi_index_type > contract_code_index;
+
+} } // graphene::chain
+
+FC_REFLECT_DERIVED( graphene::chain::contract_code_object, (graphene::db::object),
+                    (code_hash)(bytecode)(abi_json)(abi)(vm_version) )
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/contract_code_object.hpp>
+#include <graphene/chain/contract_gas_meter.hpp>
+#include <graphene/chain/contract_storage.hpp>
+#include <graphene/chain/protocol/types.hpp>
+
+#include <memory>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Compiled form of a smart contract, produced once by contract_engine::compile()
+    *
+    * Engines derive from this to keep whatever their VM needs to run the contract again without
+    * parsing its source, e.g. a VM with the contract module loaded and call handles resolved.
+    * A compiled contract must not keep state between calls, everything persistent goes through
+    * the contract_storage passed to contract_engine::call().
+    */
+   class compiled_contract
+   {
+      public:
+         virtual ~compiled_contract(){}
+
+         /**
+          * Whether calls of this contract may run on another thread than the one applying blocks,
+          * while calls of other contracts run on further threads.  Only checked if the engine
+          * supports_parallel_calls(), contract_call_scheduler leaves the calls of contracts
+          * returning false to the evaluator.
+          */
+         virtual bool parallel_safe()const { return true; }
+   };
+
+   typedef std::shared_ptr<compiled_contract> compiled_contract_ptr;
+
+   /**
+    * @brief Interface of the VM binding which runs smart contract calls
+    *
+    * Registered through database::set_contract_engine(), the database starts with a
+    * wren_contract_engine.
+    */
+   class contract_engine
+   {
+      public:
+         virtual ~contract_engine(){}
+
+         /// code.abi is the dispatch table parsed at deployment if the ABI parsed, call data selectors can be resolved here once
+         virtual compiled_contract_ptr compile( const contract_addr_type& contract_addr,
+                                                const contract_code_object& code ) = 0;
+
+         /**
+          * Executes call_data.  For code stored from HARDFORK_CONTRACT_ABI_TIME (vm_version 1) it has been
+          * checked against code.abi: it names one of its methods, followed by the arguments that method
+          * declares.  Older code gets it as sent.  The contract reads and writes
+          * its state through storage, key by key, so only the entries it touches are loaded and
+          * undo-tracked.
+          *
+          * The engine must charge every executed VM instruction to meter (storage charges its own
+          * accesses) and cap the VM heap at meter.memory_limit().  Instruction counts must not depend
+          * on anything but the contract code and its inputs, so all nodes agree on the gas used.
+          */
+         virtual void call( compiled_contract& contract,
+                            const string& call_data,
+                            contract_storage& storage,
+                            contract_gas_meter& meter ) = 0;
+
+         /**
+          * Runs the constructor of a contract being deployed, construct_data holds the arguments it
+          * is deployed with.  The default accepts contracts deployed without arguments and leaves
+          * their storage empty.
+          */
+         virtual void construct( compiled_contract& /*contract*/,
+                                 const string& construct_data,
+                                 contract_storage& /*storage*/,
+                                 contract_gas_meter& /*meter*/ )
+         {
+            FC_ASSERT( construct_data.empty(), "this contract engine does not support constructor arguments" );
+         }
+
+         /**
+          * Whether call() may run concurrently on different threads for different compiled contracts,
+          * each in its own VM.  Enables contract_call_scheduler.
+          */
+         virtual bool supports_parallel_calls()const { return false; }
+
+         /**
+          * Executes a contract method for a read-only call and returns its result.  storage rejects
+          * writes, so methods which modify state fail.  Engines that can't return method results
+          * keep this default, which refuses the call.
+          */
+         virtual string query( compiled_contract& /*contract*/,
+                               const string& /*call_data*/,
+                               contract_storage& /*storage*/,
+                               contract_gas_meter& /*meter*/ )
+         {
+            FC_THROW( "this contract engine does not support read-only calls" );
+         }
+   };
+
+} } // graphene::chain
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/config.hpp>
+#include <graphene/chain/exceptions.hpp>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Deterministic execution budget of a single smart contract call
+    *
+    * Engines charge VM instructions through charge() from their instruction hook, contract_storage
+    * charges reads and writes.  Exceeding the limit throws smart_contract_call_out_of_gas, which
+    * fails the operation and undoes everything the call did.  Since gas only depends on the
+    * executed code and data, every node stops a runaway call at the same point.
+    *
+    * memory_limit() is the VM heap cap engines must configure, allocations above it fail the call
+    * the same way.
+    */
+   class contract_gas_meter
+   {
+      public:
+         explicit contract_gas_meter( uint64_t limit,
+                                      uint64_t memory_limit = GRAPHENE_DEFAULT_CONTRACT_CALL_MEMORY_LIMIT )
+            : _limit( limit ), _memory_limit( memory_limit ) {}
+
+         void charge( uint64_t units )
+         {
+            _used += units;
+            if( _used > _limit )
+            {
+               _used = _limit;
+               FC_THROW_EXCEPTION( smart_contract_call_out_of_gas, "Smart contract call exceeded its gas limit of ${l}",
+                                   ("l", _limit) );
+            }
+         }
+
+         void charge_bytes( uint64_t bytes ) { charge( bytes * GRAPHENE_CONTRACT_GAS_PER_BYTE ); }
+
+         uint64_t used()const         { return _used; }
+         uint64_t limit()const        { return _limit; }
+         uint64_t remaining()const    { return _limit - _used; }
+         uint64_t memory_limit()const { return _memory_limit; }
+
+      private:
+         uint64_t _used = 0;
+         uint64_t _limit;
+         uint64_t _memory_limit;
+   };
+
+} } // graphene::chain
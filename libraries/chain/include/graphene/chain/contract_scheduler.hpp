@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/contract_storage.hpp>
+#include <graphene/chain/protocol/block.hpp>
+
+#include <fc/thread/thread.hpp>
+#include <fc/variant_object.hpp>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   class database;
+
+   /**
+    * @brief Outcome of a contract call executed ahead of its transaction
+    *
+    * reads holds the first value the call saw for every key it read before writing it.  As long
+    * as storage still holds those values when the transaction is applied, running the call again
+    * would do exactly the same, so its writes, events and gas can be taken over instead.
+    */
+   struct speculative_contract_call
+   {
+      contract_addr_type       contract_addr;
+      string                   call_data;
+      bool                     succeeded = false;
+      uint64_t                 gas_used  = 0;   ///< gas charged by the engine and storage, without the per-call charge
+      contract_write_set       reads;
+      contract_write_set       writes;
+      vector<contract_event>   events;
+
+      bool is_valid( database& db )const;
+      void commit( database& db )const;
+   };
+
+   /**
+    * @class contract_call_scheduler
+    * @brief Executes the contract calls of a block in parallel before the block is applied
+    *
+    * Calls are grouped by contract.  Calls to one contract run in transaction order on the same
+    * thread, each seeing the writes of the previous ones, groups run concurrently on the worker
+    * threads against the state of the previous block, in isolated VMs and without writing to the
+    * database.  smart_contract_call_evaluator then takes over a result in transaction order if its
+    * reads are still valid, otherwise, e.g. when another operation touched the contract storage or
+    * the call failed, the call is executed again serially.  The outcome is always that of serial
+    * execution.
+    *
+    * Only used when worker threads are configured and the engine supports parallel calls.
+    */
+   class contract_call_scheduler
+   {
+      public:
+         void   set_thread_count( size_t count );
+         size_t thread_count()const { return _threads.size(); }
+
+         /// Runs the contract calls of block, discarding results of any previous block
+         void speculate( database& db, const signed_block& block );
+         const speculative_contract_call* find( uint16_t trx_in_block, uint16_t op_in_trx )const;
+         void clear() { _calls.clear(); }
+
+         /// Called by the evaluator with whether a speculative result was taken over
+         void record_outcome( bool committed ) { ++( committed ? _committed : _reexecuted ); }
+
+         fc::mutable_variant_object to_variant()const;
+
+      private:
+         typedef std::map< std::pair<uint16_t, uint16_t>, speculative_contract_call > call_map;
+
+         std::vector< std::shared_ptr<fc::thread> >   _threads;
+         call_map                                     _calls;
+         uint64_t                                     _speculated = 0;
+         uint64_t                                     _committed  = 0;
+         uint64_t                                     _reexecuted = 0;
+   };
+
+} } // graphene::chain
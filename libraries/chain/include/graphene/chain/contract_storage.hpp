@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/base.hpp>
+#include <graphene/chain/protocol/types.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <map>
+
+namespace graphene { namespace chain {
+
+   class database;
+   class contract_gas_meter;
+   struct speculative_contract_call;
+
+   /// Contract storage changes by key, a null value stands for a removed key
+   typedef std::map< string, optional< vector<char> > > contract_write_set;
+
+   /**
+    * @brief Key/value storage of one smart contract
+    *
+    * Thin accessor over contract_storage_index.  Every read and write goes to a single storage
+    * object, so the cost of a call depends on the keys it uses and not on the total size of the
+    * contract state.  Writes go through database::create/modify/remove and are undone together
+    * with the enclosing transaction.
+    *
+    * When a gas meter is given, every access is charged to it by the number of bytes it moves.
+    * A read-only storage, used by read-only calls, rejects set(), remove() and emit().
+    *
+    * Events emitted by the call are collected here and end up in its contract_call_result.
+    *
+    * A speculative storage, used by contract_call_scheduler off the chain thread, never writes to
+    * the database: it records what the call reads and writes, and reads the writes of earlier
+    * calls of the same block from overlay.
+    */
+   class contract_storage
+   {
+      public:
+         contract_storage( database& db, const contract_addr_type& contract_addr, contract_gas_meter* meter = nullptr,
+                           bool read_only = false )
+            : _db( db ), _contract_addr( contract_addr ), _meter( meter ), _read_only( read_only ) {}
+         contract_storage( database& db, const contract_addr_type& contract_addr, contract_gas_meter* meter,
+                           speculative_contract_call& speculation, const contract_write_set& overlay )
+            : _db( db ), _contract_addr( contract_addr ), _meter( meter ), _read_only( false ),
+              _speculation( &speculation ), _overlay( &overlay ) {}
+
+         /// Key under which contracts run by the Wren binding, stored before HARDFORK_CONTRACT_ABI_TIME, keep their whole state
+         static const string legacy_state_key;
+
+         const contract_addr_type& contract_addr()const { return _contract_addr; }
+         bool                      read_only()const { return _read_only; }
+
+         optional< vector<char> > get( const string& key )const;
+         bool                     contains( const string& key )const;
+         void                     set( const string& key, vector<char> value );
+         /// @return true if the key existed
+         bool                     remove( const string& key );
+         /// Removes every key of the contract, @return the number of keys removed
+         size_t                   remove_all();
+
+         void                             emit( const string& name, vector<char> data );
+         const vector<contract_event>&    events()const;
+
+         template<typename T>
+         optional<T> get_value( const string& key )const
+         {
+            auto data = get( key );
+            if( !data.valid() )
+               return optional<T>();
+            return fc::raw::unpack<T>( *data );
+         }
+
+         template<typename T>
+         void set_value( const string& key, const T& value )
+         {
+            set( key, fc::raw::pack( value ) );
+         }
+
+      private:
+         optional< vector<char> > load( const string& key )const;
+         optional< vector<char> > find_stored( const string& key )const;
+         void charge_read( const string& key, size_t value_size )const;
+         void charge_write( const string& key, size_t value_size );
+
+         database&                    _db;
+         contract_addr_type           _contract_addr;
+         contract_gas_meter*          _meter;
+         bool                         _read_only;
+         speculative_contract_call*   _speculation = nullptr;
+         const contract_write_set*    _overlay = nullptr;
+         vector<contract_event>       _events;
+   };
+
+} } // graphene::chain
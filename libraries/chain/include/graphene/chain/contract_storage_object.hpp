@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/types.hpp>
+#include <graphene/db/object.hpp>
+#include <graphene/db/generic_index.hpp>
+
+#include <boost/multi_index/composite_key.hpp>
+
+namespace graphene { namespace chain {
+
+/**
+ * @brief One entry of a smart contract's key/value storage
+ *
+ * Contract state is split into one object per key, so a call only loads, modifies and undo-tracks
+ * the keys it touches instead of the whole state.  Values are binary, usually fc::raw packed.
+ *
+ * This class is an implementation detail, use contract_storage to access it.
+ */
+class contract_storage_object : public graphene::db::abstract_object< contract_storage_object >
+{
+   public:
+      static const uint8_t space_id = implementation_ids;
+      static const uint8_t type_id  = impl_contract_storage_object_type;
+
+      contract_addr_type   contract_addr;
+      string               key;
+      vector<char>         value;
+};
+
+struct by_contract_key;
+
+typedef multi_index_container<
+   contract_storage_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_contract_key>,
+         composite_key< contract_storage_object,
+            member< contract_storage_object, contract_addr_type, &contract_storage_object::contract_addr >,
+            member< contract_storage_object, string, &contract_storage_object::key >
+         >
+      >
+   >
+> contract_storage_multi_index_type;
+
+typedef generic_index< contract_storage_object, contract_storage_multi_index_type > contract_storage_index;
+
+} } // graphene::chain
+
+FC_REFLECT_DERIVED( graphene::chain::contract_storage_object, (graphene::db::object),
+                    (contract_addr)(key)(value) )
@@ -31,6 +31,9 @@
 #include <graphene/chain/block_database.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
+#include <graphene/chain/apply_statistics.hpp>
+#include <graphene/chain/contract_cache.hpp>
+#include <graphene/chain/contract_scheduler.hpp>
 
 #include <graphene/db/object_database.hpp>
 #include <graphene/db/object.hpp>
@@ -287,6 +290,12 @@ namespace graphene { namespace chain {
 
          bool update_contract_activate_status(const contract_addr_type &contract_addr, bool activated);
 
+         /// @return the code entry holding bytecode and abi_json, created unless an identical one exists
+         /// @throw fc::exception if abi_json is not a valid contract_abi
+         contract_code_id_type store_contract_code(const string &bytecode, const string &abi_json);
+         /// Removes the code entry once no contract refers to it anymore, @return true if it was removed
+         bool release_contract_code(contract_code_id_type code);
+
         //vector<optional<contract_object>> find_contract_addrs(vector<uint64_t> contract_addrs)
         //{
         //   const auto& contract_by_id = get_index_type<contract_index>().indices().get<by_contract_id>();
@@ -444,6 +453,53 @@ namespace graphene { namespace chain {
          /// Enable or disable tracking of votes of standby witnesses and committee members
          inline void enable_standby_votes_tracking(bool enable)  { _track_standby_votes = enable; }
 
+         /// @{ @group Apply statistics
+         const apply_statistics& get_apply_statistics()const { return _apply_stats; }
+         void reset_apply_statistics() { _apply_stats.reset(); }
+         /// Log a summary of the apply statistics every @p blocks blocks, 0 disables logging
+         void set_apply_statistics_log_interval( uint32_t blocks ) { _apply_stats_log_interval = blocks; }
+
+         /**
+          * @brief Wrap a signal observer so that its run time is recorded in the apply statistics
+          * @param name Name the observer is reported under, usually the plugin name
+          *
+          * Usage: db.applied_block.connect( db.timed_handler( "my_plugin", [&]( const signed_block& b ){ ... } ) );
+          */
+         template<typename Handler>
+         timed_signal_handler<typename std::decay<Handler>::type> timed_handler( const string& name, Handler&& handler )
+         {
+            return { &_apply_stats.signal_handler( name ), std::forward<Handler>( handler ) };
+         }
+         /// @}
+
+         /// @{ @group Smart contract execution
+         /// Register the VM binding used for smart contract calls, nullptr restores the wren_contract_engine
+         void set_contract_engine( const std::shared_ptr<contract_engine>& engine );
+         contract_engine* get_contract_engine()const { return _contract_engine.get(); }
+         contract_cache& get_contract_cache() { return _contract_cache; }
+         const contract_cache& get_contract_cache()const { return _contract_cache; }
+
+         /// Threads used to execute the contract calls of a block ahead of it, 0 executes calls serially
+         void set_contract_execution_threads( size_t count ) { _contract_scheduler.set_thread_count( count ); }
+         contract_call_scheduler& get_contract_scheduler() { return _contract_scheduler; }
+         const contract_call_scheduler& get_contract_scheduler()const { return _contract_scheduler; }
+         /// The speculative result for the operation being applied, if any
+         const speculative_contract_call* find_speculative_contract_call()const
+         {
+            return _contract_scheduler.find( _current_trx_in_block, _current_op_in_trx );
+         }
+
+         /**
+          * @brief Run a contract method against the current state without a transaction
+          * @return the method's result as produced by contract_engine::query()
+          *
+          * Storage is read-only and the call is bounded by the per-call gas limit, nothing is
+          * written to the database.  Uses the compiled contract cache, so like it this must run
+          * on the thread applying blocks.
+          */
+         string call_contract_readonly( const contract_addr_type& contract_addr, const string& call_data );
+         /// @}
+
    protected:
          //Mark pop_undo() as protected -- we do not want outside calling pop_undo(); it should call pop_block() instead
          void pop_undo() { object_database::pop_undo(); }
@@ -467,6 +523,8 @@ namespace graphene { namespace chain {
          operation_result      apply_operation( transaction_evaluation_state& eval_state, const operation& op );
       private:
          void                  _apply_block( const signed_block& next_block );
+         void                  switch_forks( const item_ptr& new_head, uint32_t skip );
+         void                  precheck_fork_block( const signed_block& b, const signed_block* previous, uint32_t skip )const;
          processed_transaction _apply_transaction( const signed_transaction& trx );
          void                  _cancel_bids_and_revive_mpa( const asset_object& bitasset, const asset_bitasset_data_object& bad );
 
@@ -507,6 +565,7 @@ namespace graphene { namespace chain {
          void update_active_witnesses();
          void update_active_committee_members();
          void update_worker_votes();
+         void roll_up_pio_contributions();
          void process_bids( const asset_bitasset_data_object& bad );
          void process_bitassets();
 
@@ -567,6 +626,14 @@ namespace graphene { namespace chain {
          // Counts nested proposal updates
          uint32_t                           _push_proposal_nesting_depth = 0;
 
+         /// Counters and latency histograms of the block apply pipeline
+         apply_statistics                  _apply_stats;
+         uint32_t                          _apply_stats_log_interval = 0;
+
+         std::shared_ptr<contract_engine>  _contract_engine;
+         contract_cache                    _contract_cache;
+         contract_call_scheduler           _contract_scheduler;
+
          /// Tracks assets affected by bitshares-core issue #453 before hard fork #615 in one block
          flat_set<asset_id_type>           _issue_453_affected_assets;
 
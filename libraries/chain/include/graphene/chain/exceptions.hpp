@@ -181,6 +181,10 @@ namespace graphene { namespace chain {
    GRAPHENE_DECLARE_OP_BASE_EXCEPTIONS( blind_transfer );
    GRAPHENE_DECLARE_OP_EVALUATE_EXCEPTION( unknown_commitment, blind_transfer, 1, "Attempting to claim an unknown prior commitment" );
 
+   GRAPHENE_DECLARE_OP_BASE_EXCEPTIONS( smart_contract_call );
+   GRAPHENE_DECLARE_OP_EVALUATE_EXCEPTION( out_of_gas, smart_contract_call, 1, "smart contract call exceeded its gas limit" )
+   GRAPHENE_DECLARE_OP_EVALUATE_EXCEPTION( block_gas_exhausted, smart_contract_call, 2, "block smart contract gas budget exhausted" )
+
    /*
    FC_DECLARE_DERIVED_EXCEPTION( addition_overflow,                 graphene::chain::chain_exception, 30002, "addition overflow" )
    FC_DECLARE_DERIVED_EXCEPTION( subtraction_overflow,              graphene::chain::chain_exception, 30003, "subtraction overflow" )
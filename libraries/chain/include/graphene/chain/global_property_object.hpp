@@ -108,6 +108,15 @@ namespace graphene { namespace chain {
 
          uint32_t last_irreversible_block_num = 0;
 
+         /**
+          * Smart contract gas consumed by the transactions applied on top of the head block,
+          * bounded by chain_parameters::contract_block_gas_limit().  Reset when a block is applied.
+          */
+         uint64_t contract_gas_used = 0;
+
+         /// PIO epoch collecting pio_operations, advanced at each chain maintenance
+         uint32_t current_pio_epoch = 0;
+
          enum dynamic_flag_bits
          {
             /**
@@ -138,6 +147,8 @@ FC_REFLECT_DERIVED( graphene::chain::dynamic_global_property_object, (graphene::
                     (recent_slots_filled)
                     (dynamic_flags)
                     (last_irreversible_block_num)
+                    (contract_gas_used)
+                    (current_pio_epoch)
                   )
 
 FC_REFLECT_DERIVED( graphene::chain::global_property_object, (graphene::db::object),
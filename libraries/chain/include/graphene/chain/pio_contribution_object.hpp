@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/types.hpp>
+#include <graphene/db/object.hpp>
+#include <graphene/db/generic_index.hpp>
+
+#include <boost/multi_index/composite_key.hpp>
+
+namespace graphene { namespace chain {
+
+/**
+ * @brief Contributions reported by one account during one PIO epoch
+ *
+ * Updated by pio_evaluator as pio_operations are applied, so the contributions of an epoch are
+ * available without walking operation history.  An epoch ends at each chain maintenance, which
+ * rolls the epoch up into a pio_epoch_object and drops per-account entries older than
+ * GRAPHENE_PIO_CONTRIBUTION_EPOCHS.
+ */
+class pio_contribution_object : public graphene::db::abstract_object< pio_contribution_object >
+{
+   public:
+      static const uint8_t space_id = implementation_ids;
+      static const uint8_t type_id  = impl_pio_contribution_object_type;
+
+      account_id_type account;
+      uint32_t        epoch        = 0;
+      uint64_t        contribution = 0; ///< sum of pio_operation::contribution
+      uint32_t        reports      = 0; ///< number of pio_operations
+};
+
+/**
+ * @brief Totals of a finished PIO epoch, created during chain maintenance
+ */
+class pio_epoch_object : public graphene::db::abstract_object< pio_epoch_object >
+{
+   public:
+      static const uint8_t space_id = implementation_ids;
+      static const uint8_t type_id  = impl_pio_epoch_object_type;
+
+      uint32_t           epoch              = 0;
+      time_point_sec     end_time;
+      uint64_t           total_contribution = 0;
+      uint32_t           contributors       = 0;
+      uint32_t           reports            = 0;
+};
+
+struct by_account_epoch;
+struct by_epoch_contribution;
+
+typedef multi_index_container<
+   pio_contribution_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_account_epoch>,
+         composite_key< pio_contribution_object,
+            member< pio_contribution_object, account_id_type, &pio_contribution_object::account >,
+            member< pio_contribution_object, uint32_t, &pio_contribution_object::epoch >
+         >
+      >,
+      ordered_unique< tag<by_epoch_contribution>,
+         composite_key< pio_contribution_object,
+            member< pio_contribution_object, uint32_t, &pio_contribution_object::epoch >,
+            member< pio_contribution_object, uint64_t, &pio_contribution_object::contribution >,
+            member< object, object_id_type, &object::id >
+         >,
+         composite_key_compare<
+            std::less< uint32_t >,
+            std::greater< uint64_t >,
+            std::less< object_id_type >
+         >
+      >
+   >
+> pio_contribution_multi_index_type;
+
+typedef generic_index< pio_contribution_object, pio_contribution_multi_index_type > pio_contribution_index;
+
+struct by_epoch;
+
+typedef multi_index_container<
+   pio_epoch_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_epoch>, member< pio_epoch_object, uint32_t, &pio_epoch_object::epoch > >
+   >
+> pio_epoch_multi_index_type;
+
+typedef generic_index< pio_epoch_object, pio_epoch_multi_index_type > pio_epoch_index;
+
+} } // graphene::chain
+
+FC_REFLECT_DERIVED( graphene::chain::pio_contribution_object, (graphene::db::object),
+                    (account)(epoch)(contribution)(reports) )
+FC_REFLECT_DERIVED( graphene::chain::pio_epoch_object, (graphene::db::object),
+                    (epoch)(end_time)(total_contribution)(contributors)(reports) )
@@ -81,7 +81,23 @@ namespace graphene { namespace chain {
     */
 
    struct void_result{};
-   typedef fc::static_variant<void_result,object_id_type,asset> operation_result;
+
+   /// Structured notification emitted by a smart contract call, name is the event type
+   struct contract_event
+   {
+      string         name;
+      vector<char>   data;
+   };
+
+   /// Result of smart_contract_call_operation, the metered cost of the call and the events it emitted
+   struct contract_call_result
+   {
+      uint64_t                 gas_used = 0;
+      share_type               gas_fee;         ///< CORE charged for gas_used on top of the operation fee
+      vector<contract_event>   events;
+   };
+
+   typedef fc::static_variant<void_result,object_id_type,asset,contract_call_result> operation_result;
 
    struct base_operation
    {
@@ -122,3 +138,5 @@ namespace graphene { namespace chain {
 FC_REFLECT_TYPENAME( graphene::chain::operation_result )
 FC_REFLECT_TYPENAME( graphene::chain::future_extensions )
 FC_REFLECT( graphene::chain::void_result, )
+FC_REFLECT( graphene::chain::contract_event, (name)(data) )
+FC_REFLECT( graphene::chain::contract_call_result, (gas_used)(gas_fee)(events) )
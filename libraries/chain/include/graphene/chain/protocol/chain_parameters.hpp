@@ -33,6 +33,12 @@ namespace graphene { namespace chain {
    typedef static_variant<>  parameter_extension; 
    struct chain_parameters
    {
+      struct ext
+      {
+         /// smart contract gas all calls of a block may use together, from HARDFORK_CONTRACT_GAS_TIME
+         optional< uint64_t > contract_block_gas_limit;
+      };
+
       /** using a smart ref breaks the circular dependency created between operations and the fee schedule */
       smart_ref<fee_schedule> current_fees;                       ///< current schedule of fees
       uint8_t                 block_interval                      = GRAPHENE_DEFAULT_BLOCK_INTERVAL; ///< interval in seconds between blocks
@@ -63,14 +69,22 @@ namespace graphene { namespace chain {
       uint16_t                accounts_per_fee_scale              = GRAPHENE_DEFAULT_ACCOUNTS_PER_FEE_SCALE; ///< number of accounts between fee scalings
       uint8_t                 account_fee_scale_bitshifts         = GRAPHENE_DEFAULT_ACCOUNT_FEE_SCALE_BITSHIFTS; ///< number of times to left bitshift account registration fee at each scaling
       uint8_t                 max_authority_depth                 = GRAPHENE_MAX_SIG_CHECK_DEPTH;
-      extensions_type         extensions;
+      extension<ext>          extensions;
 
       /** defined in fee_schedule.cpp */
       void validate()const;
+
+      uint64_t contract_block_gas_limit()const
+      {
+         return extensions.value.contract_block_gas_limit.valid() ? *extensions.value.contract_block_gas_limit
+                                                                  : GRAPHENE_DEFAULT_CONTRACT_BLOCK_GAS_LIMIT;
+      }
    };
 
 } }  // graphene::chain
 
+FC_REFLECT( graphene::chain::chain_parameters::ext, (contract_block_gas_limit) )
+
 FC_REFLECT( graphene::chain::chain_parameters,
             (current_fees)
             (block_interval)
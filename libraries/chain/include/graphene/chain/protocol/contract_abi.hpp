@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/protocol/types.hpp>
+
+#include <fc/container/flat.hpp>
+#include <fc/io/raw.hpp>
+
+namespace graphene { namespace chain {
+
+   /// First four bytes of every smart_contract_call_operation::call_data, identifies the called method
+   typedef uint32_t contract_method_selector;
+
+   /// Argument types an ABI may declare, each argument is fc::raw packed as the matching C++ type
+   enum contract_arg_type
+   {
+      contract_arg_bool,    ///< bool
+      contract_arg_int64,   ///< int64_t
+      contract_arg_uint64,  ///< uint64_t
+      contract_arg_string,  ///< string
+      contract_arg_bytes,   ///< vector<char>
+      contract_arg_account, ///< account_id_type
+      contract_arg_asset    ///< asset
+   };
+
+   struct contract_method
+   {
+      string                     name;
+      vector<contract_arg_type>  args;
+   };
+
+   /**
+    * @brief Dispatch table of a smart contract, parsed once from its JSON ABI when it is deployed
+    *
+    * The JSON ABI is an array of methods, each an object with a name and an optional list of
+    * inputs.  An input is a type name or an object with a "type" member:
+    *
+    *    [ { "name": "transfer", "inputs": [ "account", { "name": "amount", "type": "asset" } ] } ]
+    *
+    * Type names are bool, int64, uint64, string, bytes, account and asset.
+    *
+    * Calls of code stored from HARDFORK_CONTRACT_ABI_TIME are binary: the selector of the method, i.e. the first four bytes of the
+    * SHA256 of its name, followed by its arguments, fc::raw packed in order.  Use encode_call() to build it.  Code stored before
+    * the hardfork takes call data as sent, its binding parses the ABI JSON itself.
+    */
+   struct contract_abi
+   {
+      static const size_t selector_size = sizeof( contract_method_selector );
+
+      flat_map< contract_method_selector, contract_method > methods;
+
+      /// @throw fc::exception if abi_json is not a valid ABI or two methods have the same selector
+      static contract_abi parse( const string& abi_json );
+
+      static contract_method_selector selector( const string& method_name );
+      /// @return the selector call_data starts with, call_data must be at least selector_size long
+      static contract_method_selector call_selector( const string& call_data );
+
+      template<typename... Args>
+      static string encode_call( const string& method_name, const Args&... args )
+      {
+         vector<char> data = fc::raw::pack( selector( method_name ) );
+         int unused[] = { 0, ( append_packed( data, args ), 0 )... };
+         (void)unused;
+         return string( data.begin(), data.end() );
+      }
+
+      const contract_method* find( contract_method_selector s )const;
+
+      /**
+       * Looks up the method called by call_data and checks that its arguments decode to the
+       * declared types with no bytes left over.
+       * @return the called method
+       */
+      const contract_method& dispatch( const string& call_data )const;
+
+      private:
+         template<typename T>
+         static void append_packed( vector<char>& data, const T& value )
+         {
+            vector<char> packed = fc::raw::pack( value );
+            data.insert( data.end(), packed.begin(), packed.end() );
+         }
+   };
+
+} } // graphene::chain
+
+FC_REFLECT_ENUM( graphene::chain::contract_arg_type,
+                 (contract_arg_bool)(contract_arg_int64)(contract_arg_uint64)(contract_arg_string)
+                 (contract_arg_bytes)(contract_arg_account)(contract_arg_asset) )
+FC_REFLECT( graphene::chain::contract_method, (name)(args) )
+FC_REFLECT( graphene::chain::contract_abi, (methods) )
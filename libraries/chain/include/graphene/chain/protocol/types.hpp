@@ -165,7 +165,11 @@ namespace graphene { namespace chain {
       impl_special_authority_object_type,
       impl_buyback_object_type,
       impl_fba_accumulator_object_type,
-      impl_collateral_bid_object_type
+      impl_collateral_bid_object_type,
+      impl_contract_storage_object_type,
+      impl_contract_code_object_type,
+      impl_pio_contribution_object_type,
+      impl_pio_epoch_object_type
    };
 
    //typedef fc::unsigned_int            object_id_type;
@@ -222,6 +226,10 @@ namespace graphene { namespace chain {
    class buyback_object;
    class fba_accumulator_object;
    class collateral_bid_object;
+   class contract_storage_object;
+   class contract_code_object;
+   class pio_contribution_object;
+   class pio_epoch_object;
 
    typedef object_id< implementation_ids, impl_global_property_object_type,  global_property_object>                    global_property_id_type;
    typedef object_id< implementation_ids, impl_dynamic_global_property_object_type,  dynamic_global_property_object>    dynamic_global_property_id_type;
@@ -243,6 +251,10 @@ namespace graphene { namespace chain {
    typedef object_id< implementation_ids, impl_buyback_object_type, buyback_object >                                    buyback_id_type;
    typedef object_id< implementation_ids, impl_fba_accumulator_object_type, fba_accumulator_object >                    fba_accumulator_id_type;
    typedef object_id< implementation_ids, impl_collateral_bid_object_type, collateral_bid_object >                      collateral_bid_id_type;
+   typedef object_id< implementation_ids, impl_contract_storage_object_type, contract_storage_object >                  contract_storage_id_type;
+   typedef object_id< implementation_ids, impl_contract_code_object_type, contract_code_object >                        contract_code_id_type;
+   typedef object_id< implementation_ids, impl_pio_contribution_object_type, pio_contribution_object >                  pio_contribution_id_type;
+   typedef object_id< implementation_ids, impl_pio_epoch_object_type, pio_epoch_object >                                pio_epoch_id_type;
 
    typedef fc::array<char, GRAPHENE_MAX_ASSET_SYMBOL_LENGTH>    symbol_type;
    typedef fc::ripemd160                                        block_id_type;
@@ -375,6 +387,10 @@ FC_REFLECT_ENUM( graphene::chain::impl_object_type,
                  (impl_buyback_object_type)
                  (impl_fba_accumulator_object_type)
                  (impl_collateral_bid_object_type)
+                 (impl_contract_storage_object_type)
+                 (impl_contract_code_object_type)
+                 (impl_pio_contribution_object_type)
+                 (impl_pio_epoch_object_type)
                )
 
 FC_REFLECT_TYPENAME( graphene::chain::share_type )
@@ -407,6 +423,10 @@ FC_REFLECT_TYPENAME( graphene::chain::special_authority_id_type )
 FC_REFLECT_TYPENAME( graphene::chain::buyback_id_type )
 FC_REFLECT_TYPENAME( graphene::chain::fba_accumulator_id_type )
 FC_REFLECT_TYPENAME( graphene::chain::collateral_bid_id_type )
+FC_REFLECT_TYPENAME( graphene::chain::contract_storage_id_type )
+FC_REFLECT_TYPENAME( graphene::chain::contract_code_id_type )
+FC_REFLECT_TYPENAME( graphene::chain::pio_contribution_id_type )
+FC_REFLECT_TYPENAME( graphene::chain::pio_epoch_id_type )
 
 FC_REFLECT( graphene::chain::void_t, )
 
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/contract_engine.hpp>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief contract_engine running contracts in Wren
+    *
+    * Code stored from HARDFORK_CONTRACT_ABI_TIME (contract_code_object::vm_version 1) is loaded
+    * into a wren_vm when compiled, which the contract cache keeps and every call reuses.  Its
+    * state is read and written key by key through contract_storage, and the VM charges the
+    * blocks it runs and the memory it allocates to the meter of the call, see wren_vm.
+    *
+    * Older code runs through the binding, smart_contract_call_evaluator::call_smart_contract(),
+    * which takes the contract source, the call data and ABI JSON as deployed, and the whole
+    * contract state as one string, and returns the new state.  The state is kept under
+    * contract_storage::legacy_state_key.  The binding parses the source on every call, so the
+    * compiled form only keeps the code of the contract.  It cannot be interrupted either: a call
+    * is charged up front for the bytes the binding parses and for the state it writes, and the gas
+    * limit bounds that charge, not the instructions the VM executes.
+    *
+    * This is the engine a database uses unless another one is registered.
+    */
+   class wren_contract_engine : public contract_engine
+   {
+      public:
+         compiled_contract_ptr compile( const contract_addr_type& contract_addr,
+                                        const contract_code_object& code ) override;
+
+         /// every wren_vm has its own VM and memory, code run by the binding is not parallel_safe()
+         bool supports_parallel_calls()const override { return true; }
+
+         void call( compiled_contract& contract,
+                    const string& call_data,
+                    contract_storage& storage,
+                    contract_gas_meter& meter ) override;
+
+         /// stores the state the binding's constructor returns under contract_storage::legacy_state_key
+         void construct( compiled_contract& contract,
+                         const string& construct_data,
+                         contract_storage& storage,
+                         contract_gas_meter& meter ) override;
+
+         /// @return the result of the method as wren_vm::query() returns it, code run by the binding is refused
+         string query( compiled_contract& contract,
+                       const string& call_data,
+                       contract_storage& storage,
+                       contract_gas_meter& meter ) override;
+
+      protected:
+         /// Runs the binding on code stored before the hardfork, @return the new contract state
+         virtual string run( const contract_addr_type& contract_addr,
+                             const string& bytecode,
+                             const string& call_data,
+                             const string& abi_json,
+                             const string& state );
+
+         /// Runs the binding's constructor, @return the initial contract state
+         virtual string run_constructor( const contract_addr_type& contract_addr,
+                                         const string& bytecode,
+                                         const string& construct_data,
+                                         const string& abi_json );
+
+      private:
+         string execute( compiled_contract& contract, const string& call_data,
+                         contract_storage& storage, contract_gas_meter& meter );
+   };
+
+} } // graphene::chain
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/contract_gas_meter.hpp>
+#include <graphene/chain/contract_storage.hpp>
+#include <graphene/chain/protocol/contract_abi.hpp>
+
+#include <memory>
+
+namespace graphene { namespace chain {
+
+   namespace detail { class wren_vm_impl; }
+
+   /**
+    * @class wren_vm
+    * @brief Wren VM with one smart contract loaded, kept to run every call of that contract
+    *
+    * The contract source is interpreted once, into module "contract".  It must define a class
+    * Contract with a static method for every method of its ABI, taking the ABI arguments in order:
+    *
+    *    class Contract {
+    *       static init(owner) { ... }
+    *       static greet(name) { "hello " + name }
+    *    }
+    *
+    * Arguments are decoded from the call data: bool as Bool, int64 and uint64 as Num (beyond 2^53
+    * they are rejected), string and bytes as String, an account as its id, e.g. "1.2.17", and an
+    * asset as a list of its amount and asset id, e.g. [ 100, "1.3.0" ].  The ABI method named init
+    * is the constructor: it is run once with the arguments the contract is deployed with, and
+    * cannot be called afterwards.
+    *
+    * The contract keeps its state in contract_storage, one key at a time, through the class
+    * Storage the host defines in the module:
+    *
+    *    Storage.get(key)          the String stored under key, or null
+    *    Storage.set(key, value)   stores the String value under key
+    *    Storage.remove(key)       removes key, true if it was stored
+    *    Storage.contains(key)
+    *
+    * Keys and values are Strings, used as bytes.  Events go to the result of the call through
+    * the class Event:
+    *
+    *    Event.emit(name, data)    emits the event name carrying the String data
+    *
+    * An error in Storage or Event, e.g. writing in a read-only call, fails the whole call even if
+    * the contract catches it.
+    *
+    * All memory of the VM comes from a buffer of its own.  The used part of it is copied once the
+    * contract is loaded and copied back before every call, so each call starts from the loaded
+    * contract without interpreting the source again, and nothing a call leaves in the VM reaches
+    * the next one.
+    *
+    * Calls are metered.  The source is compiled with a gas tick at the start of every block, which
+    * charges GRAPHENE_CONTRACT_GAS_PER_TOKEN for each token of the block, and every byte the VM
+    * allocates costs GRAPHENE_CONTRACT_GAS_PER_HEAP_BYTE.  A call fails once its meter runs out, once
+    * its heap passes contract_gas_meter::memory_limit(), or if it allocates more than
+    * GRAPHENE_CONTRACT_MAX_VM_ALLOCATION at once, which bounds what a core library method does
+    * between two ticks.  The ticks require the top level of the source to only define classes and
+    * every loop body to be a block; import, foreign, ranges outside for loop headers, clock, gc and
+    * the Num methods computed by the C math library are rejected.
+    *
+    * A wren_vm runs one call at a time, concurrent calls wait for each other.  Different wren_vm
+    * share nothing and run calls on different threads at once.
+    */
+   class wren_vm
+   {
+      public:
+         /// @throw fc::exception if the source does not compile or lacks the Contract class
+         wren_vm( const string& source, const contract_abi& abi );
+         ~wren_vm();
+
+         /// Runs the method call_data selects, call_data must have passed contract_abi::dispatch()
+         void call( const string& call_data, contract_storage& storage, contract_gas_meter& meter );
+
+         /**
+          * Runs the method call_data selects like call(), @return the String the toString of its
+          * result returns, e.g. "5" for 5 and "[1, a]" for [1, "a"]
+          */
+         string query( const string& call_data, contract_storage& storage, contract_gas_meter& meter );
+
+         /// Runs init with construct_data as its packed arguments, a contract without init takes none
+         void construct( const string& construct_data, contract_storage& storage, contract_gas_meter& meter );
+
+      private:
+         std::unique_ptr<detail::wren_vm_impl> my;
+   };
+
+} } // graphene::chain
@@ -27,6 +27,8 @@
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/hardfork.hpp>
 #include <graphene/chain/is_authorized_asset.hpp>
+#include <graphene/chain/global_property_object.hpp>
+#include <graphene/chain/pio_contribution_object.hpp>
 
 namespace graphene { namespace chain {
 void_result pio_evaluator::do_evaluate( const pio_operation& op )
@@ -45,6 +47,27 @@ void_result pio_evaluator::do_evaluate( const pio_operation& op )
 
 void_result pio_evaluator::do_apply( const pio_operation& o )
 { try {
+   database& d = db();
+   const uint32_t epoch = d.get_dynamic_global_properties().current_pio_epoch;
+
+   const auto& idx = d.get_index_type<pio_contribution_index>().indices().get<by_account_epoch>();
+   auto itr = idx.find( boost::make_tuple( o.from, epoch ) );
+   if( itr == idx.end() )
+   {
+      d.create<pio_contribution_object>( [&]( pio_contribution_object& c ) {
+         c.account = o.from;
+         c.epoch = epoch;
+         c.contribution = o.contribution;
+         c.reports = 1;
+      });
+   }
+   else
+   {
+      d.modify( *itr, [&]( pio_contribution_object& c ) {
+         c.contribution += o.contribution;
+         ++c.reports;
+      });
+   }
    return void_result();
 } FC_CAPTURE_AND_RETHROW( (o) ) }
 
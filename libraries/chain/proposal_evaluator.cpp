@@ -94,6 +94,13 @@ struct proposal_operation_hardfork_visitor
          FC_ASSERT(!"Virtual operation");
       }
    }
+   // contract gas
+   void operator()(const graphene::chain::committee_member_update_global_parameters_operation &v) const {
+      if (block_time < HARDFORK_CONTRACT_GAS_TIME) {
+         FC_ASSERT( !v.new_parameters.extensions.value.contract_block_gas_limit.valid(),
+                    "Can not set contract_block_gas_limit before the smart contract gas hardfork" );
+      }
+   }
    // loop and self visit in proposals
    void operator()(const graphene::chain::proposal_create_operation &v) const {
       for (const op_wrapper &op : v.proposed_ops)
@@ -311,7 +311,9 @@ void smart_contract_kill_operation::validate() const
 
 void smart_contract_call_operation::validate() const
 {
-    //TODO: there are more condition to be checked
+    FC_ASSERT(fee.amount >= 0);
+    // calls of code stored from HARDFORK_CONTRACT_ABI_TIME are checked against the contract's ABI
+    // when the call is applied, call data of older code stays free-form
 }
 
 }
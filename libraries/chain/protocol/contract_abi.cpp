@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/protocol/contract_abi.hpp>
+#include <graphene/chain/protocol/asset.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <map>
+
+namespace graphene { namespace chain {
+
+namespace detail {
+
+   contract_arg_type parse_arg_type( const string& name )
+   {
+      static const std::map< string, contract_arg_type > types = {
+         { "bool",    contract_arg_bool },
+         { "int64",   contract_arg_int64 },
+         { "uint64",  contract_arg_uint64 },
+         { "string",  contract_arg_string },
+         { "bytes",   contract_arg_bytes },
+         { "account", contract_arg_account },
+         { "asset",   contract_arg_asset }
+      };
+      auto itr = types.find( name );
+      FC_ASSERT( itr != types.end(), "unknown ABI argument type ${t}", ("t", name) );
+      return itr->second;
+   }
+
+   void skip_arg( fc::datastream<const char*>& ds, contract_arg_type type )
+   {
+      switch( type )
+      {
+         case contract_arg_bool:    { bool v;            fc::raw::unpack( ds, v ); break; }
+         case contract_arg_int64:   { int64_t v;         fc::raw::unpack( ds, v ); break; }
+         case contract_arg_uint64:  { uint64_t v;        fc::raw::unpack( ds, v ); break; }
+         case contract_arg_string:  { string v;          fc::raw::unpack( ds, v ); break; }
+         case contract_arg_bytes:   { vector<char> v;    fc::raw::unpack( ds, v ); break; }
+         case contract_arg_account: { account_id_type v; fc::raw::unpack( ds, v ); break; }
+         case contract_arg_asset:   { asset v;           fc::raw::unpack( ds, v ); break; }
+      }
+   }
+
+}
+
+contract_abi contract_abi::parse( const string& abi_json )
+{ try {
+   const fc::variant abi = fc::json::from_string( abi_json );
+   FC_ASSERT( abi.is_array(), "ABI must be an array of methods" );
+
+   contract_abi result;
+   for( const auto& m : abi.get_array() )
+   {
+      const auto& obj = m.get_object();
+      contract_method method;
+      method.name = obj["name"].as_string();
+      FC_ASSERT( !method.name.empty(), "ABI method without a name" );
+
+      auto inputs = obj.find( "inputs" );
+      if( inputs != obj.end() )
+         for( const auto& input : inputs->value().get_array() )
+            method.args.push_back( detail::parse_arg_type(
+               input.is_object() ? input.get_object()["type"].as_string() : input.as_string() ) );
+
+      const contract_method_selector s = selector( method.name );
+      auto existing = result.methods.find( s );
+      FC_ASSERT( existing == result.methods.end(),
+                 "ABI method ${n} has the same selector as ${o}", ("n", method.name)("o", existing->second.name) );
+      result.methods.emplace( s, std::move( method ) );
+   }
+   return result;
+} FC_CAPTURE_AND_RETHROW( (abi_json) ) }
+
+contract_method_selector contract_abi::selector( const string& method_name )
+{
+   const fc::sha256 h = fc::sha256::hash( method_name );
+   contract_method_selector s;
+   fc::datastream<const char*> ds( h.data(), selector_size );
+   fc::raw::unpack( ds, s );
+   return s;
+}
+
+contract_method_selector contract_abi::call_selector( const string& call_data )
+{
+   FC_ASSERT( call_data.size() >= selector_size, "call data must start with a method selector" );
+   contract_method_selector s;
+   fc::datastream<const char*> ds( call_data.data(), selector_size );
+   fc::raw::unpack( ds, s );
+   return s;
+}
+
+const contract_method* contract_abi::find( contract_method_selector s )const
+{
+   auto itr = methods.find( s );
+   return itr == methods.end() ? nullptr : &itr->second;
+}
+
+const contract_method& contract_abi::dispatch( const string& call_data )const
+{
+   const contract_method_selector s = call_selector( call_data );
+   const contract_method* method = find( s );
+   FC_ASSERT( method != nullptr, "contract has no method with selector ${s}", ("s", s) );
+
+   fc::datastream<const char*> ds( call_data.data() + selector_size, call_data.size() - selector_size );
+   try {
+      for( auto type : method->args )
+         detail::skip_arg( ds, type );
+   } FC_RETHROW_EXCEPTIONS( warn, "bad arguments for contract method ${m}", ("m", method->name) )
+   FC_ASSERT( ds.remaining() == 0, "${n} extra bytes after the arguments of contract method ${m}",
+              ("n", ds.remaining())("m", method->name) );
+   return *method;
+}
+
+} } // graphene::chain
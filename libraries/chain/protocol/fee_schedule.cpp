@@ -192,6 +192,8 @@ namespace graphene { namespace chain {
                  "Maximum transaction expiration time must be greater than a block interval" );
       FC_ASSERT( maximum_proposal_lifetime - committee_proposal_review_period > block_interval,
                  "Committee proposal review period must be less than the maximum proposal lifetime" );
+      FC_ASSERT( contract_block_gas_limit() >= GRAPHENE_CONTRACT_GAS_PER_CALL,
+                 "Smart contract block gas limit must cover at least one call" );
    }
 
 } } // graphene::chain
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/wren_contract_engine.hpp>
+#include <graphene/chain/account_evaluator.hpp>
+#include <graphene/chain/wren_vm.hpp>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   /// code stored before HARDFORK_CONTRACT_ABI_TIME, run by the binding, which parses it on every call
+   struct wren_compiled_contract : public compiled_contract
+   {
+      wren_compiled_contract( const contract_addr_type& a, const contract_code_object& code )
+         : contract_addr( a ), bytecode( code.bytecode ), abi_json( code.abi_json ) {}
+
+      /// the binding is not known to be safe to run on several threads
+      bool parallel_safe()const override { return false; }
+
+      contract_addr_type contract_addr;
+      string             bytecode;
+      string             abi_json;
+   };
+
+   /// code stored from the hardfork, loaded once into a wren_vm
+   struct wren_loaded_contract : public compiled_contract
+   {
+      explicit wren_loaded_contract( const contract_code_object& code )
+         : vm( code.bytecode, *code.abi ) {}
+
+      wren_vm vm;
+   };
+
+}
+
+compiled_contract_ptr wren_contract_engine::compile( const contract_addr_type& contract_addr,
+                                                     const contract_code_object& code )
+{
+   if( code.vm_version == 0 )
+      return std::make_shared<wren_compiled_contract>( contract_addr, code );
+   FC_ASSERT( code.abi.valid() );
+   return std::make_shared<wren_loaded_contract>( code );
+}
+
+string wren_contract_engine::execute( compiled_contract& contract, const string& call_data,
+                                      contract_storage& storage, contract_gas_meter& meter )
+{
+   const auto& wren = static_cast<const wren_compiled_contract&>( contract );
+   auto stored_state = storage.get( contract_storage::legacy_state_key );
+   string state = stored_state.valid() ? string( stored_state->begin(), stored_state->end() ) : string();
+   meter.charge_bytes( wren.bytecode.size() + wren.abi_json.size() + state.size() );
+   return run( wren.contract_addr, wren.bytecode, call_data, wren.abi_json, state );
+}
+
+void wren_contract_engine::call( compiled_contract& contract, const string& call_data,
+                                 contract_storage& storage, contract_gas_meter& meter )
+{
+   if( auto* loaded = dynamic_cast<wren_loaded_contract*>( &contract ) )
+   {
+      loaded->vm.call( call_data, storage, meter );
+      return;
+   }
+   string new_state = execute( contract, call_data, storage, meter );
+   meter.charge( new_state.size() * GRAPHENE_CONTRACT_GAS_PER_STORED_BYTE );
+   storage.set( contract_storage::legacy_state_key, vector<char>( new_state.begin(), new_state.end() ) );
+}
+
+void wren_contract_engine::construct( compiled_contract& contract, const string& construct_data,
+                                      contract_storage& storage, contract_gas_meter& meter )
+{
+   if( auto* loaded = dynamic_cast<wren_loaded_contract*>( &contract ) )
+   {
+      loaded->vm.construct( construct_data, storage, meter );
+      return;
+   }
+   const auto& wren = static_cast<const wren_compiled_contract&>( contract );
+   meter.charge_bytes( wren.bytecode.size() + wren.abi_json.size() + construct_data.size() );
+   string state = run_constructor( wren.contract_addr, wren.bytecode, construct_data, wren.abi_json );
+   meter.charge( state.size() * GRAPHENE_CONTRACT_GAS_PER_STORED_BYTE );
+   storage.set( contract_storage::legacy_state_key, vector<char>( state.begin(), state.end() ) );
+}
+
+string wren_contract_engine::query( compiled_contract& contract, const string& call_data,
+                                    contract_storage& storage, contract_gas_meter& meter )
+{
+   auto* loaded = dynamic_cast<wren_loaded_contract*>( &contract );
+   // the binding only returns the whole state, which is not the result of the method
+   FC_ASSERT( loaded != nullptr, "smart contracts deployed before the ABI hardfork return no method results" );
+   return loaded->vm.query( call_data, storage, meter );
+}
+
+string wren_contract_engine::run( const contract_addr_type& contract_addr, const string& bytecode,
+                                  const string& call_data, const string& abi_json, const string& state )
+{
+   // the binding does not use the evaluation state
+   smart_contract_call_evaluator binding;
+   return binding.call_smart_contract( bytecode, contract_addr, call_data, abi_json, state );
+}
+
+string wren_contract_engine::run_constructor( const contract_addr_type& contract_addr, const string& bytecode,
+                                              const string& construct_data, const string& abi_json )
+{
+   smart_contract_deploy_evaluator binding;
+   return binding.construct_smart_contract( bytecode, contract_addr, construct_data, abi_json );
+}
+
+} } // graphene::chain
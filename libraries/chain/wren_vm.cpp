@@ -0,0 +1,1061 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/wren_vm.hpp>
+#include <graphene/chain/protocol/asset.hpp>
+
+#include <fc/io/datastream.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <csetjmp>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+
+#include "../wren/src/include/wren.hpp"
+
+namespace graphene { namespace chain {
+
+namespace detail {
+
+   /**
+    * Allocator of one VM.  Everything the VM allocates, the VM itself included, comes from one
+    * buffer whose allocator state is kept at its start, so copying the used part of the buffer
+    * captures the whole VM, and copying it back restores it at the same addresses.
+    *
+    * Blocks are powers of two from 16 bytes, with a 16 byte header holding their size class,
+    * and freed blocks go to a free list per size class.  Where a block lands only depends on the
+    * sequence of requests, never on the process.
+    */
+   class wren_arena
+   {
+      public:
+         explicit wren_arena( size_t capacity )
+            : _capacity( capacity ), _limit( capacity ), _buffer( new char[capacity] )
+         {
+            FC_ASSERT( capacity > state_size );
+            std::memset( _buffer.get(), 0, state_size );
+            state().top = state_size;
+         }
+
+         size_t capacity()const { return _capacity; }
+         size_t used()const     { return state().top; }
+
+         /// Limits the used part of the buffer to limit bytes from now on, at most the capacity
+         void set_limit( size_t limit ) { _limit = std::min( limit, _capacity ); }
+
+         /**
+          * @param allocated set to the size of the block taken for the request, 0 if none was
+          * @return nullptr if the request does not fit, and for size 0
+          */
+         void* reallocate( void* memory, size_t size, size_t& allocated )
+         {
+            allocated = 0;
+            if( size == 0 )
+            {
+               if( memory != nullptr )
+                  release( memory );
+               return nullptr;
+            }
+            if( memory == nullptr )
+               return allocate( size, allocated );
+
+            const size_t current = block_size( size_class_of( memory ) );
+            if( size <= current )
+               return memory;
+            void* moved = allocate( size, allocated );
+            if( moved == nullptr )
+               return nullptr;
+            std::memcpy( moved, memory, current );
+            release( memory );
+            return moved;
+         }
+
+         void snapshot() { _snapshot.assign( _buffer.get(), _buffer.get() + used() ); }
+         void restore()  { std::memcpy( _buffer.get(), _snapshot.data(), _snapshot.size() ); }
+
+      private:
+         static const size_t   header_size  = 16;
+         static const uint32_t size_classes = 48;
+
+         struct arena_state
+         {
+            size_t top;                        ///< offset of the first byte never allocated
+            size_t free_lists[size_classes];   ///< offset of the first free block per class, 0 if none
+         };
+         static const size_t state_size = ( sizeof( arena_state ) + 15 ) & ~size_t( 15 );
+
+         arena_state& state()const { return *reinterpret_cast<arena_state*>( _buffer.get() ); }
+         size_t& at( size_t offset )const { return *reinterpret_cast<size_t*>( _buffer.get() + offset ); }
+
+         static size_t block_size( uint32_t size_class ) { return size_t( 16 ) << size_class; }
+         uint32_t size_class_of( void* memory )const
+         {
+            return uint32_t( at( static_cast<char*>( memory ) - _buffer.get() - header_size ) );
+         }
+
+         void* allocate( size_t size, size_t& allocated )
+         {
+            if( size > _limit )
+               return nullptr;
+            uint32_t size_class = 0;
+            while( block_size( size_class ) < size )
+               ++size_class;
+
+            arena_state& s = state();
+            size_t block = s.free_lists[size_class];
+            if( block != 0 )
+               s.free_lists[size_class] = at( block + header_size );
+            else
+            {
+               const size_t needed = header_size + block_size( size_class );
+               if( s.top > _limit || needed > _limit - s.top )
+                  return nullptr;
+               block = s.top;
+               s.top += needed;
+            }
+            at( block ) = size_class;
+            allocated = block_size( size_class );
+            return _buffer.get() + block + header_size;
+         }
+
+         void release( void* memory )
+         {
+            const uint32_t size_class = size_class_of( memory );
+            const size_t block = static_cast<char*>( memory ) - _buffer.get() - header_size;
+            arena_state& s = state();
+            at( block + header_size ) = s.free_lists[size_class];
+            s.free_lists[size_class] = block;
+         }
+
+         const size_t              _capacity;
+         size_t                    _limit;
+         std::unique_ptr<char[]>   _buffer;
+         vector<char>              _snapshot;
+   };
+
+   /// What the callbacks of the VM need while it runs on this thread
+   struct wren_context
+   {
+      explicit wren_context( wren_arena& a ) : arena( a ) {}
+
+      wren_arena&              arena;
+      contract_storage*        storage       = nullptr;   ///< null while the contract is loaded
+      contract_gas_meter*      meter         = nullptr;
+      WrenHandle*              abort_message = nullptr;
+      std::jmp_buf             out_of_memory;
+      size_t                   max_allocation = std::numeric_limits<size_t>::max();
+      uint64_t                 heap_gas       = 0;        ///< gas of allocations not charged to meter yet
+      bool                     out_of_gas     = false;    ///< the jump to out_of_memory was for heap_gas
+      const vector<uint32_t>*  added_lines    = nullptr;  ///< lines the source metering added, for errors
+      string                   error;                     ///< first error the VM reported
+      std::exception_ptr       host_error;                ///< first error of a foreign method
+
+      /// result of the current foreign method, set before it calls into the VM to return it
+      optional< vector<char> > host_value;
+      bool                     host_flag = false;
+   };
+
+   thread_local wren_context* current_context = nullptr;
+
+   /// Makes ctx the context of the VM callbacks on this thread while in scope
+   class scoped_wren_context
+   {
+      public:
+         explicit scoped_wren_context( wren_context& ctx ) : _previous( current_context ) { current_context = &ctx; }
+         ~scoped_wren_context() { current_context = _previous; }
+      private:
+         wren_context* _previous;
+   };
+
+   /**
+    * Runs f, @return false if the VM ran out of memory while doing so.  The VM cannot report that,
+    * so the allocator jumps back here: f and the callbacks it reaches must not have objects with
+    * destructors alive while they call into the VM.
+    */
+   template<typename F>
+   bool run_vm( wren_context& ctx, F&& f )
+   {
+      if( setjmp( ctx.out_of_memory ) != 0 )
+         return false;
+      f();
+      return true;
+   }
+
+   /// Every block the VM takes costs gas by its size, charged at the next tick or when the call ends
+   void* wren_reallocate( void* memory, size_t size )
+   {
+      wren_context& ctx = *current_context;
+      if( size > ctx.max_allocation )
+         std::longjmp( ctx.out_of_memory, 1 );
+      size_t allocated = 0;
+      void* result = ctx.arena.reallocate( memory, size, allocated );
+      if( result == nullptr && size != 0 )
+         std::longjmp( ctx.out_of_memory, 1 );
+      ctx.heap_gas += uint64_t( allocated ) * GRAPHENE_CONTRACT_GAS_PER_HEAP_BYTE;
+      if( ctx.heap_gas > ctx.meter->remaining() )
+      {
+         ctx.out_of_gas = true;
+         std::longjmp( ctx.out_of_memory, 1 );
+      }
+      return result;
+   }
+
+   void wren_error( WrenVM*, WrenErrorType type, const char* /*module*/, int line, const char* message )
+   {
+      wren_context& ctx = *current_context;
+      if( !ctx.error.empty() || type == WREN_ERROR_STACK_TRACE )
+         return;
+      if( type != WREN_ERROR_COMPILE )
+      {
+         ctx.error = message;
+         return;
+      }
+      // report the line of the source as deployed
+      if( ctx.added_lines != nullptr )
+         line -= int( std::lower_bound( ctx.added_lines->begin(), ctx.added_lines->end(), uint32_t( line ) )
+                      - ctx.added_lines->begin() );
+      ctx.error = "line " + std::to_string( line ) + ": " + message;
+   }
+
+   /**
+    * Host side of a foreign method: runs f, which must not call into the VM.  An error, out of gas
+    * included, aborts the fiber and is kept: the call fails with it even if the contract catches
+    * the abort, and every foreign method called after it aborts again.
+    * @return false if the fiber was aborted
+    */
+   template<typename F>
+   bool run_host( WrenVM* vm, F&& f )
+   {
+      wren_context& ctx = *current_context;
+      if( !ctx.host_error )
+      {
+         try
+         {
+            f( ctx );
+            return true;
+         }
+         catch( ... )
+         {
+            ctx.host_error = std::current_exception();
+         }
+      }
+      wrenSetSlotHandle( vm, 0, ctx.abort_message );
+      wrenAbortFiber( vm, 0 );
+      return false;
+   }
+
+   string slot_string( WrenVM* vm, int slot, const char* what )
+   {
+      FC_ASSERT( wrenGetSlotType( vm, slot ) == WREN_TYPE_STRING, "${w} must be a string", ("w", what) );
+      int length = 0;
+      const char* bytes = wrenGetSlotBytes( vm, slot, &length );
+      return string( bytes, size_t( length ) );
+   }
+
+   contract_storage& host_storage( wren_context& ctx )
+   {
+      FC_ASSERT( ctx.storage != nullptr, "contract storage cannot be used while the contract is loaded" );
+      return *ctx.storage;
+   }
+
+   /// Storage.get(key): the value stored under key, or null
+   void storage_get( WrenVM* vm )
+   {
+      if( !run_host( vm, [vm]( wren_context& ctx ) {
+            ctx.host_value = host_storage( ctx ).get( slot_string( vm, 1, "storage key" ) );
+         } ) )
+         return;
+      const optional< vector<char> >& value = current_context->host_value;
+      if( value.valid() )
+         wrenSetSlotBytes( vm, 0, value->empty() ? "" : value->data(), value->size() );
+      else
+         wrenSetSlotNull( vm, 0 );
+   }
+
+   /// Storage.set(key, value)
+   void storage_set( WrenVM* vm )
+   {
+      if( !run_host( vm, [vm]( wren_context& ctx ) {
+            const string value = slot_string( vm, 2, "storage value" );
+            host_storage( ctx ).set( slot_string( vm, 1, "storage key" ), vector<char>( value.begin(), value.end() ) );
+         } ) )
+         return;
+      wrenSetSlotNull( vm, 0 );
+   }
+
+   /// Storage.remove(key): whether key was stored
+   void storage_remove( WrenVM* vm )
+   {
+      if( !run_host( vm, [vm]( wren_context& ctx ) {
+            ctx.host_flag = host_storage( ctx ).remove( slot_string( vm, 1, "storage key" ) );
+         } ) )
+         return;
+      wrenSetSlotBool( vm, 0, current_context->host_flag );
+   }
+
+   /// Storage.contains(key)
+   void storage_contains( WrenVM* vm )
+   {
+      if( !run_host( vm, [vm]( wren_context& ctx ) {
+            ctx.host_flag = host_storage( ctx ).contains( slot_string( vm, 1, "storage key" ) );
+         } ) )
+         return;
+      wrenSetSlotBool( vm, 0, current_context->host_flag );
+   }
+
+   /// Event.emit(name, data): adds an event to the result of the call
+   void event_emit( WrenVM* vm )
+   {
+      if( !run_host( vm, [vm]( wren_context& ctx ) {
+            const string data = slot_string( vm, 2, "event data" );
+            host_storage( ctx ).emit( slot_string( vm, 1, "event name" ), vector<char>( data.begin(), data.end() ) );
+         } ) )
+         return;
+      wrenSetSlotNull( vm, 0 );
+   }
+
+   /// Charges the gas of the allocations since the last charge
+   void charge_heap_gas( wren_context& ctx )
+   {
+      const uint64_t gas = ctx.heap_gas;
+      ctx.heap_gas = 0;
+      ctx.meter->charge( gas );
+   }
+
+   /// ContractGas_.tick(tokens), run by the metered source at the start of every block
+   void gas_tick( WrenVM* vm )
+   {
+      if( !run_host( vm, [vm]( wren_context& ctx ) {
+            const double tokens = wrenGetSlotDouble( vm, 1 );
+            FC_ASSERT( tokens >= 1 && tokens <= double( std::numeric_limits<uint32_t>::max() ) );
+            charge_heap_gas( ctx );
+            ctx.meter->charge( uint64_t( tokens ) * GRAPHENE_CONTRACT_GAS_PER_TOKEN );
+         } ) )
+         return;
+      // true, the metered source runs single expression blocks as tick(n) && (expression)
+      wrenSetSlotBool( vm, 0, true );
+   }
+
+   /// Classes defined in module "contract" before the contract source, implemented by the foreign methods below
+   const char* const host_prelude =
+      "class ContractGas_ {\n"
+      "   foreign static tick(tokens)\n"
+      "}\n"
+      "class Storage {\n"
+      "   foreign static get(key)\n"
+      "   foreign static set(key, value)\n"
+      "   foreign static remove(key)\n"
+      "   foreign static contains(key)\n"
+      "}\n"
+      "class Event {\n"
+      "   foreign static emit(name, data)\n"
+      "}\n";
+
+   WrenForeignMethodFn wren_bind_foreign_method( WrenVM*, const char* module, const char* class_name,
+                                                 bool is_static, const char* signature )
+   {
+      static const std::map< std::pair<string, string>, WrenForeignMethodFn > methods = {
+         { { "ContractGas_", "tick(_)" }, &gas_tick },
+         { { "Storage", "get(_)" },      &storage_get },
+         { { "Storage", "set(_,_)" },    &storage_set },
+         { { "Storage", "remove(_)" },   &storage_remove },
+         { { "Storage", "contains(_)" }, &storage_contains },
+         { { "Event", "emit(_,_)" },     &event_emit }
+      };
+      if( !is_static || string( module ) != "contract" )
+         return nullptr;
+      auto itr = methods.find( std::make_pair( string( class_name ), string( signature ) ) );
+      return itr == methods.end() ? nullptr : itr->second;
+   }
+
+   /// Integers a Num holds exactly
+   const int64_t wren_max_integer = int64_t( 1 ) << 53;
+
+   /// A call argument decoded from the call data, ready to go into a VM slot
+   struct wren_arg
+   {
+      contract_arg_type  type   = contract_arg_bool;
+      bool               flag   = false;
+      double             number = 0;
+      string             text;   ///< string and bytes, the id of an account or of the asset of an asset
+   };
+
+   double to_wren_number( int64_t value )
+   {
+      FC_ASSERT( value >= -wren_max_integer && value <= wren_max_integer,
+                 "contract argument ${v} is not exact as a Wren number", ("v", value) );
+      return double( value );
+   }
+
+   vector<wren_arg> decode_args( const contract_method& method, const char* data, size_t size )
+   {
+      fc::datastream<const char*> ds( data, size );
+      vector<wren_arg> args( method.args.size() );
+      for( size_t i = 0; i < args.size(); ++i )
+      {
+         wren_arg& arg = args[i];
+         arg.type = method.args[i];
+         switch( arg.type )
+         {
+            case contract_arg_bool:
+               fc::raw::unpack( ds, arg.flag );
+               break;
+            case contract_arg_int64:
+            {
+               int64_t v;
+               fc::raw::unpack( ds, v );
+               arg.number = to_wren_number( v );
+               break;
+            }
+            case contract_arg_uint64:
+            {
+               uint64_t v;
+               fc::raw::unpack( ds, v );
+               FC_ASSERT( v <= uint64_t( wren_max_integer ), "contract argument ${v} is not exact as a Wren number", ("v", v) );
+               arg.number = double( v );
+               break;
+            }
+            case contract_arg_string:
+               fc::raw::unpack( ds, arg.text );
+               break;
+            case contract_arg_bytes:
+            {
+               vector<char> v;
+               fc::raw::unpack( ds, v );
+               arg.text.assign( v.begin(), v.end() );
+               break;
+            }
+            case contract_arg_account:
+            {
+               account_id_type v;
+               fc::raw::unpack( ds, v );
+               arg.text = string( object_id_type( v ) );
+               break;
+            }
+            case contract_arg_asset:
+            {
+               asset v;
+               fc::raw::unpack( ds, v );
+               arg.number = to_wren_number( v.amount.value );
+               arg.text = string( object_id_type( v.asset_id ) );
+               break;
+            }
+         }
+      }
+      FC_ASSERT( ds.remaining() == 0, "extra bytes after the arguments of contract method ${m}", ("m", method.name) );
+      return args;
+   }
+
+   /// Puts arg into slot, scratch is a free slot used to build lists
+   void set_slot( WrenVM* vm, int slot, const wren_arg& arg, int scratch )
+   {
+      switch( arg.type )
+      {
+         case contract_arg_bool:
+            wrenSetSlotBool( vm, slot, arg.flag );
+            break;
+         case contract_arg_int64:
+         case contract_arg_uint64:
+            wrenSetSlotDouble( vm, slot, arg.number );
+            break;
+         case contract_arg_string:
+         case contract_arg_bytes:
+         case contract_arg_account:
+            wrenSetSlotBytes( vm, slot, arg.text.data(), arg.text.size() );
+            break;
+         case contract_arg_asset:
+            wrenSetSlotNewList( vm, slot );
+            wrenSetSlotDouble( vm, scratch, arg.number );
+            wrenInsertInList( vm, slot, -1, scratch );
+            wrenSetSlotBytes( vm, scratch, arg.text.data(), arg.text.size() );
+            wrenInsertInList( vm, slot, -1, scratch );
+            break;
+      }
+   }
+
+   const std::set<string>& wren_keywords()
+   {
+      static const std::set<string> keywords = {
+         "break", "class", "construct", "else", "false", "for", "foreign", "if", "import",
+         "in", "is", "null", "return", "static", "super", "this", "true", "var", "while"
+      };
+      return keywords;
+   }
+
+   bool is_name_char( char c ) { return std::isalnum( static_cast<unsigned char>( c ) ) || c == '_'; }
+
+   /// ABI method names must be plain Wren method names to be called
+   bool is_wren_method_name( const string& name )
+   {
+      if( name.empty() || !std::isalpha( static_cast<unsigned char>( name[0] ) ) || wren_keywords().count( name ) )
+         return false;
+      return std::all_of( name.begin(), name.end(), &is_name_char );
+   }
+
+   size_t source_line( const string& source, size_t offset )
+   {
+      return 1 + std::count( source.begin(), source.begin() + offset, '\n' );
+   }
+
+   /// Token of a contract source, told apart as far as metering the source needs
+   struct source_token
+   {
+      enum kind_type { name, keyword, number, string_part, punct, newline, end };
+
+      kind_type   kind;
+      string      text;
+      size_t      begin;
+      size_t      end;
+
+      bool is( kind_type k, const char* t )const { return kind == k && text == t; }
+   };
+
+   /// Splits source into tokens the way the Wren compiler does, dropping spaces and comments
+   vector<source_token> tokenize( const string& src )
+   {
+      static const char* const operators[] = { "...", "..", "||", "&&", "!=", "==", "<=", "<<", ">=", ">>" };
+      vector<source_token> tokens;
+      vector<int>          interpolations;   // parenthesis depth each open string interpolation ends at
+      int                  parens = 0;
+      size_t               i = 0;
+
+      auto push = [&]( source_token::kind_type kind, size_t begin ) {
+         tokens.push_back( source_token{ kind, src.substr( begin, i - begin ), begin, i } );
+      };
+      // from the quote starting a string, or the parenthesis ending an interpolation, to the end
+      // of the string or its next interpolation
+      auto read_string = [&]() {
+         const size_t begin = i++;
+         while( true )
+         {
+            FC_ASSERT( i < src.size(), "line ${l}: unterminated string", ("l", source_line( src, begin )) );
+            if( src[i] == '\\' )
+               i += 2;
+            else if( src[i] == '"' )
+            {
+               ++i;
+               break;
+            }
+            else if( src[i] == '%' && i + 1 < src.size() && src[i + 1] == '(' )
+            {
+               i += 2;
+               interpolations.push_back( parens );
+               break;
+            }
+            else
+               ++i;
+         }
+         push( source_token::string_part, begin );
+      };
+
+      while( i < src.size() )
+      {
+         const size_t begin = i;
+         const char c = src[i];
+         const char next = i + 1 < src.size() ? src[i + 1] : '\0';
+         if( c == ' ' || c == '\t' || c == '\r' )
+            ++i;
+         else if( c == '\n' )
+         {
+            ++i;
+            push( source_token::newline, begin );
+         }
+         else if( c == '/' && next == '/' )
+         {
+            while( i < src.size() && src[i] != '\n' )
+               ++i;
+         }
+         else if( c == '/' && next == '*' )
+         {
+            i += 2;
+            for( int depth = 1; depth > 0; )
+            {
+               FC_ASSERT( i < src.size(), "line ${l}: unterminated comment", ("l", source_line( src, begin )) );
+               if( src.compare( i, 2, "/*" ) == 0 )
+                  ++depth, i += 2;
+               else if( src.compare( i, 2, "*/" ) == 0 )
+                  --depth, i += 2;
+               else
+                  ++i;
+            }
+         }
+         else if( c == '"' || ( c == ')' && !interpolations.empty() && interpolations.back() == parens ) )
+         {
+            if( c == ')' )
+               interpolations.pop_back();
+            read_string();
+         }
+         else if( std::isalpha( static_cast<unsigned char>( c ) ) || c == '_' )
+         {
+            while( i < src.size() && is_name_char( src[i] ) )
+               ++i;
+            push( wren_keywords().count( src.substr( begin, i - begin ) ) ? source_token::keyword : source_token::name, begin );
+         }
+         else if( std::isdigit( static_cast<unsigned char>( c ) ) )
+         {
+            while( i < src.size() && ( is_name_char( src[i] ) || ( src[i] == '.' && i + 1 < src.size()
+                                                                    && std::isdigit( static_cast<unsigned char>( src[i + 1] ) ) ) ) )
+               ++i;
+            push( source_token::number, begin );
+         }
+         else
+         {
+            size_t length = 1;
+            for( const char* op : operators )
+               if( src.compare( i, std::strlen( op ), op ) == 0 )
+               {
+                  length = std::strlen( op );
+                  break;
+               }
+            FC_ASSERT( length > 1 || ( c != '\0' && std::strchr( "()[]{}:.,*/%+-|&!=<>~?^", c ) != nullptr ),
+                       "line ${l}: unexpected character in smart contract source", ("l", source_line( src, begin )) );
+            i += length;
+            if( c == '(' )
+               ++parens;
+            else if( c == ')' )
+               --parens;
+            push( source_token::punct, begin );
+         }
+      }
+      FC_ASSERT( interpolations.empty(), "unterminated string in smart contract source" );
+      push( source_token::end, i );
+      return tokens;
+   }
+
+   /// A contract source with gas ticks added
+   struct metered_source
+   {
+      string             source;
+      vector<uint32_t>   added_lines;   ///< lines of source that are not in the original, ascending
+   };
+
+   /**
+    * Adds ContractGas_.tick(n) at the start of every block of a contract source: method bodies, block
+    * arguments, and the bodies of if, else, while and for, n being the number of tokens of the block
+    * outside its inner blocks.  A block of statements gets the tick as its first line, a block of a
+    * single expression becomes tick(n) && (expression).  No loop, call or fiber of the contract runs
+    * without passing ticks.
+    *
+    * For that to hold, the top level of the source may only define classes whose superclass is a
+    * plain name, loop bodies must be braced, and import, foreign, ranges outside the header of a for
+    * loop, clock and gc and the Num methods computed by the C math library are rejected.
+    */
+   metered_source meter_source( const string& src )
+   {
+      static const std::set<string> banned_methods = {
+         "clock", "gc", "sin", "cos", "tan", "asin", "acos", "atan", "exp", "log", "log2", "pow", "cbrt"
+      };
+      enum frame_kind { paren_frame, bracket_frame, map_frame, block_frame, class_frame };
+      struct frame
+      {
+         explicit frame( frame_kind k ) : kind( k ) {}
+
+         frame_kind   kind;
+         bool         loop_header = false;   ///< parentheses of a while or for header
+         bool         for_header  = false;   ///< parentheses of a for header, where ranges are allowed
+         size_t       block_index = 0;       ///< index in blocks of a block frame
+      };
+      struct block
+      {
+         size_t       start      = 0;       ///< where the tick goes
+         bool         expression = false;   ///< a single expression, wrapped after the tick
+         bool         empty      = false;
+         size_t       last_end   = 0;       ///< end of the last token of the block
+         uint32_t     tokens     = 0;
+      };
+
+      const vector<source_token> tokens = tokenize( src );
+      vector<frame> frames;
+      vector<block> blocks;
+      int  class_header = -1;   // tokens read of "class Name is Super.Name", -1 outside a class header
+      int  pending_loop = 0;    // 1 right after while, 2 right after for
+      bool loop_body    = false;
+      const source_token* prev = nullptr;               // newlines included
+      const source_token* prev_significant = nullptr;
+
+      auto fail = [&src]( const source_token& t, const string& what ) {
+         FC_THROW( "line ${l}: ${w}", ("l", source_line( src, t.begin ))("w", what) );
+      };
+      auto count_token = [&]() {
+         for( auto f = frames.rbegin(); f != frames.rend(); ++f )
+            if( f->kind == block_frame )
+            {
+               ++blocks[f->block_index].tokens;
+               return;
+            }
+      };
+
+      for( size_t index = 0; tokens[index].kind != source_token::end; ++index )
+      {
+         const source_token& t = tokens[index];
+         if( loop_body && !t.is( source_token::punct, "{" ) )
+            fail( t, "loop bodies must be blocks in smart contracts" );
+
+         if( frames.empty() )
+         {
+            if( t.kind == source_token::newline )
+            {
+               prev = &t;
+               continue;
+            }
+            if( class_header < 0 )
+            {
+               if( !t.is( source_token::keyword, "class" ) || ( prev != nullptr && prev->kind != source_token::newline ) )
+                  fail( t, "the top level of a smart contract may only define classes" );
+               class_header = 0;
+            }
+            else if( t.kind == source_token::name && ( class_header == 0 || class_header == 2 ) )
+               class_header = class_header + 1;
+            else if( t.is( source_token::keyword, "is" ) && class_header == 1 )
+               class_header = 2;
+            else if( t.is( source_token::punct, "." ) && class_header == 3 )
+               class_header = 2;
+            else if( t.is( source_token::punct, "{" ) && ( class_header == 1 || class_header == 3 ) )
+            {
+               frames.push_back( frame( class_frame ) );
+               class_header = -1;
+            }
+            else
+               fail( t, "the superclass of a smart contract class must be a class name" );
+            prev = prev_significant = &t;
+            continue;
+         }
+
+         if( t.kind == source_token::newline )
+         {
+            prev = &t;
+            continue;
+         }
+         if( t.is( source_token::keyword, "import" ) || t.is( source_token::keyword, "foreign" ) )
+            fail( t, t.text + " is not allowed in smart contracts" );
+         if( t.is( source_token::keyword, "class" ) )
+            fail( t, "classes must be defined at the top level" );
+         if( t.is( source_token::name, "ContractGas_" ) )
+            fail( t, "ContractGas_ is reserved" );
+         if( t.kind == source_token::name && prev_significant->is( source_token::punct, "." ) && banned_methods.count( t.text ) )
+            fail( t, "method " + t.text + " is not available to smart contracts" );
+         if( ( t.is( source_token::punct, ".." ) || t.is( source_token::punct, "..." ) ) && !frames.back().for_header )
+            fail( t, "ranges are only allowed in the header of a for loop" );
+
+         const int loop = pending_loop;
+         pending_loop = t.is( source_token::keyword, "while" ) ? 1 : t.is( source_token::keyword, "for" ) ? 2 : 0;
+
+         if( t.is( source_token::punct, "(" ) )
+         {
+            count_token();
+            frame f( paren_frame );
+            f.loop_header = loop != 0;
+            f.for_header  = loop == 2;
+            frames.push_back( f );
+         }
+         else if( t.is( source_token::punct, "[" ) )
+         {
+            count_token();
+            frames.push_back( frame( bracket_frame ) );
+         }
+         else if( t.is( source_token::punct, ")" ) || t.is( source_token::punct, "]" ) )
+         {
+            if( frames.back().kind != ( t.text == ")" ? paren_frame : bracket_frame ) )
+               fail( t, "unbalanced " + t.text );
+            loop_body = frames.back().loop_header;
+            frames.pop_back();
+            count_token();
+         }
+         else if( t.is( source_token::punct, "{" ) )
+         {
+            count_token();
+            const frame& top = frames.back();
+            bool is_block;
+            if( top.kind == class_frame || loop_body )
+               is_block = true;
+            else if( prev->kind == source_token::newline )
+               is_block = top.kind == block_frame;
+            else
+               is_block = prev->kind == source_token::name || prev->is( source_token::keyword, "else" )
+                          || prev->is( source_token::keyword, "super" ) || prev->is( source_token::punct, ")" )
+                          || prev->is( source_token::punct, "]" );
+            loop_body = false;
+
+            frame f( is_block ? block_frame : map_frame );
+            if( is_block )
+            {
+               block b;
+               b.start = t.end;
+               size_t k = index + 1;
+               if( tokens[k].is( source_token::punct, "|" ) )
+               {
+                  do
+                     ++k;
+                  while( tokens[k].kind != source_token::end && !tokens[k].is( source_token::punct, "|" ) );
+                  if( tokens[k].kind == source_token::end )
+                     fail( t, "unterminated block parameters" );
+                  b.start = tokens[k++].end;
+               }
+               b.expression = tokens[k].kind != source_token::newline;
+               b.empty      = tokens[k].is( source_token::punct, "}" );
+               if( !b.expression )
+                  b.start = tokens[k].end;
+               f.block_index = blocks.size();
+               blocks.push_back( b );
+            }
+            frames.push_back( f );
+         }
+         else if( t.is( source_token::punct, "}" ) )
+         {
+            const frame& top = frames.back();
+            if( top.kind != map_frame && top.kind != block_frame && top.kind != class_frame )
+               fail( t, "unbalanced }" );
+            if( top.kind == block_frame )
+               blocks[top.block_index].last_end = prev_significant->end;
+            frames.pop_back();
+            count_token();
+         }
+         else
+            count_token();
+
+         prev = prev_significant = &t;
+      }
+      FC_ASSERT( frames.empty() && class_header < 0, "smart contract source ends inside a class" );
+
+      struct insertion
+      {
+         size_t   offset;
+         string   text;
+      };
+      vector<insertion> insertions;
+      for( const block& b : blocks )
+      {
+         const string tick = "ContractGas_.tick(" + std::to_string( std::max<uint32_t>( b.tokens, 1 ) ) + ")";
+         if( !b.expression )
+            insertions.push_back( { b.start, tick + "\n" } );
+         else if( b.empty )
+            insertions.push_back( { b.start, " " + tick + " && null " } );
+         else
+         {
+            insertions.push_back( { b.start, " " + tick + " && (" } );
+            insertions.push_back( { b.last_end, ")" } );
+         }
+      }
+      std::stable_sort( insertions.begin(), insertions.end(),
+                        []( const insertion& a, const insertion& b ) { return a.offset < b.offset; } );
+
+      metered_source result;
+      uint32_t line = 1;
+      size_t done = 0;
+      for( const insertion& ins : insertions )
+      {
+         line += uint32_t( std::count( src.begin() + done, src.begin() + ins.offset, '\n' ) );
+         result.source.append( src, done, ins.offset - done );
+         done = ins.offset;
+         if( ins.text.back() == '\n' )
+            result.added_lines.push_back( line++ );
+         result.source += ins.text;
+      }
+      result.source.append( src, done, string::npos );
+      return result;
+   }
+
+   class wren_vm_impl
+   {
+      public:
+         wren_vm_impl( const string& source, const contract_abi& abi );
+
+         /// @param result if not null, set to what the toString of the method result returns
+         void run( const contract_method& method, const char* args, size_t args_size,
+                   contract_storage& storage, contract_gas_meter& meter, string* result = nullptr );
+
+         const contract_abi                                 abi;
+         const contract_method_selector                     init = contract_abi::selector( "init" );
+
+      private:
+         wren_arena                                         _arena;
+         WrenVM*                                            _vm             = nullptr;
+         WrenHandle*                                        _contract_class = nullptr;
+         WrenHandle*                                        _abort_message  = nullptr;
+         WrenHandle*                                        _to_string      = nullptr;
+         flat_map<contract_method_selector, WrenHandle*>    _methods;
+         std::mutex                                         _running;
+   };
+
+   wren_vm_impl::wren_vm_impl( const string& source, const contract_abi& code_abi )
+      : abi( code_abi ), _arena( GRAPHENE_DEFAULT_CONTRACT_CALL_MEMORY_LIMIT )
+   {
+      vector<string> signatures;
+      for( const auto& m : abi.methods )
+      {
+         FC_ASSERT( is_wren_method_name( m.second.name ), "ABI method ${m} is not a Wren method name", ("m", m.second.name) );
+         string signature = m.second.name + "(";
+         for( size_t i = 0; i < m.second.args.size(); ++i )
+            signature += i == 0 ? "_" : ",_";
+         signatures.push_back( signature + ")" );
+         _methods[m.first] = nullptr;
+      }
+
+      const metered_source metered = meter_source( source );
+      contract_gas_meter load_meter( GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT );
+      wren_context ctx( _arena );
+      ctx.meter       = &load_meter;
+      ctx.added_lines = &metered.added_lines;
+      scoped_wren_context scope( ctx );
+      WrenInterpretResult result = WREN_RESULT_SUCCESS;
+      const bool fits = run_vm( ctx, [&]() {
+         WrenConfiguration config;
+         wrenInitConfiguration( &config );
+         config.reallocateFn        = &wren_reallocate;
+         config.errorFn             = &wren_error;
+         config.bindForeignMethodFn = &wren_bind_foreign_method;
+         // collect well before the buffer is full, blocks are rounded up to powers of two
+         config.initialHeapSize     = _arena.capacity() / 8;
+         config.minHeapSize         = _arena.capacity() / 32;
+         _vm = wrenNewVM( &config );
+         wrenEnsureSlots( _vm, 1 );
+         wrenSetSlotString( _vm, 0, "aborted by the host" );
+         _abort_message = ctx.abort_message = wrenGetSlotHandle( _vm, 0 );
+
+         result = wrenInterpret( _vm, "contract", host_prelude );
+         if( result == WREN_RESULT_SUCCESS )
+            result = wrenInterpret( _vm, "contract", metered.source.c_str() );
+         // fails to compile if Contract is not defined
+         if( result == WREN_RESULT_SUCCESS )
+            result = wrenInterpret( _vm, "contract", "Contract" );
+         if( result != WREN_RESULT_SUCCESS )
+            return;
+
+         wrenEnsureSlots( _vm, 1 );
+         wrenGetVariable( _vm, "contract", "Contract", 0 );
+         _contract_class = wrenGetSlotHandle( _vm, 0 );
+         size_t i = 0;
+         for( auto& m : _methods )
+            m.second = wrenMakeCallHandle( _vm, signatures[i++].c_str() );
+         _to_string = wrenMakeCallHandle( _vm, "toString" );
+         wrenCollectGarbage( _vm );
+      });
+      FC_ASSERT( fits && !ctx.out_of_gas, "smart contract does not fit the VM memory of ${n} bytes and ${g} gas",
+                 ("n", _arena.capacity())("g", load_meter.limit()) );
+      if( ctx.host_error )
+         std::rethrow_exception( ctx.host_error );
+      FC_ASSERT( result == WREN_RESULT_SUCCESS, "smart contract does not compile: ${e}", ("e", ctx.error) );
+      _arena.snapshot();
+   }
+
+   void wren_vm_impl::run( const contract_method& method, const char* data, size_t size,
+                           contract_storage& storage, contract_gas_meter& meter, string* result_text )
+   {
+      const vector<wren_arg> args = decode_args( method, data, size );
+      WrenHandle* const handle = _methods.at( contract_abi::selector( method.name ) );
+      const int scratch = int( args.size() ) + 1;
+
+      std::lock_guard<std::mutex> lock( _running );
+
+      _arena.restore();
+      _arena.set_limit( meter.memory_limit() );
+      wren_context ctx( _arena );
+      ctx.storage        = &storage;
+      ctx.meter          = &meter;
+      ctx.abort_message  = _abort_message;
+      ctx.max_allocation = GRAPHENE_CONTRACT_MAX_VM_ALLOCATION;
+      scoped_wren_context scope( ctx );
+      WrenInterpretResult result = WREN_RESULT_RUNTIME_ERROR;
+      bool finished = false;
+      bool is_text = false;
+      const bool fits = run_vm( ctx, [&]() {
+         wrenEnsureSlots( _vm, scratch + 1 );
+         wrenSetSlotHandle( _vm, 0, _contract_class );
+         for( size_t i = 0; i < args.size(); ++i )
+            set_slot( _vm, int( i ) + 1, args[i], scratch );
+         result = wrenCall( _vm, handle );
+         // a fiber suspended at the root returns without a result
+         finished = wrenGetSlotCount( _vm ) > 0;
+         if( result_text == nullptr || result != WREN_RESULT_SUCCESS || !finished )
+            return;
+         // the result is left in slot 0, the receiver of toString
+         result = wrenCall( _vm, _to_string );
+         finished = wrenGetSlotCount( _vm ) > 0;
+         if( result != WREN_RESULT_SUCCESS || !finished )
+            return;
+         is_text = wrenGetSlotType( _vm, 0 ) == WREN_TYPE_STRING;
+         if( is_text )
+         {
+            int length = 0;
+            const char* bytes = wrenGetSlotBytes( _vm, 0, &length );
+            result_text->assign( bytes, size_t( length ) );
+         }
+      });
+      if( ctx.host_error )
+         std::rethrow_exception( ctx.host_error );
+      // throws out of gas if the call stopped for the gas of its allocations
+      charge_heap_gas( ctx );
+      FC_ASSERT( fits, "smart contract call exceeded the VM memory of ${n} bytes or allocated more than ${a} bytes at once",
+                 ("n", std::min<uint64_t>( _arena.capacity(), meter.memory_limit() ))("a", ctx.max_allocation) );
+      FC_ASSERT( result == WREN_RESULT_SUCCESS, "smart contract method ${m} failed: ${e}", ("m", method.name)("e", ctx.error) );
+      FC_ASSERT( finished, "smart contract method ${m} suspended its fiber", ("m", method.name) );
+      FC_ASSERT( result_text == nullptr || is_text, "toString of the result of smart contract method ${m} is not a string",
+                 ("m", method.name) );
+   }
+
+}
+
+wren_vm::wren_vm( const string& source, const contract_abi& abi )
+   : my( new detail::wren_vm_impl( source, abi ) )
+{
+}
+
+wren_vm::~wren_vm()
+{
+}
+
+void wren_vm::call( const string& call_data, contract_storage& storage, contract_gas_meter& meter )
+{
+   const contract_method* method = my->abi.find( contract_abi::call_selector( call_data ) );
+   FC_ASSERT( method != nullptr && method->name != "init", "smart contract has no such method" );
+   my->run( *method, call_data.data() + contract_abi::selector_size, call_data.size() - contract_abi::selector_size,
+            storage, meter );
+}
+
+string wren_vm::query( const string& call_data, contract_storage& storage, contract_gas_meter& meter )
+{
+   const contract_method* method = my->abi.find( contract_abi::call_selector( call_data ) );
+   FC_ASSERT( method != nullptr && method->name != "init", "smart contract has no such method" );
+   string result;
+   my->run( *method, call_data.data() + contract_abi::selector_size, call_data.size() - contract_abi::selector_size,
+            storage, meter, &result );
+   return result;
+}
+
+void wren_vm::construct( const string& construct_data, contract_storage& storage, contract_gas_meter& meter )
+{
+   const contract_method* init = my->abi.find( my->init );
+   if( init == nullptr )
+   {
+      FC_ASSERT( construct_data.empty(), "smart contract without init takes no constructor arguments" );
+      return;
+   }
+   my->run( *init, construct_data.data(), construct_data.size(), storage, meter );
+}
+
+} } // graphene::chain
@@ -35,6 +35,7 @@ int object_id_comp(Db* db, const Dbt* key1, const Dbt* key2, size_t* size);
 
 #define _BDB_DATA_VERSION       -1ll
 #define _BDB_NEXT_ID            -2ll
+#define _BDB_WATERMARK          -3ll
 #define _BDB_SDB_DONOTINDEX(k)  (((k) & 0xFFFFFFFFFFFFFF00) == 0xFFFFFFFFFFFFFF00 )
 namespace graphene { namespace db {
 
@@ -209,6 +210,19 @@ public:
         return !ret;
     }
 
+    // stores an object which the caller has already packed, under an id it allocated itself.
+    // Nothing is reported to the object database, deferred writers track undo on their own.
+    void put_packed(object_id_type id, const vector<char>& packed)
+    {
+        uint64_t uid = (uint64_t)id;
+        Dbt key(&uid, sizeof(uid));
+        Dbt data(const_cast<char*>(packed.data()), packed.size());
+
+        int ret = _bdb->put(nullptr, &key, &data, 0);
+
+        FC_ASSERT(!ret, "Could not insert object into berkeley db. ret=${ret}, id:${id}", ("ret", ret) ("id", (std::string)id));
+    }
+
     virtual void modify(const object& obj, const std::function<void(object&)>& modify_callback) override
     {
         assert(nullptr != dynamic_cast<const ObjectType*>(&obj));
@@ -312,6 +326,20 @@ public:
         }
     }
 
+    // gives the pages of deleted records back to the file system, for the primary and secondary indexes
+    void compact()
+    {
+        DB_COMPACT c_data;
+        memset(&c_data, 0, sizeof(c_data));
+        int ret = _bdb->compact(nullptr, nullptr, nullptr, &c_data, DB_FREE_SPACE, nullptr);
+        FC_ASSERT(!ret, "Berkeley DB: could not compact, ret=${ret}", ("ret", ret));
+        ilog("Berkeley DB: compacted ${s}.${t}, ${p} pages freed",
+             ("s", object_type::space_id) ("t", object_type::type_id) ("p", c_data.compact_pages_truncated));
+
+        for (auto& sindex : _s_indexs)
+            sindex->compact();
+    }
+
     void save_next_id()
     {
         int64_t k = _BDB_NEXT_ID;
@@ -341,6 +369,31 @@ public:
             std::cout << "Berkeley DB: Loaded next_id: " << (std::string)next_id << std::endl;
         }
     }
+    // an application defined position, e.g. the last block whose objects are all stored.
+    // Synced together with everything written before it.
+    void save_watermark(uint32_t watermark)
+    {
+        int64_t k = _BDB_WATERMARK;
+        Dbt key((void*)(&k), sizeof(k));
+
+        Dbt data(&watermark, sizeof(watermark));
+        int ret = _bdb->put(nullptr, &key, &data, 0);
+        FC_ASSERT(!ret, "Berkeley DB: could not save the watermark, ret=${ret}", ("ret", ret));
+        flush();
+    }
+
+    bool load_watermark(uint32_t& watermark)
+    {
+        int64_t k = _BDB_WATERMARK;
+        Dbt key((void*)(&k), sizeof(k));
+
+        Dbt data;
+        data.set_data(&watermark);
+        data.set_ulen(sizeof(watermark));
+        data.set_flags(DB_DBT_USERMEM);
+        return !_bdb->get(nullptr, &key, &data, 0);
+    }
+
     void save_data_version(fc::sha256& version)
     {
         int64_t k = _BDB_DATA_VERSION;
@@ -621,6 +674,9 @@ private:
 
 typedef int(*key_comp_fun)(Db*, const Dbt*, const Dbt*, size_t*);
 
+// what bdb_secondary_index::erase_where() does with the record under its cursor
+enum class bdb_cursor_action { erase, keep, stop };
+
 template<typename ObjectType>
 class bdb_secondary_index
 {
@@ -699,7 +755,53 @@ public:
         return obj;
     }
 
+    // walks the index with one write cursor, from the first key not less than the given one,
+    // and deletes the records for which decide() returns erase, until it returns stop.
+    // Deleting through a secondary index deletes the primary record and its other secondary keys.
+    // Returns the number of records deleted.
+    uint32_t erase_where(void* key, u_int32_t size, const std::function<bdb_cursor_action(const object_type&)>& decide)
+    {
+        Dbc* cursorp;
+        int ret = _bdb->cursor(nullptr, &cursorp, DB_WRITECURSOR);
+        FC_ASSERT(!ret, "Berkeley DB: could not open write cursor, ret=${ret}", ("ret", ret));
 
+        uint32_t erased = 0;
+        Dbt skey(key, size);
+        Dbt data;
+        ret = cursorp->get(&skey, &data, DB_SET_RANGE);
+        while (!ret)
+        {
+            object_type obj;
+            fc::raw::unpack<ObjectType>((const char*)data.get_data(), data.get_size(), obj);
+
+            auto action = decide(obj);
+            if (action == bdb_cursor_action::stop)
+                break;
+            if (action == bdb_cursor_action::erase)
+            {
+                ret = cursorp->del(0);
+                if (ret)
+                {
+                    wlog("Berkeley DB: erase_where(): could not delete ${id}, ret=${ret}", ("id", (std::string)obj.id) ("ret", ret));
+                    break;
+                }
+                ++erased;
+            }
+            ret = cursorp->get(&skey, &data, DB_NEXT);
+        }
+        cursorp->close();
+        return erased;
+    }
+
+    // gives the pages of deleted records back to the file system
+    void compact()
+    {
+        DB_COMPACT c_data;
+        memset(&c_data, 0, sizeof(c_data));
+        int ret = _bdb->compact(nullptr, nullptr, nullptr, &c_data, DB_FREE_SPACE, nullptr);
+        FC_ASSERT(!ret, "Berkeley DB: could not compact, ret=${ret}", ("ret", ret));
+        ilog("Berkeley DB: compacted secondary index, ${p} pages freed", ("p", c_data.compact_pages_truncated));
+    }
 
 private:
     bdb_iterator<object_type> open_cursor(void* key, u_int32_t size, u_int32_t flags = DB_SET_RANGE) const
@@ -26,6 +26,7 @@
 #include <graphene/db/object.hpp>
 #include <graphene/db/index.hpp>
 #include <graphene/db/undo_database.hpp>
+#include <graphene/db/object_snapshot.hpp>
 
 #include <fc/log/logger.hpp>
 
@@ -43,7 +44,13 @@ namespace graphene { namespace db {
          object_database();
          ~object_database();
 
-         void reset_indexes() { _index.clear(); _index.resize(255); }
+         void reset_indexes()
+         {
+            _index.clear(); _index.resize(255);
+            // change trackers were attached to the old indexes, next publish rebuilds from scratch
+            _snapshot_tracking = false;
+            _snapshot_dirty.clear();
+         }
 
          void open(const fc::path& data_dir );
 
@@ -196,6 +203,21 @@ namespace graphene { namespace db {
 
          void pop_undo();
 
+         /**
+          * Read snapshots are opt-in because every published revision keeps its own copy of the
+          * objects changed since the previous one.  Once enabled, publish_snapshot() captures the
+          * current state of all in-memory indexes and get_snapshot() may be called from any thread.
+          */
+         /// @{
+         void enable_snapshots() { _snapshots_enabled = true; }
+         bool snapshots_enabled()const { return _snapshots_enabled; }
+         void publish_snapshot( uint32_t revision );
+         /// @return the most recently published snapshot, or null if none was published yet
+         object_snapshot_ptr get_snapshot()const { return std::atomic_load( &_snapshot ); }
+         /// makes objects of the given type available through object_snapshot::find_by_key()
+         void add_snapshot_key( uint8_t space_id, uint8_t type_id, object_snapshot::key_function key );
+         /// @}
+
          fc::path get_data_dir()const { return _data_dir; }
 
          /** public for testing purposes only... should be private in practice. */
@@ -221,6 +243,12 @@ namespace graphene { namespace db {
 
          fc::path                                                  _data_dir;
          vector< vector< unique_ptr<index> > >                     _index;
+
+         bool                                                      _snapshots_enabled = false;
+         bool                                                      _snapshot_tracking = false;
+         vector<object_id_type>                                    _snapshot_dirty;
+         std::map< uint16_t, object_snapshot::key_function >       _snapshot_keys;
+         object_snapshot_ptr                                       _snapshot;
    };
 
 } } // graphene::db
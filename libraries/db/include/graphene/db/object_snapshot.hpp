@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/db/object.hpp>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /**
+    * @class object_snapshot
+    * @brief Immutable view of the in-memory objects of an object_database at one revision
+    *
+    * Snapshots are published by object_database::publish_snapshot() and share unchanged objects with
+    * the previous revision: objects are kept in fixed-size chunks, and publishing a new revision only
+    * copies the chunks which contain objects changed since the last one (copy-on-write).
+    *
+    * A published snapshot never changes, so any thread holding a pointer to it may read from it
+    * without locking while the database keeps applying blocks.  Pointers returned by find() stay
+    * valid as long as the snapshot is held.  Objects of external (Berkeley DB) indexes are not
+    * part of snapshots, they can be read from the database directly.
+    *
+    * Object types registered with object_database::add_snapshot_key() can also be looked up by a
+    * unique string key, such as the account name, so that readers never have to consult the live
+    * indexes.  The keys are hashed into buckets which are shared between revisions the same way.
+    */
+   class object_snapshot
+   {
+      public:
+         static const uint32_t chunk_bits = 10;
+         static const uint64_t chunk_size = uint64_t(1) << chunk_bits;
+
+         typedef std::shared_ptr<const object>               object_ptr;
+         typedef std::vector<object_ptr>                     chunk_type;
+         typedef std::vector< std::shared_ptr<chunk_type> >  table_type;
+         typedef std::function<std::string( const object& )>  key_function;
+
+         static const uint32_t key_buckets = 1024;
+
+         /// head block number the snapshot was published at
+         uint32_t revision()const { return _revision; }
+
+         const object* find_object( object_id_type id )const;
+
+         template<typename T>
+         const T* find( object_id_type id )const
+         {
+            const object* obj = find_object( id );
+            assert( !obj || nullptr != dynamic_cast<const T*>(obj) );
+            return static_cast<const T*>(obj);
+         }
+
+         template<uint8_t SpaceID, uint8_t TypeID, typename T>
+         const T* find( object_id<SpaceID,TypeID,T> id )const { return find<T>(id); }
+
+         /// @return the object of the given type stored under key, null if there is none or the type has no key
+         const object* find_by_key( uint8_t space_id, uint8_t type_id, const std::string& key )const;
+
+         template<typename T>
+         const T* find_by_key( const std::string& key )const
+         {
+            const object* obj = find_by_key( T::space_id, T::type_id, key );
+            assert( !obj || nullptr != dynamic_cast<const T*>(obj) );
+            return static_cast<const T*>(obj);
+         }
+
+      private:
+         friend class object_database;
+
+         typedef std::vector< std::pair<std::string, object_id_type> > key_bucket;
+         struct key_table
+         {
+            key_function                               key;
+            std::vector< std::shared_ptr<key_bucket> > buckets;
+         };
+
+         /// start keeping the keys of a type, must be called before any object of that type is set()
+         void add_key( uint8_t space_id, uint8_t type_id, key_function key );
+
+         /// replace the object stored under id, copying its chunk first if it is shared
+         void set( object_id_type id, object_ptr obj );
+
+         /// replace the key entry of id in its bucket, copying the bucket first if it is shared
+         static void set_key( key_table& table, const std::string& key, object_id_type id, bool present );
+
+         uint32_t                                _revision = 0;
+         std::vector< std::vector<table_type> >  _tables; ///< [space][type][instance >> chunk_bits]
+         std::map< uint16_t, key_table >         _keys;   ///< keyed by (space << 8) | type
+   };
+
+   typedef std::shared_ptr<const object_snapshot> object_snapshot_ptr;
+
+} } // graphene::db
@@ -28,8 +28,26 @@
 #include <fc/container/flat.hpp>
 #include <fc/uint128.hpp>
 
+#include <algorithm>
+
 namespace graphene { namespace db {
 
+namespace detail {
+   /** records the ids of objects changed since the last published snapshot */
+   class snapshot_tracker : public index_observer
+   {
+      public:
+         explicit snapshot_tracker( vector<object_id_type>& dirty ) : _dirty( dirty ) {}
+
+         virtual void on_add( const object& obj ) override    { _dirty.push_back( obj.id ); }
+         virtual void on_remove( const object& obj ) override { _dirty.push_back( obj.id ); }
+         virtual void on_modify( const object& obj ) override { _dirty.push_back( obj.id ); }
+
+      private:
+         vector<object_id_type>& _dirty;
+   };
+}
+
 object_database::object_database()
 :_undo_db(*this)
 {
@@ -97,6 +115,53 @@ index& object_database::get_mutable_index(uint8_t space_id, uint8_t type_id)
    return *idx;
 }
 
+void object_database::publish_snapshot( uint32_t revision )
+{ try {
+   FC_ASSERT( _snapshots_enabled );
+
+   auto next = std::make_shared<object_snapshot>();
+   if( !_snapshot_tracking )
+   {
+      _snapshot_dirty.clear();
+      for( const auto& key : _snapshot_keys )
+         next->add_key( key.first >> 8, key.first & 0xff, key.second );
+      for( const auto& space : _index )
+         for( const auto& idx : space )
+         {
+            if( !idx || idx->is_external_db() )
+               continue;
+            idx->add_observer( std::make_shared<detail::snapshot_tracker>( _snapshot_dirty ) );
+            idx->inspect_all_objects( [&]( const object& o ) {
+               next->set( o.id, object_snapshot::object_ptr( o.clone() ) );
+            });
+         }
+      _snapshot_tracking = true;
+   }
+   else
+   {
+      // shares every chunk with the previous revision, set() copies the chunks it writes to
+      *next = *get_snapshot();
+      std::sort( _snapshot_dirty.begin(), _snapshot_dirty.end() );
+      auto end = std::unique( _snapshot_dirty.begin(), _snapshot_dirty.end() );
+      for( auto itr = _snapshot_dirty.begin(); itr != end; ++itr )
+      {
+         const object* obj = find_object( *itr );
+         next->set( *itr, obj ? object_snapshot::object_ptr( obj->clone() ) : object_snapshot::object_ptr() );
+      }
+      _snapshot_dirty.clear();
+   }
+   next->_revision = revision;
+
+   std::atomic_store( &_snapshot, object_snapshot_ptr( std::move( next ) ) );
+} FC_CAPTURE_AND_RETHROW( (revision) ) }
+
+void object_database::add_snapshot_key( uint8_t space_id, uint8_t type_id, object_snapshot::key_function key )
+{
+   // the key table is filled when the snapshot is built from scratch
+   FC_ASSERT( !_snapshot_tracking, "snapshot keys must be added before the first snapshot is published" );
+   _snapshot_keys[ (uint16_t(space_id) << 8) | type_id ] = std::move( key );
+}
+
 void object_database::flush()
 {
 //   ilog("Save object_database in ${d}", ("d", _data_dir));
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/db/object_snapshot.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace db {
+
+const object* object_snapshot::find_object( object_id_type id )const
+{
+   if( id.space() >= _tables.size() )
+      return nullptr;
+   const auto& types = _tables[id.space()];
+   if( id.type() >= types.size() )
+      return nullptr;
+   const auto& table = types[id.type()];
+   uint64_t c = id.instance() >> chunk_bits;
+   if( c >= table.size() || !table[c] )
+      return nullptr;
+   return (*table[c])[ id.instance() & (chunk_size - 1) ].get();
+}
+
+const object* object_snapshot::find_by_key( uint8_t space_id, uint8_t type_id, const std::string& key )const
+{
+   auto itr = _keys.find( (uint16_t(space_id) << 8) | type_id );
+   if( itr == _keys.end() )
+      return nullptr;
+   const auto& bucket = itr->second.buckets[ std::hash<std::string>()( key ) % key_buckets ];
+   if( !bucket )
+      return nullptr;
+   for( const auto& entry : *bucket )
+      if( entry.first == key )
+         return find_object( entry.second );
+   return nullptr;
+}
+
+void object_snapshot::add_key( uint8_t space_id, uint8_t type_id, key_function key )
+{
+   auto& table = _keys[ (uint16_t(space_id) << 8) | type_id ];
+   table.key = std::move( key );
+   table.buckets.clear();
+   table.buckets.resize( key_buckets );
+}
+
+void object_snapshot::set_key( key_table& table, const std::string& key, object_id_type id, bool present )
+{
+   auto& bucket = table.buckets[ std::hash<std::string>()( key ) % key_buckets ];
+   if( !bucket )
+      bucket = std::make_shared<key_bucket>();
+   else if( bucket.use_count() > 1 )
+      bucket = std::make_shared<key_bucket>( *bucket );
+
+   auto itr = std::find_if( bucket->begin(), bucket->end(),
+                            [&]( const std::pair<std::string, object_id_type>& e ) { return e.second == id; } );
+   if( itr != bucket->end() )
+      bucket->erase( itr );
+   if( present )
+      bucket->emplace_back( key, id );
+}
+
+void object_snapshot::set( object_id_type id, object_ptr obj )
+{
+   if( _tables.size() <= id.space() )
+      _tables.resize( id.space() + 1 );
+   auto& types = _tables[id.space()];
+   if( types.size() <= id.type() )
+      types.resize( id.type() + 1 );
+   auto& table = types[id.type()];
+   uint64_t c = id.instance() >> chunk_bits;
+   if( table.size() <= c )
+      table.resize( c + 1 );
+
+   auto& chunk = table[c];
+   if( !chunk )
+   {
+      if( !obj )
+         return;
+      chunk = std::make_shared<chunk_type>( size_t( chunk_size ) );
+   }
+   else if( chunk.use_count() > 1 )
+   {
+      // still referenced by an earlier revision, which must not change
+      chunk = std::make_shared<chunk_type>( *chunk );
+   }
+   auto& slot = (*chunk)[ id.instance() & (chunk_size - 1) ];
+
+   auto keys = _keys.find( (uint16_t(id.space()) << 8) | id.type() );
+   if( keys != _keys.end() )
+   {
+      if( slot )
+         set_key( keys->second, keys->second.key( *slot ), id, false );
+      if( obj )
+         set_key( keys->second, keys->second.key( *obj ), id, true );
+   }
+   slot = std::move( obj );
+}
+
+} } // graphene::db
@@ -180,6 +180,16 @@ namespace graphene { namespace net {
       fc::variant_object info;
    };
 
+   /**
+    *  Running totals of the item payload bytes this node has sent in reply to
+    *  fetch requests from its peers, since the node was started.
+    */
+   struct node_traffic_totals
+   {
+      uint64_t         bytes_served  = 0; ///< items read back from the blockchain through the delegate
+      uint64_t         bytes_relayed = 0; ///< items forwarded from the message cache
+   };
+
    /**
     *  @class node
     *  @brief provides application independent P2P broadcast and data synchronization
@@ -287,6 +297,7 @@ namespace graphene { namespace net {
 
         fc::variant_object network_get_info() const;
         fc::variant_object network_get_usage_stats() const;
+        node_traffic_totals get_traffic_totals() const;
 
         std::vector<potential_peer_record> get_potential_peers() const;
 
@@ -326,3 +337,4 @@ namespace graphene { namespace net {
 
 FC_REFLECT(graphene::net::message_propagation_data, (received_time)(validated_time)(originating_peer));
 FC_REFLECT( graphene::net::peer_status, (version)(host)(info) );
+FC_REFLECT( graphene::net::node_traffic_totals, (bytes_served)(bytes_relayed) );
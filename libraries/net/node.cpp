@@ -2265,6 +2265,7 @@ namespace graphene { namespace net { namespace detail {
           dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                ("endpoint", originating_peer->get_remote_endpoint())
                ("id", requested_message.id()));
+          _traffic_totals.bytes_relayed += requested_message.size;
           reply_messages.push_back(requested_message);
           if (fetch_items_message_received.item_type == block_message_type)
             last_block_message_sent = requested_message;
@@ -2283,6 +2284,7 @@ namespace graphene { namespace net { namespace detail {
                ("id", requested_message.id())
                ("size", requested_message.size)
                ("endpoint", originating_peer->get_remote_endpoint()));
+          _traffic_totals.bytes_served += requested_message.size;
           reply_messages.push_back(requested_message);
           if (fetch_items_message_received.item_type == block_message_type)
             last_block_message_sent = requested_message;
@@ -4574,6 +4576,12 @@ namespace graphene { namespace net { namespace detail {
       _peer_advertising_disabled = true;
     }
 
+    node_traffic_totals node_impl::get_traffic_totals() const
+    {
+      VERIFY_CORRECT_THREAD();
+      return _traffic_totals;
+    }
+
     fc::variant_object node_impl::get_call_statistics() const
     {
       VERIFY_CORRECT_THREAD();
@@ -4798,6 +4806,11 @@ namespace graphene { namespace net { namespace detail {
     INVOKE_IN_IMPL(network_get_usage_stats);
   }
 
+  node_traffic_totals node::get_traffic_totals() const
+  {
+    INVOKE_IN_IMPL(get_traffic_totals);
+  }
+
   void node::close()
   {
     INVOKE_IN_IMPL(close);
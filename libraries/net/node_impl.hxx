@@ -305,6 +305,8 @@ class node_impl : public peer_connection_delegate
       unsigned _average_network_usage_second_counter;
       unsigned _average_network_usage_minute_counter;
 
+      node_traffic_totals _traffic_totals;
+
       fc::time_point_sec _bandwidth_monitor_last_update_time;
       fc::future<void> _bandwidth_monitor_loop_done;
 
@@ -513,6 +515,7 @@ class node_impl : public peer_connection_delegate
 
       fc::variant_object         network_get_info() const;
       fc::variant_object         network_get_usage_stats() const;
+      node_traffic_totals        get_traffic_totals() const;
 
       bool is_hard_fork_block(uint32_t block_number) const;
       uint32_t get_next_known_hard_fork_block_number(uint32_t block_number) const;
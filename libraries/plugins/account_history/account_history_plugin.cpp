@@ -24,6 +24,8 @@
  */
 
 #include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/account_history/account_history_table.hpp>
+#include <graphene/account_history/operation_history_store.hpp>
 
 #include <graphene/chain/impacted.hpp>
 
@@ -40,12 +42,70 @@
 #include <graphene/db/bdb_index.hpp>
 #include <boost/filesystem.hpp>
 
+#include <deque>
+#include <map>
+#include <unordered_map>
+
 namespace graphene { namespace account_history {
 
 namespace detail
 {
 
 
+/**
+ * A history object waiting to be written to Berkeley DB.  Its id is allocated, and account
+ * statistics updated, when the block is applied; only the put is deferred.
+ *
+ * Entries with a sequence hold a record of the account_history_table instead, and entries
+ * with prune_before set remove the earliest history of an account, whose account statistics
+ * have already been updated as well.
+ */
+struct pending_history_write
+{
+   uint32_t         block_num;
+   object_id_type   id;
+   vector<char>     data;
+   account_id_type  account;          ///< account of a table record, or whose earliest entries are removed
+   uint32_t         sequence = 0;     ///< table record only: its sequence in the account history
+   uint32_t         prune_before = 0; ///< prune only: entries with a lower sequence are removed
+};
+
+/** the accounts whose history an operation belongs to */
+flat_set<account_id_type> get_history_accounts( const operation_history_object& op )
+{
+   flat_set<account_id_type> impacted;
+   vector<authority> other;
+   operation_get_required_authorities( op.op, impacted, impacted, other ); // fee_payer is added here
+
+   if( op.op.which() == operation::tag< account_create_operation >::value )
+      impacted.insert( op.result.get<object_id_type>() );
+   else
+      graphene::chain::operation_get_impacted_accounts( op.op, impacted );
+
+   for( auto& a : other )
+      for( auto& item : a.account_auths )
+         impacted.insert( item.first );
+   return impacted;
+}
+
+class account_history_plugin_impl;
+
+/**
+ * Index of the operation history, 1.11.x.  Its rows only hold operations stored one by one, so
+ * lookups by id, e.g. get_objects, go through account_history_plugin_impl::find_operation(),
+ * which knows the write-behind queue and the block store as well.
+ */
+class operation_history_index : public bdb_index<operation_history_object>
+{
+   public:
+      virtual std::unique_ptr<object> find_db( object_id_type id )const override;
+
+      /// the row stored for id, if any
+      std::unique_ptr<object> find_row( object_id_type id )const { return bdb_index<operation_history_object>::find_db( id ); }
+
+      const account_history_plugin_impl* _impl = nullptr;
+};
+
 class account_history_plugin_impl
 {
    public:
@@ -60,6 +120,24 @@ class account_history_plugin_impl
        */
       void update_account_histories( const signed_block& b );
 
+      /** writes the pending objects of irreversible blocks and moves the watermark past them */
+      void write_irreversible_history();
+
+      /** removes the entries beyond _max_ops_per_account of every account and compacts the files */
+      void compact_history();
+
+      /** fills the account_history_table from history stored before it existed */
+      void build_history_table();
+
+      optional<operation_history_object> find_operation( operation_history_id_type id )const;
+
+      vector<operation_history_object> scan_history( account_id_type account, const flat_set<int32_t>& op_types,
+                                                     uint32_t start, uint32_t stop, unsigned limit,
+                                                     const std::function<history_scan_action(const account_history_head&)>& filter )const;
+
+      /** removes the queued writes, which are not written anymore */
+      void clear_pending_writes();
+
       graphene::chain::database& database()
       {
          return _self.database();
@@ -68,13 +146,63 @@ class account_history_plugin_impl
       account_history_plugin& _self;
       flat_set<account_id_type> _tracked_accounts;
       bool _partial_operations = false; 
-	  primary_index<bdb_index<operation_history_object>>* _oho_index;
+	  primary_index<operation_history_index>* _oho_index;
 	  primary_index<bdb_index<account_transaction_history_object>>* _atho_index;
+      std::unique_ptr<account_history_table> _history_table;
+      std::unique_ptr<operation_history_store> _operation_store; ///< null with partial operations
+      bool _use_block_store = true;
+      vector<operation_history_object> _block_operations; ///< operations of the block being applied, without write-behind
       uint32_t _max_ops_per_account = -1;
+
+      bool _write_behind = true;
+      std::deque<pending_history_write> _pending_writes;
+      /// without write-behind: table prunes waiting for their block to become irreversible
+      std::deque<pending_history_write> _table_prunes;
+      /// queued operations by instance and queued table records by account and sequence, so that queries see
+      /// them before they are written; deque elements keep their address while others are added or removed
+      std::unordered_map<uint64_t, const pending_history_write*> _pending_operations;
+      std::map<std::pair<account_id_type, uint32_t>, const pending_history_write*> _pending_records;
+      /// irreversible blocks written in one batch while replaying, live blocks are written as soon as they are irreversible
+      uint32_t _write_batch_replay = 1000;
+      uint32_t _indexed_block_num = 0; ///< watermark, every object of this block and before is stored
+      bool _has_watermark = false;
+      bool _compact_on_startup = false;
    private:
       /** add one history record, then check and remove the earliest history record */
-      void add_account_history( const account_id_type account_id, const operation_history_id_type op_id );
+      void add_account_history( const account_id_type account_id, const operation_history_object& op, uint32_t block_num );
+
+      /** allocates the next id of the index, so that it is rolled back if the block is popped */
+      template<typename Index>
+      typename Index::object_type allocate( primary_index<Index>* idx )
+      {
+         typename Index::object_type obj;
+         obj.id = idx->get_next_id();
+         idx->use_next_id();
+         // registers the previous next_id with the undo session, without recording the object itself
+         graphene::chain::database& db = database();
+         db._undo_db.on_create( obj );
+         db._undo_db.on_remove( obj );
+         return obj;
+      }
+
+      void queue_write( pending_history_write&& w );
+      void pop_pending_front();
+      void pop_pending_back();
+      void unindex_pending( const pending_history_write& w );
+
+      /** erases the table records pruned by irreversible blocks, without write-behind */
+      void prune_irreversible_table();
 
+      void store( const object& obj, uint32_t block_num );
+      void store_in_table( account_id_type account_id, uint32_t sequence, const operation_history_object& op, uint32_t block_num );
+      void put( object_id_type id, const vector<char>& data );
+
+      /** removes the entries of an account with a sequence lower than prune_before */
+      void prune( account_id_type account_id, uint32_t prune_before, uint32_t block_num );
+      /** deletes the earliest entries of an account, returns the deleted objects */
+      vector<account_transaction_history_object> erase_history( account_id_type account_id, uint32_t prune_before );
+      /** deletes the operations of removed entries which no remaining entry refers to */
+      vector<operation_history_object> erase_unreferenced_operations( const vector<account_transaction_history_object>& removed );
 };
 
 account_history_plugin_impl::~account_history_plugin_impl()
@@ -82,50 +210,134 @@ account_history_plugin_impl::~account_history_plugin_impl()
    return;
 }
 
+void account_history_plugin_impl::queue_write( pending_history_write&& w )
+{
+   _pending_writes.push_back( std::move(w) );
+   const pending_history_write& queued = _pending_writes.back();
+   if( queued.sequence != 0 )
+      _pending_records[ std::make_pair( queued.account, queued.sequence ) ] = &queued;
+   else if( queued.prune_before == 0 && queued.id.type() == operation_history_object::type_id )
+      _pending_operations[ queued.id.instance() ] = &queued;
+}
+
+void account_history_plugin_impl::unindex_pending( const pending_history_write& w )
+{
+   if( w.sequence != 0 )
+   {
+      auto itr = _pending_records.find( std::make_pair( w.account, w.sequence ) );
+      if( itr != _pending_records.end() && itr->second == &w )
+         _pending_records.erase( itr );
+   }
+   else if( w.prune_before == 0 && w.id.type() == operation_history_object::type_id )
+   {
+      auto itr = _pending_operations.find( w.id.instance() );
+      if( itr != _pending_operations.end() && itr->second == &w )
+         _pending_operations.erase( itr );
+   }
+}
+
+void account_history_plugin_impl::pop_pending_front()
+{
+   unindex_pending( _pending_writes.front() );
+   _pending_writes.pop_front();
+}
+
+void account_history_plugin_impl::pop_pending_back()
+{
+   unindex_pending( _pending_writes.back() );
+   _pending_writes.pop_back();
+}
+
+void account_history_plugin_impl::clear_pending_writes()
+{
+   _pending_operations.clear();
+   _pending_records.clear();
+   _pending_writes.clear();
+}
+
+void account_history_plugin_impl::store( const object& obj, uint32_t block_num )
+{
+   // already on disk, the block is applied again by a replay
+   if( block_num <= _indexed_block_num )
+      return;
+   if( _write_behind )
+   {
+      queue_write( pending_history_write{ block_num, obj.id, obj.pack() } );
+      return;
+   }
+   if( _operation_store && obj.id.type() == operation_history_object::type_id )
+   {
+      // appended together with the rest of the block, popped blocks are truncated from the store
+      _block_operations.push_back( static_cast<const operation_history_object&>( obj ) );
+      return;
+   }
+   put( obj.id, obj.pack() );
+   // let undo remove the object again if the block is popped
+   database()._undo_db.on_create( obj );
+}
+
+void account_history_plugin_impl::store_in_table( account_id_type account_id, uint32_t sequence, const operation_history_object& op, uint32_t block_num )
+{
+   if( block_num <= _indexed_block_num )
+      return;
+   if( _write_behind )
+   {
+      pending_history_write w{ block_num, object_id_type(), account_history_table::pack_record( op ) };
+      w.account = account_id;
+      w.sequence = sequence;
+      queue_write( std::move(w) );
+      return;
+   }
+   // not undone with the block: queries stop at total_ops, and the record is overwritten when the
+   // sequence is used again
+   _history_table->put( account_id, sequence, op );
+}
+
+void account_history_plugin_impl::put( object_id_type id, const vector<char>& data )
+{
+   if( id.type() == operation_history_object::type_id )
+      _oho_index->put_packed( id, data );
+   else
+      _atho_index->put_packed( id, data );
+}
+
 void account_history_plugin_impl::update_account_histories( const signed_block& b )
 {
    graphene::chain::database& db = database();
-   const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
-   bool is_first = true;
-   auto skip_oho_id = [&is_first,&db,this]() {
-      if( is_first && db._undo_db.enabled() ) // this ensures that the current id is rolled back on undo
-      {
-		 db.remove( *db.create_db<operation_history_object>( []( object& obj) {} ) );
-         is_first = false;
-      }
-      else
-		  _oho_index->use_next_id();
-   };
+   const uint32_t block_num = b.block_num();
 
+   // objects still pending for this block number or later belong to blocks which have been popped
+   while( !_pending_writes.empty() && _pending_writes.back().block_num >= block_num )
+      pop_pending_back();
+   while( !_table_prunes.empty() && _table_prunes.back().block_num >= block_num )
+      _table_prunes.pop_back();
+   _block_operations.clear();
+
+   const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
    for( const optional< operation_history_object >& o_op : hist )
    {
       optional<operation_history_object> oho;
 
-	  operation_history_object ho;
       auto create_oho = [&]() {
-         is_first = false;
-
-		 std::unique_ptr<object> tmp = db.create_db<operation_history_object>([&](object& o)
-		 {
-			 if (o_op.valid())
-			 {
-				 operation_history_object& h = dynamic_cast<operation_history_object&>(o);
-				 h.op = o_op->op;
-				 h.result = o_op->result;
-				 h.block_num = o_op->block_num;
-				 h.trx_in_block = o_op->trx_in_block;
-				 h.op_in_trx = o_op->op_in_trx;
-				 h.virtual_op = o_op->virtual_op;
-			 }
-		 }); 
-         return optional<operation_history_object>(dynamic_cast<operation_history_object&>(*tmp));
+         operation_history_object h = allocate( _oho_index );
+         if (o_op.valid())
+         {
+            h.op = o_op->op;
+            h.result = o_op->result;
+            h.block_num = o_op->block_num;
+            h.trx_in_block = o_op->trx_in_block;
+            h.op_in_trx = o_op->op_in_trx;
+            h.virtual_op = o_op->virtual_op;
+         }
+         store( h, block_num );
+         return optional<operation_history_object>( std::move(h) );
       };
 
       if( !o_op.valid() || ( _max_ops_per_account == 0 && _partial_operations ) )
       {
          // Note: the 2nd and 3rd checks above are for better performance, when the db is not clean,
          //       they will break consistency of account_stats.total_ops and removed_ops and most_recent_op
-         skip_oho_id();
+         allocate( _oho_index );
          continue;
       }
       else if( !_partial_operations )
@@ -135,18 +347,7 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
       const operation_history_object& op = *o_op;
 
       // get the set of accounts this operation applies to
-      flat_set<account_id_type> impacted;
-      vector<authority> other;
-      operation_get_required_authorities( op.op, impacted, impacted, other ); // fee_payer is added here
-
-      if( op.op.which() == operation::tag< account_create_operation >::value )
-         impacted.insert( op.result.get<object_id_type>() );
-      else
-         graphene::chain::operation_get_impacted_accounts( op.op, impacted );
-
-      for( auto& a : other )
-         for( auto& item : a.account_auths )
-            impacted.insert( item.first );
+      flat_set<account_id_type> impacted = get_history_accounts( op );
 
       // be here, either _max_ops_per_account > 0, or _partial_operations == false, or both
       // if _partial_operations == false, oho should have been created above
@@ -172,7 +373,7 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
                // that indexing now happens in observers' post_evaluate()
 
                // add history
-               add_account_history( account_id, oho->id );
+               add_account_history( account_id, *oho, block_num );
             }
          }
       }
@@ -192,79 +393,386 @@ void account_history_plugin_impl::update_account_histories( const signed_block&
                {
                   if (!oho.valid()) { oho = create_oho(); }
                   // add history
-                  add_account_history( account_id, oho->id );
+                  add_account_history( account_id, *oho, block_num );
                }
             }
          }
       }
       if (_partial_operations && ! oho.valid())
-         skip_oho_id();
+         allocate( _oho_index );
+   }
+
+   if( !_write_behind && _operation_store && block_num > _indexed_block_num )
+   {
+      _operation_store->truncate_from( block_num );
+      _operation_store->append( block_num, _block_operations );
+      _block_operations.clear();
+   }
+   if( !_write_behind )
+      prune_irreversible_table();
+
+   if( _write_behind && !_pending_writes.empty() )
+   {
+      // written in line: while replaying in batches of many blocks, which keeps the queue bounded
+      // without syncing for every block, and block by block once the node is in sync
+      const uint32_t batch = ( fc::time_point::now() - b.timestamp ) < fc::seconds(30) ? 1 : _write_batch_replay;
+      if( db.get_dynamic_global_properties().last_irreversible_block_num + 1 >= _pending_writes.front().block_num + batch )
+         write_irreversible_history();
+   }
+}
+
+/**
+ * Irreversible blocks can no longer be popped, so their objects are written in one batch and
+ * synced, then the watermark is advanced to the last irreversible block.  Should the node stop
+ * before that, the watermark still names a block whose objects are all on disk.
+ */
+void account_history_plugin_impl::write_irreversible_history()
+{
+   const uint32_t irreversible = database().get_dynamic_global_properties().last_irreversible_block_num;
+   if( irreversible <= _indexed_block_num )
+      return;
+
+   // a prune only removes entries put before it, so the prunes of the batch are merged per account
+   // and done after the puts, one cursor walk for each account
+   flat_map<account_id_type, uint32_t> prunes;
+   // operations are appended to the block store one block at a time
+   vector<operation_history_object> block_ops;
+   auto append_block_ops = [&]() {
+      if( block_ops.empty() )
+         return;
+      _operation_store->append( block_ops.front().block_num, block_ops );
+      block_ops.clear();
+   };
+   while( !_pending_writes.empty() && _pending_writes.front().block_num <= irreversible )
+   {
+      const pending_history_write& w = _pending_writes.front();
+      if( w.sequence != 0 )
+      {
+         atho_by_seq key;
+         memset( &key, 0, sizeof(key) );
+         key.account = w.account;
+         key.sequence = w.sequence;
+         _history_table->put_packed( key, w.data );
+      }
+      else if( w.prune_before == 0 )
+      {
+         if( _operation_store && w.id.type() == operation_history_object::type_id )
+         {
+            if( !block_ops.empty() && block_ops.front().block_num != w.block_num )
+               append_block_ops();
+            block_ops.push_back( fc::raw::unpack<operation_history_object>( w.data ) );
+         }
+         else
+            put( w.id, w.data );
+      }
+      else
+      {
+         uint32_t& prune_before = prunes[w.account];
+         prune_before = std::max( prune_before, w.prune_before );
+      }
+      pop_pending_front();
+   }
+   append_block_ops();
+   // irreversible, so the erased entries are not reported to undo
+   for( const auto& p : prunes )
+   {
+      erase_unreferenced_operations( erase_history( p.first, p.second ) );
+      _history_table->erase_before( p.first, p.second );
    }
+   _history_table->flush();
+   if( _operation_store )
+      _operation_store->flush();
+   _atho_index->flush();
+   _oho_index->save_watermark( irreversible );
+   _indexed_block_num = irreversible;
+   _has_watermark = true;
 }
 
-void account_history_plugin_impl::add_account_history( const account_id_type account_id, const operation_history_id_type op_id )
+void account_history_plugin_impl::add_account_history( const account_id_type account_id, const operation_history_object& op, uint32_t block_num )
 {
    graphene::chain::database& db = database();
    const auto& stats_obj = account_id(db).statistics(db);
 
    // add new entry
-   auto ath_ptr = db.create_db<account_transaction_history_object>( [&]( object& o ){
+   account_transaction_history_object ath = allocate( _atho_index );
+   ath.operation_id = op.id;
+   ath.account = account_id;
+   ath.sequence = stats_obj.total_ops + 1;
+   ath.next = stats_obj.most_recent_op;
+   store( ath, block_num );
+   store_in_table( account_id, ath.sequence, op, block_num );
 
-	   account_transaction_history_object& obj = static_cast<account_transaction_history_object&>(o);
-       obj.operation_id = op_id;
-       obj.account = account_id;
-       obj.sequence = stats_obj.total_ops + 1;
-       obj.next = stats_obj.most_recent_op;
-   });
-   const auto& ath = static_cast<account_transaction_history_object&>(*ath_ptr);
    db.modify( stats_obj, [&]( account_statistics_object& obj ){
        obj.most_recent_op = ath.id;
        obj.total_ops = ath.sequence;
    });
 
-   /*
    // remove the earliest account history entry if too many
    // _max_ops_per_account is guaranteed to be non-zero outside
    if( stats_obj.total_ops - stats_obj.removed_ops > _max_ops_per_account )
    {
-      // look for the earliest entry
-      const auto& his_idx = _atho_index;
-      const auto& by_seq_idx = his_idx->find_db_secondary()// .indices().get<by_seq>();
-      auto itr = by_seq_idx.lower_bound( boost::make_tuple( account_id, 0 ) );
-      // make sure don't remove the one just added
-      if( itr != by_seq_idx.end() && itr->account == account_id && itr->id != ath.id )
+      // sequences of an account are contiguous, so the entries to remove are known without a lookup
+      const uint32_t prune_before = stats_obj.total_ops - _max_ops_per_account + 1;
+      db.modify( stats_obj, [&]( account_statistics_object& obj ){
+          obj.removed_ops = prune_before - 1;
+      });
+      prune( account_id, prune_before, block_num );
+   }
+}
+
+/**
+ * The next pointer of the new earliest entry is left as it is: walking the list stops at the
+ * first entry which can not be found, so the entry does not need to be written again.
+ */
+void account_history_plugin_impl::prune( account_id_type account_id, uint32_t prune_before, uint32_t block_num )
+{
+   if( block_num <= _indexed_block_num )
+      return;
+   if( _write_behind )
+   {
+      pending_history_write w{ block_num, object_id_type(), vector<char>() };
+      w.account = account_id;
+      w.prune_before = prune_before;
+      queue_write( std::move(w) );
+      return;
+   }
+
+   // let undo put the objects back if the block is popped
+   graphene::chain::database& db = database();
+   auto removed = erase_history( account_id, prune_before );
+   for( const auto& ath : removed )
+      db._undo_db.on_remove( ath );
+   for( const auto& oho : erase_unreferenced_operations( removed ) )
+      db._undo_db.on_remove( oho );
+
+   // table records are not undo-tracked, they are erased once the block can no longer be popped
+   pending_history_write w{ block_num, object_id_type(), vector<char>() };
+   w.account = account_id;
+   w.prune_before = prune_before;
+   _table_prunes.push_back( std::move(w) );
+}
+
+void account_history_plugin_impl::prune_irreversible_table()
+{
+   const uint32_t irreversible = database().get_dynamic_global_properties().last_irreversible_block_num;
+   flat_map<account_id_type, uint32_t> prunes;
+   while( !_table_prunes.empty() && _table_prunes.front().block_num <= irreversible )
+   {
+      uint32_t& prune_before = prunes[_table_prunes.front().account];
+      prune_before = std::max( prune_before, _table_prunes.front().prune_before );
+      _table_prunes.pop_front();
+   }
+   for( const auto& p : prunes )
+      _history_table->erase_before( p.first, p.second );
+}
+
+vector<account_transaction_history_object> account_history_plugin_impl::erase_history( account_id_type account_id, uint32_t prune_before )
+{
+   vector<account_transaction_history_object> removed;
+   atho_by_seq key;
+   key.account = account_id;
+   key.sequence = 0;
+   _atho_index->get_bdb_secondary_index(0).erase_where( &key, sizeof(key),
+      [&]( const account_transaction_history_object& ath ) {
+         if( ath.account != account_id || ath.sequence >= prune_before )
+            return bdb_cursor_action::stop;
+         removed.push_back( ath );
+         return bdb_cursor_action::erase;
+      });
+   return removed;
+}
+
+vector<operation_history_object> account_history_plugin_impl::erase_unreferenced_operations( const vector<account_transaction_history_object>& removed )
+{
+   vector<operation_history_object> erased;
+   // without partial operations, the whole operation history is kept
+   if( !_partial_operations )
+      return erased;
+
+   const auto& by_op_idx = _atho_index->get_bdb_secondary_index(1);
+   for( const auto& ath : removed )
+   {
+      auto oho = _oho_index->find_row( ath.operation_id );
+      if( !oho )
+         continue;
+      const auto& op = static_cast<const operation_history_object&>( *oho );
+
+      // only the accounts the operation belongs to can refer to it
+      bool referenced = false;
+      for( const auto& account_id : get_history_accounts( op ) )
       {
-         // if found, remove the entry, and adjust account stats object
-         const auto remove_op_id = itr->operation_id;
-         const auto itr_remove = itr;
-         ++itr;
-         db.remove( *itr_remove );
-         db.modify( stats_obj, [&]( account_statistics_object& obj ){
-             obj.removed_ops = obj.removed_ops + 1;
-         });
-         // modify previous node's next pointer
-         // this should be always true, but just have a check here
-         if( itr != by_seq_idx.end() && itr->account == account_id )
+         atho_by_op key;
+         key.account = account_id;
+         key.operation_id = ath.operation_id;
+         if( by_op_idx.exists( &key, sizeof(key) ) )
          {
-            db.modify( *itr, [&]( account_transaction_history_object& obj ){
-               obj.next = account_transaction_history_id_type();
-            });
+            referenced = true;
+            break;
          }
-         // else need to modify the head pointer, but it shouldn't be true
+      }
+      if( !referenced )
+      {
+         erased.push_back( op );
+         _oho_index->remove( op.id );
+      }
+   }
+   return erased;
+}
 
-         // remove the operation history entry (1.11.x) if configured and no reference left
-         if( _partial_operations )
+/**
+ * Meant to be run once on a database which was written without max-ops-per-account, or with a
+ * higher value: the by_seq index is walked with one write cursor, then the freed pages are handed
+ * back to the file system.
+ */
+void account_history_plugin_impl::compact_history()
+{
+   graphene::chain::database& db = database();
+   FC_ASSERT( _pending_writes.empty() );
+   // no block is being applied, so the statistics are updated outside of undo, as during a replay
+   db._undo_db.disable();
+
+   const account_statistics_object* stats = nullptr;
+   uint32_t prune_before = 0;
+   vector<account_transaction_history_object> removed;
+
+   atho_by_seq key;
+   key.account = account_id_type( 0 );
+   key.sequence = 0;
+   uint32_t erased = _atho_index->get_bdb_secondary_index(0).erase_where( &key, sizeof(key),
+      [&]( const account_transaction_history_object& ath ) {
+         if( stats == nullptr || stats->owner != ath.account )
          {
-            // check for references
-            const auto& by_opid_idx = his_idx.indices().get<by_opid>();
-            if( by_opid_idx.find( remove_op_id ) == by_opid_idx.end() )
-            {
-               // if no reference, remove
-				_oho_index->remove_db(remove_op_id);
-            }
+            if( stats != nullptr && prune_before > stats->removed_ops + 1 )
+               db.modify( *stats, [&]( account_statistics_object& obj ){ obj.removed_ops = prune_before - 1; });
+            stats = &ath.account(db).statistics(db);
+            prune_before = stats->total_ops > _max_ops_per_account ? stats->total_ops - _max_ops_per_account + 1 : 0;
          }
-      }
-   }*/
+         if( ath.sequence >= prune_before )
+            return bdb_cursor_action::keep;
+         removed.push_back( ath );
+         return bdb_cursor_action::erase;
+      });
+   if( stats != nullptr && prune_before > stats->removed_ops + 1 )
+      db.modify( *stats, [&]( account_statistics_object& obj ){ obj.removed_ops = prune_before - 1; });
+   db._undo_db.enable();
+
+   auto operations = erase_unreferenced_operations( removed );
+   uint32_t table_erased = _history_table->erase_where( [&]( const atho_by_seq& key ) {
+      return key.sequence <= key.account(db).statistics(db).removed_ops;
+   });
+   ilog( "account history compaction removed ${a} account history entries, ${t} table records and ${o} operations",
+         ("a", erased)("t", table_erased)("o", operations.size()) );
+
+   _atho_index->compact();
+   _oho_index->compact();
+   _history_table->compact();
+   if( _operation_store )
+      _operation_store->compact();
+}
+
+/**
+ * The table is filled in one pass over the by_seq index, reading every operation once.  Runs at
+ * startup when the table is empty but history has been stored before.
+ */
+void account_history_plugin_impl::build_history_table()
+{
+   if( !_history_table->empty() )
+      return;
+
+   atho_by_seq key;
+   memset( &key, 0, sizeof(key) );
+   key.account = account_id_type( 0 );
+   key.sequence = 0;
+   const auto& by_seq_idx = _atho_index->get_bdb_secondary_index(0);
+   auto itr = by_seq_idx.lower_bound( &key, sizeof(key) );
+   if( itr == by_seq_idx.end() )
+      return;
+
+   ilog( "filling the clustered account history table from stored history" );
+   uint32_t count = 0;
+   for( ; itr != by_seq_idx.end(); ++itr )
+   {
+      auto oho = find_operation( itr->operation_id );
+      if( !oho.valid() )
+         continue;
+      _history_table->put( itr->account, itr->sequence, *oho );
+      ++count;
+   }
+   _history_table->flush();
+   ilog( "stored ${n} records in the clustered account history table", ("n", count) );
+}
+
+optional<operation_history_object> account_history_plugin_impl::find_operation( operation_history_id_type id )const
+{
+   auto pending = _pending_operations.find( id.instance.value );
+   if( pending != _pending_operations.end() )
+      return fc::raw::unpack<operation_history_object>( pending->second->data );
+   if( _operation_store )
+   {
+      auto op = _operation_store->find( id );
+      if( op.valid() )
+         return op;
+   }
+   // operations stored one by one, with partial operations or before the block store was used
+   auto oho = _oho_index->find_row( id );
+   if( !oho )
+      return optional<operation_history_object>();
+   return static_cast<const operation_history_object&>( *oho );
+}
+
+std::unique_ptr<object> operation_history_index::find_db( object_id_type id )const
+{
+   if( _impl == nullptr )
+      return find_row( id );
+   auto op = _impl->find_operation( id );
+   if( !op.valid() )
+      return std::unique_ptr<object>();
+   return std::unique_ptr<object>( new operation_history_object( std::move( *op ) ) );
+}
+
+/**
+ * Queued records belong to reversible blocks, so they have the highest sequences of the account
+ * and are walked first, then the walk continues in the table below the lowest of them.  Queued
+ * prunes need no attention, callers do not ask for sequences up to removed_ops.
+ */
+vector<operation_history_object> account_history_plugin_impl::scan_history( account_id_type account, const flat_set<int32_t>& op_types,
+                                                                            uint32_t start, uint32_t stop, unsigned limit,
+                                                                            const std::function<history_scan_action(const account_history_head&)>& filter )const
+{
+   vector<operation_history_object> result;
+   if( start < stop || limit == 0 )
+      return result;
+
+   auto type_filter = [&]( const account_history_head& head ) {
+      if( !op_types.empty() && op_types.find( head.op_type ) == op_types.end() )
+         return history_scan_action::skip;
+      return filter( head );
+   };
+
+   const auto first = _pending_records.lower_bound( std::make_pair( account, stop ) );
+   auto itr = _pending_records.upper_bound( std::make_pair( account, start ) );
+   while( itr != first && result.size() < limit )
+   {
+      --itr;
+      const vector<char>& record = itr->second->data;
+      account_history_head head;
+      memcpy( &head, record.data(), sizeof(head) );
+      start = itr->first.second - 1;
+      auto action = type_filter( head );
+      if( action == history_scan_action::stop )
+         return result;
+      if( action == history_scan_action::take )
+         result.push_back( fc::raw::unpack<operation_history_object>( record.data() + sizeof(head), record.size() - sizeof(head) ) );
+   }
+   if( result.size() >= limit || start < stop )
+      return result;
+
+   const unsigned rest = limit - result.size();
+   auto stored = ( !op_types.empty() && _history_table->has_op_type_index() )
+                 ? _history_table->scan_types( account, op_types, start, stop, rest, filter )
+                 : _history_table->scan( account, start, stop, rest, type_filter );
+   result.insert( result.end(), std::make_move_iterator( stored.begin() ), std::make_move_iterator( stored.end() ) );
+   return result;
 }
 
 } // end namespace detail
@@ -297,6 +805,16 @@ void account_history_plugin::plugin_set_program_options(
          ("track-account", boost::program_options::value<std::vector<std::string>>()->composing()->multitoken(), "Account ID to track history for (may specify multiple times)")
          ("partial-operations", boost::program_options::value<bool>(), "Keep only those operations in memory that are related to account history tracking")
          ("max-ops-per-account", boost::program_options::value<uint32_t>(), "Maximum number of operations per account will be kept in memory")
+         ("history-write-behind", boost::program_options::value<bool>()->default_value(true),
+          "Write history to Berkeley DB in batches once blocks are irreversible, instead of while applying them (default: true)")
+         ("history-write-batch-replay", boost::program_options::value<uint32_t>()->default_value(1000),
+          "Number of irreversible blocks whose history is written in one batch while replaying (default: 1000)")
+         ("history-compact", boost::program_options::bool_switch()->default_value(false),
+          "Remove the history beyond max-ops-per-account from an existing Berkeley DB and compact it at startup")
+         ("history-index-op-types", boost::program_options::value<bool>()->default_value(false),
+          "Index account history by operation type, for fast queries of one operation type (default: false)")
+         ("history-block-store", boost::program_options::value<bool>()->default_value(true),
+          "Store operations compressed and grouped by block, unless partial-operations is set (default: true)")
          ;
    cfg.add(cli);
 }
@@ -402,12 +920,18 @@ void account_history_plugin::plugin_initialize(const boost::program_options::var
 
 	graphene::db::bdb_env::getInstance().init(bdb_home.generic_string().c_str(), "data_dir");
 
-	database().applied_block.connect( [&]( const signed_block& b){ my->update_account_histories(b); } );
-	my->_oho_index = database().add_index< primary_index< bdb_index<operation_history_object> > >();
+	database().applied_block.connect( database().timed_handler( plugin_name(), [&]( const signed_block& b){ my->update_account_histories(b); } ) );
+	my->_oho_index = database().add_index< primary_index< detail::operation_history_index > >();
+	my->_oho_index->_impl = my.get();
 	my->_atho_index = database().add_index< primary_index< bdb_index<account_transaction_history_object > > >();
 
 	my->_atho_index->add_bdb_secondary_index(new bdb_secondary_index<account_transaction_history_object>("by_seq", false, account_seq_key_comp), get_account_seq);
 	my->_atho_index->add_bdb_secondary_index(new bdb_secondary_index<account_transaction_history_object>("by_op", false, account_op_key_comp), get_account_op);
+	my->_history_table.reset(new account_history_table());
+	if (options.count("history-index-op-types") && options["history-index-op-types"].as<bool>())
+		my->_history_table->index_op_types();
+	else
+		my->_history_table->drop_op_type_index();
 	// my->_atho_index->add_bdb_secondary_index(new bdb_secondary_index<account_transaction_history_object>("by_opid", true), get_account_opid);
 
 	LOAD_VALUE_SET(options, "track-account", my->_tracked_accounts, graphene::chain::account_id_type);
@@ -417,10 +941,76 @@ void account_history_plugin::plugin_initialize(const boost::program_options::var
 	if (options.count("max-ops-per-account")) {
 		my->_max_ops_per_account = options["max-ops-per-account"].as<uint32_t>();
 	}
+	if (options.count("history-write-behind")) {
+		my->_write_behind = options["history-write-behind"].as<bool>();
+	}
+	if (options.count("history-write-batch-replay")) {
+		my->_write_batch_replay = std::max<uint32_t>(options["history-write-batch-replay"].as<uint32_t>(), 1);
+	}
+	if (options.count("history-block-store")) {
+		my->_use_block_store = options["history-block-store"].as<bool>();
+	}
+	// the block store is append-only, partial operations removes operations one by one from 1.11 instead
+	if (my->_use_block_store && !my->_partial_operations)
+		my->_operation_store.reset(new operation_history_store());
+	if (options.count("history-compact")) {
+		my->_compact_on_startup = options["history-compact"].as<bool>();
+	}
+	my->_has_watermark = my->_oho_index->load_watermark(my->_indexed_block_num);
+	if (my->_has_watermark)
+		ilog("account history is stored up to block ${n}", ("n", my->_indexed_block_num));
 }
 
 void account_history_plugin::plugin_startup()
 {
+   // the chain database is open by now, and no block has been applied yet.  Blocks up to the
+   // watermark which a replay applies again are skipped, their history is on disk.  With
+   // write-behind, blocks of the chain state beyond it were applied without their history
+   // reaching disk, e.g. the node crashed after the chain state was saved during a replay
+   const uint32_t head = database().head_block_num();
+   if( my->_write_behind && my->_has_watermark && head > my->_indexed_block_num )
+      elog( "account history is stored up to block ${n}, but the chain state is at block ${h}: the history of the "
+            "blocks in between is missing, replay the blockchain with an empty ${d} to restore it",
+            ("n", my->_indexed_block_num)("h", head)("d", "blockchain/bdb_home") );
+   if( my->_compact_on_startup )
+      my->compact_history();
+   my->build_history_table();
+}
+
+void account_history_plugin::plugin_shutdown()
+{
+   // objects of reversible blocks are dropped, the database pops those blocks when it is closed
+   my->write_irreversible_history();
+   my->clear_pending_writes();
+   // blocks which are not irreversible are applied again after restart, and prune the table again
+   my->_table_prunes.clear();
+}
+
+void account_history_plugin::flush_irreversible_history()
+{
+   my->write_irreversible_history();
+}
+
+uint32_t account_history_plugin::indexed_block_num()const
+{
+   return my->_indexed_block_num;
+}
+
+const account_history_table& account_history_plugin::history_table()const
+{
+   return *my->_history_table;
+}
+
+optional<operation_history_object> account_history_plugin::find_operation( operation_history_id_type id )const
+{
+   return my->find_operation( id );
+}
+
+vector<operation_history_object> account_history_plugin::scan_history( account_id_type account, const flat_set<int32_t>& op_types,
+                                                                       uint32_t start, uint32_t stop, unsigned limit,
+                                                                       const std::function<history_scan_action(const account_history_head&)>& filter )const
+{
+   return my->scan_history( account, op_types, start, stop, limit, filter );
 }
 
 flat_set<account_id_type> account_history_plugin::tracked_accounts() const
@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/account_history/account_history_table.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace account_history {
+
+using graphene::db::bdb;
+using graphene::db::bdb_cursor_action;
+
+namespace detail
+{
+   int account_history_key_comp( Db* db, const Dbt* key1, const Dbt* key2, size_t* size )
+   {
+      const atho_by_seq* k1 = (const atho_by_seq*)key1->get_data();
+      const atho_by_seq* k2 = (const atho_by_seq*)key2->get_data();
+
+      if( k1->account.instance.value != k2->account.instance.value )
+         return k1->account.instance.value > k2->account.instance.value ? 1 : -1;
+
+      if( k1->sequence != k2->sequence )
+         return k1->sequence > k2->sequence ? 1 : -1;
+
+      return 0;
+   }
+
+   atho_by_seq make_key( account_id_type account, uint32_t sequence )
+   {
+      atho_by_seq key;
+      memset( &key, 0, sizeof(key) );
+      key.account = account;
+      key.sequence = sequence;
+      return key;
+   }
+
+   int account_history_type_key_comp( Db* db, const Dbt* key1, const Dbt* key2, size_t* size )
+   {
+      const account_history_type_key* k1 = (const account_history_type_key*)key1->get_data();
+      const account_history_type_key* k2 = (const account_history_type_key*)key2->get_data();
+
+      if( k1->account.instance.value != k2->account.instance.value )
+         return k1->account.instance.value > k2->account.instance.value ? 1 : -1;
+
+      if( k1->op_type != k2->op_type )
+         return k1->op_type > k2->op_type ? 1 : -1;
+
+      if( k1->sequence != k2->sequence )
+         return k1->sequence > k2->sequence ? 1 : -1;
+
+      return 0;
+   }
+
+   account_history_type_key make_type_key( account_id_type account, int32_t op_type, uint32_t sequence )
+   {
+      account_history_type_key key;
+      memset( &key, 0, sizeof(key) );
+      key.account = account;
+      key.op_type = op_type;
+      key.sequence = sequence;
+      return key;
+   }
+
+   // the operation type is taken from the head of the record, nothing is unpacked
+   int get_account_history_type_key( Db* sdb, const Dbt* pkey, const Dbt* pdata, Dbt* skey )
+   {
+      const atho_by_seq* k = (const atho_by_seq*)pkey->get_data();
+      const account_history_head* head = (const account_history_head*)pdata->get_data();
+
+      account_history_type_key* type_key = (account_history_type_key*)malloc( sizeof(account_history_type_key) );
+      *type_key = make_type_key( k->account, head->op_type, k->sequence );
+
+      skey->set_flags( DB_DBT_APPMALLOC ); // let bdb to free it
+      skey->set_data( type_key );
+      skey->set_size( sizeof(account_history_type_key) );
+      return 0;
+   }
+}
+
+account_history_table::account_history_table()
+{
+   _bdb->set_bt_compare( detail::account_history_key_comp );
+   _bdb.open( "account_history" );
+   FC_ASSERT( _bdb.isOpen(), "Berkeley DB: Could not open file 'account_history'" );
+}
+
+vector<char> account_history_table::pack_record( const operation_history_object& op )
+{
+   account_history_head head;
+   head.operation_id = op.id.instance();
+   head.op_type = op.op.which();
+   head.block_num = op.block_num;
+
+   vector<char> record( sizeof(head) );
+   memcpy( record.data(), &head, sizeof(head) );
+   vector<char> packed = fc::raw::pack( op );
+   record.insert( record.end(), packed.begin(), packed.end() );
+   return record;
+}
+
+void account_history_table::put( account_id_type account, uint32_t sequence, const operation_history_object& op )
+{
+   put_packed( detail::make_key( account, sequence ), pack_record( op ) );
+}
+
+void account_history_table::put_packed( const atho_by_seq& k, const vector<char>& record )
+{
+   Dbt key( const_cast<atho_by_seq*>(&k), sizeof(k) );
+   Dbt data( const_cast<char*>(record.data()), record.size() );
+
+   int ret = _bdb->put( nullptr, &key, &data, 0 );
+   FC_ASSERT( !ret, "Could not insert account history into berkeley db. ret=${ret}, account:${a}, sequence:${s}",
+              ("ret", ret)("a", k.account)("s", k.sequence) );
+}
+
+vector<operation_history_object> account_history_table::scan( account_id_type account, uint32_t start, uint32_t stop, unsigned limit,
+                                                              const std::function<history_scan_action(const account_history_head&)>& filter )const
+{
+   if( start < stop || limit == 0 )
+      return vector<operation_history_object>();
+
+   Dbc* cursorp;
+   bdb& bdb_ = const_cast<bdb&>(_bdb);
+   int ret = bdb_->cursor( nullptr, &cursorp, 0 );
+   FC_ASSERT( !ret, "Berkeley DB: could not open cursor, ret=${ret}", ("ret", ret) );
+
+   // start is at most the total_ops of the account, so start + 1 does not overflow
+   atho_by_seq k = detail::make_key( account, start + 1 );
+   auto result = walk_back( cursorp, &k, sizeof(k), [&]( const void* key ) {
+      const atho_by_seq* found = (const atho_by_seq*)key;
+      return found->account == account && found->sequence >= stop;
+   }, limit, filter );
+   cursorp->close();
+   return result;
+}
+
+vector<operation_history_object> account_history_table::scan_types( account_id_type account, const flat_set<int32_t>& op_types,
+                                                                    uint32_t start, uint32_t stop, unsigned limit,
+                                                                    const std::function<history_scan_action(const account_history_head&)>& filter )const
+{
+   FC_ASSERT( has_op_type_index(), "the operation type index of account history is not enabled" );
+   vector<operation_history_object> result;
+   if( start < stop || limit == 0 )
+      return result;
+
+   for( int32_t op_type : op_types )
+   {
+      Dbc* cursorp;
+      int ret = (*_by_type)->cursor( nullptr, &cursorp, 0 );
+      FC_ASSERT( !ret, "Berkeley DB: could not open cursor, ret=${ret}", ("ret", ret) );
+
+      account_history_type_key k = detail::make_type_key( account, op_type, start + 1 );
+      auto ops = walk_back( cursorp, &k, sizeof(k), [&]( const void* key ) {
+         const account_history_type_key* found = (const account_history_type_key*)key;
+         return found->account == account && found->op_type == op_type && found->sequence >= stop;
+      }, limit, filter );
+      cursorp->close();
+      result.insert( result.end(), std::make_move_iterator( ops.begin() ), std::make_move_iterator( ops.end() ) );
+   }
+
+   // operation ids grow with the sequence of the account, newest first
+   if( op_types.size() > 1 )
+   {
+      std::sort( result.begin(), result.end(), []( const operation_history_object& a, const operation_history_object& b ) {
+         return b.id < a.id;
+      });
+      if( result.size() > limit )
+         result.resize( limit );
+   }
+   return result;
+}
+
+vector<operation_history_object> account_history_table::walk_back( Dbc* cursorp, void* start_key, u_int32_t key_size,
+                                                                   const std::function<bool(const void*)>& in_range, unsigned limit,
+                                                                   const std::function<history_scan_action(const account_history_head&)>& filter )const
+{
+   vector<operation_history_object> result;
+   Dbt key( start_key, key_size );
+
+   // moving the cursor reads only the head of a record
+   account_history_head head;
+   Dbt head_data;
+   head_data.set_data( &head );
+   head_data.set_ulen( sizeof(head) );
+   head_data.set_dlen( sizeof(head) );
+   head_data.set_doff( 0 );
+   head_data.set_flags( DB_DBT_USERMEM | DB_DBT_PARTIAL );
+
+   int ret = cursorp->get( &key, &head_data, DB_SET_RANGE );
+   if( ret && ret != DB_NOTFOUND )
+      return result;
+   ret = cursorp->get( &key, &head_data, ret == DB_NOTFOUND ? DB_LAST : DB_PREV );
+
+   while( !ret && result.size() < limit && in_range( key.get_data() ) )
+   {
+      auto action = filter( head );
+      if( action == history_scan_action::stop )
+         break;
+      if( action == history_scan_action::take )
+      {
+         Dbt data;
+         ret = cursorp->get( &key, &data, DB_CURRENT );
+         if( ret )
+            break;
+         operation_history_object op;
+         fc::raw::unpack<operation_history_object>( (const char*)data.get_data() + sizeof(head), data.get_size() - sizeof(head), op );
+         result.push_back( std::move(op) );
+      }
+      ret = cursorp->get( &key, &head_data, DB_PREV );
+   }
+   return result;
+}
+
+void account_history_table::index_op_types()
+{
+   if( _by_type )
+      return;
+
+   std::unique_ptr<bdb> by_type( new bdb() );
+   (*by_type)->set_bt_compare( detail::account_history_type_key_comp );
+   by_type->open( "account_history.by_type" );
+   FC_ASSERT( by_type->isOpen(), "Berkeley DB: Could not open file 'account_history.by_type'" );
+
+   // DB_CREATE fills an empty secondary index from the records of the table
+   int ret = _bdb->associate( nullptr, &by_type->getDb(), detail::get_account_history_type_key, DB_CREATE );
+   FC_ASSERT( !ret, "Berkeley DB: could not associate the operation type index, ret=${ret}", ("ret", ret) );
+   _by_type = std::move( by_type );
+}
+
+void account_history_table::drop_op_type_index()
+{
+   FC_ASSERT( !_by_type, "the operation type index is in use" );
+   // a stale index would not be filled again by associate(), the file is removed instead
+   try {
+      graphene::db::bdb_env::getInstance().getDbEnv()->dbremove( nullptr, "account_history.by_type", nullptr, 0 );
+   } catch( DbException& ) {
+      // no such file
+   }
+}
+
+uint32_t account_history_table::erase_before( account_id_type account, uint32_t prune_before )
+{
+   return erase_from( detail::make_key( account, 0 ), [&]( const atho_by_seq& k ) {
+      if( k.account != account || k.sequence >= prune_before )
+         return bdb_cursor_action::stop;
+      return bdb_cursor_action::erase;
+   });
+}
+
+uint32_t account_history_table::erase_where( const std::function<bool(const atho_by_seq&)>& erase )
+{
+   return erase_from( detail::make_key( account_id_type(0), 0 ), [&]( const atho_by_seq& k ) {
+      return erase( k ) ? bdb_cursor_action::erase : bdb_cursor_action::keep;
+   });
+}
+
+uint32_t account_history_table::erase_from( const atho_by_seq& start, const std::function<bdb_cursor_action(const atho_by_seq&)>& decide )
+{
+   Dbc* cursorp;
+   int ret = _bdb->cursor( nullptr, &cursorp, DB_WRITECURSOR );
+   FC_ASSERT( !ret, "Berkeley DB: could not open write cursor, ret=${ret}", ("ret", ret) );
+
+   atho_by_seq k = start;
+   Dbt key( &k, sizeof(k) );
+   // only keys are looked at
+   Dbt data;
+   data.set_dlen( 0 );
+   data.set_doff( 0 );
+   data.set_flags( DB_DBT_PARTIAL );
+
+   uint32_t erased = 0;
+   ret = cursorp->get( &key, &data, DB_SET_RANGE );
+   while( !ret )
+   {
+      auto action = decide( *(const atho_by_seq*)key.get_data() );
+      if( action == bdb_cursor_action::stop )
+         break;
+      if( action == bdb_cursor_action::erase )
+      {
+         ret = cursorp->del( 0 );
+         if( ret )
+         {
+            wlog( "Berkeley DB: could not delete account history, ret=${ret}", ("ret", ret) );
+            break;
+         }
+         ++erased;
+      }
+      ret = cursorp->get( &key, &data, DB_NEXT );
+   }
+   cursorp->close();
+   return erased;
+}
+
+bool account_history_table::empty()const
+{
+   Dbc* cursorp;
+   bdb& bdb_ = const_cast<bdb&>(_bdb);
+   int ret = bdb_->cursor( nullptr, &cursorp, 0 );
+   FC_ASSERT( !ret, "Berkeley DB: could not open cursor, ret=${ret}", ("ret", ret) );
+
+   Dbt key, data;
+   data.set_dlen( 0 );
+   data.set_doff( 0 );
+   data.set_flags( DB_DBT_PARTIAL );
+   ret = cursorp->get( &key, &data, DB_FIRST );
+   cursorp->close();
+   return ret == DB_NOTFOUND;
+}
+
+void account_history_table::flush()
+{
+   _bdb->sync( 0 );
+}
+
+void account_history_table::compact()
+{
+   DB_COMPACT c_data;
+   memset( &c_data, 0, sizeof(c_data) );
+   int ret = _bdb->compact( nullptr, nullptr, nullptr, &c_data, DB_FREE_SPACE, nullptr );
+   FC_ASSERT( !ret, "Berkeley DB: could not compact, ret=${ret}", ("ret", ret) );
+   ilog( "Berkeley DB: compacted account_history, ${p} pages freed", ("p", c_data.compact_pages_truncated) );
+}
+
+} } // graphene::account_history
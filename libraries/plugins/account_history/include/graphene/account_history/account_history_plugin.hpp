@@ -28,6 +28,8 @@
 
 #include <graphene/chain/operation_history_object.hpp>
 
+#include <graphene/account_history/account_history_table.hpp>
+
 #include <fc/thread/future.hpp>
 
 namespace graphene { namespace account_history {
@@ -73,9 +75,27 @@ class account_history_plugin : public graphene::app::plugin
          boost::program_options::options_description& cfg) override;
       virtual void plugin_initialize(const boost::program_options::variables_map& options) override;
       virtual void plugin_startup() override;
+      virtual void plugin_shutdown() override;
 
       flat_set<account_id_type> tracked_accounts()const;
 
+      /// Writes the history of irreversible blocks now, instead of waiting for the next batch
+      void flush_irreversible_history();
+      /// Last block whose history is completely stored in Berkeley DB
+      uint32_t indexed_block_num()const;
+      /// Account history clustered by account and sequence, available after plugin_initialize()
+      const account_history_table& history_table()const;
+      /// Looks an operation up among those waiting to be written, in the block store, or among the operations stored one by one
+      optional<operation_history_object> find_operation( operation_history_id_type id )const;
+      /**
+       * Walks the history of an account like account_history_table::scan(), including the records of
+       * reversible blocks which are still waiting to be written.  With op_types only these operation
+       * types are returned, read through the operation type index if the table has one.
+       */
+      vector<operation_history_object> scan_history( account_id_type account, const flat_set<int32_t>& op_types,
+                                                     uint32_t start, uint32_t stop, unsigned limit,
+                                                     const std::function<history_scan_action(const account_history_head&)>& filter )const;
+
       friend class detail::account_history_plugin_impl;
       std::unique_ptr<detail::account_history_plugin_impl> my;
 };
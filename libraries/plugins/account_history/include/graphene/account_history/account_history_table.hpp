@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/operation_history_object.hpp>
+#include <graphene/db/bdb_index.hpp>
+
+#include <functional>
+
+namespace graphene { namespace account_history {
+   using namespace chain;
+
+/**
+ * Fixed size head stored in front of every record of the account_history_table.  A scan reads
+ * only the heads, with a partial get, until a record is accepted.
+ */
+struct account_history_head
+{
+   uint64_t  operation_id; ///< instance of the operation_history_id_type
+   int32_t   op_type;      ///< operation::which()
+   uint32_t  block_num;
+};
+
+/// key of the optional (account, op_type, sequence) index of the account_history_table
+struct account_history_type_key
+{
+   account_id_type  account;
+   int32_t          op_type;
+   uint32_t         sequence;
+};
+
+/// what account_history_table::scan() does with a record, judged by its head
+enum class history_scan_action { take, skip, stop };
+
+/**
+ * @brief Account history clustered by (account, sequence)
+ *
+ * Every entry of an account history is stored in one Berkeley DB btree, keyed by atho_by_seq,
+ * together with the packed operation.  A page of history is one cursor walk over adjacent
+ * keys, instead of following account_transaction_history_object::next and reading each
+ * operation from the operation history.
+ *
+ * Optionally a secondary index on (account, op_type, sequence) is kept as well, so that the
+ * history of one operation type costs as many reads as there are results.
+ */
+class account_history_table
+{
+   public:
+      /// opens the table, the Berkeley DB environment must have been initialized before
+      account_history_table();
+
+      void put( account_id_type account, uint32_t sequence, const operation_history_object& op );
+      void put_packed( const atho_by_seq& key, const vector<char>& record );
+      static vector<char> pack_record( const operation_history_object& op );
+
+      /**
+       * Walks the history of an account from sequence start down to stop, both inclusive, and
+       * returns at most limit operations, newest first.  Records which filter() skips are not
+       * read beyond their head, and the walk ends early when it returns stop.
+       */
+      vector<operation_history_object> scan( account_id_type account, uint32_t start, uint32_t stop, unsigned limit,
+                                             const std::function<history_scan_action(const account_history_head&)>& filter )const;
+
+      /**
+       * Same as scan(), for the given operation types only, walking the (account, op_type, sequence)
+       * index once per type.  Requires index_op_types().
+       */
+      vector<operation_history_object> scan_types( account_id_type account, const flat_set<int32_t>& op_types,
+                                                   uint32_t start, uint32_t stop, unsigned limit,
+                                                   const std::function<history_scan_action(const account_history_head&)>& filter )const;
+
+      /// maintains the (account, op_type, sequence) index, it is built from the stored records if it is new
+      void index_op_types();
+      /// deletes the (account, op_type, sequence) index, so that it is built again once it is enabled
+      void drop_op_type_index();
+      bool has_op_type_index()const { return _by_type != nullptr; }
+
+      /// deletes the entries of an account with a sequence lower than prune_before
+      uint32_t erase_before( account_id_type account, uint32_t prune_before );
+      /// walks the whole table and deletes the entries for which erase() returns true
+      uint32_t erase_where( const std::function<bool(const atho_by_seq&)>& erase );
+
+      bool empty()const;
+      void flush();
+      void compact();
+
+   private:
+      uint32_t erase_from( const atho_by_seq& start, const std::function<graphene::db::bdb_cursor_action(const atho_by_seq&)>& decide );
+
+      /**
+       * Moves the cursor to the last key before start_key, then walks back for as long as
+       * in_range() accepts the keys.
+       */
+      vector<operation_history_object> walk_back( Dbc* cursorp, void* start_key, u_int32_t key_size,
+                                                  const std::function<bool(const void*)>& in_range, unsigned limit,
+                                                  const std::function<history_scan_action(const account_history_head&)>& filter )const;
+
+      graphene::db::bdb                   _bdb;
+      /// declared after the table, secondary indexes are closed before their primary
+      std::unique_ptr<graphene::db::bdb>  _by_type;
+};
+
+} } // graphene::account_history
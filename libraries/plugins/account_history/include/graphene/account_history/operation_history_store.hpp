@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/operation_history_object.hpp>
+#include <graphene/db/bdb_index.hpp>
+
+namespace graphene { namespace account_history {
+   using namespace chain;
+
+/**
+ * Fixed size head of a block record of the operation_history_store.  It is followed by one
+ * offset per operation, then by the compressed payload.
+ */
+struct operation_block_head
+{
+   uint64_t  first_op_id; ///< instance of the first operation, the others follow without gaps
+   uint32_t  count;       ///< number of operations in the block
+   uint32_t  raw_size;    ///< size of the payload once decompressed
+};
+
+/**
+ * The columns which are small and similar from one operation to the next, stored in front of
+ * the rows of the payload.  Ids and block numbers are not stored at all, they follow from the
+ * record head and key.
+ */
+struct operation_block_columns
+{
+   vector<uint16_t>  trx_in_block;
+   vector<uint16_t>  op_in_trx;
+   vector<uint16_t>  virtual_op;
+};
+
+/**
+ * @brief Append-only operation history, grouped by block
+ *
+ * All operations of a block are stored in one compressed Berkeley DB record keyed by the block
+ * number.  The payload holds the operation_block_columns, then one (op, result) row per
+ * operation; the offsets in front of the payload locate a row, so a single operation is read
+ * without unpacking the others.  A secondary index on the first operation id of each block
+ * finds the block of an operation.
+ */
+class operation_history_store
+{
+   public:
+      /// opens the store, the Berkeley DB environment must have been initialized before
+      operation_history_store();
+
+      /// stores the operations of a block, their ids have to be consecutive
+      void append( uint32_t block_num, const vector<operation_history_object>& ops );
+      /// deletes the records of block_num and later blocks, which have been popped
+      void truncate_from( uint32_t block_num );
+
+      optional<operation_history_object> find( operation_history_id_type id )const;
+      vector<operation_history_object> get_block( uint32_t block_num )const;
+
+      void flush();
+      void compact();
+
+   private:
+      /// decompresses the payload of a record and unpacks the rows from first to last, excluded
+      vector<operation_history_object> unpack_rows( uint32_t block_num, const char* record, size_t size,
+                                                    uint32_t first, uint32_t last )const;
+
+      graphene::db::bdb                   _bdb;
+      /// declared after the store, secondary indexes are closed before their primary
+      graphene::db::bdb                   _by_first_op;
+};
+
+} } // graphene::account_history
+
+FC_REFLECT( graphene::account_history::operation_block_columns, (trx_in_block)(op_in_trx)(virtual_op) )
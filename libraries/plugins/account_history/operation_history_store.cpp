@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/account_history/operation_history_store.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+namespace graphene { namespace account_history {
+
+using graphene::db::bdb;
+
+namespace detail
+{
+   int block_num_comp( Db* db, const Dbt* key1, const Dbt* key2, size_t* size )
+   {
+      uint32_t k1 = *(const uint32_t*)key1->get_data();
+      uint32_t k2 = *(const uint32_t*)key2->get_data();
+      if( k1 != k2 )
+         return k1 > k2 ? 1 : -1;
+      return 0;
+   }
+
+   int first_op_comp( Db* db, const Dbt* key1, const Dbt* key2, size_t* size )
+   {
+      uint64_t k1 = *(const uint64_t*)key1->get_data();
+      uint64_t k2 = *(const uint64_t*)key2->get_data();
+      if( k1 != k2 )
+         return k1 > k2 ? 1 : -1;
+      return 0;
+   }
+
+   int get_first_op_key( Db* sdb, const Dbt* pkey, const Dbt* pdata, Dbt* skey )
+   {
+      const operation_block_head* head = (const operation_block_head*)pdata->get_data();
+      skey->set_data( const_cast<uint64_t*>( &head->first_op_id ) );
+      skey->set_size( sizeof(head->first_op_id) );
+      return 0;
+   }
+
+   std::string deflate( const vector<char>& data )
+   {
+      std::string out;
+      boost::iostreams::filtering_ostream os;
+      os.push( boost::iostreams::zlib_compressor() );
+      os.push( boost::iostreams::back_inserter( out ) );
+      os.write( data.data(), data.size() );
+      os.reset(); // flushes the compressor
+      return out;
+   }
+
+   vector<char> inflate( const char* data, size_t size, uint32_t raw_size )
+   {
+      vector<char> out( raw_size );
+      boost::iostreams::filtering_istream is;
+      is.push( boost::iostreams::zlib_decompressor() );
+      is.push( boost::iostreams::array_source( data, size ) );
+      is.read( out.data(), raw_size );
+      FC_ASSERT( uint32_t( is.gcount() ) == raw_size, "Corrupt operation history block" );
+      return out;
+   }
+}
+
+operation_history_store::operation_history_store()
+{
+   _bdb->set_bt_compare( detail::block_num_comp );
+   _bdb.open( "operation_history.blocks" );
+   FC_ASSERT( _bdb.isOpen(), "Berkeley DB: Could not open file 'operation_history.blocks'" );
+
+   _by_first_op->set_bt_compare( detail::first_op_comp );
+   _by_first_op.open( "operation_history.by_first_op" );
+   FC_ASSERT( _by_first_op.isOpen(), "Berkeley DB: Could not open file 'operation_history.by_first_op'" );
+
+   int ret = _bdb->associate( nullptr, &_by_first_op.getDb(), detail::get_first_op_key, DB_CREATE );
+   FC_ASSERT( !ret, "Berkeley DB: could not associate the first operation index, ret=${ret}", ("ret", ret) );
+}
+
+void operation_history_store::append( uint32_t block_num, const vector<operation_history_object>& ops )
+{
+   if( ops.empty() )
+      return;
+
+   operation_block_head head;
+   head.first_op_id = ops.front().id.instance();
+   head.count = ops.size();
+
+   operation_block_columns columns;
+   for( size_t i = 0; i < ops.size(); ++i )
+   {
+      FC_ASSERT( ops[i].id.instance() == head.first_op_id + i, "Operations of a block must have consecutive ids",
+                 ("block_num", block_num)("id", ops[i].id) );
+      columns.trx_in_block.push_back( ops[i].trx_in_block );
+      columns.op_in_trx.push_back( ops[i].op_in_trx );
+      columns.virtual_op.push_back( ops[i].virtual_op );
+   }
+
+   vector<char> payload = fc::raw::pack( columns );
+   vector<uint32_t> offsets;
+   offsets.reserve( ops.size() );
+   for( const auto& o : ops )
+   {
+      offsets.push_back( payload.size() );
+      vector<char> row = fc::raw::pack( o.op );
+      payload.insert( payload.end(), row.begin(), row.end() );
+      row = fc::raw::pack( o.result );
+      payload.insert( payload.end(), row.begin(), row.end() );
+   }
+   head.raw_size = payload.size();
+
+   std::string compressed = detail::deflate( payload );
+   vector<char> record( sizeof(head) + offsets.size() * sizeof(uint32_t) );
+   memcpy( record.data(), &head, sizeof(head) );
+   memcpy( record.data() + sizeof(head), offsets.data(), offsets.size() * sizeof(uint32_t) );
+   record.insert( record.end(), compressed.begin(), compressed.end() );
+
+   Dbt key( &block_num, sizeof(block_num) );
+   Dbt data( record.data(), record.size() );
+   int ret = _bdb->put( nullptr, &key, &data, 0 );
+   FC_ASSERT( !ret, "Could not insert operation history into berkeley db. ret=${ret}, block:${b}", ("ret", ret)("b", block_num) );
+}
+
+void operation_history_store::truncate_from( uint32_t block_num )
+{
+   Dbc* cursorp;
+   int ret = _bdb->cursor( nullptr, &cursorp, DB_WRITECURSOR );
+   FC_ASSERT( !ret, "Berkeley DB: could not open write cursor, ret=${ret}", ("ret", ret) );
+
+   Dbt key( &block_num, sizeof(block_num) );
+   // only keys are looked at
+   Dbt data;
+   data.set_dlen( 0 );
+   data.set_doff( 0 );
+   data.set_flags( DB_DBT_PARTIAL );
+
+   ret = cursorp->get( &key, &data, DB_SET_RANGE );
+   while( !ret )
+   {
+      ret = cursorp->del( 0 );
+      if( ret )
+      {
+         wlog( "Berkeley DB: could not delete operation history, ret=${ret}", ("ret", ret) );
+         break;
+      }
+      ret = cursorp->get( &key, &data, DB_NEXT );
+   }
+   cursorp->close();
+}
+
+optional<operation_history_object> operation_history_store::find( operation_history_id_type id )const
+{
+   Dbc* cursorp;
+   bdb& by_first_op = const_cast<bdb&>(_by_first_op);
+   int ret = by_first_op->cursor( nullptr, &cursorp, 0 );
+   FC_ASSERT( !ret, "Berkeley DB: could not open cursor, ret=${ret}", ("ret", ret) );
+
+   // the block is the last one which starts at or before the operation
+   uint64_t k = uint64_t( id.instance.value ) + 1;
+   Dbt key( &k, sizeof(k) );
+   Dbt pkey, data;
+   ret = cursorp->pget( &key, &pkey, &data, DB_SET_RANGE );
+   if( !ret || ret == DB_NOTFOUND )
+      ret = cursorp->pget( &key, &pkey, &data, ret == DB_NOTFOUND ? DB_LAST : DB_PREV );
+
+   optional<operation_history_object> result;
+   if( !ret )
+   {
+      const operation_block_head* head = (const operation_block_head*)data.get_data();
+      uint64_t index = id.instance.value - head->first_op_id;
+      if( id.instance.value >= head->first_op_id && index < head->count )
+      {
+         uint32_t block_num = *(const uint32_t*)pkey.get_data();
+         auto rows = unpack_rows( block_num, (const char*)data.get_data(), data.get_size(), index, index + 1 );
+         result = std::move( rows.front() );
+      }
+   }
+   cursorp->close();
+   return result;
+}
+
+vector<operation_history_object> operation_history_store::get_block( uint32_t block_num )const
+{
+   Dbt key( &block_num, sizeof(block_num) );
+   Dbt data;
+   bdb& bdb_ = const_cast<bdb&>(_bdb);
+   if( bdb_->get( nullptr, &key, &data, 0 ) )
+      return vector<operation_history_object>();
+
+   const operation_block_head* head = (const operation_block_head*)data.get_data();
+   return unpack_rows( block_num, (const char*)data.get_data(), data.get_size(), 0, head->count );
+}
+
+vector<operation_history_object> operation_history_store::unpack_rows( uint32_t block_num, const char* record, size_t size,
+                                                                       uint32_t first, uint32_t last )const
+{
+   operation_block_head head;
+   memcpy( &head, record, sizeof(head) );
+   const char* offsets = record + sizeof(head);
+   const size_t compressed_pos = sizeof(head) + head.count * sizeof(uint32_t);
+   FC_ASSERT( size >= compressed_pos && last <= head.count, "Corrupt operation history block ${b}", ("b", block_num) );
+
+   vector<char> payload = detail::inflate( record + compressed_pos, size - compressed_pos, head.raw_size );
+   operation_block_columns columns;
+   fc::raw::unpack( payload, columns );
+
+   vector<operation_history_object> result;
+   result.reserve( last - first );
+   for( uint32_t i = first; i < last; ++i )
+   {
+      uint32_t offset;
+      memcpy( &offset, offsets + i * sizeof(uint32_t), sizeof(offset) );
+
+      operation_history_object o;
+      o.id = operation_history_id_type( head.first_op_id + i );
+      o.block_num = block_num;
+      o.trx_in_block = columns.trx_in_block[i];
+      o.op_in_trx = columns.op_in_trx[i];
+      o.virtual_op = columns.virtual_op[i];
+
+      fc::datastream<const char*> ds( payload.data() + offset, payload.size() - offset );
+      fc::raw::unpack( ds, o.op );
+      fc::raw::unpack( ds, o.result );
+      result.push_back( std::move(o) );
+   }
+   return result;
+}
+
+void operation_history_store::flush()
+{
+   _bdb->sync( 0 );
+   _by_first_op->sync( 0 );
+}
+
+void operation_history_store::compact()
+{
+   DB_COMPACT c_data;
+   memset( &c_data, 0, sizeof(c_data) );
+   int ret = _bdb->compact( nullptr, nullptr, nullptr, &c_data, DB_FREE_SPACE, nullptr );
+   FC_ASSERT( !ret, "Berkeley DB: could not compact, ret=${ret}", ("ret", ret) );
+   ilog( "Berkeley DB: compacted operation_history.blocks, ${p} pages freed", ("p", c_data.compact_pages_truncated) );
+}
+
+} } // graphene::account_history
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <graphene/contract_history/contract_history_plugin.hpp>
+
+#include <graphene/chain/operation_history_object.hpp>
+
+namespace graphene { namespace contract_history {
+
+namespace detail
+{
+
+class contract_history_plugin_impl
+{
+   public:
+      contract_history_plugin_impl(contract_history_plugin& _plugin)
+      :_self( _plugin ) {}
+      virtual ~contract_history_plugin_impl();
+
+      /** this method is called as a callback after a block is applied
+       * and indexes the events of the contract calls in that block.
+       */
+      void update_contract_events( const signed_block& b );
+
+      graphene::chain::database& database()
+      {
+         return _self.database();
+      }
+
+      contract_history_plugin&   _self;
+      uint32_t                   _max_history_blocks = 201600;
+};
+
+contract_history_plugin_impl::~contract_history_plugin_impl()
+{}
+
+void contract_history_plugin_impl::update_contract_events( const signed_block& b )
+{
+   graphene::chain::database& db = database();
+   const uint32_t block_num = b.block_num();
+   for( const optional< operation_history_object >& o_op : db.get_applied_operations() )
+   {
+      if( !o_op.valid() || o_op->op.which() != operation::tag< smart_contract_call_operation >::value
+          || o_op->result.which() != operation_result::tag< contract_call_result >::value )
+         continue;
+
+      const auto& op = o_op->op.get<smart_contract_call_operation>();
+      const auto& events = o_op->result.get<contract_call_result>().events;
+      for( uint16_t i = 0; i < events.size(); ++i )
+      {
+         db.create<contract_event_object>( [&]( contract_event_object& e ) {
+            e.contract_addr = op.contract_addr;
+            e.name          = events[i].name;
+            e.data          = events[i].data;
+            e.caller        = op.caller;
+            e.block_num     = block_num;
+            e.trx_in_block  = o_op->trx_in_block;
+            e.op_in_trx     = o_op->op_in_trx;
+            e.event_in_op   = i;
+         });
+      }
+   }
+
+   // blocks are indexed in order, so expired events are at the front of by_block
+   if( _max_history_blocks == 0 || block_num <= _max_history_blocks )
+      return;
+   const auto& by_block_idx = db.get_index_type<contract_event_index>().indices().get<by_block>();
+   const uint32_t oldest_kept = block_num - _max_history_blocks + 1;
+   for( auto itr = by_block_idx.begin(); itr != by_block_idx.end() && itr->block_num < oldest_kept; )
+   {
+      const auto& e = *itr;
+      ++itr;
+      db.remove( e );
+   }
+}
+
+} // end namespace detail
+
+contract_history_plugin::contract_history_plugin() :
+   my( new detail::contract_history_plugin_impl(*this) )
+{
+}
+
+contract_history_plugin::~contract_history_plugin()
+{
+}
+
+std::string contract_history_plugin::plugin_name()const
+{
+   return "contract_history";
+}
+
+void contract_history_plugin::plugin_set_program_options(
+   boost::program_options::options_description& cli,
+   boost::program_options::options_description& cfg
+   )
+{
+   cli.add_options()
+         ("contract-history-blocks", boost::program_options::value<uint32_t>()->default_value(201600),
+          "Keep the events of smart contract calls from this many recent blocks, 0 keeps all (default: 201600, 7 days)")
+         ;
+   cfg.add(cli);
+}
+
+void contract_history_plugin::plugin_initialize(const boost::program_options::variables_map& options)
+{ try {
+   database().applied_block.connect( database().timed_handler( plugin_name(), [this]( const signed_block& b ){ my->update_contract_events(b); } ) );
+   database().add_index< primary_index< contract_event_index > >();
+
+   if( options.count( "contract-history-blocks" ) )
+      my->_max_history_blocks = options["contract-history-blocks"].as<uint32_t>();
+} FC_CAPTURE_AND_RETHROW() }
+
+void contract_history_plugin::plugin_startup()
+{
+}
+
+uint32_t contract_history_plugin::max_history_blocks()const
+{
+   return my->_max_history_blocks;
+}
+
+} }
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/app/plugin.hpp>
+#include <graphene/chain/database.hpp>
+
+#include <boost/multi_index/composite_key.hpp>
+
+namespace graphene { namespace contract_history {
+using namespace chain;
+
+//
+// Plugins should #define their SPACE_ID's so plugins with
+// conflicting SPACE_ID assignments can be compiled into the
+// same binary (by simply re-assigning some of the conflicting #defined
+// SPACE_ID's in a build script).
+//
+// Assignment of SPACE_ID's cannot be done at run-time because
+// various template automagic depends on them being known at compile
+// time.
+//
+#ifndef CONTRACT_HISTORY_SPACE_ID
+#define CONTRACT_HISTORY_SPACE_ID 7
+#endif
+
+enum contract_history_object_type
+{
+   contract_event_object_type = 0
+};
+
+/**
+ * @brief One event emitted by a smart contract call, with the position of the call in the chain
+ */
+struct contract_event_object : public abstract_object<contract_event_object>
+{
+   static const uint8_t space_id = CONTRACT_HISTORY_SPACE_ID;
+   static const uint8_t type_id  = contract_event_object_type;
+
+   contract_addr_type   contract_addr;
+   string               name;
+   vector<char>         data;
+   account_id_type      caller;
+   uint32_t             block_num    = 0;
+   uint16_t             trx_in_block = 0;
+   uint16_t             op_in_trx    = 0;
+   uint16_t             event_in_op  = 0;
+};
+
+struct by_event;
+struct by_contract;
+struct by_block;
+typedef multi_index_container<
+   contract_event_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique<
+         tag<by_event>,
+         composite_key<
+            contract_event_object,
+            member<contract_event_object, contract_addr_type, &contract_event_object::contract_addr>,
+            member<contract_event_object, string, &contract_event_object::name>,
+            member<contract_event_object, uint32_t, &contract_event_object::block_num>,
+            member<object, object_id_type, &object::id>
+         >
+      >,
+      ordered_unique<
+         tag<by_contract>,
+         composite_key<
+            contract_event_object,
+            member<contract_event_object, contract_addr_type, &contract_event_object::contract_addr>,
+            member<contract_event_object, uint32_t, &contract_event_object::block_num>,
+            member<object, object_id_type, &object::id>
+         >
+      >,
+      ordered_non_unique< tag<by_block>, member< contract_event_object, uint32_t, &contract_event_object::block_num > >
+   >
+> contract_event_multi_index_type;
+
+typedef generic_index<contract_event_object, contract_event_multi_index_type> contract_event_index;
+
+namespace detail
+{
+    class contract_history_plugin_impl;
+}
+
+/**
+ *  The contract history plugin indexes the events emitted by smart contract calls by contract, event
+ *  name and block, so they can be queried without replaying operation history.  Events older than
+ *  the configured number of blocks are dropped.
+ */
+class contract_history_plugin : public graphene::app::plugin
+{
+   public:
+      contract_history_plugin();
+      virtual ~contract_history_plugin();
+
+      std::string plugin_name()const override;
+      virtual void plugin_set_program_options(
+         boost::program_options::options_description& cli,
+         boost::program_options::options_description& cfg) override;
+      virtual void plugin_initialize(
+         const boost::program_options::variables_map& options) override;
+      virtual void plugin_startup() override;
+
+      uint32_t max_history_blocks()const;
+
+   private:
+      friend class detail::contract_history_plugin_impl;
+      std::unique_ptr<detail::contract_history_plugin_impl> my;
+};
+
+} } //graphene::contract_history
+
+FC_REFLECT_DERIVED( graphene::contract_history::contract_event_object, (graphene::db::object),
+                    (contract_addr)(name)(data)(caller)(block_num)(trx_in_block)(op_in_trx)(event_in_op) )
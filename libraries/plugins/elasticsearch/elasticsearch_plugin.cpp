@@ -406,12 +406,12 @@ void elasticsearch_plugin::plugin_set_program_options(
 
 void elasticsearch_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
-   database().applied_block.connect( [&]( const signed_block& b) {
+   database().applied_block.connect( database().timed_handler( plugin_name(), [&]( const signed_block& b) {
       if(!my->update_account_histories(b))
       {
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception, "Error populating ES database, we are going to keep trying.");
       }
-   } );
+   } ) );
    my->_oho_index = database().add_index< primary_index< operation_history_index > >();
    database().add_index< primary_index< account_transaction_history_index > >();
 
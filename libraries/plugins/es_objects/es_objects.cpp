@@ -399,18 +399,18 @@ void es_objects_plugin::plugin_set_program_options(
 
 void es_objects_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
-   database().new_objects.connect([&]( const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts ) {
+   database().new_objects.connect(database().timed_handler(plugin_name() + ".new_objects", [&]( const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts ) {
       if(!my->updateDatabase(ids, 1))
       {
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception, "Error populating ES database, we are going to keep trying.");
       }
-   });
-   database().changed_objects.connect([&]( const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts ) {
+   }));
+   database().changed_objects.connect(database().timed_handler(plugin_name() + ".changed_objects", [&]( const vector<object_id_type>& ids, const flat_set<account_id_type>& impacted_accounts ) {
       if(!my->updateDatabase(ids, 0))
       {
          FC_THROW_EXCEPTION(graphene::chain::plugin_exception, "Error populating ES database, we are going to keep trying.");
       }
-   });
+   }));
    if (options.count("es-objects-elasticsearch-url")) {
       my->_es_objects_elasticsearch_url = options["es-objects-elasticsearch-url"].as<std::string>();
    }
@@ -225,6 +225,26 @@ typedef generic_index<order_history_object, order_history_multi_index_type> hist
 typedef generic_index<market_ticker_object, market_ticker_object_multi_index_type> market_ticker_index;
 
 
+/**
+ * OHLCV candles of a market as parallel arrays, entry i of every array belongs to candle i.
+ * Prices are given as base and quote amounts, all amounts in satoshis of the respective asset.
+ */
+struct market_candles
+{
+   uint32_t           resolution = 0;  ///< seconds per candle
+   vector<uint32_t>   open_time;       ///< seconds since epoch, a multiple of resolution
+   vector<int64_t>    open_base;
+   vector<int64_t>    open_quote;
+   vector<int64_t>    high_base;
+   vector<int64_t>    high_quote;
+   vector<int64_t>    low_base;
+   vector<int64_t>    low_quote;
+   vector<int64_t>    close_base;
+   vector<int64_t>    close_quote;
+   vector<int64_t>    base_volume;
+   vector<int64_t>    quote_volume;
+};
+
 namespace detail
 {
     class market_history_plugin_impl;
@@ -253,6 +273,15 @@ class market_history_plugin : public graphene::app::plugin
       const flat_set<uint32_t>&   tracked_buckets()const;
       uint32_t                    max_order_his_records_per_market()const;
       uint32_t                    max_order_his_seconds_per_market()const;
+      /// Number of candles kept in memory, one per market and bucket size whose current period received fills
+      size_t                      open_candles()const;
+
+      /**
+       * Returns the candles of market a:b with the given resolution which open between start and end, at most limit.
+       * The resolution must be a multiple of a tracked bucket size, candles are merged from the largest such size.
+       */
+      market_candles              get_candles( asset_id_type a, asset_id_type b, uint32_t resolution,
+                                               fc::time_point_sec start, fc::time_point_sec end, uint32_t limit )const;
 
    private:
       friend class detail::market_history_plugin_impl;
@@ -264,6 +293,13 @@ class market_history_plugin : public graphene::app::plugin
 FC_REFLECT( graphene::market_history::history_key, (base)(quote)(sequence) )
 FC_REFLECT_DERIVED( graphene::market_history::order_history_object, (graphene::db::object), (key)(time)(op) )
 FC_REFLECT( graphene::market_history::bucket_key, (base)(quote)(seconds)(open) )
+FC_REFLECT( graphene::market_history::market_candles,
+            (resolution)(open_time)
+            (open_base)(open_quote)
+            (high_base)(high_quote)
+            (low_base)(low_quote)
+            (close_base)(close_quote)
+            (base_volume)(quote_volume) )
 FC_REFLECT_DERIVED( graphene::market_history::bucket_object, (graphene::db::object),
                     (key)
                     (high_base)(high_quote)
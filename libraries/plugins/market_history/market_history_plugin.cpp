@@ -38,11 +38,80 @@
 #include <fc/smart_ref_impl.hpp>
 #include <graphene/db/bdb_index.hpp>
 
+#include <deque>
+
 namespace graphene { namespace market_history {
 
 namespace detail
 {
 
+/**
+ * The candle of a market which is still open for one bucket size.  Fills update it in memory,
+ * and it is written to BDB once at the end of the block.
+ */
+struct open_bucket
+{
+   bucket_object  bucket;
+   bucket_object  flushed;        ///< as last written, the value undo restores
+   bool           stored = false; ///< bucket.id is valid, the bucket exists in BDB
+   bool           dirty  = false; ///< changed since it was last written
+};
+
+typedef std::tuple<asset_id_type, asset_id_type, uint32_t> open_bucket_key; ///< base, quote, seconds
+
+/**
+ * A maker fill which is still counted in the 24h volume of its market ticker.
+ */
+struct ticker_fill
+{
+   fc::time_point_sec   time;
+   uint32_t             block_num = 0;  ///< 0 when loaded from order history at startup
+   object_id_type       order_his_id;
+   asset_id_type        base;
+   asset_id_type        quote;
+   share_type           base_volume;
+   share_type           quote_volume;
+   share_type           fill_base;
+   share_type           fill_quote;
+};
+
+/**
+ * A bucket without its object id, as kept in the candle cache.
+ */
+struct cached_candle
+{
+   cached_candle() {}
+   explicit cached_candle( const bucket_object& b )
+   :open(b.key.open.sec_since_epoch()),
+    open_base(b.open_base.value),open_quote(b.open_quote.value),
+    high_base(b.high_base.value),high_quote(b.high_quote.value),
+    low_base(b.low_base.value),low_quote(b.low_quote.value),
+    close_base(b.close_base.value),close_quote(b.close_quote.value),
+    base_volume(b.base_volume.value),quote_volume(b.quote_volume.value) {}
+
+   uint32_t open = 0;
+   int64_t  open_base = 0;
+   int64_t  open_quote = 0;
+   int64_t  high_base = 0;
+   int64_t  high_quote = 0;
+   int64_t  low_base = 0;
+   int64_t  low_quote = 0;
+   int64_t  close_base = 0;
+   int64_t  close_quote = 0;
+   int64_t  base_volume = 0;
+   int64_t  quote_volume = 0;
+};
+
+/**
+ * All stored buckets of one market and bucket size, in time order.  Loaded from BDB by the first query,
+ * then kept up to date by flush_open_buckets() and remove_expired_buckets().
+ */
+struct candle_series
+{
+   std::deque<cached_candle> candles;
+   uint64_t                  last_used = 0;
+};
+
 class market_history_plugin_impl
 {
    public:
@@ -55,6 +124,30 @@ class market_history_plugin_impl
        */
       void update_market_histories( const signed_block& b );
 
+      /** adds a maker fill to the open candle of every tracked bucket size of its market */
+      void update_buckets( bucket_key key, const price& trade_price, const price& fill_price, fc::time_point_sec now );
+
+      /** writes the candles changed by the block, and forgets the candles closed by now */
+      void flush_open_buckets( fc::time_point_sec now );
+
+      /** the cached buckets of a market and bucket size, loads them if needed */
+      const candle_series& cached_candles( const open_bucket_key& key );
+
+      market_candles get_candles( asset_id_type a, asset_id_type b, uint32_t resolution,
+                                  fc::time_point_sec start, fc::time_point_sec end, uint32_t limit );
+
+      /** rolls the fills older than a day out of the market tickers */
+      void roll_out_ticker( const signed_block& b, const market_ticker_meta_object* meta );
+
+      /** fills the ticker window from the order history, starting at the rolling minimum of the meta object */
+      void load_ticker_fills();
+
+      /**
+       * removes the order history which is beyond both limits of the markets in _markets_to_trim,
+       * at most _max_order_his_removals_per_block records, the remaining markets are trimmed in later blocks
+       */
+      void trim_order_history( fc::time_point_sec now );
+
       graphene::chain::database& database()
       {
          return _self.database();
@@ -65,17 +158,48 @@ class market_history_plugin_impl
       uint32_t                   _maximum_history_per_bucket_size = 1000;
       uint32_t                   _max_order_his_records_per_market = 1000;
       uint32_t                   _max_order_his_seconds_per_market = 259200;
+      uint32_t                   _max_order_his_removals_per_block = 1000;
+
+      std::map<open_bucket_key, open_bucket> _open_buckets;
+      uint32_t                   _last_block_num = 0;
+
+      std::map<open_bucket_key, candle_series> _candle_cache;
+      uint64_t                   _candle_cache_clock = 0;
+      uint32_t                   _max_cached_candle_series = 200;
+
+      /// maker fills of the last 24 hours, in time order
+      std::deque<ticker_fill>    _ticker_fills;
+      /// fills rolled out by reversible blocks, with the number of the block, restored when it is popped
+      std::deque<std::pair<uint32_t, ticker_fill>> _retired_ticker_fills;
+      /// head block when _ticker_fills was loaded, forks below it reload the window
+      uint32_t                   _ticker_fills_loaded_at = 0;
+
+      /// markets which received fills since their order history was last trimmed
+      flat_set<std::pair<asset_id_type, asset_id_type>> _markets_to_trim;
+
+   private:
+      /** removes the buckets which are older than the tracked history */
+      void remove_expired_buckets( bucket_key key, uint32_t bucket_num );
+
+      /** drops the ticker fills added by popped blocks and restores the ones they rolled out */
+      void undo_ticker_fills( uint32_t block_num );
+
+      bool find_order_history_trim_start( history_key& hkey, fc::time_point_sec min_time,
+                                          const bdb_secondary_index<order_history_object>& history_idx,
+                                          const bdb_secondary_index<order_history_object>& his_time_idx );
 };
 
 
 struct operation_process_fill_order
 {
    market_history_plugin&            _plugin;
+   market_history_plugin_impl&       _impl;
    fc::time_point_sec                _now;
    const market_ticker_meta_object*& _meta;
 
-   operation_process_fill_order( market_history_plugin& mhp, fc::time_point_sec n, const market_ticker_meta_object*& meta )
-   :_plugin(mhp),_now(n),_meta(meta) {}
+   operation_process_fill_order( market_history_plugin& mhp, market_history_plugin_impl& impl, fc::time_point_sec n,
+                                 const market_ticker_meta_object*& meta )
+   :_plugin(mhp),_impl(impl),_now(n),_meta(meta) {}
 
    typedef void result_type;
 
@@ -93,7 +217,6 @@ struct operation_process_fill_order
 
       const auto& order_his_idx = dynamic_cast<const bdb_index<order_history_object>&>(db.get_index(order_history_object::space_id, order_history_object::type_id));
       const auto& history_idx = order_his_idx.get_bdb_secondary_index(0);
-      const auto& his_time_idx = order_his_idx.get_bdb_secondary_index(1);
 
       // To save new filled order data
       history_key hkey;
@@ -129,57 +252,8 @@ struct operation_process_fill_order
             _meta = &( *meta_idx.begin() );
       }
 
-      // To remove old filled order data
-      vector<order_history_object> objects_to_remove;
-      const auto max_records = _plugin.max_order_his_records_per_market();
-      hkey.sequence += max_records;
-      itr = history_idx.lower_bound( &hkey, sizeof(hkey) );
-      if( itr != history_idx.end() && itr->key.base == hkey.base && itr->key.quote == hkey.quote )
-      {
-         const auto max_seconds = _plugin.max_order_his_seconds_per_market();
-         fc::time_point_sec min_time;
-         if( min_time + max_seconds < _now )
-            min_time = _now - max_seconds;
-         order_history_market_time_key market_time_key;
-         market_time_key.base = hkey.base;
-         market_time_key.quote = hkey.quote;
-         market_time_key.time = min_time;
-         market_time_key.sequence = 0;
-
-         // auto time_itr = his_time_idx.lower_bound( std::make_tuple( hkey.base, hkey.quote, min_time ) );
-         auto time_itr = his_time_idx.lower_bound(&market_time_key, sizeof(market_time_key));
-         if( time_itr != his_time_idx.end() && time_itr->key.base == hkey.base && time_itr->key.quote == hkey.quote )
-         {
-            if(itr->key.sequence >= time_itr->key.sequence )
-            {
-               while( itr != history_idx.end() && itr->key.base == hkey.base && itr->key.quote == hkey.quote )
-               {
-                  objects_to_remove.push_back(*itr); 
-                  ++itr;
-               }
-            }
-            else
-            {
-               while( time_itr != his_time_idx.end() && time_itr->key.base == hkey.base && time_itr->key.quote == hkey.quote )
-               {
-                  objects_to_remove.push_back(*time_itr);
-                  ++time_itr; 
-               }
-            }
-         }
-      }
-
-      static u_int64_t consume = 0, total_removed = 0;
-      fc::time_point start_point = fc::time_point::now();
-      for (auto& obj : objects_to_remove)
-          db.remove(obj);
-      if (objects_to_remove.size() > 0)
-      {
-          total_removed += objects_to_remove.size();
-          consume += (fc::time_point::now() - start_point).count();
-          if (consume % 1000000 < 100)
-              ilog("remove order_history_object ${total} takes: ${consume}", ("total", total_removed) ("consume", consume));
-      }
+      // old filled order data of the market is removed at the end of the block
+      _impl._markets_to_trim.insert( std::make_pair( hkey.base, hkey.quote ) );
 
       // To update ticker data and buckets data, only update for maker orders
       if( !o.is_maker )
@@ -227,6 +301,18 @@ struct operation_process_fill_order
          });
       }
 
+      ticker_fill tf;
+      tf.time         = _now;
+      tf.block_num    = db.head_block_num();
+      tf.order_his_id = new_order_his_obj->id;
+      tf.base         = key.base;
+      tf.quote        = key.quote;
+      tf.base_volume  = trade_price.base.amount;
+      tf.quote_volume = trade_price.quote.amount;
+      tf.fill_base    = fill_price.base.amount;
+      tf.fill_quote   = fill_price.quote.amount;
+      _impl._ticker_fills.push_back( tf );
+
       // To update buckets data
       const auto max_history = _plugin.max_history();
       if( max_history == 0 ) return;
@@ -234,102 +320,188 @@ struct operation_process_fill_order
       const auto& buckets = _plugin.tracked_buckets();
       if( buckets.size() == 0 ) return;
 
-      // const auto& bucket_idx = db.get_index_type<bucket_index>();
-      const auto& bucket_idx = dynamic_cast<const bdb_index<bucket_object>&>(db.get_index(bucket_object::space_id, bucket_object::type_id));
-      for( auto bucket : buckets )
-      {
-          auto bucket_num = _now.sec_since_epoch() / bucket;
-          fc::time_point_sec cutoff;
-          if( bucket_num > max_history )
-             cutoff = cutoff + ( bucket * ( bucket_num - max_history ) );
-
-          key.seconds = bucket;
-          key.open    = fc::time_point_sec() + ( bucket_num * bucket );
-
-          // const auto& by_key_idx = bucket_idx.indices().get<by_key>();
-          // auto bucket_itr = by_key_idx.find( key );
-          // if( bucket_itr == by_key_idx.end() )
-
-          const auto& by_key_idx = bucket_idx.get_bdb_secondary_index(0); 
-          if(!by_key_idx.exists(&key, sizeof(key)))
-          { // create new bucket
-            /* const auto& obj = */
-            db.create_db<bucket_object>( [&]( bucket_object& b ){
-                 b.key = key;
-                 b.base_volume = trade_price.base.amount;
-                 b.quote_volume = trade_price.quote.amount;
-                 b.open_base = fill_price.base.amount;
-                 b.open_quote = fill_price.quote.amount;
-                 b.close_base = fill_price.base.amount;
-                 b.close_quote = fill_price.quote.amount;
-                 b.high_base = b.close_base;
-                 b.high_quote = b.close_quote;
-                 b.low_base = b.close_base;
-                 b.low_quote = b.close_quote;
-            });
-            //wlog( "    creating bucket ${b}", ("b",obj) );
-          }
-          else
-          { // update existing bucket
-             //wlog( "    before updating bucket ${b}", ("b",*bucket_itr) ); 
-             auto bo = by_key_idx.find_db(&key, sizeof(key));
-             db.modify( *bo, [&]( bucket_object& b ){
-                  try {
-                     b.base_volume += trade_price.base.amount;
-                  } catch( fc::overflow_exception ) {
-                     b.base_volume = std::numeric_limits<int64_t>::max();
-                  }
-                  try {
-                     b.quote_volume += trade_price.quote.amount;
-                  } catch( fc::overflow_exception ) {
-                     b.quote_volume = std::numeric_limits<int64_t>::max();
-                  }
-                  b.close_base = fill_price.base.amount;
-                  b.close_quote = fill_price.quote.amount;
-                  if( b.high() < fill_price )
-                  {
-                      b.high_base = b.close_base;
-                      b.high_quote = b.close_quote;
-                  }
-                  if( b.low() > fill_price )
-                  {
-                      b.low_base = b.close_base;
-                      b.low_quote = b.close_quote;
-                  }
-             });
-             //wlog( "    after bucket bucket ${b}", ("b",*bucket_itr) );
-          }
-
-          {
-             key.open = fc::time_point_sec();
-             auto bucket_itr = by_key_idx.lower_bound( &key, sizeof(key));
-             vector<bucket_object> vect;
-             while( bucket_itr != by_key_idx.end() &&
-                bucket_itr->key.base == key.base &&
-                bucket_itr->key.quote == key.quote &&
-                bucket_itr->key.seconds == bucket &&
-                bucket_itr->key.open < cutoff )
-             {
-              //  elog( "    removing old bucket ${b}", ("b", *bucket_itr) );
-                vect.push_back(*bucket_itr);
-                ++bucket_itr;
-             }
-
-             for ( auto xbo : vect)
-             {
-                 db.remove(xbo);
-             }
-          }
-      }
+      _impl.update_buckets( key, trade_price, fill_price, _now );
    }
 };
 
 market_history_plugin_impl::~market_history_plugin_impl()
 {}
 
+static void apply_fill( bucket_object& b, const price& trade_price, const price& fill_price )
+{
+   try {
+      b.base_volume += trade_price.base.amount;
+   } catch( fc::overflow_exception ) {
+      b.base_volume = std::numeric_limits<int64_t>::max();
+   }
+   try {
+      b.quote_volume += trade_price.quote.amount;
+   } catch( fc::overflow_exception ) {
+      b.quote_volume = std::numeric_limits<int64_t>::max();
+   }
+   b.close_base = fill_price.base.amount;
+   b.close_quote = fill_price.quote.amount;
+   if( b.high() < fill_price )
+   {
+       b.high_base = b.close_base;
+       b.high_quote = b.close_quote;
+   }
+   if( b.low() > fill_price )
+   {
+       b.low_base = b.close_base;
+       b.low_quote = b.close_quote;
+   }
+}
+
+void market_history_plugin_impl::update_buckets( bucket_key key, const price& trade_price, const price& fill_price, fc::time_point_sec now )
+{
+   graphene::chain::database& db = database();
+   const auto& bucket_idx = dynamic_cast<const bdb_index<bucket_object>&>(db.get_index(bucket_object::space_id, bucket_object::type_id));
+   const auto& by_key_idx = bucket_idx.get_bdb_secondary_index(0);
+
+   for( auto bucket : _tracked_buckets )
+   {
+      auto bucket_num = now.sec_since_epoch() / bucket;
+      key.seconds = bucket;
+      key.open    = fc::time_point_sec() + ( bucket_num * bucket );
+
+      open_bucket& ob = _open_buckets[ std::make_tuple( key.base, key.quote, bucket ) ];
+      if( ob.bucket.key.seconds == bucket && ob.bucket.key.open == key.open )
+         apply_fill( ob.bucket, trade_price, fill_price );
+      else
+      {
+         // the previous candle is closed, it was written at the end of its last block.
+         // The new one may have been stored already, before a restart or a fork switch
+         ob = open_bucket();
+         auto bo = by_key_idx.find_db( &key, sizeof(key) );
+         if( bo )
+         {
+            ob.bucket = *bo;
+            ob.flushed = *bo;
+            ob.stored = true;
+            apply_fill( ob.bucket, trade_price, fill_price );
+         }
+         else
+         {
+            bucket_object& b = ob.bucket;
+            b.key = key;
+            b.base_volume = trade_price.base.amount;
+            b.quote_volume = trade_price.quote.amount;
+            b.open_base = fill_price.base.amount;
+            b.open_quote = fill_price.quote.amount;
+            b.close_base = fill_price.base.amount;
+            b.close_quote = fill_price.quote.amount;
+            b.high_base = b.close_base;
+            b.high_quote = b.close_quote;
+            b.low_base = b.close_base;
+            b.low_quote = b.close_quote;
+         }
+         // old buckets can only expire when a new one opens
+         remove_expired_buckets( key, bucket_num );
+      }
+      ob.dirty = true;
+   }
+}
+
+void market_history_plugin_impl::remove_expired_buckets( bucket_key key, uint32_t bucket_num )
+{
+   if( bucket_num <= _maximum_history_per_bucket_size )
+      return;
+
+   graphene::chain::database& db = database();
+   const auto& bucket_idx = dynamic_cast<const bdb_index<bucket_object>&>(db.get_index(bucket_object::space_id, bucket_object::type_id));
+   const auto& by_key_idx = bucket_idx.get_bdb_secondary_index(0);
+
+   fc::time_point_sec cutoff = fc::time_point_sec() + ( key.seconds * ( bucket_num - _maximum_history_per_bucket_size ) );
+   key.open = fc::time_point_sec();
+   auto bucket_itr = by_key_idx.lower_bound( &key, sizeof(key));
+   vector<bucket_object> vect;
+   while( bucket_itr != by_key_idx.end() &&
+      bucket_itr->key.base == key.base &&
+      bucket_itr->key.quote == key.quote &&
+      bucket_itr->key.seconds == key.seconds &&
+      bucket_itr->key.open < cutoff )
+   {
+      vect.push_back(*bucket_itr);
+      ++bucket_itr;
+   }
+
+   for ( auto xbo : vect)
+   {
+       db.remove(xbo);
+   }
+
+   auto series_itr = _candle_cache.find( std::make_tuple( key.base, key.quote, key.seconds ) );
+   if( series_itr != _candle_cache.end() )
+   {
+      auto& candles = series_itr->second.candles;
+      while( !candles.empty() && candles.front().open < cutoff.sec_since_epoch() )
+         candles.pop_front();
+   }
+}
+
+/**
+ * Called at the end of every block, so that the buckets in BDB, and the undo history of the
+ * block, are complete once the block is applied.
+ */
+void market_history_plugin_impl::flush_open_buckets( fc::time_point_sec now )
+{
+   graphene::chain::database& db = database();
+   for( auto itr = _open_buckets.begin(); itr != _open_buckets.end(); )
+   {
+      open_bucket& ob = itr->second;
+      // no fill reaches a closed candle anymore, a market trading again reads its new candle from BDB
+      if( !ob.dirty )
+      {
+         if( ob.bucket.key.open + ob.bucket.key.seconds <= now )
+            itr = _open_buckets.erase( itr );
+         else
+            ++itr;
+         continue;
+      }
+      if( ob.stored )
+         db.modify( ob.flushed, [&]( bucket_object& b ){ b = ob.bucket; } );
+      else
+      {
+         auto obj = db.create_db<bucket_object>( [&]( bucket_object& b ){
+            object_id_type id = b.id;
+            b = ob.bucket;
+            b.id = id;
+         });
+         ob.bucket.id = obj->id;
+         ob.stored = true;
+      }
+      ob.flushed = ob.bucket;
+      ob.dirty = false;
+
+      auto series_itr = _candle_cache.find( itr->first );
+      if( series_itr != _candle_cache.end() )
+      {
+         auto& candles = series_itr->second.candles;
+         cached_candle c( ob.bucket );
+         if( !candles.empty() && candles.back().open == c.open )
+            candles.back() = c;
+         else if( candles.empty() || candles.back().open < c.open )
+            candles.push_back( c );
+         else // should not happen, let the next query load it again
+            _candle_cache.erase( series_itr );
+      }
+      ++itr;
+   }
+}
+
 void market_history_plugin_impl::update_market_histories( const signed_block& b )
 {
    graphene::chain::database& db = database();
+   // blocks have been popped, the candles are loaded again from BDB, where undo has restored them
+   if( b.block_num() <= _last_block_num )
+   {
+      _open_buckets.clear();
+      _candle_cache.clear();
+      undo_ticker_fills( b.block_num() );
+   }
+   _last_block_num = b.block_num();
+
    const market_ticker_meta_object* _meta = nullptr;
    const auto& meta_idx = db.get_index_type<simple_index<market_ticker_meta_object>>();
    if( meta_idx.size() > 0 )
@@ -341,81 +513,319 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
       {
          try
          {
-            o_op->op.visit( operation_process_fill_order( _self, b.timestamp, _meta ) );
+            o_op->op.visit( operation_process_fill_order( _self, *this, b.timestamp, _meta ) );
          } FC_CAPTURE_AND_LOG( (o_op) )
       }
    }
-   // roll out expired data from ticker
-   if( _meta != nullptr )
+   flush_open_buckets( b.timestamp );
+   trim_order_history( b.timestamp );
+
+   roll_out_ticker( b, _meta );
+}
+
+/**
+ * Sets hkey.sequence to the first record of the market which is beyond both the count and the time limit.
+ * The cursors it opens are closed when it returns, before the write cursor of the trim is opened.
+ */
+bool market_history_plugin_impl::find_order_history_trim_start( history_key& hkey, fc::time_point_sec min_time,
+                                                                 const bdb_secondary_index<order_history_object>& history_idx,
+                                                                 const bdb_secondary_index<order_history_object>& his_time_idx )
+{
+   // sequences decrease, the newest record of the market comes first
+   hkey.sequence = std::numeric_limits<int64_t>::min();
+   auto itr = history_idx.lower_bound( &hkey, sizeof(hkey) );
+   if( itr == history_idx.end() || itr->key.base != hkey.base || itr->key.quote != hkey.quote )
+      return false;
+
+   hkey.sequence = itr->key.sequence + _max_order_his_records_per_market;
+   itr = history_idx.lower_bound( &hkey, sizeof(hkey) );
+   if( itr == history_idx.end() || itr->key.base != hkey.base || itr->key.quote != hkey.quote )
+      return false;
+
+   order_history_market_time_key market_time_key;
+   market_time_key.base = hkey.base;
+   market_time_key.quote = hkey.quote;
+   market_time_key.time = min_time;
+   market_time_key.sequence = 0;
+   auto time_itr = his_time_idx.lower_bound( &market_time_key, sizeof(market_time_key) );
+   if( time_itr == his_time_idx.end() || time_itr->key.base != hkey.base || time_itr->key.quote != hkey.quote )
+      return false;
+
+   hkey.sequence = std::max( itr->key.sequence, time_itr->key.sequence );
+   return true;
+}
+
+const candle_series& market_history_plugin_impl::cached_candles( const open_bucket_key& key )
+{
+   auto itr = _candle_cache.find( key );
+   if( itr == _candle_cache.end() )
    {
-      time_point_sec last_day = b.timestamp - 86400;
-      object_id_type last_min_his_id = _meta->rolling_min_order_his_id;
-      bool skip = _meta->skip_min_order_his_id;
+      if( _candle_cache.size() >= _max_cached_candle_series )
+      {
+         auto lru = _candle_cache.begin();
+         for( auto i = _candle_cache.begin(); i != _candle_cache.end(); ++i )
+            if( i->second.last_used < lru->second.last_used )
+               lru = i;
+         _candle_cache.erase( lru );
+      }
 
-      const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
-      // const auto& history_idx = db.get_index_type<history_index>().indices().get<by_id>();
-      // auto history_itr = history_idx.lower_bound( _meta->rolling_min_order_his_id );
-      const auto& history_idx = dynamic_cast<const bdb_index<order_history_object>&>(db.get_index(order_history_object::space_id, order_history_object::type_id));
-      auto history_itr = history_idx.lower_bound( _meta->rolling_min_order_his_id );
+      candle_series series;
+      graphene::chain::database& db = database();
+      const auto& bucket_idx = dynamic_cast<const bdb_index<bucket_object>&>(db.get_index(bucket_object::space_id, bucket_object::type_id));
+      const auto& by_key_idx = bucket_idx.get_bdb_secondary_index(0);
+      bucket_key bkey( std::get<0>(key), std::get<1>(key), std::get<2>(key), fc::time_point_sec() );
+      auto bucket_itr = by_key_idx.lower_bound( &bkey, sizeof(bkey) );
+      while( bucket_itr != by_key_idx.end() &&
+         bucket_itr->key.base == bkey.base &&
+         bucket_itr->key.quote == bkey.quote &&
+         bucket_itr->key.seconds == bkey.seconds )
+      {
+         series.candles.emplace_back( *bucket_itr );
+         ++bucket_itr;
+      }
+      itr = _candle_cache.emplace( key, std::move( series ) ).first;
+   }
+   itr->second.last_used = ++_candle_cache_clock;
+   return itr->second;
+}
+
+static int64_t add_volume( int64_t a, int64_t b )
+{
+   return a > std::numeric_limits<int64_t>::max() - b ? std::numeric_limits<int64_t>::max() : a + b;
+}
 
-      while( history_itr != history_idx.end() && history_itr->time < last_day )
+market_candles market_history_plugin_impl::get_candles( asset_id_type a, asset_id_type b, uint32_t resolution,
+                                                        fc::time_point_sec start, fc::time_point_sec end, uint32_t limit )
+{
+   // flat_set is sorted, the last match is the largest
+   uint32_t tier = 0;
+   for( auto bucket : _tracked_buckets )
+      if( resolution >= bucket && resolution % bucket == 0 )
+         tier = bucket;
+   FC_ASSERT( tier != 0, "resolution ${r} is not a multiple of a tracked bucket size", ("r", resolution) );
+
+   // blocks have been popped and no block was applied since, undo has restored the buckets in BDB
+   if( database().head_block_num() < _last_block_num )
+      _candle_cache.clear();
+
+   if( a > b ) std::swap( a, b );
+   const auto& candles = cached_candles( std::make_tuple( a, b, tier ) ).candles;
+
+   // start from the first bucket of the candle containing start
+   uint32_t first_open = start.sec_since_epoch() / resolution * resolution;
+   auto itr = std::lower_bound( candles.begin(), candles.end(), first_open,
+                                []( const cached_candle& c, uint32_t open ){ return c.open < open; } );
+
+   vector<cached_candle> merged;
+   for( ; itr != candles.end() && itr->open <= end.sec_since_epoch(); ++itr )
+   {
+      const cached_candle& c = *itr;
+      uint32_t open = c.open / resolution * resolution;
+      if( merged.empty() || merged.back().open != open )
       {
-         const fill_order_operation& o = history_itr->op;
-         if( skip && history_itr->id == _meta->rolling_min_order_his_id )
-            skip = false;
-         else if( o.is_maker )
-         {
-            bucket_key key;
-            key.base    = o.pays.asset_id;
-            key.quote   = o.receives.asset_id;
+         if( merged.size() == limit )
+            break;
+         merged.push_back( c );
+         merged.back().open = open;
+         continue;
+      }
+      cached_candle& m = merged.back();
+      if( price( asset( m.high_base, a ), asset( m.high_quote, b ) ) < price( asset( c.high_base, a ), asset( c.high_quote, b ) ) )
+      {
+         m.high_base = c.high_base;
+         m.high_quote = c.high_quote;
+      }
+      if( price( asset( m.low_base, a ), asset( m.low_quote, b ) ) > price( asset( c.low_base, a ), asset( c.low_quote, b ) ) )
+      {
+         m.low_base = c.low_base;
+         m.low_quote = c.low_quote;
+      }
+      m.close_base = c.close_base;
+      m.close_quote = c.close_quote;
+      m.base_volume = add_volume( m.base_volume, c.base_volume );
+      m.quote_volume = add_volume( m.quote_volume, c.quote_volume );
+   }
 
-            price trade_price = o.pays / o.receives;
+   market_candles result;
+   result.resolution = resolution;
+   result.open_time.reserve( merged.size() );
+   for( const auto& m : merged )
+   {
+      result.open_time.push_back( m.open );
+      result.open_base.push_back( m.open_base );
+      result.open_quote.push_back( m.open_quote );
+      result.high_base.push_back( m.high_base );
+      result.high_quote.push_back( m.high_quote );
+      result.low_base.push_back( m.low_base );
+      result.low_quote.push_back( m.low_quote );
+      result.close_base.push_back( m.close_base );
+      result.close_quote.push_back( m.close_quote );
+      result.base_volume.push_back( m.base_volume );
+      result.quote_volume.push_back( m.quote_volume );
+   }
+   return result;
+}
 
-            if( key.base > key.quote )
-            {
-               std::swap( key.base, key.quote );
-               trade_price = ~trade_price;
-            }
+void market_history_plugin_impl::trim_order_history( fc::time_point_sec now )
+{
+   if( _markets_to_trim.empty() )
+      return;
 
-            price fill_price = o.fill_price;
-            if( fill_price.base.asset_id > fill_price.quote.asset_id )
-               fill_price = ~fill_price;
+   graphene::chain::database& db = database();
+   const auto& order_his_idx = dynamic_cast<const bdb_index<order_history_object>&>(db.get_index(order_history_object::space_id, order_history_object::type_id));
+   auto& history_idx = order_his_idx.get_bdb_secondary_index(0);
+   const auto& his_time_idx = order_his_idx.get_bdb_secondary_index(1);
+
+   uint32_t budget = _max_order_his_removals_per_block ? _max_order_his_removals_per_block : std::numeric_limits<uint32_t>::max();
+   fc::time_point_sec min_time;
+   if( min_time + _max_order_his_seconds_per_market < now )
+      min_time = now - _max_order_his_seconds_per_market;
 
-            auto ticker_itr = ticker_idx.find( std::make_tuple( key.base, key.quote ) );
-            if( ticker_itr != ticker_idx.end() ) // should always be true
+   auto market_itr = _markets_to_trim.begin();
+   while( market_itr != _markets_to_trim.end() && budget > 0 )
+   {
+      history_key hkey;
+      hkey.base = market_itr->first;
+      hkey.quote = market_itr->second;
+
+      bool trimmed = true;
+      if( find_order_history_trim_start( hkey, min_time, history_idx, his_time_idx ) )
+      {
+         history_idx.erase_where( &hkey, sizeof(hkey), [&]( const order_history_object& oho ) {
+            if( oho.key.base != hkey.base || oho.key.quote != hkey.quote )
+               return bdb_cursor_action::stop;
+            if( budget == 0 )
             {
-               db.modify( *ticker_itr, [&]( market_ticker_object& mt ) {
-                  mt.last_day_base  = fill_price.base.amount;
-                  mt.last_day_quote = fill_price.quote.amount;
-                  mt.base_volume    -= trade_price.base.amount.value;  // ignore underflow
-                  mt.quote_volume   -= trade_price.quote.amount.value; // ignore underflow
-               });
+               trimmed = false;
+               return bdb_cursor_action::stop;
             }
-         }
-         last_min_his_id = history_itr->id;
-         ++history_itr;
+            --budget;
+            // let undo put the record back if the block is popped
+            db._undo_db.on_remove( oho );
+            return bdb_cursor_action::erase;
+         });
       }
-      // update meta
-      if( history_itr != history_idx.end() ) // if still has some data rolling
+      if( trimmed )
+         market_itr = _markets_to_trim.erase( market_itr );
+      else
+         ++market_itr;
+   }
+}
+
+void market_history_plugin_impl::roll_out_ticker( const signed_block& b, const market_ticker_meta_object* meta )
+{
+   if( meta == nullptr )
+      return;
+
+   graphene::chain::database& db = database();
+   const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+   time_point_sec last_day = b.timestamp - 86400;
+   object_id_type last_min_his_id = meta->rolling_min_order_his_id;
+   bool rolled_out = false;
+
+   while( !_ticker_fills.empty() && _ticker_fills.front().time < last_day )
+   {
+      const ticker_fill& f = _ticker_fills.front();
+      auto ticker_itr = ticker_idx.find( std::make_tuple( f.base, f.quote ) );
+      if( ticker_itr != ticker_idx.end() ) // should always be true
       {
-         if( history_itr->id != _meta->rolling_min_order_his_id ) // if rolled out some
+         db.modify( *ticker_itr, [&]( market_ticker_object& mt ) {
+            mt.last_day_base  = f.fill_base;
+            mt.last_day_quote = f.fill_quote;
+            mt.base_volume    -= f.base_volume.value;  // ignore underflow
+            mt.quote_volume   -= f.quote_volume.value; // ignore underflow
+         });
+      }
+      last_min_his_id = f.order_his_id;
+      rolled_out = true;
+      _retired_ticker_fills.emplace_back( b.block_num(), f );
+      _ticker_fills.pop_front();
+   }
+
+   // update meta, it is where load_ticker_fills() starts after a restart
+   if( rolled_out )
+   {
+      db.modify( *meta, [&]( market_ticker_meta_object& mtm ) {
+         if( !_ticker_fills.empty() ) // if still has some data rolling
          {
-            db.modify( *_meta, [&]( market_ticker_meta_object& mtm ) {
-               mtm.rolling_min_order_his_id = history_itr->id;
-               mtm.skip_min_order_his_id = false;
-            });
+            mtm.rolling_min_order_his_id = _ticker_fills.front().order_his_id;
+            mtm.skip_min_order_his_id = false;
          }
-      }
-      else // if all data are rolled out
-      {
-         if( last_min_his_id != _meta->rolling_min_order_his_id ) // if rolled out some
+         else // if all data are rolled out
          {
-            db.modify( *_meta, [&]( market_ticker_meta_object& mtm ) {
-               mtm.rolling_min_order_his_id = last_min_his_id;
-               mtm.skip_min_order_his_id = true;
-            });
+            mtm.rolling_min_order_his_id = last_min_his_id;
+            mtm.skip_min_order_his_id = true;
          }
+      });
+   }
+
+   const uint32_t last_irreversible = db.get_dynamic_global_properties().last_irreversible_block_num;
+   while( !_retired_ticker_fills.empty() && _retired_ticker_fills.front().first <= last_irreversible )
+      _retired_ticker_fills.pop_front();
+}
+
+void market_history_plugin_impl::undo_ticker_fills( uint32_t block_num )
+{
+   if( block_num <= _ticker_fills_loaded_at )
+   {
+      // the fills of these blocks came from the order history, undo has restored it already
+      load_ticker_fills();
+      return;
+   }
+   while( !_ticker_fills.empty() && _ticker_fills.back().block_num >= block_num )
+      _ticker_fills.pop_back();
+   while( !_retired_ticker_fills.empty() && _retired_ticker_fills.back().first >= block_num )
+   {
+      _ticker_fills.push_front( _retired_ticker_fills.back().second );
+      _retired_ticker_fills.pop_back();
+   }
+}
+
+void market_history_plugin_impl::load_ticker_fills()
+{
+   graphene::chain::database& db = database();
+   _ticker_fills.clear();
+   _retired_ticker_fills.clear();
+   _ticker_fills_loaded_at = db.head_block_num();
+
+   const auto& meta_idx = db.get_index_type<simple_index<market_ticker_meta_object>>();
+   if( meta_idx.size() == 0 )
+      return;
+   const market_ticker_meta_object& meta = *meta_idx.begin();
+
+   const auto& history_idx = dynamic_cast<const bdb_index<order_history_object>&>(db.get_index(order_history_object::space_id, order_history_object::type_id));
+   auto history_itr = history_idx.lower_bound( meta.rolling_min_order_his_id );
+   if( meta.skip_min_order_his_id && history_itr != history_idx.end() && history_itr->id == meta.rolling_min_order_his_id )
+      ++history_itr;
+
+   for( ; history_itr != history_idx.end(); ++history_itr )
+   {
+      const fill_order_operation& o = history_itr->op;
+      if( !o.is_maker )
+         continue;
+
+      ticker_fill tf;
+      tf.time         = history_itr->time;
+      tf.order_his_id = history_itr->id;
+      tf.base         = o.pays.asset_id;
+      tf.quote        = o.receives.asset_id;
+
+      price trade_price = o.pays / o.receives;
+      if( tf.base > tf.quote )
+      {
+         std::swap( tf.base, tf.quote );
+         trade_price = ~trade_price;
       }
+
+      price fill_price = o.fill_price;
+      if( fill_price.base.asset_id > fill_price.quote.asset_id )
+         fill_price = ~fill_price;
+
+      tf.base_volume  = trade_price.base.amount;
+      tf.quote_volume = trade_price.quote.amount;
+      tf.fill_base    = fill_price.base.amount;
+      tf.fill_quote   = fill_price.quote.amount;
+      _ticker_fills.push_back( tf );
    }
 }
 
@@ -454,6 +864,10 @@ void market_history_plugin::plugin_set_program_options(
            "Will only store this amount of matched orders for each market in order history for querying, or those meet the other option, which has more data (default: 1000)")
          ("max-order-his-seconds-per-market", boost::program_options::value<uint32_t>()->default_value(259200),
            "Will only store matched orders in last X seconds for each market in order history for querying, or those meet the other option, which has more data (default: 259200 (3 days))")
+         ("max-order-his-removals-per-block", boost::program_options::value<uint32_t>()->default_value(1000),
+           "Maximum number of old matched orders removed from order history per block, the rest is removed in later blocks, 0 for no limit (default: 1000)")
+         ("max-cached-candle-series", boost::program_options::value<uint32_t>()->default_value(200),
+           "How many markets and bucket sizes to keep in memory for candle queries, the least recently queried are dropped first (default: 200)")
          ;
    cfg.add(cli);
 }
@@ -594,7 +1008,7 @@ int order_history_market_time_comp(Db* db, const Dbt* key1, const Dbt* key2, siz
 
 void market_history_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 { try {
-   database().applied_block.connect( [this]( const signed_block& b){ my->update_market_histories(b); } );
+   database().applied_block.connect( database().timed_handler( plugin_name(), [this]( const signed_block& b){ my->update_market_histories(b); } ) );
    // database().add_index< primary_index< bucket_index  > >();
    auto bucket_idx = database().add_index< primary_index< bdb_index<bucket_object> > >();
    bucket_idx->add_bdb_secondary_index(new bdb_secondary_index<bucket_object>("by_key", false, bucket_key_comp), get_bucket_key);
@@ -619,10 +1033,15 @@ void market_history_plugin::plugin_initialize(const boost::program_options::vari
       my->_max_order_his_records_per_market = options["max-order-his-records-per-market"].as<uint32_t>();
    if( options.count( "max-order-his-seconds-per-market" ) )
       my->_max_order_his_seconds_per_market = options["max-order-his-seconds-per-market"].as<uint32_t>();
+   if( options.count( "max-order-his-removals-per-block" ) )
+      my->_max_order_his_removals_per_block = options["max-order-his-removals-per-block"].as<uint32_t>();
+   if( options.count( "max-cached-candle-series" ) )
+      my->_max_cached_candle_series = std::max( options["max-cached-candle-series"].as<uint32_t>(), 1u );
 } FC_CAPTURE_AND_RETHROW() }
 
 void market_history_plugin::plugin_startup()
 {
+   my->load_ticker_fills();
 }
 
 const flat_set<uint32_t>& market_history_plugin::tracked_buckets() const
@@ -645,4 +1064,15 @@ uint32_t market_history_plugin::max_order_his_seconds_per_market()const
    return my->_max_order_his_seconds_per_market;
 }
 
+size_t market_history_plugin::open_candles()const
+{
+   return my->_open_buckets.size();
+}
+
+market_candles market_history_plugin::get_candles( asset_id_type a, asset_id_type b, uint32_t resolution,
+                                                   fc::time_point_sec start, fc::time_point_sec end, uint32_t limit )const
+{
+   return my->get_candles( a, b, resolution, start, end, limit );
+}
+
 } }
@@ -25,14 +25,18 @@
 
 #include <graphene/app/plugin.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/net/node.hpp>
 
 #include <websocketpp/config/asio_no_tls_client.hpp>
 #include <websocketpp/client.hpp>
 #include <websocketpp/common/thread.hpp>
 #include <websocketpp/common/memory.hpp>
 
+#include <fc/crypto/elliptic.hpp>
 #include <fc/thread/future.hpp>
 
+#include <boost/circular_buffer.hpp>
+
 namespace graphene { namespace poc_plugin {
 
 typedef websocketpp::client<websocketpp::config::asio_client> client;
@@ -174,6 +178,29 @@ private:
     int m_next_id;
 };
 
+/**
+ * Contribution of this node measured over one collection period.
+ */
+struct contribution_sample
+{
+   fc::time_point_sec time;                ///< end of the period
+   uint32_t           uptime_seconds = 0;  ///< time the node was running during the period
+   uint64_t           bytes_served   = 0;  ///< blocks and transactions read from disk for peers
+   uint64_t           bytes_relayed  = 0;  ///< items forwarded to peers from the message cache
+
+   /// uptime in seconds plus served and relayed traffic in KiB, saturated to the range of pio_operation::contribution
+   uint32_t score()const;
+};
+
+/**
+ * Samples kept on disk so that uptime and unreported contributions survive restarts.
+ */
+struct contribution_journal
+{
+   fc::time_point_sec                last_report;
+   std::vector<contribution_sample>  samples;
+};
+
 class poc_plugin : public graphene::app::plugin {
 public:
    ~poc_plugin() {
@@ -190,18 +217,46 @@ public:
    virtual void plugin_startup() override;
    virtual void plugin_shutdown() override;
 
+   /// most recent samples, oldest first
+   const boost::circular_buffer<contribution_sample>& samples()const { return _samples; }
+
 private:
    void schedule_poc_loop();
    void _schedule_poc_loop();
 
-   uint32_t disk_contribution();
-   uint32_t uptime_contribution();
-   uint32_t l2_contribution();
-   void send_to(uint32_t contributions);
+   contribution_sample collect_sample();
+   void load_journal();
+   void save_journal()const;
+   void report_contributions();
+   void on_applied_block( const graphene::chain::signed_block& b );
 
    fc::future<void> _contribution_collection_task;
-   uint32_t _collection_period;
+   uint32_t _collection_period = 24;
+   uint32_t _report_periods = 150;
    std::string _supervisor_addr;
+
+   boost::circular_buffer<contribution_sample> _samples;
+   fc::time_point_sec _last_report;             ///< time of the last sample covered by a report included in a block
+   fc::time_point_sec _last_sample_time;
+   graphene::net::node_traffic_totals _last_traffic;
+   uint32_t _periods_since_report = 0;
+   fc::path _journal_file;
+
+   std::string _reporter_name;
+   fc::optional<graphene::chain::account_id_type> _reporter_id;
+   fc::optional<fc::ecc::private_key> _reporter_key;
+
+   /// broadcast report waiting to be included in a block
+   struct pending_report
+   {
+      graphene::chain::transaction_id_type trx_id;
+      fc::time_point_sec                   expiration;
+      fc::time_point_sec                   last_sample;
+   };
+   fc::optional<pending_report> _pending_report;
 };
 
 } } //graphene::poc_plugin
+
+FC_REFLECT( graphene::poc_plugin::contribution_sample, (time)(uptime_seconds)(bytes_served)(bytes_relayed) )
+FC_REFLECT( graphene::poc_plugin::contribution_journal, (last_report)(samples) )
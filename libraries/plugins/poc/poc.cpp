@@ -23,16 +23,18 @@
  */
 #include <graphene/poc/poc.hpp>
 
+#include <graphene/chain/account_object.hpp>
 #include <graphene/chain/database.hpp>
-#include <graphene/chain/witness_object.hpp>
-#include <graphene/wallet/wallet.hpp>
 
 #include <graphene/utilities/key_conversion.hpp>
 
+#include <fc/io/json.hpp>
 #include <fc/smart_ref_impl.hpp>
 #include <fc/thread/thread.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 
 using namespace graphene::poc_plugin;
 using namespace graphene::chain;
@@ -41,6 +43,12 @@ using std::vector;
 
 namespace bpo = boost::program_options;
 
+uint32_t contribution_sample::score()const
+{
+   const uint64_t total = uint64_t( uptime_seconds ) + ( bytes_served >> 10 ) + ( bytes_relayed >> 10 );
+   return uint32_t( std::min<uint64_t>( total, std::numeric_limits<uint32_t>::max() ) );
+}
+
 void poc_plugin::plugin_set_program_options(
    boost::program_options::options_description& command_line_options,
    boost::program_options::options_description& config_file_options)
@@ -48,6 +56,12 @@ void poc_plugin::plugin_set_program_options(
    command_line_options.add_options()
          ("poc-period", boost::program_options::value<uint32_t>()->default_value(24), "Node Contribution Collection Period")
          ("poc-supervisor", boost::program_options::value<std::string>()->default_value("65.49.233.5:8093"), "Node Contribution Supervisor Address")
+         ("poc-history", boost::program_options::value<uint32_t>()->default_value(3600),
+          "Number of collection periods kept in the local contribution journal")
+         ("poc-report-periods", boost::program_options::value<uint32_t>()->default_value(150),
+          "Number of collection periods aggregated into one on-chain contribution report")
+         ("poc-account", boost::program_options::value<std::string>(), "Name of the account reporting the contributions of this node")
+         ("poc-private-key", boost::program_options::value<std::string>(), "WIF private key used to sign contribution reports")
          ;
    config_file_options.add(command_line_options);
    return;
@@ -65,23 +79,53 @@ void poc_plugin::plugin_initialize(const boost::program_options::variables_map&
        _collection_period = options["poc-period"].as<uint32_t>();
        ilog("###  period is ${p}", ("p", _collection_period));
    }
+   FC_ASSERT( _collection_period > 0, "poc-period must be positive" );
    if (options.count("poc-supervisor")) {
        _supervisor_addr = "ws://"+options["poc-supervisor"].as<std::string>();
        ilog("###  supervisor is ${a}", ("a", _supervisor_addr));
    }
+   if (options.count("poc-report-periods"))
+      _report_periods = std::max<uint32_t>( options["poc-report-periods"].as<uint32_t>(), 1 );
+   _samples.set_capacity( options.count("poc-history") ? std::max<uint32_t>( options["poc-history"].as<uint32_t>(), 1 ) : 3600 );
+
+   if (options.count("poc-account") && options.count("poc-private-key")) {
+      _reporter_name = options["poc-account"].as<std::string>();
+      _reporter_key = graphene::utilities::wif_to_key( options["poc-private-key"].as<std::string>() );
+      FC_ASSERT( _reporter_key.valid(), "Invalid WIF-format private key in poc-private-key" );
+      ilog("###  reporting contributions as ${a}", ("a", _reporter_name));
+   }
+   else
+      wlog("poc-account and poc-private-key are not set, contributions are collected but not reported");
+
+   if (options.count("data-dir")) {
+      const fc::path data_dir = options["data-dir"].as<boost::filesystem::path>();
+      fc::create_directories( data_dir / "poc" );
+      _journal_file = data_dir / "poc" / "contributions.json";
+      load_journal();
+   }
    ilog("poc plugin:  plugin_initialize() end");
 } FC_LOG_AND_RETHROW() }
 
 void poc_plugin::plugin_startup()
 { try {
    ilog("poc plugin:  plugin_startup() begin");
+   _last_sample_time = fc::time_point::now();
+   database().applied_block.connect( database().timed_handler( plugin_name(), [this]( const signed_block& b ) {
+      on_applied_block( b );
+   } ) );
    schedule_poc_loop();
    ilog("poc plugin:  plugin_startup() end");
 } FC_CAPTURE_AND_RETHROW() }
 
 void poc_plugin::plugin_shutdown()
 {
-   // nothing to do
+   try {
+      if( _contribution_collection_task.valid() )
+         _contribution_collection_task.cancel_and_wait( __FUNCTION__ );
+   } catch( fc::canceled_exception& ) {
+      //Expected exception. Move along.
+   }
+   save_journal();
 }
 
 void poc_plugin::schedule_poc_loop()
@@ -96,55 +140,154 @@ void poc_plugin::schedule_poc_loop()
 
 void poc_plugin::_schedule_poc_loop()
 {
-   uint32_t contributions;
-   ilog("_schedule_poc_loop()");
-
-   // retrieve contributions
-   contributions = disk_contribution();
-   contributions += uptime_contribution();
-   contributions += l2_contribution();
+   try
+   {
+      // saved every period, a crash loses at most the sample being collected
+      _samples.push_back( collect_sample() );
+      save_journal();
 
-   // report contribution
-   send_to(contributions);
+      if( ++_periods_since_report >= _report_periods )
+      {
+         report_contributions();
+         _periods_since_report = 0;
+      }
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Failed to collect node contribution: ${e}", ("e", e.to_detail_string()) );
+   }
 
    schedule_poc_loop();
 }
 
-uint32_t poc_plugin::disk_contribution()
+/**
+ * Traffic counters are totals since the p2p node started, the sample records the part of them
+ * accumulated during this period.  Uptime is the wall clock time since the previous sample, so
+ * periods during which the node was down are simply absent from the journal.
+ */
+contribution_sample poc_plugin::collect_sample()
 {
-   // Fix me
-   return 1;
+   const fc::time_point_sec now = fc::time_point::now();
+   const graphene::net::node_traffic_totals traffic = p2p_node().get_traffic_totals();
+
+   contribution_sample sample;
+   sample.time = now;
+   sample.uptime_seconds = now > _last_sample_time ? ( now - _last_sample_time ).to_seconds() : 0;
+   sample.bytes_served = traffic.bytes_served - _last_traffic.bytes_served;
+   sample.bytes_relayed = traffic.bytes_relayed - _last_traffic.bytes_relayed;
+
+   _last_sample_time = now;
+   _last_traffic = traffic;
+   return sample;
 }
 
-uint32_t poc_plugin::uptime_contribution()
+void poc_plugin::load_journal()
 {
-   return _collection_period;
+   if( !fc::exists( _journal_file ) )
+      return;
+   try
+   {
+      contribution_journal journal = fc::json::from_file( _journal_file ).as<contribution_journal>( 3 );
+      _last_report = journal.last_report;
+      for( const contribution_sample& s : journal.samples )
+         _samples.push_back( s );
+      ilog( "Loaded ${n} contribution samples, last reported at ${t}", ("n", _samples.size())("t", _last_report) );
+   }
+   catch( const fc::exception& e )
+   {
+      wlog( "Ignoring unreadable contribution journal ${f}: ${e}", ("f", _journal_file)("e", e.to_detail_string()) );
+   }
 }
 
-uint32_t poc_plugin::l2_contribution()
+void poc_plugin::save_journal()const
 {
-   return 1;
+   if( _journal_file == fc::path() )
+      return;
+   contribution_journal journal;
+   journal.last_report = _last_report;
+   journal.samples.assign( _samples.begin(), _samples.end() );
+   // written aside and renamed, so a crash while saving leaves the previous journal intact
+   const fc::path tmp_file = _journal_file.generic_string() + ".tmp";
+   fc::json::save_to_file( journal, tmp_file );
+   fc::rename( tmp_file, _journal_file );
 }
 
-void poc_plugin::send_to(uint32_t contributions)
+/**
+ * Sums every sample taken since the previous report into a single pio_operation, so one
+ * transaction is broadcast per report instead of one per collection period.
+ */
+void poc_plugin::report_contributions()
 {
-    graphene::chain::database& db = database();
-    graphene::chain::signed_transaction trx;
-    // use alpha brain key to generate private key
-    vector<wallet::brain_key_info> derived_keys =
-         graphene::wallet::utility::derive_owner_keys_from_brain_key("REABUSE REFRACT BROODY FIGARO INTRANT BEGRIME MNEME TANE REDDING RESPADE MOMENTA WINK FANION SUET SLOB BAIGNET", 1);
-    fc::optional<fc::ecc::private_key> alpha_key = utilities::wif_to_key(derived_keys[0].wif_priv_key);
-    account_id_type contributor_id =
-         db.get_index_type<account_index>().indices().get<by_name>().find( "alpha" )->id;
-    pio_operation pio_op;
-    pio_op.from = contributor_id;
-    pio_op.rpc_addr = "none";
-    pio_op.contribution = contributions;
-
-    trx.set_expiration(db.head_block_time() + fc::seconds(60));
-    trx.operations.push_back(pio_op);
-    trx.sign(*alpha_key, db.get_chain_id());
-    trx.validate();
-
-    p2p_node().broadcast(graphene::net::trx_message(trx));
+   if( !_reporter_key.valid() )
+      return;
+   // samples of a report still in flight are sent again only once it expired unconfirmed
+   if( _pending_report.valid() )
+      return;
+
+   graphene::chain::database& db = database();
+   if( !_reporter_id.valid() )
+   {
+      const auto& accounts_by_name = db.get_index_type<account_index>().indices().get<by_name>();
+      auto itr = accounts_by_name.find( _reporter_name );
+      if( itr == accounts_by_name.end() )
+      {
+         wlog( "poc-account ${a} does not exist yet, contributions are not reported", ("a", _reporter_name) );
+         return;
+      }
+      _reporter_id = itr->id;
+   }
+
+   uint64_t contributions = 0;
+   fc::time_point_sec last_sample;
+   for( auto itr = _samples.rbegin(); itr != _samples.rend() && itr->time > _last_report; ++itr )
+   {
+      contributions += itr->score();
+      last_sample = std::max( last_sample, itr->time );
+   }
+   if( contributions == 0 )
+      return;
+
+   pio_operation pio_op;
+   pio_op.from = *_reporter_id;
+   pio_op.rpc_addr = "none";
+   pio_op.contribution = uint32_t( std::min<uint64_t>( contributions, std::numeric_limits<uint32_t>::max() ) );
+
+   graphene::chain::signed_transaction trx;
+   trx.set_expiration(db.head_block_time() + fc::seconds(60));
+   trx.operations.push_back(pio_op);
+   for( auto& op : trx.operations )
+      db.current_fee_schedule().set_fee( op );
+   trx.sign(*_reporter_key, db.get_chain_id());
+   trx.validate();
+
+   p2p_node().broadcast(graphene::net::trx_message(trx));
+
+   _pending_report = pending_report{ trx.id(), trx.expiration, last_sample };
+}
+
+/**
+ * Samples count as reported once the report is in a block, a report dropped by the network is
+ * retried with the next one.
+ */
+void poc_plugin::on_applied_block( const signed_block& b )
+{
+   if( !_pending_report.valid() )
+      return;
+
+   for( const auto& trx : b.transactions )
+   {
+      if( trx.operations.size() != 1 || trx.operations[0].which() != operation::tag<pio_operation>::value
+          || trx.operations[0].get<pio_operation>().from != *_reporter_id || trx.id() != _pending_report->trx_id )
+         continue;
+      _last_report = _pending_report->last_sample;
+      _pending_report.reset();
+      save_journal();
+      return;
+   }
+
+   if( b.timestamp > _pending_report->expiration )
+   {
+      wlog( "Contribution report ${t} expired before it was included in a block", ("t", _pending_report->trx_id) );
+      _pending_report.reset();
+   }
 }
@@ -71,9 +71,9 @@ void snapshot_plugin::plugin_initialize(const boost::program_options::variables_
          snapshot_block = options[OPT_BLOCK_NUM].as<uint32_t>();
       if( options.count(OPT_BLOCK_TIME) )
          snapshot_time = fc::time_point_sec::from_iso_string( options[OPT_BLOCK_TIME].as<std::string>() );
-      database().applied_block.connect( [&]( const graphene::chain::signed_block& b ) {
+      database().applied_block.connect( database().timed_handler( plugin_name(), [&]( const graphene::chain::signed_block& b ) {
          check_snapshot( b );
-      });
+      }));
    }
    else
       FC_ASSERT( !options.count("snapshot-to"), "Must specify snapshot-at-block or snapshot-at-time in addition to snapshot-to!" );
@@ -856,10 +856,24 @@ class wallet_api
       signed_transaction kill_contract(contract_addr_type contract_addr,
                                        bool broadcast = true);
 
+      /** Call a method of a smart contract deployed before the ABI hardfork.
+       * @param contract_addr address of the contract
+       * @param call_data the call as the contract reads it, sent as is
+       * @param broadcast true to broadcast the transaction on the network
+       */
       signed_transaction call_contract(contract_addr_type contract_addr,
                                        string call_data,
                                        bool broadcast = true);
 
+      /** Call a method of a smart contract deployed from the ABI hardfork.
+       * @param contract_addr address of the contract
+       * @param hex_call_data hex-encoded method selector followed by the packed arguments, see contract_abi
+       * @param broadcast true to broadcast the transaction on the network
+       */
+      signed_transaction call_contract_encoded(contract_addr_type contract_addr,
+                                               string hex_call_data,
+                                               bool broadcast = true);
+
       /** Transfer an amount from one account to another.
        * @param from the name or id of the account sending the funds
        * @param to the name or id of the account receiving the funds
@@ -1806,6 +1820,7 @@ FC_API( graphene::wallet::wallet_api,
         (deactivate_contract)
         (kill_contract)
         (call_contract)
+        (call_contract_encoded)
         (sell_asset)
         (borrow_asset)
         (borrow_asset_ext)
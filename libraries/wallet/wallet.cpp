@@ -106,6 +106,7 @@ public:
    std::string operator()(const void_result& x) const;
    std::string operator()(const object_id_type& oid);
    std::string operator()(const asset& a);
+   std::string operator()(const contract_call_result& r);
 };
 
 // BLOCK  TRX  OP  VOP
@@ -1337,6 +1338,20 @@ public:
         } FC_CAPTURE_AND_RETHROW((contract_addr)(call_data)(broadcast))
     }
 
+    signed_transaction call_contract_encoded(contract_addr_type contract_addr,
+                                             string hex_call_data,
+                                             bool broadcast = true)
+    {
+        try
+        {
+            string data(hex_call_data.size() / 2, '\0');
+            FC_ASSERT( hex_call_data.size() % 2 == 0
+                       && fc::from_hex(hex_call_data, &data[0], data.size()) == data.size(),
+                       "call data must be hex-encoded" );
+            return call_contract(contract_addr, data, broadcast);
+        } FC_CAPTURE_AND_RETHROW((contract_addr)(hex_call_data)(broadcast))
+    }
+
    signed_transaction create_asset(string issuer,
                                    string symbol,
                                    uint8_t precision,
@@ -3099,6 +3114,15 @@ std::string operation_result_printer::operator()(const asset& a)
    return _wallet.get_asset(a.asset_id).amount_to_pretty_string(a);
 }
 
+std::string operation_result_printer::operator()(const contract_call_result& r)
+{
+   std::string result = "gas used " + std::to_string(r.gas_used) + ", gas fee "
+                        + _wallet.get_asset(asset_id_type()).amount_to_pretty_string(r.gas_fee);
+   for( const auto& e : r.events )
+      result += ", event " + e.name;
+   return result;
+}
+
 }}}
 
 namespace graphene { namespace wallet {
@@ -3707,6 +3731,12 @@ signed_transaction wallet_api::call_contract(contract_addr_type contract_addr, s
     return my->call_contract(contract_addr, call_data, broadcast);
 }
 
+signed_transaction wallet_api::call_contract_encoded(contract_addr_type contract_addr, string hex_call_data,
+                                                     bool broadcast /*= true*/)
+{
+    return my->call_contract_encoded(contract_addr, hex_call_data, broadcast);
+}
+
 signed_transaction wallet_api::issue_asset(string to_account, string amount, string symbol,
                                            string memo, bool broadcast)
 {
@@ -33,6 +33,7 @@
 #include <graphene/snapshot/snapshot.hpp>
 #include <graphene/es_objects/es_objects.hpp>
 #include <graphene/grouped_orders/grouped_orders_plugin.hpp>
+#include <graphene/contract_history/contract_history_plugin.hpp>
 #include <graphene/poc/poc.hpp>
 
 #include <fc/exception/exception.hpp>
@@ -202,6 +203,7 @@ int main(int argc, char** argv) {
       auto snapshot_plug = node->register_plugin<snapshot_plugin::snapshot_plugin>();
       auto es_objects_plug = node->register_plugin<es_objects::es_objects_plugin>();
       auto grouped_orders_plug = node->register_plugin<grouped_orders::grouped_orders_plugin>();
+      auto contract_history_plug = node->register_plugin<contract_history::contract_history_plugin>();
       auto poc_plug = node->register_plugin<poc_plugin::poc_plugin>();
 
       try
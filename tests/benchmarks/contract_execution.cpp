@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/apply_statistics.hpp>
+#include <graphene/chain/contract_engine.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/hardfork.hpp>
+#include <graphene/chain/wren_contract_engine.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/crypto/digest.hpp>
+
+#include <functional>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+/*
+ * Contract execution benchmarks.  Three representative workloads are deployed with
+ * smart_contract_deploy_operation and called thousands of times through
+ * database::push_transaction() and generate_block(), once on a node with the usual test plugins
+ * (account and market history, grouped orders) and once on a bare database, to size
+ * contract-enabled witnesses.
+ *
+ * Every workload runs twice: as a Wren contract on wren_contract_engine, and on bench_engine, a
+ * native contract_engine doing the same storage accesses.  The native run covers the evaluator,
+ * gas metering, contract storage and undo, the difference to the Wren run is the VM time.
+ */
+
+namespace {
+
+#ifdef NDEBUG
+   const uint32_t calls_per_workload = 20000;
+#else
+   const uint32_t calls_per_workload = 2000;
+#endif
+   const uint32_t calls_per_block    = 200;
+   const uint32_t ledger_accounts    = 1000;
+   const uint32_t map_keys_per_call  = 32;
+   const string   bench_abi          = "[ { \"name\": \"run\", \"inputs\": [ \"uint64\" ] } ]";
+
+   enum workload_kind { counter_workload, ledger_workload, map_workload };
+
+   struct bench_contract : public compiled_contract
+   {
+      explicit bench_contract( workload_kind k ) : kind( k ) {}
+      workload_kind kind;
+   };
+
+   struct workload
+   {
+      string        name;
+      workload_kind kind;
+      string        wren_source;
+   };
+
+   /// The Wren contracts, storing numbers as their decimal strings
+   const std::vector<workload> workloads = {
+      { "counter", counter_workload,
+        "class Contract {\n"
+        "   static run(seq) {\n"
+        "      var count = Storage.get(\"count\")\n"
+        "      Storage.set(\"count\", ((count == null ? 0 : Num.fromString(count)) + 1).toString)\n"
+        "   }\n"
+        "}\n" },
+      { "token ledger", ledger_workload,
+        "class Contract {\n"
+        "   static run(seq) {\n"
+        "      var from = \"bal/\" + (seq % " + std::to_string( ledger_accounts ) + ").toString\n"
+        "      var to = \"bal/\" + ((seq * 7 + 1) % " + std::to_string( ledger_accounts ) + ").toString\n"
+        "      Storage.set(from, (balance(from) - 1).toString)\n"
+        "      Storage.set(to, (balance(to) + 1).toString)\n"
+        "   }\n"
+        "   static balance(key) {\n"
+        "      var value = Storage.get(key)\n"
+        "      return value == null ? 1000000 : Num.fromString(value)\n"
+        "   }\n"
+        "}\n" },
+      { "map-heavy", map_workload,
+        "class Contract {\n"
+        "   static run(seq) {\n"
+        "      for (i in 0..." + std::to_string( map_keys_per_call ) + ") {\n"
+        "         var key = \"map/\" + ((seq + i) % " + std::to_string( 16 * map_keys_per_call ) + ").toString\n"
+        "         var value = Storage.get(key)\n"
+        "         Storage.set(key, ((value == null ? 0 : Num.fromString(value)) + seq).toString)\n"
+        "      }\n"
+        "   }\n"
+        "}\n" } };
+
+   contract_addr_type contract_address( const string& bytecode )
+   {
+      return fc::sha256::hash( bytecode + bench_abi );
+   }
+
+   /// wren_contract_engine timing the calls it runs
+   struct wren_bench_engine : public wren_contract_engine
+   {
+      latency_histogram execute;
+
+      void call( compiled_contract& contract, const string& call_data, contract_storage& storage,
+                 contract_gas_meter& meter ) override
+      {
+         scoped_latency_timer timer( execute );
+         wren_contract_engine::call( contract, call_data, storage, meter );
+      }
+   };
+
+   struct bench_engine : public contract_engine
+   {
+      std::map<contract_addr_type, workload_kind> kinds;
+      latency_histogram                           execute;
+
+      compiled_contract_ptr compile( const contract_addr_type& addr, const contract_code_object& ) override
+      {
+         return std::make_shared<bench_contract>( kinds.at( addr ) );
+      }
+
+      /// call_data is run( sequence number ), the workload derives its keys from it
+      void call( compiled_contract& contract, const string& call_data, contract_storage& storage,
+                 contract_gas_meter& meter ) override
+      {
+         scoped_latency_timer timer( execute );
+         const uint64_t seq = fc::raw::unpack<uint64_t>(
+            vector<char>( call_data.begin() + contract_abi::selector_size, call_data.end() ) );
+         meter.charge( 100 );
+         switch( static_cast<bench_contract&>( contract ).kind )
+         {
+            case counter_workload:
+            {
+               auto count = storage.get_value<uint64_t>( "count" );
+               storage.set_value( "count", ( count.valid() ? *count : 0 ) + 1 );
+               break;
+            }
+            case ledger_workload:
+            {
+               const string from = "bal/" + std::to_string( seq % ledger_accounts );
+               const string to   = "bal/" + std::to_string( ( seq * 7 + 1 ) % ledger_accounts );
+               auto from_balance = storage.get_value<int64_t>( from );
+               auto to_balance   = storage.get_value<int64_t>( to );
+               storage.set_value( from, ( from_balance.valid() ? *from_balance : 1000000 ) - 1 );
+               storage.set_value( to, ( to_balance.valid() ? *to_balance : 1000000 ) + 1 );
+               break;
+            }
+            case map_workload:
+               for( uint32_t i = 0; i < map_keys_per_call; ++i )
+               {
+                  const string key = "map/" + std::to_string( ( seq + i ) % ( 16 * map_keys_per_call ) );
+                  auto value = storage.get_value<uint64_t>( key );
+                  storage.set_value( key, ( value.valid() ? *value : 0 ) + seq );
+               }
+               break;
+         }
+      }
+   };
+
+   /// A database without any plugin attached, opened with the same genesis as database_fixture
+   struct bare_chain
+   {
+      bare_chain()
+      {
+         genesis_state_type genesis_state;
+         genesis_state.initial_timestamp = time_point_sec( GRAPHENE_TESTING_GENESIS_TIMESTAMP );
+         genesis_state.initial_active_witnesses = 10;
+         for( unsigned int i = 0; i < genesis_state.initial_active_witnesses; ++i )
+         {
+            auto name = "init"+fc::to_string(i);
+            genesis_state.initial_accounts.emplace_back( name, key.get_public_key(), key.get_public_key(), true );
+            genesis_state.initial_committee_candidates.push_back({name});
+            genesis_state.initial_witness_candidates.push_back({name, key.get_public_key()});
+         }
+         genesis_state.initial_parameters.current_fees->zero_all_fees();
+         db.open( data_dir.path(), [&genesis_state]{ return genesis_state; }, "test" );
+         generate_block();
+      }
+      ~bare_chain() { db.close(); }
+
+      void generate_block()
+      {
+         db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), key,
+                            ~0 | database::skip_undo_history_check );
+         db.clear_pending();
+      }
+
+      /// Skips to the first slot at or after @p t, missing the blocks in between
+      void generate_blocks( fc::time_point_sec t )
+      {
+         const uint32_t slot = db.get_slot_at_time( t );
+         if( slot == 0 )
+            return;
+         db.generate_block( db.get_slot_time( slot ), db.get_scheduled_witness( slot ), key,
+                            ~0 | database::skip_undo_history_check );
+         db.clear_pending();
+      }
+
+      fc::temp_directory   data_dir{ graphene::utilities::temp_directory_path() };
+      database             db;
+      fc::ecc::private_key key = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "null_key" ) ) );
+   };
+
+   signed_transaction make_deploy( const database& db, const string& bytecode, const string& name )
+   {
+      smart_contract_deploy_operation op;
+      op.owner = GRAPHENE_COMMITTEE_ACCOUNT;
+      op.contract_addr = contract_address( bytecode );
+      op.bytecode = bytecode;
+      op.abi_json = bench_abi;
+      op.contract_name = name;
+      signed_transaction trx;
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      return trx;
+   }
+
+   signed_transaction make_call( const database& db, const contract_addr_type& addr, uint64_t seq )
+   {
+      smart_contract_call_operation op;
+      op.caller = GRAPHENE_COMMITTEE_ACCOUNT;
+      op.contract_addr = addr;
+      op.call_data = contract_abi::encode_call( "run", seq );
+      signed_transaction trx;
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      return trx;
+   }
+
+   void run_workload( database& db, const std::function<void()>& generate_block, const string& label,
+                      const string& bytecode, latency_histogram& execute )
+   {
+      const auto addr = contract_address( bytecode );
+      db.push_transaction( make_deploy( db, bytecode, label ), ~0 );
+      generate_block();
+
+      execute.reset();
+      const latency_histogram compile_before = db.get_contract_cache().compile_latency();
+      latency_histogram push_latency;
+      uint64_t gas_used = 0;
+
+      auto start = fc::time_point::now();
+      for( uint32_t i = 0; i < calls_per_workload; ++i )
+      {
+         processed_transaction ptx;
+         {
+            scoped_latency_timer timer( push_latency );
+            ptx = db.push_transaction( make_call( db, addr, i ), ~0 );
+         }
+         gas_used += ptx.operation_results[0].get<contract_call_result>().gas_used;
+         if( ( i + 1 ) % calls_per_block == 0 )
+            generate_block();
+      }
+      generate_block();
+      const int64_t elapsed_us = ( fc::time_point::now() - start ).count();
+
+      // undo cost: apply a block worth of calls in a session, then roll it back
+      int64_t undo_us = 0;
+      {
+         auto session = db._undo_db.start_undo_session();
+         for( uint32_t i = 0; i < calls_per_block; ++i )
+            db.apply_transaction( make_call( db, addr, calls_per_workload + i ), ~0 );
+         auto undo_start = fc::time_point::now();
+         session.undo();
+         undo_us = ( fc::time_point::now() - undo_start ).count();
+      }
+
+      const auto& compile_after = db.get_contract_cache().compile_latency();
+      const uint64_t compiles = compile_after.count - compile_before.count;
+      ilog( "${w}: ${n} calls in ${t} ms, ${r} calls/s, including ${b} blocks",
+            ("w", label)("n", calls_per_workload)("t", elapsed_us / 1000)
+            ("r", uint64_t( calls_per_workload * 1000000.0 / std::max<int64_t>( elapsed_us, 1 ) ))
+            ("b", calls_per_workload / calls_per_block + 1) );
+      ilog( "   push_transaction: p50 <= ${p50} us, p99 <= ${p99} us, max ${max} us",
+            ("p50", push_latency.percentile( 50 ))("p99", push_latency.percentile( 99 ))("max", push_latency.max_us) );
+      ilog( "   execute: mean ${e} us, p99 <= ${ep} us; gas per call ${g}",
+            ("e", execute.mean_us())("ep", execute.percentile( 99 ))("g", gas_used / calls_per_workload) );
+      ilog( "   undo: ${u} us per call, transaction overhead: ${o} us per call",
+            ("u", undo_us / calls_per_block)
+            ("o", int64_t( push_latency.mean_us() ) - int64_t( execute.mean_us() )) );
+
+      // calls run the contract compiled when it was deployed
+      BOOST_CHECK_EQUAL( compiles, 0u );
+   }
+
+   void run_contract_bench( database& db, const std::function<void()>& generate_block, const string& setup )
+   {
+      auto wren = std::make_shared<wren_bench_engine>();
+      db.set_contract_engine( wren );
+      for( const auto& w : workloads )
+         run_workload( db, generate_block, setup + " / wren / " + w.name, w.wren_source, wren->execute );
+
+      auto native = std::make_shared<bench_engine>();
+      db.set_contract_engine( native );
+      for( const auto& w : workloads )
+      {
+         const string bytecode = "native " + w.name;
+         native->kinds[contract_address( bytecode )] = w.kind;
+         run_workload( db, generate_block, setup + " / native / " + w.name, bytecode, native->execute );
+      }
+
+      db.set_contract_engine( nullptr );
+   }
+
+}
+
+BOOST_FIXTURE_TEST_CASE( contract_execution_bench_with_plugins, database_fixture )
+{
+   try {
+      generate_blocks( HARDFORK_CONTRACT_GAS_TIME );
+      run_contract_bench( db, [this]() { generate_block(); }, "with plugins" );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( contract_execution_bench_without_plugins )
+{
+   try {
+      bare_chain chain;
+      chain.generate_blocks( HARDFORK_CONTRACT_GAS_TIME );
+      run_contract_bench( chain.db, [&chain]() { chain.generate_block(); }, "without plugins" );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
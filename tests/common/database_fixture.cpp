@@ -25,6 +25,7 @@
 #include <boost/program_options.hpp>
 
 #include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/contract_history/contract_history_plugin.hpp>
 #include <graphene/market_history/market_history_plugin.hpp>
 #include <graphene/grouped_orders/grouped_orders_plugin.hpp>
 #include <graphene/elasticsearch/elasticsearch_plugin.hpp>
@@ -44,6 +45,7 @@
 #include <fc/smart_ref_impl.hpp>
 
 #include <iomanip>
+#include <limits>
 
 #include "database_fixture.hpp"
 
@@ -72,6 +74,7 @@ database_fixture::database_fixture()
    }
    auto mhplugin = app.register_plugin<graphene::market_history::market_history_plugin>();
    auto goplugin = app.register_plugin<graphene::grouped_orders::grouped_orders_plugin>();
+   auto chplugin = app.register_plugin<graphene::contract_history::contract_history_plugin>();
    init_account_pub_key = init_account_priv_key.get_public_key();
 
    boost::program_options::variables_map options;
@@ -121,6 +124,35 @@ database_fixture::database_fixture()
       track_account.push_back(track);
       options.insert(std::make_pair("track-account", boost::program_options::variable_value(track_account, false)));
    }
+   // keep only the 3 most recent operations of each account for the pruning tests
+   if( !options.count("max-ops-per-account") && ( boost::unit_test::framework::current_test_case().p_name.value == "max_ops_per_account"
+                                                 || boost::unit_test::framework::current_test_case().p_name.value == "history_prune_fork" ) )
+      options.insert(std::make_pair("max-ops-per-account", boost::program_options::variable_value(uint32_t(3), false)));
+   // history written while blocks are applied, for the test of pruning it across a fork
+   if( !options.count("history-write-behind") && boost::unit_test::framework::current_test_case().p_name.value == "history_prune_fork" )
+      options.insert(std::make_pair("history-write-behind", boost::program_options::variable_value(false, false)));
+   // test blocks are old, so history is written in replay batches, small ones for the write-behind test
+   if( !options.count("history-write-batch-replay") && boost::unit_test::framework::current_test_case().p_name.value == "history_write_behind" )
+      options.insert(std::make_pair("history-write-batch-replay", boost::program_options::variable_value(uint32_t(3), false)));
+   // account history indexed by operation type
+   if( !options.count("history-index-op-types") && boost::unit_test::framework::current_test_case().p_name.value == "history_index_op_types" )
+      options.insert(std::make_pair("history-index-op-types", boost::program_options::variable_value(true, false)));
+   // market history buckets of one minute and one day for the candle tests
+   if( !options.count("bucket-size") && ( boost::unit_test::framework::current_test_case().p_name.value == "get_market_candles"
+                                          || boost::unit_test::framework::current_test_case().p_name.value == "market_history_open_candles" ) )
+      options.insert(std::make_pair("bucket-size", boost::program_options::variable_value(string("[60,86400]"), false)));
+   // order history trimmed to two records per market, one record per block, for the market history fork test
+   if( boost::unit_test::framework::current_test_case().p_name.value == "market_history_fork" ) {
+      options.insert(std::make_pair("bucket-size", boost::program_options::variable_value(string("[60,86400]"), false)));
+      options.insert(std::make_pair("max-order-his-records-per-market", boost::program_options::variable_value(uint32_t(2), false)));
+      options.insert(std::make_pair("max-order-his-seconds-per-market", boost::program_options::variable_value(uint32_t(0), false)));
+      options.insert(std::make_pair("max-order-his-removals-per-block", boost::program_options::variable_value(uint32_t(1), false)));
+   }
+   // order history kept for two records or a minute per market, for the order history trim test
+   if( boost::unit_test::framework::current_test_case().p_name.value == "market_order_history_trim" ) {
+      options.insert(std::make_pair("max-order-his-records-per-market", boost::program_options::variable_value(uint32_t(2), false)));
+      options.insert(std::make_pair("max-order-his-seconds-per-market", boost::program_options::variable_value(uint32_t(60), false)));
+   }
    // standby votes tracking
    if( boost::unit_test::framework::current_test_case().p_name.value == "track_votes_witnesses_disabled" ||
        boost::unit_test::framework::current_test_case().p_name.value == "track_votes_committee_disabled") {
@@ -173,8 +205,12 @@ database_fixture::database_fixture()
    goplugin->plugin_set_app(&app);
    goplugin->plugin_initialize(options);
 
+   chplugin->plugin_set_app(&app);
+   chplugin->plugin_initialize(options);
+
    mhplugin->plugin_startup();
    goplugin->plugin_startup();
+   chplugin->plugin_startup();
 
    generate_block();
 
@@ -773,6 +809,24 @@ const worker_object& database_fixture::create_worker( const account_id_type owne
    return db.get<worker_object>(ptx.operation_results[0].get<object_id_type>());
 } FC_CAPTURE_AND_RETHROW() }
 
+contract_addr_type database_fixture::deploy_contract( account_id_type owner, const string& bytecode,
+                                                      const string& abi_json, const string& construct_data )
+{ try {
+   smart_contract_deploy_operation op;
+   op.owner = owner;
+   op.contract_addr = fc::sha256::hash( bytecode + abi_json + construct_data );
+   op.bytecode = bytecode;
+   op.abi_json = abi_json;
+   op.construct_data = construct_data;
+   op.contract_name = "contract";
+   set_expiration( db, trx );
+   trx.operations.push_back(op);
+   trx.validate();
+   db.push_transaction(trx, ~0);
+   trx.clear();
+   return op.contract_addr;
+} FC_CAPTURE_AND_RETHROW( (owner)(abi_json)(construct_data) ) }
+
 uint64_t database_fixture::fund(
    const account_object& account,
    const asset& amount /* = asset(500000) */
@@ -1206,24 +1260,14 @@ int64_t database_fixture::get_balance( const account_object& account, const asse
 
 vector< operation_history_object > database_fixture::get_operation_history( account_id_type account_id )const
 {
-   vector< operation_history_object > result;
+   // history of reversible blocks is still queued for writing, the plugin serves it from memory
    const auto& stats = account_id(db).statistics(db);
-   if(stats.most_recent_op == account_transaction_history_id_type())
-      return result;
-
-   const account_transaction_history_object* node = &stats.most_recent_op(db);
-   std::unique_ptr<account_transaction_history_object> atho_ptr;
-   while( true )
-   {
-      auto op = db.find_db(node->operation_id);
-      result.push_back( *op );
-      if(node->next == account_transaction_history_id_type())
-         break;
-
-      atho_ptr = db.find_db(node->next);
-      node = atho_ptr.get();
-   }
-   return result;
+   auto ahplugin = app.get_plugin<graphene::account_history::account_history_plugin>( "account_history" );
+   return ahplugin->scan_history( account_id, flat_set<int32_t>(), stats.total_ops, stats.removed_ops + 1,
+                                  std::numeric_limits<unsigned>::max(),
+                                  []( const graphene::account_history::account_history_head& ) {
+                                     return graphene::account_history::history_scan_action::take;
+                                  } );
 }
 
 vector< graphene::market_history::order_history_object > database_fixture::get_market_order_history( asset_id_type a, asset_id_type b )const
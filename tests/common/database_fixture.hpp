@@ -316,6 +316,9 @@ struct database_fixture {
    const witness_object& create_witness(const account_object& owner,
                                         const fc::ecc::private_key& signing_private_key = generate_private_key("null_key"));
    const worker_object& create_worker(account_id_type owner, const share_type daily_pay = 1000, const fc::microseconds& duration = fc::days(2));
+   /// deploys through smart_contract_deploy_operation, @return the address of the contract
+   contract_addr_type deploy_contract( account_id_type owner, const string& bytecode, const string& abi_json,
+                                       const string& construct_data = string() );
    uint64_t fund( const account_object& account, const asset& amount = asset(500000) );
    digest_type digest( const transaction& tx );
    void sign( signed_transaction& trx, const fc::ecc::private_key& key );
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/app/api_worker_pool.hpp>
+
+#include <fc/thread/thread.hpp>
+
+using namespace graphene::app;
+
+BOOST_AUTO_TEST_SUITE(api_worker_pool_tests)
+
+BOOST_AUTO_TEST_CASE( parse_request_test )
+{
+   bool database_call = false;
+   fc::variant id;
+
+   BOOST_CHECK_EQUAL( api_worker_pool::parse_request( R"({"id":1,"method":"get_objects","params":[[]]})",
+                                                      database_call, id ), "get_objects" );
+   BOOST_CHECK( database_call );
+   BOOST_CHECK_EQUAL( id.as_uint64(), 1u );
+
+   BOOST_CHECK_EQUAL( api_worker_pool::parse_request( R"({"id":2,"method":"call","params":["database","get_assets",[[]]]})",
+                                                      database_call, id ), "get_assets" );
+   BOOST_CHECK( database_call );
+
+   BOOST_CHECK_EQUAL( api_worker_pool::parse_request( R"({"id":3,"method":"call","params":[2,"get_account_history",[]]})",
+                                                      database_call, id ), "get_account_history" );
+   BOOST_CHECK( !database_call );
+
+   BOOST_CHECK_EQUAL( api_worker_pool::parse_request( R"([{"id":4,"method":"get_objects","params":[[]]}])",
+                                                      database_call, id ), "batch" );
+
+   BOOST_CHECK_EQUAL( api_worker_pool::parse_request( "not json", database_call, id ), "" );
+}
+
+BOOST_AUTO_TEST_CASE( admission_control_test )
+{ try {
+   api_worker_pool_options opts;
+   opts.worker_threads = 1;
+   opts.chain_thread_slots = 1;
+   opts.max_pending_per_method = 2;
+   opts.concurrent_methods.insert( "get_chain_id" );
+   api_worker_pool pool( opts );
+
+   const std::string request = R"({"id":7,"method":"call","params":["database","get_accounts",[["init0"]]]})";
+   uint32_t executed = 0;
+   std::vector<std::string> rejections;
+   auto run = [&executed]() { ++executed; };
+   auto reject = [&rejections]( const std::string& reply ) { rejections.push_back( reply ); };
+
+   // chain thread calls are only run once this thread yields, so all three are pending at once
+   pool.submit( pool.open_queue(), request, run, reject );
+   pool.submit( pool.open_queue(), request, run, reject );
+   pool.submit( pool.open_queue(), request, run, reject );
+   BOOST_CHECK_EQUAL( executed, 0u );
+   BOOST_REQUIRE_EQUAL( rejections.size(), 1u );
+   BOOST_CHECK( rejections[0].find( "server busy" ) != std::string::npos );
+   BOOST_CHECK( rejections[0].find( "\"id\":7" ) != std::string::npos );
+
+   fc::usleep( fc::milliseconds( 100 ) );
+   BOOST_CHECK_EQUAL( executed, 2u );
+
+   // methods which only read snapshots run on a worker thread
+   fc::promise<std::string>::ptr thread_name( new fc::promise<std::string>( "worker thread name" ) );
+   pool.submit( pool.open_queue(), R"({"id":8,"method":"get_chain_id","params":[]})",
+                [thread_name]() { thread_name->set_value( fc::thread::current().name() ); }, reject );
+   BOOST_CHECK_EQUAL( fc::future<std::string>( thread_name ).wait( fc::seconds( 5 ) ), "api-worker-0" );
+
+   fc::variant_object stats = pool.get_statistics();
+   BOOST_CHECK_EQUAL( stats["methods"]["get_accounts"]["rejected"].as_uint64(), 1u );
+   BOOST_CHECK_EQUAL( stats["methods"]["get_accounts"]["execution"]["count"].as_uint64(), 2u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( destroy_with_posted_requests_test )
+{ try {
+   api_worker_pool_options opts;
+   opts.worker_threads = 1;
+   opts.chain_thread_slots = 2;
+   opts.concurrent_methods.insert( "get_chain_id" );
+
+   uint32_t executed = 0;
+   auto run = [&executed]() { ++executed; };
+   auto reject = []( const std::string& ) {};
+   {
+      api_worker_pool pool( opts );
+      // posted to the chain thread, which has not run them when the pool goes away
+      pool.submit( pool.open_queue(), R"({"id":1,"method":"get_accounts","params":[[]]})", run, reject );
+      pool.submit( pool.open_queue(), R"({"id":2,"method":"get_accounts","params":[[]]})", run, reject );
+      pool.submit( pool.open_queue(), R"({"id":3,"method":"get_accounts","params":[[]]})", run, reject );
+   }
+   // the destructor waited for the posted tasks, none of them is left to touch the freed pool
+   fc::usleep( fc::milliseconds( 50 ) );
+   BOOST_CHECK_EQUAL( executed, 0u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()
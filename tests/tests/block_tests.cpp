@@ -324,6 +324,14 @@ BOOST_AUTO_TEST_CASE( fork_blocks )
             BOOST_CHECK_EQUAL(db2.head_block_num(), 14u + j);
             PUSH_BLOCK( db1, good_block );
             BOOST_CHECK_EQUAL(db1.head_block_id().str(), db2.head_block_id().str());
+
+            // the invalid block was rejected before popping anything, the good one popped 11 through 13
+            const auto& forks = db1.get_apply_statistics().fork_switches();
+            BOOST_CHECK_EQUAL( forks.count, 2u );
+            BOOST_CHECK_EQUAL( forks.failed, 1u );
+            BOOST_CHECK_EQUAL( forks.blocks_popped, 3u );
+            BOOST_CHECK_EQUAL( forks.blocks_pushed, 4u );
+            BOOST_CHECK_EQUAL( forks.max_depth, 3u );
          }
       }
 
@@ -559,6 +567,66 @@ BOOST_AUTO_TEST_CASE( switch_forks_undo_create )
    }
 }
 
+BOOST_AUTO_TEST_CASE( switch_forks_failed_branch_keeps_transactions )
+{
+   try {
+      fc::temp_directory dir1( graphene::utilities::temp_directory_path() ),
+                         dir2( graphene::utilities::temp_directory_path() );
+      database db1,
+               db2;
+      db1.open(dir1.path(), make_genesis, "TEST");
+      db2.open(dir2.path(), make_genesis, "TEST");
+
+      auto init_account_priv_key  = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")) );
+      public_key_type init_account_pub_key  = init_account_priv_key.get_public_key();
+      account_id_type nathan_id = db1.get_index(protocol_ids, account_object_type).get_next_id();
+
+      // db1 : A1 A2
+      // db2 : B1 B2 B3, B1 creates nathan and B3 fails to apply
+      db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+      db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+      const block_id_type db1_tip = db1.head_block_id();
+
+      signed_transaction trx;
+      set_expiration( db2, trx );
+      account_create_operation cop;
+      cop.registrar = GRAPHENE_TEMP_ACCOUNT;
+      cop.name = "nathan";
+      cop.owner = authority(1, init_account_pub_key, 1);
+      cop.active = cop.owner;
+      trx.operations.push_back(cop);
+      PUSH_TX( db2, trx );
+      vector<signed_block> branch;
+      for( int i = 0; i < 3; ++i )
+         branch.push_back( db2.generate_block(db2.get_slot_time(1), db2.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing) );
+
+      // an unsigned transfer passes the checks made before switching, it fails once applied
+      signed_transaction bad_trx;
+      set_expiration( db2, bad_trx );
+      transfer_operation top;
+      top.from = GRAPHENE_COMMITTEE_ACCOUNT;
+      top.to = nathan_id;
+      top.amount = asset(1);
+      bad_trx.operations.push_back(top);
+      branch.back().transactions.push_back(bad_trx);
+      branch.back().transaction_merkle_root = branch.back().calculate_merkle_root();
+      branch.back().sign( init_account_priv_key );
+
+      PUSH_BLOCK( db1, branch[0] );
+      PUSH_BLOCK( db1, branch[1] );
+      GRAPHENE_REQUIRE_THROW( PUSH_BLOCK( db1, branch[2] ), fc::exception );
+      BOOST_CHECK( db1.head_block_id() == db1_tip );
+
+      // the account creation of the rejected branch is pending again
+      BOOST_CHECK_EQUAL( nathan_id(db1).name, "nathan" );
+      db1.clear_pending();
+      GRAPHENE_REQUIRE_THROW( nathan_id(db1), fc::exception );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( duplicate_transactions )
 {
    try {
@@ -833,4 +833,116 @@ BOOST_AUTO_TEST_CASE( get_transaction_hex )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( multi_call )
+{ try {
+   ACTORS( (alice) );
+   graphene::app::database_api db_api(db);
+
+   vector<graphene::app::api_call> calls(4);
+   calls[0].method = "get_accounts";
+   calls[0].params.emplace_back( fc::variant( vector<string>{ "alice" }, 2 ) );
+   calls[1].method = "lookup_asset_symbols";
+   calls[1].params.emplace_back( fc::variant( vector<string>{ GRAPHENE_SYMBOL }, 2 ) );
+   calls[2].method = "get_dynamic_global_properties";
+   calls[3].method = "set_subscribe_callback";
+
+   auto results = db_api.multi_call( calls );
+   BOOST_REQUIRE_EQUAL( results.size(), 4u );
+
+   BOOST_CHECK( !results[0].error );
+   auto accounts = results[0].result.as<vector<optional<account_object>>>( GRAPHENE_MAX_NESTED_OBJECTS );
+   BOOST_REQUIRE_EQUAL( accounts.size(), 1u );
+   BOOST_REQUIRE( accounts[0] );
+   BOOST_CHECK( accounts[0]->id == alice_id );
+
+   BOOST_CHECK( !results[1].error );
+   auto assets = results[1].result.as<vector<optional<asset_object>>>( GRAPHENE_MAX_NESTED_OBJECTS );
+   BOOST_REQUIRE_EQUAL( assets.size(), 1u );
+   BOOST_REQUIRE( assets[0] );
+   BOOST_CHECK( assets[0]->id == asset_id_type() );
+
+   BOOST_CHECK( !results[2].error );
+   BOOST_CHECK_EQUAL( results[2].result.as<dynamic_global_property_object>( GRAPHENE_MAX_NESTED_OBJECTS ).head_block_number,
+                      db.head_block_num() );
+
+   // unavailable methods fail alone
+   BOOST_CHECK( results[3].error );
+   BOOST_CHECK( results[3].result.is_null() );
+
+   BOOST_CHECK_THROW( db_api.multi_call( vector<graphene::app::api_call>( 101 ) ), fc::exception );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( multi_call_does_not_subscribe )
+{ try {
+   ACTORS( (alice) );
+   graphene::app::database_api db_api(db);
+
+   uint32_t objects_changed = 0;
+   db_api.set_subscribe_callback( [&objects_changed]( const variant& ) { ++objects_changed; }, false );
+
+   vector<graphene::app::api_call> calls(1);
+   calls[0].method = "get_full_accounts";
+   calls[0].params.emplace_back( fc::variant( vector<string>{ "alice" }, 2 ) );
+   calls[0].params.emplace_back( fc::variant( true ) );
+   auto results = db_api.multi_call( calls );
+   BOOST_REQUIRE_EQUAL( results.size(), 1u );
+   BOOST_CHECK( !results[0].error );
+   BOOST_CHECK_EQUAL( results[0].result.get_object().size(), 1u );
+
+   // the subscribe flag was ignored, changes to alice are not notified
+   transfer( account_id_type(), alice_id, asset(1) );
+   generate_block();
+   fc::usleep(fc::milliseconds(200));
+   BOOST_CHECK_EQUAL( objects_changed, 0u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( pio_contribution_ranking )
+{ try {
+   ACTORS( (alice)(bob) );
+   graphene::app::database_api db_api(db);
+
+   auto report = [&]( account_id_type from, uint32_t contribution, const fc::ecc::private_key& key ) {
+      pio_operation op;
+      op.from = from;
+      op.rpc_addr = "none";
+      op.contribution = contribution;
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      sign( trx, key );
+      PUSH_TX( db, trx );
+      trx.clear();
+   };
+
+   const uint32_t epoch = db.get_dynamic_global_properties().current_pio_epoch;
+   report( alice_id, 10, alice_private_key );
+   report( bob_id, 25, bob_private_key );
+   report( alice_id, 30, alice_private_key );
+
+   auto ranking = db_api.get_pio_contribution_ranking( epoch, 10 );
+   BOOST_REQUIRE_EQUAL( ranking.size(), 2u );
+   BOOST_CHECK( ranking[0].account == alice_id );
+   BOOST_CHECK_EQUAL( ranking[0].contribution, 40u );
+   BOOST_CHECK_EQUAL( ranking[0].reports, 2u );
+   BOOST_CHECK( ranking[1].account == bob_id );
+   BOOST_CHECK_EQUAL( ranking[1].contribution, 25u );
+   BOOST_CHECK_EQUAL( db_api.get_pio_contribution_ranking( epoch, 1 ).size(), 1u );
+   BOOST_CHECK( !db_api.get_pio_epoch( epoch ) );
+   BOOST_CHECK_THROW( db_api.get_pio_contribution_ranking( epoch, 101 ), fc::exception );
+
+   // maintenance closes the epoch and later reports go to the next one
+   generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+   BOOST_CHECK_EQUAL( db.get_dynamic_global_properties().current_pio_epoch, epoch + 1 );
+   auto totals = db_api.get_pio_epoch( epoch );
+   BOOST_REQUIRE( totals );
+   BOOST_CHECK_EQUAL( totals->total_contribution, 65u );
+   BOOST_CHECK_EQUAL( totals->contributors, 2u );
+   BOOST_CHECK_EQUAL( totals->reports, 3u );
+
+   report( bob_id, 5, bob_private_key );
+   ranking = db_api.get_pio_contribution_ranking( epoch + 1, 10 );
+   BOOST_REQUIRE_EQUAL( ranking.size(), 1u );
+   BOOST_CHECK( ranking[0].account == bob_id );
+   BOOST_CHECK_EQUAL( db_api.get_pio_contribution_ranking( epoch, 10 ).size(), 2u );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -137,4 +137,87 @@ BOOST_AUTO_TEST_CASE( merge_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( apply_statistics_test )
+{ try {
+   ACTORS( (alice)(bob) );
+   fund( alice );
+   generate_block();
+   db.reset_apply_statistics();
+
+   transfer( alice, bob, asset(100) );
+   generate_block();
+
+   fc::variant_object stats = db.get_apply_statistics().to_variant();
+   BOOST_CHECK_EQUAL( stats["blocks"]["count"].as_uint64(), 1u );
+   BOOST_CHECK( stats["transactions"]["count"].as_uint64() >= 1u );
+   BOOST_CHECK( stats["operations"].get_object().contains( "transfer_operation" ) );
+   BOOST_CHECK( stats["signal_handlers"].get_object().contains( "applied_block" ) );
+
+   latency_histogram h;
+   h.record( 0 );
+   h.record( 3 );
+   h.record( 1000000 );
+   BOOST_CHECK_EQUAL( h.count, 3u );
+   BOOST_CHECK_EQUAL( h.max_us, 1000000u );
+   BOOST_CHECK_EQUAL( h.percentile( 100 ), 1000000u );
+   BOOST_CHECK( h.percentile( 50 ) <= 4u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( read_snapshot_test )
+{ try {
+   BOOST_CHECK( !db.get_snapshot() );
+   db.enable_snapshots();
+   generate_block();
+
+   auto first = db.get_snapshot();
+   BOOST_REQUIRE( first );
+   BOOST_CHECK_EQUAL( first->revision(), db.head_block_num() );
+   const auto* first_dgp = first->find( dynamic_global_property_id_type() );
+   BOOST_REQUIRE( first_dgp );
+   BOOST_CHECK_EQUAL( first_dgp->head_block_number, db.head_block_num() );
+
+   ACTORS( (alice) );
+   generate_block();
+
+   auto second = db.get_snapshot();
+   BOOST_REQUIRE( second );
+   BOOST_CHECK_EQUAL( second->revision(), db.head_block_num() );
+   BOOST_REQUIRE( second->find( alice_id ) );
+   BOOST_CHECK_EQUAL( second->find( alice_id )->name, "alice" );
+   BOOST_CHECK_EQUAL( second->find( dynamic_global_property_id_type() )->head_block_number, db.head_block_num() );
+
+   // the earlier revision is unaffected by later blocks
+   BOOST_CHECK( !first->find( alice_id ) );
+   BOOST_CHECK_EQUAL( first->find( dynamic_global_property_id_type() ), first_dgp );
+   BOOST_CHECK_EQUAL( first_dgp->head_block_number, first->revision() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( read_snapshot_pop_block_test )
+{ try {
+   db.enable_snapshots();
+   generate_block();
+   ACTORS( (alice) );
+   generate_block();
+
+   auto with_alice = db.get_snapshot();
+   BOOST_REQUIRE( with_alice->find_by_key<account_object>( "alice" ) );
+   BOOST_CHECK( with_alice->find_by_key<account_object>( "alice" )->id == alice_id );
+   BOOST_CHECK( !with_alice->find_by_key<account_object>( "bob" ) );
+
+   // popping the block republishes the snapshot without waiting for the next block
+   db.pop_block();
+   auto popped = db.get_snapshot();
+   BOOST_CHECK_EQUAL( popped->revision(), db.head_block_num() );
+   BOOST_CHECK( !popped->find( alice_id ) );
+   BOOST_CHECK( !popped->find_by_key<account_object>( "alice" ) );
+   BOOST_CHECK_EQUAL( popped->find( dynamic_global_property_id_type() )->head_block_number, db.head_block_num() );
+   BOOST_CHECK( with_alice->find_by_key<account_object>( "alice" ) );
+
+   // the popped transaction is pending again after the next block, it is in the snapshot once it is in a block
+   generate_block();
+   generate_block();
+   BOOST_REQUIRE( db.get_snapshot()->find_by_key<account_object>( "alice" ) );
+   BOOST_CHECK_EQUAL( db.get_snapshot()->find_by_key<account_object>( "alice" )->name, "alice" );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -26,15 +26,36 @@
 
 #include <graphene/app/api.hpp>
 
+#include <graphene/account_history/account_history_plugin.hpp>
+#include <graphene/market_history/market_history_plugin.hpp>
+
 #include <graphene/utilities/tempdir.hpp>
 
 #include <fc/crypto/digest.hpp>
+#include <fc/io/raw.hpp>
 
 #include "../common/database_fixture.hpp"
 
 using namespace graphene::chain;
 using namespace graphene::chain::test;
 using namespace graphene::app;
+
+/// the tickers, the candles of every tracked bucket size and the order history of a market, packed to compare two chain states
+static vector<char> market_state( database_fixture& f, history_api& hist_api, asset_id_type a, asset_id_type b )
+{
+   const auto& ticker_idx = f.db.get_index_type<graphene::market_history::market_ticker_index>().indices();
+   vector<char> state = fc::raw::pack( vector<graphene::market_history::market_ticker_object>( ticker_idx.begin(), ticker_idx.end() ) );
+   auto mhplugin = f.app.get_plugin<graphene::market_history::market_history_plugin>( "market_history" );
+   for( uint32_t seconds : mhplugin->tracked_buckets() )
+   {
+      vector<char> candles = fc::raw::pack( hist_api.get_market_candles( a, b, seconds, fc::time_point_sec(), f.db.head_block_time() ) );
+      state.insert( state.end(), candles.begin(), candles.end() );
+   }
+   vector<char> history = fc::raw::pack( f.get_market_order_history( a, b ) );
+   state.insert( state.end(), history.begin(), history.end() );
+   return state;
+}
+
 BOOST_FIXTURE_TEST_SUITE( history_api_tests, database_fixture )
 
 BOOST_AUTO_TEST_CASE(get_account_history) {
@@ -581,4 +602,528 @@ BOOST_AUTO_TEST_CASE(get_account_history_operations) {
    }
 }
 
+BOOST_AUTO_TEST_CASE(get_account_history_by_operations) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      ACTOR(dan);
+      transfer( account_id_type(), dan_id, asset(1000) );
+      transfer( account_id_type(), dan_id, asset(2000) );
+      generate_block();
+
+      // dan: account_create, then 2 transfers, newest first
+      vector<uint16_t> transfers{ uint16_t( operation::tag<transfer_operation>::value ) };
+      history_operation_detail histories = hist_api.get_account_history_by_operations("dan", transfers, 0, 100);
+      BOOST_CHECK_EQUAL(histories.total_count, 3u);
+      BOOST_REQUIRE_EQUAL(histories.operation_history_objs.size(), 2u);
+      BOOST_CHECK_EQUAL(histories.operation_history_objs[0].op.get<transfer_operation>().amount.amount.value, 2000);
+      BOOST_CHECK_EQUAL(histories.operation_history_objs[1].op.get<transfer_operation>().amount.amount.value, 1000);
+
+      histories = hist_api.get_account_history_by_operations("dan", vector<uint16_t>(), 0, 100);
+      BOOST_REQUIRE_EQUAL(histories.operation_history_objs.size(), 3u);
+      BOOST_CHECK_EQUAL(histories.operation_history_objs[2].op.which(), operation::tag<account_create_operation>::value);
+
+      // a page of one skips the newest entry
+      vector<operation_history_object> page = hist_api.get_relative_account_history("dan", 0, 1, 2);
+      BOOST_REQUIRE_EQUAL(page.size(), 1u);
+      BOOST_CHECK_EQUAL(page[0].op.get<transfer_operation>().amount.amount.value, 1000);
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(history_index_op_types) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      ACTOR(dan);
+      ACTOR(eve);
+      transfer( account_id_type(), dan_id, asset(1000) );
+      transfer( dan_id, eve_id, asset(100) );
+      transfer( account_id_type(), dan_id, asset(2000) );
+      generate_block();
+
+      int transfer_op_id = operation::tag<transfer_operation>::value;
+      int account_create_op_id = operation::tag<account_create_operation>::value;
+
+      vector<operation_history_object> histories = hist_api.get_account_history_operations("dan", transfer_op_id, operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_REQUIRE_EQUAL(histories.size(), 3u);
+      BOOST_CHECK_EQUAL(histories[0].op.get<transfer_operation>().amount.amount.value, 2000);
+      BOOST_CHECK_EQUAL(histories[1].op.get<transfer_operation>().amount.amount.value, 100);
+      BOOST_CHECK_EQUAL(histories[2].op.get<transfer_operation>().amount.amount.value, 1000);
+
+      // the range between start and stop
+      histories = hist_api.get_account_history_operations("dan", transfer_op_id, histories[1].id, histories[2].id, 100);
+      BOOST_REQUIRE_EQUAL(histories.size(), 1u);
+      BOOST_CHECK_EQUAL(histories[0].op.get<transfer_operation>().amount.amount.value, 100);
+
+      // several types are merged, newest first
+      vector<uint16_t> types{ uint16_t( transfer_op_id ), uint16_t( account_create_op_id ) };
+      history_operation_detail detail = hist_api.get_account_history_by_operations("dan", types, 0, 100);
+      BOOST_REQUIRE_EQUAL(detail.operation_history_objs.size(), 4u);
+      BOOST_CHECK_EQUAL(detail.operation_history_objs[3].op.which(), account_create_op_id);
+      for( size_t i = 1; i < detail.operation_history_objs.size(); ++i )
+         BOOST_CHECK(detail.operation_history_objs[i].id < detail.operation_history_objs[i - 1].id);
+
+      histories = hist_api.get_account_history_operations("eve", transfer_op_id, operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_REQUIRE_EQUAL(histories.size(), 1u);
+      BOOST_CHECK_EQUAL(histories[0].op.get<transfer_operation>().amount.amount.value, 100);
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(operation_history_block_store) {
+   try {
+      graphene::app::history_api hist_api(app);
+      auto ahplugin = app.get_plugin<graphene::account_history::account_history_plugin>("account_history");
+
+      ACTOR(dan);
+      transfer( account_id_type(), dan_id, asset(1000) );
+      transfer( account_id_type(), dan_id, asset(2000) );
+      generate_block();
+      const uint32_t block_num = db.head_block_num();
+
+      vector<operation_history_object> histories = hist_api.get_account_history("dan", operation_history_id_type(), 100, operation_history_id_type());
+      BOOST_REQUIRE_EQUAL(histories.size(), 3u);
+      for( const auto& h : histories )
+      {
+         // every field but the id and block number is stored in the block record
+         auto op = ahplugin->find_operation( h.id );
+         BOOST_REQUIRE(op.valid());
+         BOOST_CHECK(op->id == h.id);
+         BOOST_CHECK_EQUAL(op->block_num, block_num);
+         BOOST_CHECK_EQUAL(op->trx_in_block, h.trx_in_block);
+         BOOST_CHECK_EQUAL(op->op.which(), h.op.which());
+      }
+      BOOST_CHECK_EQUAL(histories[0].op.get<transfer_operation>().amount.amount.value, 2000);
+      BOOST_CHECK(!ahplugin->find_operation( operation_history_id_type( histories[0].id.instance() + 1000 ) ).valid());
+
+      // operations kept in the block store have no 1.11 row, get_objects finds them all the same
+      graphene::app::database_api db_api(db);
+      fc::variants objs = db_api.get_objects( { histories[0].id, operation_history_id_type( histories[0].id.instance() + 1000 ) } );
+      BOOST_REQUIRE_EQUAL(objs.size(), 2u);
+      BOOST_REQUIRE(!objs[0].is_null());
+      BOOST_CHECK(objs[0].as<operation_history_object>( GRAPHENE_MAX_NESTED_OBJECTS ).id == histories[0].id);
+      BOOST_CHECK(objs[1].is_null());
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(history_write_behind) {
+   try {
+      graphene::app::history_api hist_api(app);
+      auto ahplugin = app.get_plugin<graphene::account_history::account_history_plugin>("account_history");
+
+      create_account("dan");
+      generate_block();
+      const uint32_t block_num = db.head_block_num();
+
+      // nothing is written before the block is irreversible, the queued history is served meanwhile
+      BOOST_REQUIRE_LT(db.get_dynamic_global_properties().last_irreversible_block_num, block_num);
+      ahplugin->flush_irreversible_history();
+      BOOST_CHECK_LT(ahplugin->indexed_block_num(), block_num);
+      vector<operation_history_object> queued = hist_api.get_account_history("dan", operation_history_id_type(), 100, operation_history_id_type());
+      BOOST_REQUIRE_EQUAL(queued.size(), 1u);
+      BOOST_CHECK(ahplugin->find_operation(queued[0].id).valid());
+      BOOST_CHECK_EQUAL(hist_api.get_relative_account_history("dan", 0, 100, 0).size(), 1u);
+
+      // queued history of a popped block is dropped with it
+      create_account("eve");
+      generate_block();
+      BOOST_CHECK_EQUAL(hist_api.get_account_history("eve", operation_history_id_type(), 100, operation_history_id_type()).size(), 1u);
+      db.pop_block();
+      generate_block();
+      BOOST_CHECK_EQUAL(hist_api.get_relative_account_history("committee-account", 0, 100, 0).size(),
+                        db.get_account_stats_by_owner(account_id_type()).total_ops);
+
+      // written in line while blocks are applied, once a batch of history-write-batch-replay blocks is irreversible
+      while( db.get_dynamic_global_properties().last_irreversible_block_num < block_num + 3 )
+         generate_block();
+      BOOST_CHECK_GE(ahplugin->indexed_block_num(), block_num);
+
+      ahplugin->flush_irreversible_history();
+      BOOST_CHECK_EQUAL(ahplugin->indexed_block_num(), db.get_dynamic_global_properties().last_irreversible_block_num);
+      vector<operation_history_object> histories = hist_api.get_account_history("dan", operation_history_id_type(), 100, operation_history_id_type());
+      BOOST_REQUIRE_EQUAL(histories.size(), 1u);
+      BOOST_CHECK_EQUAL(histories[0].op.which(), operation::tag<account_create_operation>::value);
+      BOOST_CHECK_EQUAL(histories[0].block_num, block_num);
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(max_ops_per_account) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      ACTOR(dan);
+      for( int i = 0; i < 4; ++i )
+         transfer( account_id_type(), dan_id, asset(1000 + i) );
+      generate_block();
+
+      // account_create plus 4 transfers, only the 3 most recent are kept
+      const auto& stats = dan_id(db).statistics(db);
+      BOOST_CHECK_EQUAL(stats.total_ops, 5u);
+      BOOST_CHECK_EQUAL(stats.removed_ops, 2u);
+
+      vector<operation_history_object> histories = hist_api.get_account_history("dan", operation_history_id_type(), 100, operation_history_id_type());
+      BOOST_REQUIRE_EQUAL(histories.size(), 3u);
+      for( const auto& h : histories )
+         BOOST_CHECK_EQUAL(h.op.which(), operation::tag<transfer_operation>::value);
+      BOOST_CHECK_EQUAL(histories.back().op.get<transfer_operation>().amount.amount.value, 1001);
+
+      // the operations stay in the operation history, other accounts still refer to them
+      histories = hist_api.get_account_history("committee-account", operation_history_id_type(), 100, operation_history_id_type());
+      BOOST_CHECK_EQUAL(histories.size(), 3u);
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(history_prune_fork) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      ACTOR(dan);
+      transfer( account_id_type(), dan_id, asset(1000) );
+      transfer( account_id_type(), dan_id, asset(1001) );
+      generate_block();
+      BOOST_CHECK_EQUAL(hist_api.get_relative_account_history("dan", 0, 100, 0).size(), 3u);
+
+      // the block pruning the two earliest entries is popped, they are back in both indexes
+      transfer( account_id_type(), dan_id, asset(1002) );
+      transfer( account_id_type(), dan_id, asset(1003) );
+      generate_block();
+      BOOST_CHECK_EQUAL(dan_id(db).statistics(db).removed_ops, 2u);
+      BOOST_CHECK_EQUAL(hist_api.get_relative_account_history("dan", 0, 100, 0).size(), 3u);
+      db.pop_block();
+      db.clear_pending();
+
+      const auto& stats = dan_id(db).statistics(db);
+      BOOST_CHECK_EQUAL(stats.total_ops, 3u);
+      BOOST_CHECK_EQUAL(stats.removed_ops, 0u);
+      vector<operation_history_object> histories = hist_api.get_relative_account_history("dan", 0, 100, 0);
+      BOOST_REQUIRE_EQUAL(histories.size(), 3u);
+      BOOST_CHECK_EQUAL(histories[2].op.which(), operation::tag<account_create_operation>::value);
+      BOOST_CHECK_EQUAL(hist_api.get_account_history("dan", operation_history_id_type(), 100, operation_history_id_type()).size(), 3u);
+
+      // once the pruning block is irreversible the table is pruned as well
+      transfer( account_id_type(), dan_id, asset(1002) );
+      transfer( account_id_type(), dan_id, asset(1003) );
+      generate_block();
+      const uint32_t block_num = db.head_block_num();
+      while( db.get_dynamic_global_properties().last_irreversible_block_num < block_num )
+         generate_block();
+      histories = hist_api.get_relative_account_history("dan", 0, 100, 0);
+      BOOST_REQUIRE_EQUAL(histories.size(), 3u);
+      BOOST_CHECK_EQUAL(histories[2].op.get<transfer_operation>().amount.amount.value, 1001);
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(get_market_candles) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      ACTORS((buyer)(seller));
+      const asset_object& usd = create_user_issued_asset( "USDCANDLE" );
+      const asset_id_type usd_id = usd.id;
+      issue_uia( seller, usd.amount(1000) );
+      transfer( account_id_type(), buyer_id, asset(10000) );
+      generate_block();
+
+      // the seller's orders are the makers, 10 USDCANDLE at 10 CORE, then at 20 CORE one minute later
+      create_sell_order( seller_id, asset(10, usd_id), asset(100) );
+      create_sell_order( buyer_id, asset(100), asset(10, usd_id) );
+      generate_block();
+      generate_blocks( db.head_block_time() + 60 );
+      create_sell_order( seller_id, asset(10, usd_id), asset(200) );
+      create_sell_order( buyer_id, asset(200), asset(10, usd_id) );
+      generate_block();
+
+      market_candles minutes = hist_api.get_market_candles( usd_id, asset_id_type(), 60, fc::time_point_sec(), db.head_block_time() );
+      BOOST_CHECK_EQUAL( minutes.resolution, 60u );
+      BOOST_REQUIRE_EQUAL( minutes.open_time.size(), 2u );
+      BOOST_REQUIRE_EQUAL( minutes.base_volume.size(), 2u );
+      BOOST_CHECK_EQUAL( minutes.base_volume[0], 100 );
+      BOOST_CHECK_EQUAL( minutes.quote_volume[0], 10 );
+      BOOST_CHECK_EQUAL( minutes.close_base[1], 200 );
+      BOOST_CHECK_EQUAL( minutes.close_quote[1], 10 );
+
+      // a week is merged from the one day buckets, both fills normally fall into the same week
+      market_candles weeks = hist_api.get_market_candles( asset_id_type(), usd_id, 7 * 86400, fc::time_point_sec(), db.head_block_time() );
+      const size_t week_count = minutes.open_time[0] / ( 7 * 86400 ) == minutes.open_time[1] / ( 7 * 86400 ) ? 1 : 2;
+      BOOST_REQUIRE_EQUAL( weeks.open_time.size(), week_count );
+      BOOST_CHECK_EQUAL( weeks.open_time[0] % ( 7 * 86400 ), 0u );
+      if( week_count == 1 )
+      {
+         BOOST_CHECK_EQUAL( weeks.open_base[0], 100 );
+         BOOST_CHECK_EQUAL( weeks.close_base[0], 200 );
+         BOOST_CHECK_EQUAL( weeks.high_base[0], 200 );
+         BOOST_CHECK_EQUAL( weeks.low_base[0], 100 );
+         BOOST_CHECK_EQUAL( weeks.base_volume[0], 300 );
+         BOOST_CHECK_EQUAL( weeks.quote_volume[0], 20 );
+      }
+
+      // candles are only merged from tracked bucket sizes
+      GRAPHENE_REQUIRE_THROW( hist_api.get_market_candles( asset_id_type(), usd_id, 90, fc::time_point_sec(), db.head_block_time() ), fc::exception );
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(market_history_open_candles) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      ACTORS((buyer)(seller));
+      const asset_object& usd = create_user_issued_asset( "USDOPEN" );
+      const asset_id_type usd_id = usd.id;
+      issue_uia( seller, usd.amount(1000) );
+      transfer( account_id_type(), buyer_id, asset(10000) );
+      generate_block();
+
+      // the seller's orders are the makers
+      auto fill = [&]( int64_t core_amount ) {
+         create_sell_order( seller_id, asset(10, usd_id), asset(core_amount) );
+         create_sell_order( buyer_id, asset(core_amount), asset(10, usd_id) );
+      };
+
+      // fills of one block go into the open candle, which is stored with all of them
+      fill( 100 );
+      fill( 300 );
+      fill( 200 );
+      generate_block();
+      const fc::time_point_sec first_time = db.head_block_time();
+      market_candles minutes = hist_api.get_market_candles( usd_id, asset_id_type(), 60, fc::time_point_sec(), db.head_block_time() );
+      BOOST_REQUIRE_EQUAL( minutes.open_time.size(), 1u );
+      BOOST_CHECK_EQUAL( minutes.open_base[0], 100 );
+      BOOST_CHECK_EQUAL( minutes.high_base[0], 300 );
+      BOOST_CHECK_EQUAL( minutes.low_base[0], 100 );
+      BOOST_CHECK_EQUAL( minutes.close_base[0], 200 );
+      BOOST_CHECK_EQUAL( minutes.base_volume[0], 600 );
+      BOOST_CHECK_EQUAL( minutes.quote_volume[0], 30 );
+
+      // a later block adds to the candle still open, and opens a new one once its period ended
+      generate_blocks( db.head_block_time() + 60 );
+      fill( 400 );
+      generate_block();
+      minutes = hist_api.get_market_candles( usd_id, asset_id_type(), 60, fc::time_point_sec(), db.head_block_time() );
+      BOOST_REQUIRE_EQUAL( minutes.open_time.size(), 2u );
+      BOOST_CHECK_EQUAL( minutes.base_volume[0], 600 );
+      BOOST_CHECK_EQUAL( minutes.open_base[1], 400 );
+      BOOST_CHECK_EQUAL( minutes.close_base[1], 400 );
+      BOOST_CHECK_EQUAL( minutes.base_volume[1], 400 );
+
+      market_candles days = hist_api.get_market_candles( usd_id, asset_id_type(), 86400, fc::time_point_sec(), db.head_block_time() );
+      const bool same_day = first_time.sec_since_epoch() / 86400 == db.head_block_time().sec_since_epoch() / 86400;
+
+      // candles are forgotten once their period ended, the minute candle after the next minute, the day candle the next day
+      auto mhplugin = app.get_plugin<graphene::market_history::market_history_plugin>( "market_history" );
+      BOOST_CHECK_EQUAL( mhplugin->open_candles(), 2u );
+      const fc::time_point_sec last_fill_time = db.head_block_time();
+      generate_blocks( last_fill_time + 60 );
+      generate_block();
+      const bool day_open = last_fill_time.sec_since_epoch() / 86400 == db.head_block_time().sec_since_epoch() / 86400;
+      BOOST_CHECK_EQUAL( mhplugin->open_candles(), day_open ? 1u : 0u );
+      generate_blocks( last_fill_time + 86400 );
+      generate_block();
+      BOOST_CHECK_EQUAL( mhplugin->open_candles(), 0u );
+      BOOST_REQUIRE_EQUAL( days.open_time.size(), same_day ? 1u : 2u );
+      BOOST_CHECK_EQUAL( days.open_base[0], 100 );
+      BOOST_CHECK_EQUAL( days.close_base.back(), 400 );
+      if( same_day )
+      {
+         BOOST_CHECK_EQUAL( days.high_base[0], 400 );
+         BOOST_CHECK_EQUAL( days.base_volume[0], 1000 );
+         BOOST_CHECK_EQUAL( days.quote_volume[0], 40 );
+      }
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(market_history_fork) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      ACTORS((buyer)(seller));
+      const asset_object& usd = create_user_issued_asset( "USDFORK" );
+      const asset_id_type usd_id = usd.id;
+      issue_uia( seller, usd.amount(1000) );
+      transfer( account_id_type(), buyer_id, asset(10000) );
+      generate_block();
+
+      // the seller's orders are the makers, every fill adds two records to the order history
+      auto fill = [&]( int64_t core_amount ) {
+         create_sell_order( seller_id, asset(10, usd_id), asset(core_amount) );
+         create_sell_order( buyer_id, asset(core_amount), asset(10, usd_id) );
+      };
+
+      fill( 100 );
+      generate_block();
+      BOOST_CHECK_EQUAL( get_market_order_history( usd_id, asset_id_type() ).size(), 2u );
+      const vector<char> one_fill = market_state( *this, hist_api, usd_id, asset_id_type() );
+
+      // four records are beyond the limit of two, one of them is removed per block
+      fill( 200 );
+      fill( 300 );
+      generate_block();
+      BOOST_CHECK_EQUAL( get_market_order_history( usd_id, asset_id_type() ).size(), 5u );
+      market_candles days = hist_api.get_market_candles( usd_id, asset_id_type(), 86400, fc::time_point_sec(), db.head_block_time() );
+      int64_t day_volume = 0;
+      for( int64_t volume : days.base_volume )
+         day_volume += volume;
+      BOOST_CHECK_EQUAL( day_volume, 600 );
+      const vector<char> three_fills = market_state( *this, hist_api, usd_id, asset_id_type() );
+
+      // the candles, the ticker and the trimmed record of the popped block are gone until it is applied again
+      db.pop_block();
+      db.clear_pending();
+      BOOST_CHECK( market_state( *this, hist_api, usd_id, asset_id_type() ) == one_fill );
+      fill( 200 );
+      fill( 300 );
+      generate_block();
+      BOOST_CHECK( market_state( *this, hist_api, usd_id, asset_id_type() ) == three_fills );
+
+      // the trim goes on in the following blocks, a popped one puts its removal back
+      generate_block();
+      BOOST_CHECK_EQUAL( get_market_order_history( usd_id, asset_id_type() ).size(), 4u );
+      const vector<char> trimmed = market_state( *this, hist_api, usd_id, asset_id_type() );
+      db.pop_block();
+      db.clear_pending();
+      BOOST_CHECK( market_state( *this, hist_api, usd_id, asset_id_type() ) == three_fills );
+      generate_block();
+      BOOST_CHECK( market_state( *this, hist_api, usd_id, asset_id_type() ) == trimmed );
+      generate_blocks( 3 );
+      vector<graphene::market_history::order_history_object> history = get_market_order_history( usd_id, asset_id_type() );
+      BOOST_REQUIRE_EQUAL( history.size(), 2u );
+      BOOST_CHECK_EQUAL( history[0].op.fill_price.quote.amount.value + history[0].op.fill_price.base.amount.value, 310 );
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(market_order_history_trim) {
+   try {
+      ACTORS((buyer)(seller));
+      const asset_object& usd = create_user_issued_asset( "USDTRIM" );
+      const asset_id_type usd_id = usd.id;
+      issue_uia( seller, usd.amount(1000) );
+      transfer( account_id_type(), buyer_id, asset(10000) );
+      generate_block();
+
+      // every fill adds two records to the order history
+      auto fill = [&]( int64_t core_amount ) {
+         create_sell_order( seller_id, asset(10, usd_id), asset(core_amount) );
+         create_sell_order( buyer_id, asset(core_amount), asset(10, usd_id) );
+      };
+
+      // six records are beyond the limit of two, but all of them are younger than a minute
+      fill( 100 );
+      fill( 200 );
+      fill( 300 );
+      generate_block();
+      BOOST_CHECK_EQUAL( get_market_order_history( usd_id, asset_id_type() ).size(), 6u );
+
+      // a minute later the old records are beyond both limits, and all of them are removed at the end of the block
+      generate_blocks( db.head_block_time() + 61 );
+      fill( 400 );
+      generate_block();
+      vector<graphene::market_history::order_history_object> history = get_market_order_history( usd_id, asset_id_type() );
+      BOOST_REQUIRE_EQUAL( history.size(), 2u );
+      for( const auto& h : history )
+         BOOST_CHECK_EQUAL( h.op.fill_price.quote.amount.value + h.op.fill_price.base.amount.value, 410 );
+
+      // markets without fills are not trimmed again
+      generate_blocks( db.head_block_time() + 61 );
+      BOOST_CHECK_EQUAL( get_market_order_history( usd_id, asset_id_type() ).size(), 2u );
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(market_ticker_fork) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      ACTORS((buyer)(seller));
+      const asset_object& usd = create_user_issued_asset( "USDTICKER" );
+      const asset_id_type usd_id = usd.id;
+      issue_uia( seller, usd.amount(1000) );
+      transfer( account_id_type(), buyer_id, asset(10000) );
+      generate_block();
+
+      auto fill = [&]( int64_t core_amount ) {
+         create_sell_order( seller_id, asset(10, usd_id), asset(core_amount) );
+         create_sell_order( buyer_id, asset(core_amount), asset(10, usd_id) );
+      };
+      const auto& ticker_idx = db.get_index_type<graphene::market_history::market_ticker_index>().indices().get<graphene::market_history::by_market>();
+      auto ticker = [&]() -> const graphene::market_history::market_ticker_object& {
+         auto itr = ticker_idx.find( std::make_tuple( asset_id_type(), usd_id ) );
+         BOOST_REQUIRE( itr != ticker_idx.end() );
+         return *itr;
+      };
+      // a block at the given time, the slots before it are missed
+      auto generate_block_at = [&]( fc::time_point_sec when ) {
+         generate_block( ~0, init_account_priv_key, db.get_slot_at_time( when ) - 1 );
+      };
+
+      fill( 100 );
+      generate_block();
+      const fc::time_point_sec first_fill_time = db.head_block_time();
+      fill( 200 );
+      generate_block();
+      BOOST_CHECK( ticker().base_volume == fc::uint128( 300u ) );
+      const vector<char> both_fills = market_state( *this, hist_api, usd_id, asset_id_type() );
+
+      // the first fill is older than a day in this block
+      const fc::time_point_sec roll_out_time = first_fill_time + 86400 + db.get_global_properties().parameters.block_interval;
+      generate_block_at( roll_out_time );
+      BOOST_CHECK( ticker().base_volume == fc::uint128( 200u ) );
+      BOOST_CHECK( ticker().quote_volume == fc::uint128( 10u ) );
+      const vector<char> rolled_out = market_state( *this, hist_api, usd_id, asset_id_type() );
+
+      // popping the block puts the first fill back into the window, it is rolled out again with the block
+      db.pop_block();
+      db.clear_pending();
+      BOOST_CHECK( market_state( *this, hist_api, usd_id, asset_id_type() ) == both_fills );
+      generate_block_at( roll_out_time );
+      BOOST_CHECK( market_state( *this, hist_api, usd_id, asset_id_type() ) == rolled_out );
+
+      // after a restart the window is loaded from the order history, a fork at or below that block loads it again
+      app.get_plugin<graphene::market_history::market_history_plugin>( "market_history" )->plugin_startup();
+      db.pop_block();
+      db.clear_pending();
+      BOOST_CHECK( market_state( *this, hist_api, usd_id, asset_id_type() ) == both_fills );
+      generate_block_at( roll_out_time );
+      BOOST_CHECK( market_state( *this, hist_api, usd_id, asset_id_type() ) == rolled_out );
+
+      // a different block at the same height rolls the first fill out as well
+      db.pop_block();
+      db.clear_pending();
+      fill( 300 );
+      generate_block_at( roll_out_time );
+      BOOST_CHECK( ticker().base_volume == fc::uint128( 500u ) );
+      BOOST_CHECK( ticker().quote_volume == fc::uint128( 20u ) );
+      BOOST_CHECK_EQUAL( ticker().latest_base.value, 300 );
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
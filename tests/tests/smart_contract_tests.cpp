@@ -0,0 +1,983 @@
+/*
+ * Copyright (c) 2018- μNEST Foundation, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/contract_cache.hpp>
+#include <graphene/chain/contract_engine.hpp>
+#include <graphene/chain/global_property_object.hpp>
+#include <graphene/chain/hardfork.hpp>
+#include <graphene/chain/contract_code_object.hpp>
+#include <graphene/chain/contract_storage.hpp>
+#include <graphene/chain/contract_storage_object.hpp>
+#include <graphene/chain/wren_contract_engine.hpp>
+
+#include <graphene/contract_history/contract_history_plugin.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+using namespace graphene::chain::test;
+
+namespace {
+   struct test_compiled_contract : public compiled_contract
+   {
+      explicit test_compiled_contract( const contract_addr_type& a ) : addr( a ) {}
+      contract_addr_type addr;
+   };
+
+   const string counter_abi = "[ { \"name\": \"inc\", \"inputs\": [ \"uint64\" ] }, { \"name\": \"loop\" }, { \"name\": \"count\" } ]";
+
+   /// inc adds its argument to the "count" key, loop runs forever.  Queries return the count.
+   /// The constructor takes an optional initial count.
+   struct counter_engine : public contract_engine
+   {
+      compiled_contract_ptr compile( const contract_addr_type& addr, const contract_code_object& ) override
+      {
+         return std::make_shared<test_compiled_contract>( addr );
+      }
+
+      void construct( compiled_contract&, const string& construct_data, contract_storage& storage,
+                      contract_gas_meter& ) override
+      {
+         if( !construct_data.empty() )
+            storage.set_value( "count", fc::raw::unpack<uint64_t>( vector<char>( construct_data.begin(), construct_data.end() ) ) );
+      }
+
+      void call( compiled_contract&, const string& call_data, contract_storage& storage,
+                 contract_gas_meter& meter ) override
+      {
+         while( contract_abi::call_selector( call_data ) == contract_abi::selector( "loop" ) )
+            meter.charge( 1 );
+         meter.charge( 50 );
+         const uint64_t amount = fc::raw::unpack<uint64_t>(
+            vector<char>( call_data.begin() + contract_abi::selector_size, call_data.end() ) );
+         auto count = storage.get_value<uint64_t>( "count" );
+         storage.set_value( "count", ( count.valid() ? *count : 0 ) + amount );
+      }
+
+      string query( compiled_contract& contract, const string& call_data, contract_storage& storage,
+                    contract_gas_meter& meter ) override
+      {
+         if( contract_abi::call_selector( call_data ) != contract_abi::selector( "count" ) )
+            call( contract, call_data, storage, meter );
+         auto count = storage.get_value<uint64_t>( "count" );
+         return std::to_string( count.valid() ? *count : 0 );
+      }
+   };
+
+   struct parallel_counter_engine : public counter_engine
+   {
+      bool supports_parallel_calls()const override { return true; }
+   };
+
+   /// emits an "inc" event carrying the increment after each inc call
+   struct event_counter_engine : public counter_engine
+   {
+      void call( compiled_contract& contract, const string& call_data, contract_storage& storage,
+                 contract_gas_meter& meter ) override
+      {
+         counter_engine::call( contract, call_data, storage, meter );
+         storage.emit( "inc", vector<char>( call_data.begin() + contract_abi::selector_size, call_data.end() ) );
+      }
+   };
+
+   /// wren_contract_engine with the binding replaced, the constructor stores its arguments and calls append to them
+   struct stub_wren_engine : public wren_contract_engine
+   {
+      uint32_t runs = 0;
+
+   protected:
+      string run( const contract_addr_type&, const string&, const string& call_data, const string&,
+                  const string& state ) override
+      {
+         ++runs;
+         return state + call_data;
+      }
+
+      string run_constructor( const contract_addr_type&, const string&, const string& construct_data,
+                              const string& ) override
+      {
+         return construct_data;
+      }
+   };
+
+   /// constructor arguments of the counter engines
+   string packed( uint64_t count )
+   {
+      const vector<char> data = fc::raw::pack( count );
+      return string( data.begin(), data.end() );
+   }
+
+   const contract_object& get_contract( const database& db, const contract_addr_type& addr )
+   {
+      const auto& idx = db.get_index_type<contract_index>().indices().get<by_contract_addr>();
+      auto itr = idx.find( addr );
+      FC_ASSERT( itr != idx.end() );
+      return *itr;
+   }
+}
+
+BOOST_FIXTURE_TEST_SUITE( smart_contract_tests, database_fixture )
+
+BOOST_AUTO_TEST_CASE( contract_cache_test )
+{ try {
+   contract_cache cache( 2 );
+   uint32_t compiles = 0;
+   auto compiler = [&compiles]( const contract_addr_type& addr ) {
+      return [&compiles, addr]() -> compiled_contract_ptr {
+         ++compiles;
+         return std::make_shared<test_compiled_contract>( addr );
+      };
+   };
+
+   const auto a = fc::sha256::hash( string( "a" ) );
+   const auto b = fc::sha256::hash( string( "b" ) );
+   const auto c = fc::sha256::hash( string( "c" ) );
+
+   auto first = cache.get( a, compiler( a ) );
+   BOOST_CHECK( cache.get( a, compiler( a ) ) == first );
+   BOOST_CHECK_EQUAL( compiles, 1u );
+   BOOST_CHECK_EQUAL( cache.hits(), 1u );
+   BOOST_CHECK_EQUAL( cache.misses(), 1u );
+
+   // b then c evicts a, the least recently used entry
+   cache.get( b, compiler( b ) );
+   cache.get( c, compiler( c ) );
+   BOOST_CHECK_EQUAL( cache.size(), 2u );
+   cache.get( a, compiler( a ) );
+   BOOST_CHECK_EQUAL( compiles, 4u );
+
+   // killing a contract drops it from the cache
+   cache.invalidate( a );
+   cache.get( a, compiler( a ) );
+   BOOST_CHECK_EQUAL( compiles, 5u );
+
+   cache.set_capacity( 0 );
+   BOOST_CHECK_EQUAL( cache.size(), 0u );
+   cache.get( a, compiler( a ) );
+   cache.get( a, compiler( a ) );
+   BOOST_CHECK_EQUAL( compiles, 7u );
+
+   fc::variant_object stats = cache.to_variant();
+   BOOST_CHECK_EQUAL( stats["misses"].as_uint64(), 7u );
+   BOOST_CHECK_EQUAL( stats["compile"]["count"].as_uint64(), 7u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( contract_storage_test )
+{ try {
+   const auto a = fc::sha256::hash( string( "a" ) );
+   const auto b = fc::sha256::hash( string( "b" ) );
+   contract_storage storage_a( db, a );
+   contract_storage storage_b( db, b );
+   const auto& idx = db.get_index_type<contract_storage_index>().indices();
+
+   storage_a.set_value( "balance", uint64_t(100) );
+   storage_a.set_value( "owner", string( "alice" ) );
+   storage_b.set_value( "balance", uint64_t(7) );
+   BOOST_CHECK_EQUAL( idx.size(), 3u );
+   BOOST_CHECK_EQUAL( *storage_a.get_value<uint64_t>( "balance" ), 100u );
+   BOOST_CHECK_EQUAL( *storage_a.get_value<string>( "owner" ), "alice" );
+   BOOST_CHECK_EQUAL( *storage_b.get_value<uint64_t>( "balance" ), 7u );
+   BOOST_CHECK( !storage_b.get_value<string>( "owner" ).valid() );
+
+   {
+      // writes only touch the keys used and are undone with the session
+      auto ses = db._undo_db.start_undo_session();
+      storage_a.set_value( "balance", uint64_t(42) );
+      storage_a.set_value( "spender", string( "bob" ) );
+      BOOST_CHECK( storage_a.remove( "owner" ) );
+      BOOST_CHECK( !storage_a.remove( "owner" ) );
+      BOOST_CHECK_EQUAL( *storage_a.get_value<uint64_t>( "balance" ), 42u );
+      BOOST_CHECK( !storage_a.contains( "owner" ) );
+      ses.undo();
+   }
+   BOOST_CHECK_EQUAL( *storage_a.get_value<uint64_t>( "balance" ), 100u );
+   BOOST_CHECK_EQUAL( *storage_a.get_value<string>( "owner" ), "alice" );
+   BOOST_CHECK( !storage_a.contains( "spender" ) );
+
+   BOOST_CHECK_EQUAL( storage_a.remove_all(), 2u );
+   BOOST_CHECK_EQUAL( idx.size(), 1u );
+   BOOST_CHECK_EQUAL( *storage_b.get_value<uint64_t>( "balance" ), 7u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( contract_gas_metering_test )
+{ try {
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+
+   db.set_contract_engine( std::make_shared<counter_engine>() );
+   const auto addr = deploy_contract( alice_id, "counter", counter_abi );
+
+   auto call = [&]( const string& data ) {
+      smart_contract_call_operation op;
+      op.caller = alice_id;
+      op.contract_addr = addr;
+      op.call_data = data;
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      auto ptx = PUSH_TX( db, trx, ~0 );
+      trx.clear();
+      return ptx.operation_results[0].get<contract_call_result>();
+   };
+
+   // before the hardfork calls are not metered and pay no gas
+   {
+      smart_contract_call_operation op;
+      op.caller = alice_id;
+      op.contract_addr = addr;
+      op.call_data = contract_abi::encode_call( "inc", uint64_t(1) );
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      const int64_t balance = get_balance( alice_id, asset_id_type() );
+      auto ptx = PUSH_TX( db, trx, ~0 );
+      trx.clear();
+      BOOST_CHECK( ptx.operation_results[0].is_type<void_result>() );
+      BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), balance );
+      BOOST_CHECK_EQUAL( db.get_dynamic_global_properties().contract_gas_used, 0u );
+   }
+
+   generate_blocks( HARDFORK_CONTRACT_GAS_TIME );
+   contract_storage( db, addr ).remove( "count" );
+
+   int64_t balance = get_balance( alice_id, asset_id_type() );
+   contract_call_result result = call( contract_abi::encode_call( "inc", uint64_t(1) ) );
+   const uint64_t expected_gas = GRAPHENE_CONTRACT_GAS_PER_CALL + 12 + 50
+                               + GRAPHENE_CONTRACT_GAS_PER_STORAGE_READ + 5
+                               + GRAPHENE_CONTRACT_GAS_PER_STORAGE_WRITE + ( 5 + 8 ) * GRAPHENE_CONTRACT_GAS_PER_STORED_BYTE;
+   BOOST_CHECK_EQUAL( result.gas_used, expected_gas );
+   BOOST_CHECK_EQUAL( result.gas_fee.value, int64_t( expected_gas * GRAPHENE_DEFAULT_CONTRACT_PRICE_PER_KGAS / 1000 ) );
+   BOOST_CHECK_EQUAL( get_balance( alice_id, asset_id_type() ), balance - result.gas_fee.value );
+   BOOST_CHECK_EQUAL( db.get_dynamic_global_properties().contract_gas_used, expected_gas );
+
+   // a runaway call stops at the per-call limit and leaves no trace
+   GRAPHENE_REQUIRE_THROW( call( contract_abi::encode_call( "loop" ) ), fc::exception );
+   trx.clear();
+   BOOST_CHECK_EQUAL( db.get_dynamic_global_properties().contract_gas_used, expected_gas );
+   BOOST_CHECK_EQUAL( *contract_storage( db, addr ).get_value<uint64_t>( "count" ), 1u );
+
+   // the block budget is reset once a block is applied
+   generate_block();
+   BOOST_CHECK_EQUAL( db.get_dynamic_global_properties().contract_gas_used, 0u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( call_contract_readonly_test )
+{ try {
+   ACTORS( (alice) );
+   db.set_contract_engine( std::make_shared<counter_engine>() );
+   const auto addr = deploy_contract( alice_id, "counter", counter_abi, packed( 41 ) );
+   const string count = contract_abi::encode_call( "count" );
+   BOOST_CHECK_EQUAL( db.call_contract_readonly( addr, count ), "41" );
+
+   // writes are rejected and leave the state untouched
+   GRAPHENE_REQUIRE_THROW( db.call_contract_readonly( addr, contract_abi::encode_call( "inc", uint64_t(1) ) ), fc::exception );
+   BOOST_CHECK_EQUAL( *contract_storage( db, addr ).get_value<uint64_t>( "count" ), 41u );
+   // compiled once by the deployment
+   BOOST_CHECK_EQUAL( db.get_contract_cache().misses(), 1u );
+   BOOST_CHECK_EQUAL( db.get_contract_cache().hits(), 2u );
+
+   GRAPHENE_REQUIRE_THROW( db.call_contract_readonly( addr, contract_abi::encode_call( "dec" ) ), fc::exception );
+   GRAPHENE_REQUIRE_THROW( db.call_contract_readonly( fc::sha256::hash( string( "unknown" ) ), count ), fc::exception );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( wren_contract_engine_test )
+{ try {
+   BOOST_CHECK( dynamic_cast<wren_contract_engine*>( db.get_contract_engine() ) != nullptr );
+
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+
+   auto engine = std::make_shared<stub_wren_engine>();
+   db.set_contract_engine( engine );
+   const auto addr = deploy_contract( alice_id, "counter", counter_abi, "init" );
+
+   const string data = contract_abi::encode_call( "count" );
+   for( int i = 0; i < 2; ++i )
+   {
+      smart_contract_call_operation op;
+      op.caller = alice_id;
+      op.contract_addr = addr;
+      op.call_data = data;
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      PUSH_TX( db, trx, ~0 );
+      trx.clear();
+   }
+
+   // the state is kept under the legacy key, the contract is compiled once by the deployment
+   auto state = contract_storage( db, addr ).get( contract_storage::legacy_state_key );
+   BOOST_REQUIRE( state.valid() );
+   BOOST_CHECK_EQUAL( string( state->begin(), state->end() ), "init" + data + data );
+   BOOST_CHECK_EQUAL( engine->runs, 2u );
+   BOOST_CHECK_EQUAL( db.get_contract_cache().misses(), 1u );
+   BOOST_CHECK_EQUAL( db.get_contract_cache().hits(), 2u );
+
+   // the binding has no method results, read-only calls do not expose the state instead
+   GRAPHENE_REQUIRE_THROW( db.call_contract_readonly( addr, data ), fc::exception );
+   BOOST_CHECK_EQUAL( engine->runs, 2u );
+
+   db.set_contract_engine( nullptr );
+   BOOST_CHECK( dynamic_cast<wren_contract_engine*>( db.get_contract_engine() ) != nullptr );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( wren_vm_test )
+{ try {
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+   generate_blocks( HARDFORK_CONTRACT_ABI_TIME );
+
+   const string abi = "[ { \"name\": \"init\", \"inputs\": [ \"uint64\" ] }, { \"name\": \"check\", \"inputs\": [ \"uint64\" ] },"
+                      "  { \"name\": \"once\" }, { \"name\": \"pay\", \"inputs\": [ \"account\", \"asset\" ] },"
+                      "  { \"name\": \"hog\" } ]";
+   const string source =
+      "class Contract {\n"
+      "   static init(limit) {\n"
+      "      if (limit != 3) Fiber.abort(\"bad limit\")\n"
+      "   }\n"
+      "   static check(n) {\n"
+      "      if (n > 3) Fiber.abort(\"too big\")\n"
+      "   }\n"
+      "   static once() {\n"
+      "      if (__called) Fiber.abort(\"state of an earlier call\")\n"
+      "      __called = true\n"
+      "   }\n"
+      "   static pay(to, amount) {\n"
+      "      if (to != \"1.2.5\" || amount[0] != 100 || amount[1] != \"1.3.0\") Fiber.abort(\"bad arguments\")\n"
+      "   }\n"
+      "   static hog() {\n"
+      "      var list = []\n"
+      "      while (true) {\n"
+      "         list.add(\"x\" * 1000)\n"
+      "      }\n"
+      "   }\n"
+      "}\n";
+
+   // init runs with the constructor arguments
+   GRAPHENE_REQUIRE_THROW( deploy_contract( alice_id, source, abi, packed( 4 ) ), fc::exception );
+   trx.clear();
+   const auto addr = deploy_contract( alice_id, source, abi, packed( 3 ) );
+   BOOST_CHECK_EQUAL( get_contract( db, addr ).get_code( db ).vm_version, 1 );
+   const uint64_t misses = db.get_contract_cache().misses();
+   const uint64_t hits = db.get_contract_cache().hits();
+
+   auto call = [&]( const string& data ) {
+      smart_contract_call_operation op;
+      op.caller = alice_id;
+      op.contract_addr = addr;
+      op.call_data = data;
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      PUSH_TX( db, trx, ~0 );
+      trx.clear();
+   };
+   call( contract_abi::encode_call( "check", uint64_t(2) ) );
+   GRAPHENE_REQUIRE_THROW( call( contract_abi::encode_call( "check", uint64_t(5) ) ), fc::exception );
+   trx.clear();
+   call( contract_abi::encode_call( "pay", account_id_type(5), asset(100) ) );
+   GRAPHENE_REQUIRE_THROW( call( contract_abi::encode_call( "pay", account_id_type(6), asset(100) ) ), fc::exception );
+   trx.clear();
+   // init only runs at deployment
+   GRAPHENE_REQUIRE_THROW( call( contract_abi::encode_call( "init", uint64_t(3) ) ), fc::exception );
+   trx.clear();
+
+   // every call starts from the loaded contract, without loading it again
+   call( contract_abi::encode_call( "once" ) );
+   call( contract_abi::encode_call( "once" ) );
+   BOOST_CHECK_EQUAL( db.get_contract_cache().misses(), misses );
+   BOOST_CHECK_EQUAL( db.get_contract_cache().hits(), hits + 7 );
+
+   // a call allocating without end fails, and the next call is not affected
+   GRAPHENE_REQUIRE_THROW( call( contract_abi::encode_call( "hog" ) ), fc::exception );
+   trx.clear();
+   call( contract_abi::encode_call( "check", uint64_t(1) ) );
+
+   // sources which do not compile or lack the Contract class are not deployed
+   GRAPHENE_REQUIRE_THROW( deploy_contract( alice_id, "class Contract {", "[]" ), fc::exception );
+   trx.clear();
+   GRAPHENE_REQUIRE_THROW( deploy_contract( alice_id, "class Other {}", "[]" ), fc::exception );
+   trx.clear();
+   GRAPHENE_REQUIRE_THROW( deploy_contract( alice_id, "class Contract {}", "[ { \"name\": \"is\" } ]" ), fc::exception );
+   trx.clear();
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( wren_vm_storage_test )
+{ try {
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+   generate_blocks( HARDFORK_CONTRACT_ABI_TIME );
+
+   const string abi = "[ { \"name\": \"inc\", \"inputs\": [ \"uint64\" ] }, { \"name\": \"reset\" },"
+                      "  { \"name\": \"swallow\" } ]";
+   const string source =
+      "class Contract {\n"
+      "   static inc(n) {\n"
+      "      var count = Storage.get(\"count\")\n"
+      "      Storage.set(\"count\", (count == null ? n : Num.fromString(count) + n).toString)\n"
+      "   }\n"
+      "   static reset() {\n"
+      "      if (!Storage.remove(\"count\") || Storage.contains(\"count\")) Fiber.abort(\"not removed\")\n"
+      "   }\n"
+      "   static swallow() {\n"
+      "      Storage.set(\"other\", \"x\")\n"
+      "      Fiber.new { Storage.set(1, \"x\") }.try()\n"
+      "   }\n"
+      "}\n";
+   const auto addr = deploy_contract( alice_id, source, abi );
+
+   auto call = [&]( const string& data ) {
+      smart_contract_call_operation op;
+      op.caller = alice_id;
+      op.contract_addr = addr;
+      op.call_data = data;
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      PUSH_TX( db, trx, ~0 );
+      trx.clear();
+   };
+   auto stored = [&]( const string& key ) {
+      auto value = contract_storage( db, addr ).get( key );
+      return value.valid() ? string( value->begin(), value->end() ) : string( "<none>" );
+   };
+
+   // the state is kept key by key, not as one blob
+   call( contract_abi::encode_call( "inc", uint64_t(2) ) );
+   call( contract_abi::encode_call( "inc", uint64_t(3) ) );
+   BOOST_CHECK_EQUAL( stored( "count" ), "5" );
+   BOOST_CHECK( !contract_storage( db, addr ).contains( contract_storage::legacy_state_key ) );
+
+   call( contract_abi::encode_call( "reset" ) );
+   BOOST_CHECK_EQUAL( stored( "count" ), "<none>" );
+   GRAPHENE_REQUIRE_THROW( call( contract_abi::encode_call( "reset" ) ), fc::exception );
+   trx.clear();
+
+   // a storage error fails the call even when the contract catches it, and undoes its writes
+   GRAPHENE_REQUIRE_THROW( call( contract_abi::encode_call( "swallow" ) ), fc::exception );
+   trx.clear();
+   BOOST_CHECK_EQUAL( stored( "other" ), "<none>" );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( wren_vm_query_test )
+{ try {
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+   generate_blocks( HARDFORK_CONTRACT_ABI_TIME );
+
+   const string abi = "[ { \"name\": \"sum\", \"inputs\": [ \"uint64\", \"uint64\" ] }, { \"name\": \"pair\" },"
+                      "  { \"name\": \"get\", \"inputs\": [ \"string\" ] }, { \"name\": \"set\", \"inputs\": [ \"string\" ] },"
+                      "  { \"name\": \"nothing\" } ]";
+   const string source =
+      "class Contract {\n"
+      "   static sum(a, b) { a + b }\n"
+      "   static pair() { [1, \"a\"] }\n"
+      "   static get(key) { Storage.get(key) }\n"
+      "   static set(value) { Storage.set(\"key\", value) }\n"
+      "   static nothing() {}\n"
+      "}\n";
+   const auto addr = deploy_contract( alice_id, source, abi );
+
+   // the result of the method, not the contract state
+   BOOST_CHECK_EQUAL( db.call_contract_readonly( addr, contract_abi::encode_call( "sum", uint64_t(2), uint64_t(3) ) ), "5" );
+   BOOST_CHECK_EQUAL( db.call_contract_readonly( addr, contract_abi::encode_call( "pair" ) ), "[1, a]" );
+   BOOST_CHECK_EQUAL( db.call_contract_readonly( addr, contract_abi::encode_call( "nothing" ) ), "null" );
+
+   smart_contract_call_operation op;
+   op.caller = alice_id;
+   op.contract_addr = addr;
+   op.call_data = contract_abi::encode_call( "set", string( "stored" ) );
+   trx.operations.push_back( op );
+   set_expiration( db, trx );
+   PUSH_TX( db, trx, ~0 );
+   trx.clear();
+   BOOST_CHECK_EQUAL( db.call_contract_readonly( addr, contract_abi::encode_call( "get", string( "key" ) ) ), "stored" );
+   BOOST_CHECK_EQUAL( db.call_contract_readonly( addr, contract_abi::encode_call( "get", string( "other" ) ) ), "null" );
+
+   // writes fail
+   GRAPHENE_REQUIRE_THROW( db.call_contract_readonly( addr, contract_abi::encode_call( "set", string( "x" ) ) ), fc::exception );
+   BOOST_CHECK_EQUAL( db.call_contract_readonly( addr, contract_abi::encode_call( "get", string( "key" ) ) ), "stored" );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( wren_vm_metering_test )
+{ try {
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+   generate_blocks( std::max( HARDFORK_CONTRACT_ABI_TIME, HARDFORK_CONTRACT_GAS_TIME ) );
+
+   const string abi = "[ { \"name\": \"spin\" }, { \"name\": \"work\", \"inputs\": [ \"uint64\" ] },"
+                      "  { \"name\": \"sneak\" }, { \"name\": \"big\" }, { \"name\": \"hog\" } ]";
+   const string source =
+      "class Contract {\n"
+      "   static spin() {\n"
+      "      while (true) {}\n"
+      "   }\n"
+      "   static work(n) {\n"
+      "      var i = 0\n"
+      "      while (i < n) { i = i + 1 }\n"
+      "   }\n"
+      "   static sneak() {\n"
+      "      Fiber.new { Contract.spin() }.try()\n"
+      "      Storage.set(\"after\", \"x\")\n"
+      "   }\n"
+      "   static big() {\n"
+      "      return List.filled(100000, 0).count\n"
+      "   }\n"
+      "   static hog() {\n"
+      "      var list = []\n"
+      "      while (true) { list.add(List.filled(1000, 0)) }\n"
+      "   }\n"
+      "}\n";
+   const auto addr = deploy_contract( alice_id, source, abi );
+
+   wren_contract_engine engine;
+   auto compiled = engine.compile( addr, get_contract( db, addr ).get_code( db ) );
+   auto run = [&]( const string& data, contract_gas_meter& meter ) {
+      contract_storage storage( db, addr, &meter );
+      engine.call( *compiled, data, storage, meter );
+   };
+
+   // a loop without calls or allocations stops when its ticks exhaust the meter
+   {
+      contract_gas_meter meter( 1000 * 1000 );
+      GRAPHENE_REQUIRE_THROW( run( contract_abi::encode_call( "spin" ), meter ), smart_contract_call_out_of_gas );
+      BOOST_CHECK_EQUAL( meter.used(), meter.limit() );
+   }
+
+   // gas follows the executed code: each turn of the loop charges the 5 tokens of its body
+   auto gas_of = [&]( uint64_t n ) {
+      contract_gas_meter meter( GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT );
+      run( contract_abi::encode_call( "work", n ), meter );
+      return meter.used();
+   };
+   const uint64_t gas_10 = gas_of( 10 );
+   BOOST_CHECK_EQUAL( gas_of( 10 ), gas_10 );
+   BOOST_CHECK_EQUAL( gas_of( 20 ) - gas_10, 10 * 5 * GRAPHENE_CONTRACT_GAS_PER_TOKEN );
+
+   // running out of gas cannot be caught by the contract
+   {
+      contract_gas_meter meter( 1000 * 1000 );
+      GRAPHENE_REQUIRE_THROW( run( contract_abi::encode_call( "sneak" ), meter ), smart_contract_call_out_of_gas );
+      BOOST_CHECK( !contract_storage( db, addr ).contains( "after" ) );
+   }
+
+   // no single allocation beyond GRAPHENE_CONTRACT_MAX_VM_ALLOCATION
+   {
+      contract_gas_meter meter( GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT );
+      GRAPHENE_REQUIRE_THROW( run( contract_abi::encode_call( "big" ), meter ), fc::assert_exception );
+      BOOST_CHECK( meter.used() < meter.limit() );
+   }
+
+   // allocations cost gas, and the heap stops at the memory limit of the meter
+   {
+      contract_gas_meter meter( GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT );
+      GRAPHENE_REQUIRE_THROW( run( contract_abi::encode_call( "hog" ), meter ), smart_contract_call_out_of_gas );
+   }
+   {
+      contract_gas_meter meter( std::numeric_limits<uint64_t>::max(), 4 * 1024 * 1024 );
+      GRAPHENE_REQUIRE_THROW( run( contract_abi::encode_call( "hog" ), meter ), fc::assert_exception );
+   }
+   contract_gas_meter after_hog( GRAPHENE_DEFAULT_CONTRACT_CALL_GAS_LIMIT );
+   run( contract_abi::encode_call( "work", uint64_t(10) ), after_hog );
+   BOOST_CHECK_EQUAL( after_hog.used(), gas_10 );
+
+   // the block budget is a chain parameter
+   auto call = [&]( const string& data ) {
+      smart_contract_call_operation op;
+      op.caller = alice_id;
+      op.contract_addr = addr;
+      op.call_data = data;
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      PUSH_TX( db, trx, ~0 );
+      trx.clear();
+   };
+   chain_parameters params = db.get_global_properties().parameters;
+   params.extensions.value.contract_block_gas_limit = GRAPHENE_CONTRACT_GAS_PER_CALL - 1;
+   GRAPHENE_REQUIRE_THROW( params.validate(), fc::exception );
+
+   generate_block();
+   db.modify( db.get_global_properties(), []( global_property_object& p ) {
+      p.parameters.extensions.value.contract_block_gas_limit = 50000;
+   } );
+   BOOST_CHECK_EQUAL( db.get_global_properties().parameters.contract_block_gas_limit(), 50000u );
+   call( contract_abi::encode_call( "work", uint64_t(10) ) );
+   const uint64_t used = db.get_dynamic_global_properties().contract_gas_used;
+   GRAPHENE_REQUIRE_THROW( call( contract_abi::encode_call( "work", uint64_t(1000) ) ), smart_contract_call_block_gas_exhausted );
+   trx.clear();
+   BOOST_CHECK_EQUAL( db.get_dynamic_global_properties().contract_gas_used, used );
+   // lowered below what the block used, further calls are refused before they run
+   db.modify( db.get_global_properties(), [used]( global_property_object& p ) {
+      p.parameters.extensions.value.contract_block_gas_limit = used;
+   } );
+   GRAPHENE_REQUIRE_THROW( call( contract_abi::encode_call( "work", uint64_t(1) ) ), smart_contract_call_block_gas_exhausted );
+   trx.clear();
+   generate_block();
+   call( contract_abi::encode_call( "work", uint64_t(1) ) );
+
+   // a constructor is metered like a call
+   const string init_abi = "[ { \"name\": \"init\" } ]";
+   GRAPHENE_REQUIRE_THROW( deploy_contract( alice_id, "class Contract {\n   static init() {\n      while (true) {}\n   }\n}\n", init_abi ),
+                           fc::exception );
+   trx.clear();
+
+   // sources the ticks could not bound are not deployed
+   for( const string& bad : { string( "class Contract {\n   static f() {\n      while (true) Fiber.yield()\n   }\n}\n" ),
+                              string( "var x = 1\nclass Contract {}\n" ),
+                              string( "class Contract {\n   static f() {\n      import \"meta\"\n   }\n}\n" ),
+                              string( "class Contract {\n   static f() { ContractGas_.tick(1) }\n}\n" ),
+                              string( "class Contract {\n   static f() { System.clock }\n}\n" ),
+                              string( "class Contract {\n   static f() { (1..1000000).count }\n}\n" ) } )
+   {
+      GRAPHENE_REQUIRE_THROW( deploy_contract( alice_id, bad, "[]" ), fc::exception );
+      trx.clear();
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( contract_speculative_execution_test )
+{ try {
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+
+   db.set_contract_engine( std::make_shared<parallel_counter_engine>() );
+   const auto a = deploy_contract( alice_id, "counter", counter_abi );
+   const auto b = deploy_contract( alice_id, "counter", counter_abi, packed( 0 ) );
+   db.set_contract_execution_threads( 2 );
+
+   auto make_call = [&]( const contract_addr_type& addr, const string& data ) {
+      smart_contract_call_operation op;
+      op.caller = alice_id;
+      op.contract_addr = addr;
+      op.call_data = data;
+      signed_transaction tx;
+      tx.operations.push_back( op );
+      set_expiration( db, tx );
+      return tx;
+   };
+
+   // results are taken over only while the storage they read is unchanged
+   signed_block block;
+   block.transactions.push_back( make_call( a, contract_abi::encode_call( "inc", uint64_t(1) ) ) );
+   block.transactions.push_back( make_call( b, contract_abi::encode_call( "inc", uint64_t(1) ) ) );
+   db.get_contract_scheduler().speculate( db, block );
+   const speculative_contract_call* spec = db.get_contract_scheduler().find( 0, 0 );
+   BOOST_REQUIRE( spec != nullptr );
+   BOOST_CHECK( spec->succeeded );
+   BOOST_CHECK( spec->is_valid( db ) );
+   BOOST_CHECK_EQUAL( spec->writes.size(), 1u );
+   contract_storage( db, a ).set_value( "count", uint64_t(10) );
+   BOOST_CHECK( !spec->is_valid( db ) );
+   BOOST_CHECK( db.get_contract_scheduler().find( 1, 0 )->is_valid( db ) );
+   db.get_contract_scheduler().clear();
+
+   // a block with several calls per contract ends up as if applied serially
+   for( uint64_t i = 1; i <= 3; ++i )
+   {
+      PUSH_TX( db, make_call( a, contract_abi::encode_call( "inc", i ) ), ~0 );
+      PUSH_TX( db, make_call( b, contract_abi::encode_call( "inc", i ) ), ~0 );
+   }
+   generate_block();
+   BOOST_CHECK_EQUAL( *contract_storage( db, a ).get_value<uint64_t>( "count" ), 16u );
+   BOOST_CHECK_EQUAL( *contract_storage( db, b ).get_value<uint64_t>( "count" ), 6u );
+   fc::variant_object stats = db.get_contract_scheduler().to_variant();
+   BOOST_CHECK_EQUAL( stats["committed"].as_uint64(), 6u );
+   BOOST_CHECK_EQUAL( stats["reexecuted"].as_uint64(), 0u );
+
+   db.set_contract_execution_threads( 0 );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( wren_vm_speculative_execution_test )
+{ try {
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+
+   auto make_call = [&]( const contract_addr_type& addr, const string& data ) {
+      smart_contract_call_operation op;
+      op.caller = alice_id;
+      op.contract_addr = addr;
+      op.call_data = data;
+      signed_transaction tx;
+      tx.operations.push_back( op );
+      set_expiration( db, tx );
+      return tx;
+   };
+
+   // code run by the binding is left to the evaluator
+   {
+      db.set_contract_engine( std::make_shared<stub_wren_engine>() );
+      const auto a = deploy_contract( alice_id, "a", counter_abi );
+      const auto b = deploy_contract( alice_id, "b", counter_abi );
+      db.set_contract_execution_threads( 2 );
+      signed_block block;
+      block.transactions.push_back( make_call( a, contract_abi::encode_call( "count" ) ) );
+      block.transactions.push_back( make_call( b, contract_abi::encode_call( "count" ) ) );
+      db.get_contract_scheduler().speculate( db, block );
+      for( uint16_t t = 0; t < 2; ++t )
+      {
+         const speculative_contract_call* spec = db.get_contract_scheduler().find( t, 0 );
+         BOOST_CHECK( spec == nullptr || !spec->succeeded );
+      }
+      BOOST_CHECK_EQUAL( db.get_contract_scheduler().to_variant()["speculated"].as_uint64(), 0u );
+      db.get_contract_scheduler().clear();
+      db.set_contract_execution_threads( 0 );
+      db.set_contract_engine( nullptr );
+   }
+
+   generate_blocks( HARDFORK_CONTRACT_ABI_TIME );
+   const string abi = "[ { \"name\": \"inc\", \"inputs\": [ \"uint64\" ] } ]";
+   const string source =
+      "class Contract {\n"
+      "   static inc(n) {\n"
+      "      var count = Storage.get(\"count\")\n"
+      "      Storage.set(\"count\", (count == null ? n : Num.fromString(count) + n).toString)\n"
+      "   }\n"
+      "}\n";
+   const auto a = deploy_contract( alice_id, source, abi );
+   const auto b = deploy_contract( alice_id, source + "// b\n", abi );
+   db.set_contract_execution_threads( 2 );
+
+   // wren_vm calls of different contracts run on the worker threads and end up as if applied serially
+   for( uint64_t i = 1; i <= 3; ++i )
+   {
+      PUSH_TX( db, make_call( a, contract_abi::encode_call( "inc", i ) ), ~0 );
+      PUSH_TX( db, make_call( b, contract_abi::encode_call( "inc", i * 10 ) ), ~0 );
+   }
+   generate_block();
+   auto stored = [&]( const contract_addr_type& addr ) {
+      auto value = contract_storage( db, addr ).get( "count" );
+      return value.valid() ? string( value->begin(), value->end() ) : string( "<none>" );
+   };
+   BOOST_CHECK_EQUAL( stored( a ), "6" );
+   BOOST_CHECK_EQUAL( stored( b ), "60" );
+   fc::variant_object stats = db.get_contract_scheduler().to_variant();
+   BOOST_CHECK_EQUAL( stats["committed"].as_uint64(), 6u );
+   BOOST_CHECK_EQUAL( stats["reexecuted"].as_uint64(), 0u );
+
+   db.set_contract_execution_threads( 0 );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( contract_code_dedup_test )
+{ try {
+   const contract_code_id_type code = db.store_contract_code( "bytecode", "[]" );
+   BOOST_CHECK( db.store_contract_code( "bytecode", "[]" ) == code );
+   BOOST_CHECK( db.store_contract_code( "bytecode", "[ { \"name\": \"v2\" } ]" ) != code );
+   // fields are hashed with their sizes, moving bytes between them gives another entry
+   BOOST_CHECK( db.store_contract_code( "bytecode ", "[]" ) != db.store_contract_code( "bytecode", " []" ) );
+   BOOST_CHECK_EQUAL( code( db ).bytecode, "bytecode" );
+
+   // contracts deployed with the same code and different constructor arguments share the code
+   ACTORS( (alice) );
+   db.set_contract_engine( std::make_shared<counter_engine>() );
+   vector<contract_addr_type> addrs;
+   for( uint64_t initial : { 1, 2 } )
+      addrs.push_back( deploy_contract( alice_id, "counter", counter_abi, packed( initial ) ) );
+   const contract_code_id_type shared = get_contract( db, addrs[0] ).code;
+   BOOST_CHECK( get_contract( db, addrs[1] ).code == shared );
+   BOOST_CHECK_EQUAL( *contract_storage( db, addrs[1] ).get_value<uint64_t>( "count" ), 2u );
+
+   // the address can be checked against the stored code and constructor arguments
+   for( const auto& addr : addrs )
+   {
+      const contract_object& contract = get_contract( db, addr );
+      const contract_code_object& c = contract.get_code( db );
+      BOOST_CHECK( addr == fc::sha256::hash( c.bytecode + c.abi_json + contract.construct_data ) );
+   }
+
+   // the entry goes away with the last contract using it
+   auto kill = [&]( const contract_addr_type& addr ) {
+      smart_contract_kill_operation op;
+      op.killer = alice_id;
+      op.contract_addr = addr;
+      set_expiration( db, trx );
+      trx.operations.push_back( op );
+      PUSH_TX( db, trx, ~0 );
+      trx.clear();
+   };
+   kill( addrs[0] );
+   BOOST_CHECK( db.find( shared ) != nullptr );
+   BOOST_CHECK( !contract_storage( db, addrs[0] ).contains( "count" ) );
+   kill( addrs[1] );
+   BOOST_CHECK( db.find( shared ) == nullptr );
+
+   // an unused entry stored directly is released the same way
+   BOOST_CHECK( db.release_contract_code( code ) );
+   BOOST_CHECK( db.find( code ) == nullptr );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( contract_event_test )
+{ try {
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+
+   db.set_contract_engine( std::make_shared<event_counter_engine>() );
+   const auto addr = deploy_contract( alice_id, "counter", counter_abi );
+   generate_blocks( HARDFORK_CONTRACT_GAS_TIME );
+
+   smart_contract_call_operation op;
+   op.caller = alice_id;
+   op.contract_addr = addr;
+   op.call_data = contract_abi::encode_call( "inc", uint64_t(7) );
+   trx.operations.push_back( op );
+   set_expiration( db, trx );
+   auto ptx = PUSH_TX( db, trx, ~0 );
+   trx.clear();
+
+   const contract_call_result result = ptx.operation_results[0].get<contract_call_result>();
+   BOOST_REQUIRE_EQUAL( result.events.size(), 1u );
+   BOOST_CHECK_EQUAL( result.events[0].name, "inc" );
+   BOOST_CHECK_EQUAL( fc::raw::unpack<uint64_t>( result.events[0].data ), 7u );
+   const uint64_t expected_gas = GRAPHENE_CONTRACT_GAS_PER_CALL + 12 + 50
+                               + GRAPHENE_CONTRACT_GAS_PER_STORAGE_READ + 5
+                               + GRAPHENE_CONTRACT_GAS_PER_STORAGE_WRITE + ( 5 + 8 ) * GRAPHENE_CONTRACT_GAS_PER_STORED_BYTE
+                               + GRAPHENE_CONTRACT_GAS_PER_EVENT + 8 * GRAPHENE_CONTRACT_GAS_PER_STORED_BYTE;
+   BOOST_CHECK_EQUAL( result.gas_used, expected_gas );
+
+   // read-only calls cannot emit events
+   GRAPHENE_REQUIRE_THROW( db.call_contract_readonly( addr, contract_abi::encode_call( "inc", uint64_t(1) ) ), fc::exception );
+
+   // events are indexed by the contract history plugin once the block is applied
+   generate_block();
+   const uint32_t block_num = db.head_block_num();
+   const auto& idx = db.get_index_type<graphene::contract_history::contract_event_index>()
+                       .indices().get<graphene::contract_history::by_event>();
+   auto itr = idx.lower_bound( boost::make_tuple( addr, string( "inc" ) ) );
+   BOOST_REQUIRE( itr != idx.end() );
+   BOOST_CHECK( itr->contract_addr == addr );
+   BOOST_CHECK_EQUAL( itr->name, "inc" );
+   BOOST_CHECK( itr->caller == alice_id );
+   BOOST_CHECK_EQUAL( itr->block_num, block_num );
+   BOOST_CHECK_EQUAL( fc::raw::unpack<uint64_t>( itr->data ), 7u );
+   BOOST_CHECK( ++itr == idx.end() );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( wren_vm_event_test )
+{ try {
+   ACTORS( (alice) );
+   transfer( committee_account, alice_id, asset( 1000 * GRAPHENE_BLOCKCHAIN_PRECISION ) );
+   generate_blocks( HARDFORK_CONTRACT_ABI_TIME );
+
+   const string abi = "[ { \"name\": \"pay\", \"inputs\": [ \"account\", \"uint64\" ] }, { \"name\": \"unnamed\" } ]";
+   const string source =
+      "class Contract {\n"
+      "   static pay(to, amount) {\n"
+      "      Event.emit(\"paid\", to)\n"
+      "      Event.emit(\"amount\", amount.toString)\n"
+      "      amount\n"
+      "   }\n"
+      "   static unnamed() { Event.emit(\"\", \"x\") }\n"
+      "}\n";
+   const auto addr = deploy_contract( alice_id, source, abi );
+
+   auto call = [&]( const string& data ) {
+      smart_contract_call_operation op;
+      op.caller = alice_id;
+      op.contract_addr = addr;
+      op.call_data = data;
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      auto ptx = PUSH_TX( db, trx, ~0 );
+      trx.clear();
+      return ptx.operation_results[0].get<contract_call_result>();
+   };
+
+   const contract_call_result result = call( contract_abi::encode_call( "pay", account_id_type(5), uint64_t(100) ) );
+   BOOST_REQUIRE_EQUAL( result.events.size(), 2u );
+   BOOST_CHECK_EQUAL( result.events[0].name, "paid" );
+   BOOST_CHECK_EQUAL( string( result.events[0].data.begin(), result.events[0].data.end() ), "1.2.5" );
+   BOOST_CHECK_EQUAL( result.events[1].name, "amount" );
+   BOOST_CHECK_EQUAL( string( result.events[1].data.begin(), result.events[1].data.end() ), "100" );
+
+   // events need a name, and read-only calls cannot emit them
+   GRAPHENE_REQUIRE_THROW( call( contract_abi::encode_call( "unnamed" ) ), fc::exception );
+   trx.clear();
+   GRAPHENE_REQUIRE_THROW( db.call_contract_readonly( addr, contract_abi::encode_call( "pay", account_id_type(5), uint64_t(1) ) ),
+                           fc::exception );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( contract_abi_test )
+{ try {
+   const contract_abi abi = contract_abi::parse(
+      "[ { \"name\": \"transfer\", \"inputs\": [ \"account\", { \"name\": \"amount\", \"type\": \"asset\" } ] },"
+      "  { \"name\": \"pause\" } ]" );
+   BOOST_REQUIRE_EQUAL( abi.methods.size(), 2u );
+   const contract_method* transfer = abi.find( contract_abi::selector( "transfer" ) );
+   BOOST_REQUIRE( transfer != nullptr );
+   BOOST_REQUIRE_EQUAL( transfer->args.size(), 2u );
+   BOOST_CHECK( transfer->args[1] == contract_arg_asset );
+
+   const string call = contract_abi::encode_call( "transfer", account_id_type(5), asset(100) );
+   BOOST_CHECK_EQUAL( abi.dispatch( call ).name, "transfer" );
+   BOOST_CHECK_EQUAL( abi.dispatch( contract_abi::encode_call( "pause" ) ).name, "pause" );
+
+   // unknown methods, missing, mistyped or extra arguments are rejected
+   GRAPHENE_REQUIRE_THROW( abi.dispatch( contract_abi::encode_call( "resume" ) ), fc::exception );
+   GRAPHENE_REQUIRE_THROW( abi.dispatch( contract_abi::encode_call( "transfer", account_id_type(5) ) ), fc::exception );
+   GRAPHENE_REQUIRE_THROW( abi.dispatch( contract_abi::encode_call( "pause", true ) ), fc::exception );
+   GRAPHENE_REQUIRE_THROW( abi.dispatch( "tra" ), fc::exception );
+
+   GRAPHENE_REQUIRE_THROW( contract_abi::parse( "{}" ), fc::exception );
+   GRAPHENE_REQUIRE_THROW( contract_abi::parse( "[ { \"name\": \"f\", \"inputs\": [ \"float\" ] } ]" ), fc::exception );
+   GRAPHENE_REQUIRE_THROW( contract_abi::parse( "[ { \"name\": \"f\" }, { \"name\": \"f\" } ]" ), fc::exception );
+
+   // before the hardfork any ABI is accepted and calls are not checked against it
+   ACTORS( (alice) );
+   db.set_contract_engine( std::make_shared<counter_engine>() );
+   const auto addr = deploy_contract( alice_id, "counter", counter_abi );
+   const auto free_form = deploy_contract( alice_id, "bytecode", "{}" );
+   BOOST_CHECK( !get_contract( db, free_form ).get_code( db ).abi.valid() );
+   BOOST_REQUIRE( get_contract( db, addr ).get_code( db ).abi.valid() );
+
+   auto call_inc = [&]( const contract_addr_type& contract, const string& data ) {
+      smart_contract_call_operation op;
+      op.caller = alice_id;
+      op.contract_addr = contract;
+      op.call_data = data;
+      op.validate();
+      trx.operations.push_back( op );
+      set_expiration( db, trx );
+      PUSH_TX( db, trx, ~0 );
+      trx.clear();
+   };
+   // an extra argument byte the counter engine ignores
+   call_inc( addr, contract_abi::encode_call( "inc", uint64_t(1) ) + "x" );
+   BOOST_CHECK_EQUAL( *contract_storage( db, addr ).get_value<uint64_t>( "count" ), 1u );
+
+   generate_blocks( HARDFORK_CONTRACT_ABI_TIME );
+   // also when the same code is already stored
+   GRAPHENE_REQUIRE_THROW( db.store_contract_code( "bytecode", "{}" ), fc::exception );
+   GRAPHENE_REQUIRE_THROW( deploy_contract( alice_id, "bytecode", "{}", "again" ), fc::exception );
+   trx.clear();
+
+   // code stored before the hardfork keeps getting its call data as sent
+   call_inc( addr, contract_abi::encode_call( "inc", uint64_t(1) ) + "x" );
+   BOOST_CHECK_EQUAL( *contract_storage( db, addr ).get_value<uint64_t>( "count" ), 2u );
+
+   // the same code deployed again is stored for the new VM, its calls are checked against the ABI
+   const auto checked = deploy_contract( alice_id, "counter", counter_abi, packed( 10 ) );
+   BOOST_CHECK( get_contract( db, checked ).get_code( db ).vm_version == 1 );
+   GRAPHENE_REQUIRE_THROW( call_inc( checked, contract_abi::encode_call( "inc", uint64_t(1) ) + "x" ), fc::exception );
+   trx.clear();
+   call_inc( checked, contract_abi::encode_call( "inc", uint64_t(1) ) );
+   BOOST_CHECK_EQUAL( *contract_storage( db, checked ).get_value<uint64_t>( "count" ), 11u );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_SUITE_END()